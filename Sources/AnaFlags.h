@@ -51,7 +51,10 @@ enum AnaFlags
 	CPU_SSE4                   = 0x00800000, // SSE4.1
 	// force MVAnalyse to use a different function for SAD / SADCHROMA (debug)
 	MOTION_USE_SSD             = 0x01000000,
-	MOTION_USE_SATD            = 0x02000000
+	MOTION_USE_SATD            = 0x02000000,
+	// more cpu capability flags, only set if the OS saves the extended registers
+	CPU_AVX2                   = 0x04000000,
+	CPU_AVX512BW               = 0x08000000  // AVX-512 F + BW
 };
 
 
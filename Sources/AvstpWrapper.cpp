@@ -32,12 +32,15 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 #include	"conc/Mutex.h"
 #include	"AvstpFinder.h"
 #include	"AvstpWrapper.h"
+#include	"ThreadPool.h"
 
 #include	"Windows.h"
 
 #include	<stdexcept>
+#include	<string>
 
 #include	<cassert>
+#include	<cstdlib>
 
 
 
@@ -55,8 +58,13 @@ Name: dtor
 
 AvstpWrapper::~AvstpWrapper ()
 {
-	::FreeLibrary (reinterpret_cast < ::HMODULE> (_dll_hnd));
-	_dll_hnd = 0;
+	_thread_pool_aptr.reset ();
+
+	if (_dll_hnd != 0)
+	{
+		::FreeLibrary (reinterpret_cast < ::HMODULE> (_dll_hnd));
+		_dll_hnd = 0;
+	}
 }
 
 
@@ -101,6 +109,30 @@ AvstpWrapper &	AvstpWrapper::use_instance ()
 
 
 
+/*
+==============================================================================
+Name: notify_process_exit
+Description:
+	To be called when the module is detached because the process terminates,
+	before the static objects are destroyed. At this point the other threads
+	have already been killed by the OS, so the built-in pool workers cannot
+	be waited for and the libraries should not be unloaded. The pool and the
+	library are intentionally leaked, the OS reclaims them.
+	Does nothing if the singleton has not been created.
+==============================================================================
+*/
+
+void	AvstpWrapper::notify_process_exit ()
+{
+	if (_singleton_init_flag && _singleton_aptr.get () != 0)
+	{
+		_singleton_aptr->_thread_pool_aptr.release ();
+		_singleton_aptr->_dll_hnd = 0;
+	}
+}
+
+
+
 // Below are the AVSTP wrapped function.
 // See the documentation for more details.
 
@@ -153,28 +185,49 @@ int	AvstpWrapper::wait_completion (avstp_TaskDispatcher *td_ptr)
 
 
 AvstpWrapper::AvstpWrapper ()
-:	_dll_hnd (AvstpFinder::find_lib ())
-,	_avstp_get_interface_version_ptr (0)
+:	_avstp_get_interface_version_ptr (0)
 ,	_avstp_create_dispatcher_ptr (0)
 ,	_avstp_destroy_dispatcher_ptr (0)
 ,	_avstp_get_nbr_threads_ptr (0)
 ,	_avstp_enqueue_task_ptr (0)
 ,	_avstp_wait_completion_ptr (0)
+,	_dll_hnd (0)
+,	_thread_pool_aptr ()
 {
-	if (_dll_hnd == 0)
+	const char *	backend_0 = std::getenv ("MVTOOLS_AVSTP");
+	const std::string	backend ((backend_0 != 0) ? backend_0 : "auto");
+
+	if (backend == "mono")
 	{
-		::OutputDebugStringW (
-			L"AvstpWrapper: cannot find avstp.dll."
-			L"Usage restricted to single threading.\n"
-		);
-//		throw std::runtime_error ("Cannot find avstp.dll.");
 		assign_fallback ();
 	}
 
+	else if (backend == "builtin")
+	{
+		assign_builtin ();
+	}
+
 	else
 	{
-		// Now resolves the function names
-		assign_normal ();
+		_dll_hnd = AvstpFinder::find_lib ();
+		if (_dll_hnd != 0)
+		{
+			// Now resolves the function names
+			assign_normal ();
+		}
+		else if (backend == "dll")
+		{
+			::OutputDebugStringW (
+				L"AvstpWrapper: cannot find avstp.dll."
+				L"Usage restricted to single threading.\n"
+			);
+//			throw std::runtime_error ("Cannot find avstp.dll.");
+			assign_fallback ();
+		}
+		else
+		{
+			assign_builtin ();
+		}
 	}
 }
 
@@ -216,6 +269,36 @@ void	AvstpWrapper::assign_normal ()
 
 
 
+void	AvstpWrapper::assign_builtin ()
+{
+	int				nbr_threads = ThreadPool::get_nbr_cpus ();
+	const char *	nbr_threads_0 = std::getenv ("MVTOOLS_AVSTP_THREADS");
+	if (nbr_threads_0 != 0 && std::atoi (nbr_threads_0) > 0)
+	{
+		nbr_threads = std::atoi (nbr_threads_0);
+	}
+
+	uint64_t			affinity_mask = 0;
+	const char *	affinity_0 = std::getenv ("MVTOOLS_AVSTP_AFFINITY");
+	if (affinity_0 != 0)
+	{
+		affinity_mask = std::strtoull (affinity_0, 0, 0);
+	}
+
+	_thread_pool_aptr = std::auto_ptr <ThreadPool> (
+		new ThreadPool (nbr_threads, affinity_mask)
+	);
+
+	_avstp_get_interface_version_ptr = &fallback_get_interface_version_ptr;
+	_avstp_create_dispatcher_ptr     = &builtin_create_dispatcher_ptr;
+	_avstp_destroy_dispatcher_ptr    = &builtin_destroy_dispatcher_ptr;
+	_avstp_get_nbr_threads_ptr       = &builtin_get_nbr_threads_ptr;
+	_avstp_enqueue_task_ptr          = &builtin_enqueue_task_ptr;
+	_avstp_wait_completion_ptr       = &builtin_wait_completion_ptr;
+}
+
+
+
 void	AvstpWrapper::assign_fallback ()
 {
 	_avstp_get_interface_version_ptr = &fallback_get_interface_version_ptr;
@@ -289,6 +372,45 @@ int	AvstpWrapper::fallback_wait_completion_ptr (avstp_TaskDispatcher *td_ptr)
 
 
 
+// The built-in functions are called only once the singleton is constructed.
+
+avstp_TaskDispatcher *	AvstpWrapper::builtin_create_dispatcher_ptr ()
+{
+	return (_singleton_aptr->_thread_pool_aptr->create_dispatcher ());
+}
+
+
+
+void	AvstpWrapper::builtin_destroy_dispatcher_ptr (avstp_TaskDispatcher *td_ptr)
+{
+	_singleton_aptr->_thread_pool_aptr->destroy_dispatcher (td_ptr);
+}
+
+
+
+int	AvstpWrapper::builtin_get_nbr_threads_ptr ()
+{
+	return (_singleton_aptr->_thread_pool_aptr->get_nbr_threads ());
+}
+
+
+
+int	AvstpWrapper::builtin_enqueue_task_ptr (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr)
+{
+	return (_singleton_aptr->_thread_pool_aptr->enqueue_task (
+		td_ptr, task_ptr, user_data_ptr
+	));
+}
+
+
+
+int	AvstpWrapper::builtin_wait_completion_ptr (avstp_TaskDispatcher *td_ptr)
+{
+	return (_singleton_aptr->_thread_pool_aptr->wait_completion (td_ptr));
+}
+
+
+
 std::auto_ptr <AvstpWrapper>	AvstpWrapper::_singleton_aptr;
 volatile bool	AvstpWrapper::_singleton_init_flag = false;
 
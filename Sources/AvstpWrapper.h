@@ -6,7 +6,16 @@
 A convenient wrapper on top of the AVSTP low-level API.
 Take care of:
 - Library discovery and initialisation
-- Fallback to mono-threaded mode if not found
+- Fallback to the built-in thread pool if not found
+
+The backend is selected at the first access, with environment variables:
+- MVTOOLS_AVSTP: "auto" (default, avstp.dll if found, built-in pool
+	otherwise), "dll" (avstp.dll, mono-threaded if not found), "builtin" or
+	"mono" (no multi-threading at all).
+- MVTOOLS_AVSTP_THREADS: number of threads of the built-in pool. Default is
+	the number of logical CPUs.
+- MVTOOLS_AVSTP_AFFINITY: CPU mask the built-in pool workers are bound to,
+	for example 0xFF for the first 8 logical CPUs. Default is no affinity.
 
 This is a singleton, you cannot construct it directly. Use use_instance()
 to access it from anywhere.
@@ -41,6 +50,10 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 
 
+class ThreadPool;
+
+
+
 class AvstpWrapper
 {
 
@@ -52,6 +65,7 @@ public:
 
 	static AvstpWrapper &
 						use_instance ();
+	static void		notify_process_exit ();
 
 	// Wrapped functions
 	int				get_interface_version () const;
@@ -80,6 +94,7 @@ private:
 	void				resolve_name (T &fnc_ptr, const char *name_0);
 
 	void				assign_normal ();
+	void				assign_builtin ();
 	void				assign_fallback ();
 
 	static int		fallback_get_interface_version_ptr ();
@@ -90,6 +105,13 @@ private:
 	static int		fallback_enqueue_task_ptr (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr);
 	static int		fallback_wait_completion_ptr (avstp_TaskDispatcher *td_ptr);
 
+	static avstp_TaskDispatcher *
+						builtin_create_dispatcher_ptr ();
+	static void		builtin_destroy_dispatcher_ptr (avstp_TaskDispatcher *td_ptr);
+	static int		builtin_get_nbr_threads_ptr ();
+	static int		builtin_enqueue_task_ptr (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr);
+	static int		builtin_wait_completion_ptr (avstp_TaskDispatcher *td_ptr);
+
 	int				(*_avstp_get_interface_version_ptr) ();
 	avstp_TaskDispatcher *
 						(*_avstp_create_dispatcher_ptr) ();
@@ -99,6 +121,8 @@ private:
 	int				(*_avstp_wait_completion_ptr) (avstp_TaskDispatcher *td_ptr);
 
 	void *			_dll_hnd;	// Avoids loading windows.h just for HMODULE
+	std::auto_ptr <ThreadPool>
+						_thread_pool_aptr;	// Built-in backend, 0 if not used
 
 	static std::auto_ptr <AvstpWrapper>
                   _singleton_aptr;
@@ -19,9 +19,9 @@
 
 
 
-#include	"conc/CritSec.h"
 #include "DCTFFTW.h"
 
+#include <emmintrin.h>
 #include <mmintrin.h>
 
 #include	<algorithm>
@@ -30,18 +30,24 @@
 
 
 
-conc::Mutex	DCTFFTW::_fftw_mutex;
+// Float to int conversion matching the scalar code used before: FPU rounding
+// (to nearest) on 32-bit builds, truncation on 64-bit builds.
+#if !defined(_WIN64)
+	#define	DCTFFTW_CVT_PS(x)	_mm_cvtps_epi32 (x)
+	#define	DCTFFTW_CVT_SS(x)	_mm_cvtss_si32 (x)
+#else
+	#define	DCTFFTW_CVT_PS(x)	_mm_cvttps_epi32 (x)
+	#define	DCTFFTW_CVT_SS(x)	_mm_cvttss_si32 (x)
+#endif
 
 
 
-DCTFFTW::DCTFFTW(int _sizex, int _sizey, HINSTANCE hinstFFTW3, int _dctmode) 
+DCTFFTW::DCTFFTW(int _sizex, int _sizey, int _dctmode)
+:	fftwlib (FftwLib::use_instance ())
+,	fSrc (0)
+,	dctplan (0)
+,	fSrcDCT (0)
 {
-	fftwf_free_addr = (fftwf_free_proc) GetProcAddress(hinstFFTW3, "fftwf_free"); 
-	fftwf_malloc_addr = (fftwf_malloc_proc)GetProcAddress(hinstFFTW3, "fftwf_malloc"); 
-	fftwf_destroy_plan_addr = (fftwf_destroy_plan_proc) GetProcAddress(hinstFFTW3, "fftwf_destroy_plan");
-	fftwf_plan_r2r_2d_addr = (fftwf_plan_r2r_2d_proc) GetProcAddress(hinstFFTW3, "fftwf_plan_r2r_2d");
-	fftwf_execute_r2r_addr = (fftwf_execute_r2r_proc) GetProcAddress(hinstFFTW3, "fftwf_execute_r2r");
-
 	sizex = _sizex;
 	sizey = _sizey;
 	dctmode = _dctmode;
@@ -58,35 +64,54 @@ DCTFFTW::DCTFFTW(int _sizex, int _sizey, HINSTANCE hinstFFTW3, int _dctmode)
 
 	dctshift0 = dctshift + 2;
 
-	// FFTW plan construction and destruction are not thread-safe.
-	// http://www.fftw.org/fftw3_doc/Thread-safety.html#Thread-safety
-	conc::CritSec	lock (_fftw_mutex);
+	// The plan is shared by all the instances of the same size and is created
+	// only once. fftwf_malloc is thread-safe, unlike the planner.
+	dctplan = fftwlib.use_plan_dct_2d (sizex, sizey); // direct fft 
 
-	fSrc = (float *)fftwf_malloc_addr(sizeof(float) * size2d );
-	fSrcDCT = (float *)fftwf_malloc_addr(sizeof(float) * size2d );
-
-	dctplan = fftwf_plan_r2r_2d_addr(sizey, sizex, fSrc, fSrcDCT, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE); // direct fft 
+	fSrc = fftwlib.alloc_buf (size2d);
+	try
+	{
+		fSrcDCT = fftwlib.alloc_buf (size2d);
+	}
+	catch (...)
+	{
+		fftwlib.free_buf (fSrc);
+		throw;
+	}
 }
 
 
 
 DCTFFTW::~DCTFFTW()
 {
-	conc::CritSec	lock (_fftw_mutex);
-
-	fftwf_destroy_plan_addr(dctplan);
-	fftwf_free_addr(fSrc);
-	fftwf_free_addr(fSrcDCT);
+	fftwlib.free_buf (fSrc);
+	fftwlib.free_buf (fSrcDCT);
 }
 
 //  put source data to real array for FFT
 void DCTFFTW::Bytes2Float (const unsigned char * srcp, int src_pitch, float * realdata)
 {
+	const __m128i zero = _mm_setzero_si128 ();
 	int floatpitch = sizex;
+	const int w8 = sizex & ~7;
+	const int w4 = sizex & ~3;
 	int i, j;
 	for (j = 0; j < sizey; j++)
 	{ 
-		for (i = 0; i < sizex; i+=1)
+		for (i = 0; i < w8; i+=8)
+		{
+			const __m128i b = _mm_loadl_epi64 (reinterpret_cast <const __m128i *> (srcp + i));
+			const __m128i w = _mm_unpacklo_epi8 (b, zero);
+			_mm_storeu_ps (realdata + i,     _mm_cvtepi32_ps (_mm_unpacklo_epi16 (w, zero)));
+			_mm_storeu_ps (realdata + i + 4, _mm_cvtepi32_ps (_mm_unpackhi_epi16 (w, zero)));
+		}
+		for ( ; i < w4; i+=4)
+		{
+			const __m128i b = _mm_cvtsi32_si128 (*reinterpret_cast <const int *> (srcp + i));
+			const __m128i w = _mm_unpacklo_epi8 (b, zero);
+			_mm_storeu_ps (realdata + i, _mm_cvtepi32_ps (_mm_unpacklo_epi16 (w, zero)));
+		}
+		for ( ; i < sizex; i+=1)
 		{
 			realdata[i] = srcp[i];
 		}
@@ -96,48 +121,42 @@ void DCTFFTW::Bytes2Float (const unsigned char * srcp, int src_pitch, float * re
 }
 
 //  put source data to real array for FFT
+// The scaling, rounding, shift and saturation are done 4 coefficients at a
+// time. The DC coefficient has its own scaling and is fixed afterwards.
 void DCTFFTW::Float2Bytes (unsigned char * dstp, int dst_pitch, float * realdata)
 {
+	const __m128 mul = _mm_set1_ps (0.707f); // to be compatible with integer DCTINT8
+	const __m128i shift = _mm_cvtsi32_si128 (dctshift);
+	const __m128i bias = _mm_set1_epi32 (128);
 	int floatpitch = sizex;
+	const int w4 = sizex & ~3;
 	int i, j;
-	int integ;
-	float f = realdata[0]*0.5f; // to be compatible with integer DCTINT8
-#if !defined(_WIN64)
-	_asm fld f; 
-	_asm fistp integ; // fast conversion
-#else
-	integ = (int)f;
-#endif
-	dstp[0] = std::min(255, std::max(0, (integ>>dctshift0) + 128)); // DC
-	for (i = 1; i < sizex; i+=1)
-	{
-		f = realdata[i]*0.707f; // to be compatible with integer DCTINT8
-#if !defined(_WIN64)
-		_asm fld f; 
-		_asm fistp integ; // fast conversion
-#else
-		integ = (int)f;
-#endif
-		dstp[i] = std::min(255, std::max(0, (integ>>dctshift) + 128));
-	}
-	dstp += dst_pitch;
-	realdata += floatpitch;
-	for (j = 1; j < sizey; j++)
+
+	float * realdata0 = realdata;
+	unsigned char * dstp0 = dstp;
+
+	for (j = 0; j < sizey; j++)
 	{ 
-		for (i = 0; i < sizex; i+=1)
+		for (i = 0; i < w4; i+=4)
 		{
-			f = realdata[i]*0.707f; // to be compatible with integer DCTINT8
-#if !defined(_WIN64)
-			_asm fld f; 
-			_asm fistp integ; // fast conversion
-#else
-			integ = (int)f;
-#endif
+			const __m128 f = _mm_mul_ps (_mm_loadu_ps (realdata + i), mul);
+			__m128i integ = DCTFFTW_CVT_PS (f);
+			integ = _mm_add_epi32 (_mm_sra_epi32 (integ, shift), bias);
+			integ = _mm_packs_epi32 (integ, integ);
+			integ = _mm_packus_epi16 (integ, integ);
+			*reinterpret_cast <int *> (dstp + i) = _mm_cvtsi128_si32 (integ);
+		}
+		for ( ; i < sizex; i+=1)
+		{
+			const int integ = DCTFFTW_CVT_SS (_mm_mul_ss (_mm_load_ss (realdata + i), mul));
 			dstp[i] = std::min(255, std::max(0, (integ>>dctshift) + 128));
 		}
 		dstp += dst_pitch;
 		realdata += floatpitch;
 	}
+
+	const int integ = DCTFFTW_CVT_SS (_mm_set_ss (realdata0[0]*0.5f)); // to be compatible with integer DCTINT8
+	dstp0[0] = std::min(255, std::max(0, (integ>>dctshift0) + 128)); // DC
 }
 
 
@@ -145,7 +164,7 @@ void DCTFFTW::DCTBytes2D(const unsigned char *srcp, int src_pitch, unsigned char
 {
 	_mm_empty ();
 	Bytes2Float (srcp, src_pitch, fSrc);
-	fftwf_execute_r2r_addr(dctplan, fSrc, fSrcDCT);
+	fftwlib.execute_r2r (dctplan, fSrc, fSrcDCT);
 	Float2Bytes (dctp, dct_pitch, fSrcDCT);
 
 }
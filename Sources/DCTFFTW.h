@@ -20,27 +20,18 @@
 #ifndef __MV_DCTFFTW__
 #define __MV_DCTFFTW__
 
-#include	"conc/Mutex.h"
 #include "DCTClass.h"
-#include "fftwlite.h"
-
-#define	NOGDI
-#define	NOMINMAX
-#define	WIN32_LEAN_AND_MEAN
-#include "windows.h"
+#include "FftwLib.h"
 
 
 
+// Instances share the plan of their size, held by FftwLib. Only the arrays
+// are private, so several instances can run concurrently.
 class DCTFFTW
 :	public DCTClass
 {
 
-	HINSTANCE hinstFFTW3;
-	fftwf_malloc_proc fftwf_malloc_addr;
-	fftwf_free_proc fftwf_free_addr;
-	fftwf_plan_r2r_2d_proc fftwf_plan_r2r_2d_addr;
-	fftwf_destroy_plan_proc fftwf_destroy_plan_addr;
-	fftwf_execute_r2r_proc fftwf_execute_r2r_addr;
+	FftwLib & fftwlib;
 
 	float * fSrc;
 	fftwf_plan dctplan;
@@ -55,12 +46,9 @@ class DCTFFTW
 	void Bytes2Float(const unsigned char * srcp0, int _pitch, float * realdata);
 	void Float2Bytes(unsigned char * srcp0, int _pitch, float * realdata);
 
-	static conc::Mutex
-						_fftw_mutex;
-
 public:
 
-	DCTFFTW(int _sizex, int _sizey, ::HINSTANCE _hFFTW3, int _dctmode);
+	DCTFFTW(int _sizex, int _sizey, int _dctmode);
 	~DCTFFTW();
 	void DCTBytes2D(const unsigned char *srcp0, int _src_pitch, unsigned char *dctp, int _dct_pitch);
 
@@ -34,6 +34,11 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 #include	"DCTFactory.h"
 #include	"DCTFFTW.h"
 #include	"DCTINT.h"
+#include	"DCTIntSse2.h"
+#include	"FftwLib.h"
+#include	"FuncDispatch.h"
+
+#include	<exception>
 
 #include	<cassert>
 
@@ -44,19 +49,28 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 
 DCTFactory::DCTFactory (int dctmode, bool isse, int blksizex, int blksizey, ::IScriptEnvironment &env)
-:	_fftw_hnd (0)
-,	_dctmode (dctmode)
+:	_dctmode (dctmode)
 ,	_isse (isse)
 ,	_blksizex (blksizex)
 ,	_blksizey (blksizey)
-,	_fftw_flag (! (_isse && _blksizex == 8 && _blksizey == 8))
+,	_int_flag (
+		   _isse && ! (_blksizex == 8 && _blksizey == 8)
+		&& FuncDispatch::select_tier (_isse) >= FuncDispatch::Tier_SSE2
+		&& DCTIntSse2::is_size_supported (_blksizex, _blksizey)
+	)
+,	_fftw_flag (! (_isse && _blksizex == 8 && _blksizey == 8) && ! _int_flag)
 {
 	assert (dctmode != 0);
 
 	if (_fftw_flag)
 	{
-		_fftw_hnd = ::LoadLibrary ("fftw3.dll"); // delayed loading
-		if (_fftw_hnd == 0)
+		// Loads the library and builds the plan now, so the instances
+		// created later by the pool just have to allocate their arrays.
+		try
+		{
+			FftwLib::use_instance ().use_plan_dct_2d (_blksizex, _blksizey);
+		}
+		catch (std::exception &)
 		{
 			env.ThrowError ("MAnalyse: Can not load FFTW3.DLL!");
 		}
@@ -67,11 +81,7 @@ DCTFactory::DCTFactory (int dctmode, bool isse, int blksizex, int blksizey, ::IS
 
 DCTFactory::~DCTFactory ()
 {
-	if (_fftw_hnd != 0)
-	{
-		::FreeLibrary (_fftw_hnd);
-		_fftw_hnd = 0;
-	}
+	// Nothing. The FFTW library and its plans are kept for the whole process.
 }
 
 
@@ -98,7 +108,12 @@ DCTClass *	DCTFactory::do_create ()
 {
 	if (_fftw_flag)
 	{
-		return (new DCTFFTW (_blksizex, _blksizey, _fftw_hnd, _dctmode));
+		return (new DCTFFTW (_blksizex, _blksizey, _dctmode));
+	}
+
+	if (_int_flag)
+	{
+		return (new DCTIntSse2 (_blksizex, _blksizey, _dctmode));
 	}
 
 	return (new DCTINT (_blksizex, _blksizey, _dctmode));
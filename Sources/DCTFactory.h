@@ -27,15 +27,9 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 /*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
 
-#define	NOMINMAX
-#define	NOGDI
-#define	WIN32_LEAN_AND_MEAN
-
 #include	"conc/ObjFactoryInterface.h"
 #include	"DCTClass.h"
 
-#include	<windows.h>
-
 
 
 class IScriptEnvironment;
@@ -70,11 +64,11 @@ protected:
 
 private:
 
-	::HINSTANCE		_fftw_hnd;
 	const int		_dctmode;
 	const int		_blksizex;
 	const int		_blksizey;
 	const bool		_isse;
+	const bool		_int_flag;		// DCTIntSse2 instead of FFTW
 	const bool		_fftw_flag;
 
 
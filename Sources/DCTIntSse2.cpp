@@ -0,0 +1,335 @@
+/*****************************************************************************
+
+        DCTIntSse2.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"DCTIntSse2.h"
+
+#include	<emmintrin.h>
+
+#include	<algorithm>
+
+#include	<cassert>
+#include	<cmath>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+DCTIntSse2::DCTIntSse2 (int sizex, int sizey, int dctmode)
+:	_log2_w (compute_log2 (sizex))
+,	_log2_h (compute_log2 (sizey))
+,	_stride (std::max (sizex, 8))
+,	_frac_row (0)
+,	_coef_row_arr ()
+,	_coef_col_arr ()
+,	_work_arr ()
+{
+	assert (is_size_supported (sizex, sizey));
+
+	this->sizex   = sizex;
+	this->sizey   = sizey;
+	this->dctmode = dctmode;
+
+	// Centered pixels are in [-128; 127], so a row sum fits in 16 bits with
+	// 8 - log2 (sizex) fractional bits.
+	_frac_row = 8 - _log2_w;
+
+	const double	pi = 3.1415926535897932384626433832795;
+	const double	scale = double (1 << COEF_BITS);
+
+	_coef_row_arr.resize (sizex * _stride, 0);
+	for (int kx = 0; kx < sizex; ++kx)
+	{
+		for (int x = 0; x < sizex; ++x)
+		{
+			const double	c = cos (pi * (2 * x + 1) * kx / (2 * sizex));
+			_coef_row_arr [kx * _stride + x] =
+				int16_t (floor (c * scale + 0.5));
+		}
+	}
+
+	const int		nbr_pairs = sizey >> 1;
+	_coef_col_arr.resize (sizey * nbr_pairs);
+	for (int ky = 0; ky < sizey; ++ky)
+	{
+		for (int p = 0; p < nbr_pairs; ++p)
+		{
+			int				c_arr [2];
+			for (int k = 0; k < 2; ++k)
+			{
+				const int		y = p * 2 + k;
+				const double	c = cos (pi * (2 * y + 1) * ky / (2 * sizey));
+				c_arr [k] = int (floor (c * 0.707 * scale + 0.5));	// 0.707 as in DCTFFTW
+			}
+			_coef_col_arr [ky * nbr_pairs + p] =
+				(c_arr [0] & 0xFFFF) | (c_arr [1] << 16);
+		}
+	}
+
+	// The padding columns must be clean, they are processed with the others
+	_work_arr.resize (sizey * _stride, 0);
+}
+
+
+
+// All the power-of-2 sizes from 4x2 to 32x32.
+bool	DCTIntSse2::is_size_supported (int sizex, int sizey)
+{
+	return (   sizex >= MIN_SIZE_X && sizex <= MAX_SIZE && (sizex & (sizex - 1)) == 0
+	        && sizey >= MIN_SIZE_Y && sizey <= MAX_SIZE && (sizey & (sizey - 1)) == 0);
+}
+
+
+
+void	DCTIntSse2::DCTBytes2D (const unsigned char *srcp0, int _src_pitch, unsigned char *dctp, int _dct_pitch)
+{
+	assert (srcp0 != 0);
+	assert (dctp != 0);
+
+	transform_rows (srcp0, _src_pitch);
+	transform_cols (dctp, _dct_pitch);
+	compute_dc (dctp);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Each row is multiplied by the coefficient matrix, 4 outputs at a time:
+// the pmaddwd partial sums of 4 coefficient rows are reduced together.
+void	DCTIntSse2::transform_rows (const uint8_t *src_ptr, int src_stride)
+{
+	const __m128i	zero = _mm_setzero_si128 ();
+	const __m128i	c128 = _mm_set1_epi16 (128);
+	const int		shift = COEF_BITS - _frac_row;
+	const __m128i	rnd  = _mm_set1_epi32 (1 << (shift - 1));
+	const int		nbr_chunks = _stride >> 3;
+
+	for (int y = 0; y < sizey; ++y)
+	{
+		// Centered pixels. With sizex = 4, the 4 last ones are garbage but
+		// their coefficients are null.
+		__m128i			pix_arr [MAX_SIZE / 8];
+		if (sizex == 4)
+		{
+			const __m128i	b = _mm_cvtsi32_si128 (
+				*reinterpret_cast <const int *> (src_ptr)
+			);
+			pix_arr [0] = _mm_sub_epi16 (_mm_unpacklo_epi8 (b, zero), c128);
+		}
+		else if (sizex == 8)
+		{
+			const __m128i	b = _mm_loadl_epi64 (
+				reinterpret_cast <const __m128i *> (src_ptr)
+			);
+			pix_arr [0] = _mm_sub_epi16 (_mm_unpacklo_epi8 (b, zero), c128);
+		}
+		else
+		{
+			for (int x = 0; x < sizex; x += 16)
+			{
+				const __m128i	b = _mm_loadu_si128 (
+					reinterpret_cast <const __m128i *> (src_ptr + x)
+				);
+				pix_arr [(x >> 3)    ] = _mm_sub_epi16 (_mm_unpacklo_epi8 (b, zero), c128);
+				pix_arr [(x >> 3) + 1] = _mm_sub_epi16 (_mm_unpackhi_epi8 (b, zero), c128);
+			}
+		}
+
+		int16_t *		dst_ptr = &_work_arr [y * _stride];
+		for (int kx = 0; kx < sizex; kx += 4)
+		{
+			const int16_t *	coef_ptr = &_coef_row_arr [kx * _stride];
+			__m128i			a0 = zero;
+			__m128i			a1 = zero;
+			__m128i			a2 = zero;
+			__m128i			a3 = zero;
+			for (int c = 0; c < nbr_chunks; ++c)
+			{
+				const __m128i	p = pix_arr [c];
+				const __m128i *	cc_ptr =
+					reinterpret_cast <const __m128i *> (coef_ptr + c * 8);
+				const int		cs = _stride >> 3;	// Coefficient row, in __m128i
+				a0 = _mm_add_epi32 (a0, _mm_madd_epi16 (p, _mm_load_si128 (cc_ptr         )));
+				a1 = _mm_add_epi32 (a1, _mm_madd_epi16 (p, _mm_load_si128 (cc_ptr + cs    )));
+				a2 = _mm_add_epi32 (a2, _mm_madd_epi16 (p, _mm_load_si128 (cc_ptr + cs * 2)));
+				a3 = _mm_add_epi32 (a3, _mm_madd_epi16 (p, _mm_load_si128 (cc_ptr + cs * 3)));
+			}
+
+			// Horizontal sums: a0, a1, a2, a3 -> one lane each
+			const __m128i	t0 = _mm_add_epi32 (
+				_mm_unpacklo_epi32 (a0, a1), _mm_unpackhi_epi32 (a0, a1)
+			);
+			const __m128i	t1 = _mm_add_epi32 (
+				_mm_unpacklo_epi32 (a2, a3), _mm_unpackhi_epi32 (a2, a3)
+			);
+			__m128i			s = _mm_add_epi32 (
+				_mm_unpacklo_epi64 (t0, t1), _mm_unpackhi_epi64 (t0, t1)
+			);
+
+			s = _mm_srai_epi32 (_mm_add_epi32 (s, rnd), shift);
+			_mm_storel_epi64 (
+				reinterpret_cast <__m128i *> (dst_ptr + kx),
+				_mm_packs_epi32 (s, s)
+			);
+		}
+
+		src_ptr += src_stride;
+	}
+}
+
+
+
+// 8 columns at a time. Rows are interleaved by pairs once, then each output
+// row is a sum of pmaddwd with the coefficient pairs.
+// The products are scaled down before the accumulation to stay within 32
+// bits. The precision loss is negligible compared to the final shift.
+// Output is computed for the DC too, it is overwritten later.
+void	DCTIntSse2::transform_cols (uint8_t *dst_ptr, int dst_stride) const
+{
+	const int		nbr_pairs  = sizey >> 1;
+	const int		prod_shift = _log2_h - 1;
+	const int		log2_size  = _log2_w + _log2_h;
+
+	// acc has OUT_SHIFT - log2_size fractional bits. Scaling by 4 and rounding
+	// like DCTFFTW happen before the shift: to nearest on 32-bit builds,
+	// toward 0 on 64-bit builds.
+#if ! defined (_WIN64)
+	const __m128i	rnd  = _mm_set1_epi32 (1 << (OUT_SHIFT - 1 - log2_size));
+#else
+	const __m128i	rnd  = _mm_set1_epi32 ((1 << (OUT_SHIFT - log2_size)) - 1);
+#endif
+	const __m128i	sign = _mm_set1_epi8 (-128);
+
+	__m128i			row_arr [MAX_SIZE];	// Interleaved rows, lo/hi for each pair
+
+	for (int x = 0; x < sizex; x += 8)
+	{
+		const int16_t *	src_ptr = &_work_arr [x];
+		for (int p = 0; p < nbr_pairs; ++p)
+		{
+			const __m128i	r0 = _mm_load_si128 (
+				reinterpret_cast <const __m128i *> (src_ptr + (p * 2    ) * _stride)
+			);
+			const __m128i	r1 = _mm_load_si128 (
+				reinterpret_cast <const __m128i *> (src_ptr + (p * 2 + 1) * _stride)
+			);
+			row_arr [p * 2    ] = _mm_unpacklo_epi16 (r0, r1);
+			row_arr [p * 2 + 1] = _mm_unpackhi_epi16 (r0, r1);
+		}
+
+		uint8_t *		d_ptr = dst_ptr + x;
+		const int *		coef_ptr = &_coef_col_arr [0];
+		for (int ky = 0; ky < sizey; ++ky)
+		{
+			__m128i			acc_lo = _mm_setzero_si128 ();
+			__m128i			acc_hi = _mm_setzero_si128 ();
+			for (int p = 0; p < nbr_pairs; ++p)
+			{
+				const __m128i	c = _mm_set1_epi32 (coef_ptr [p]);
+				acc_lo = _mm_add_epi32 (acc_lo, _mm_srai_epi32 (
+					_mm_madd_epi16 (row_arr [p * 2    ], c), prod_shift
+				));
+				acc_hi = _mm_add_epi32 (acc_hi, _mm_srai_epi32 (
+					_mm_madd_epi16 (row_arr [p * 2 + 1], c), prod_shift
+				));
+			}
+			coef_ptr += nbr_pairs;
+
+#if ! defined (_WIN64)
+			acc_lo = _mm_add_epi32 (acc_lo, rnd);
+			acc_hi = _mm_add_epi32 (acc_hi, rnd);
+#else
+			// Negative values only
+			acc_lo = _mm_add_epi32 (acc_lo, _mm_and_si128 (_mm_srai_epi32 (acc_lo, 31), rnd));
+			acc_hi = _mm_add_epi32 (acc_hi, _mm_and_si128 (_mm_srai_epi32 (acc_hi, 31), rnd));
+#endif
+			acc_lo = _mm_srai_epi32 (acc_lo, OUT_SHIFT);
+			acc_hi = _mm_srai_epi32 (acc_hi, OUT_SHIFT);
+
+			// Saturation to [-128 ; 127] then offset by 128
+			__m128i			v = _mm_packs_epi32 (acc_lo, acc_hi);
+			v = _mm_packs_epi16 (v, v);
+			v = _mm_xor_si128 (v, sign);
+
+			if (sizex == 4)
+			{
+				*reinterpret_cast <int *> (d_ptr) = _mm_cvtsi128_si32 (v);
+			}
+			else
+			{
+				_mm_storel_epi64 (reinterpret_cast <__m128i *> (d_ptr), v);
+			}
+
+			d_ptr += dst_stride;
+		}
+	}
+}
+
+
+
+// The first column of the row transform is the exact sum of each row,
+// because the DC coefficient is a power of 2. The DC is computed like in
+// DCTFFTW::Float2Bytes: 4 * sum * 0.5 >> (log2 (size) + 2).
+void	DCTIntSse2::compute_dc (uint8_t *dst_ptr) const
+{
+	int				sum = 0;
+	for (int y = 0; y < sizey; ++y)
+	{
+		sum += _work_arr [y * _stride];
+	}
+	sum >>= _frac_row;
+	sum += 128 << (_log2_w + _log2_h);
+
+	const int		dc = ((sum * 2) >> (_log2_w + _log2_h + 2)) + 128;
+	dst_ptr [0] = uint8_t (std::min (std::max (dc, 0), 255));
+}
+
+
+
+int	DCTIntSse2::compute_log2 (int x)
+{
+	assert (x > 0);
+
+	int				l = 0;
+	while ((1 << l) < x)
+	{
+		++ l;
+	}
+
+	return (l);
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
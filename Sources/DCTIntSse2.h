@@ -0,0 +1,136 @@
+/*****************************************************************************
+
+        DCTIntSse2.h
+        Author: agent, 2026
+
+Integer 2D DCT-II for the power-of-2 block sizes from 4x2 to 32x32, using
+SSE2. It does not need FFTW.
+
+The output has the same normalisation as DCTFFTW: the DC coefficient is
+scaled by 0.5 / (4 * size) and the others by 0.707 / size, then they are
+offset by 128 and saturated to bytes. The DC is exact. Before the shift,
+the other coefficients are rounded like the DCTFFTW code: to the nearest
+integer on 32-bit builds, toward 0 on 64-bit builds. They may rarely differ
+by one because of the fixed-point arithmetic.
+
+The transform is separable and computed with matrix products: rows first,
+stored as 16-bit data with as many fractional bits as the block width
+allows, then columns with 32-bit accumulators. Pixels are centered on 0
+to get one more bit of precision.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (DCTIntSse2_HEADER_INCLUDED)
+#define	DCTIntSse2_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"AllocAlign.h"
+#include	"DCTClass.h"
+#include	"types.h"
+
+#include	<vector>
+
+
+
+class DCTIntSse2
+:	public DCTClass
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			MIN_SIZE_X	=  4	};
+	enum {			MIN_SIZE_Y	=  2	};
+	enum {			MAX_SIZE		= 32	};
+
+						DCTIntSse2 (int sizex, int sizey, int dctmode);
+	virtual			~DCTIntSse2 () {}
+
+	static bool		is_size_supported (int sizex, int sizey);
+
+	// DCTClass
+	virtual void	DCTBytes2D (const unsigned char *srcp0, int _src_pitch, unsigned char *dctp, int _dct_pitch);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	enum {			COEF_BITS	= 14	};	// Fractional bits of the coefficients
+	enum {			OUT_SHIFT	= 21	};	// Final shift, whatever the size
+
+	typedef	std::vector <int16_t, AllocAlign <int16_t, 16> >	Int16Array;
+	typedef	std::vector <int, AllocAlign <int, 16> >	IntArray;
+
+	void				transform_rows (const uint8_t *src_ptr, int src_stride);
+	void				transform_cols (uint8_t *dst_ptr, int dst_stride) const;
+	void				compute_dc (uint8_t *dst_ptr) const;
+
+	static int		compute_log2 (int x);
+
+	int				_log2_w;
+	int				_log2_h;
+	int				_stride;			// Of the work area and _coef_row_arr, in int16_t. Multiple of 8
+	int				_frac_row;		// Fractional bits of the row transform results
+
+	// Row coefficients, [kx * _stride + x], zero-padded
+	Int16Array		_coef_row_arr;
+
+	// Column coefficients (including the 0.707 scale) as pairs of int16_t,
+	// [ky * (sizey / 2) + y / 2]. Low half is for row y, high half for y + 1.
+	IntArray			_coef_col_arr;
+
+	// Row transform results, [y * _stride + kx]
+	Int16Array		_work_arr;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						DCTIntSse2 ();
+						DCTIntSse2 (const DCTIntSse2 &other);
+	DCTIntSse2 &	operator = (const DCTIntSse2 &other);
+	bool				operator == (const DCTIntSse2 &other) const;
+	bool				operator != (const DCTIntSse2 &other) const;
+
+};	// class DCTIntSse2
+
+
+
+//#include	"DCTIntSse2.hpp"
+
+
+
+#endif	// DCTIntSse2_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
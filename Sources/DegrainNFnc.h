@@ -0,0 +1,287 @@
+#ifndef __MV_DEGRAINN_FNC__
+#define __MV_DEGRAINN_FNC__
+
+
+
+#define	NOMINMAX
+#define	NOGDI
+#define	WIN32_LEAN_AND_MEAN
+
+#include	<windows.h>
+
+#include	<emmintrin.h>
+#include	<mmintrin.h>
+
+
+
+// Maximum temporal radius handled by the kernels
+enum { DegrainN_MAX_TRAD = 128 };
+
+typedef void (DegrainNFunction) (
+	BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
+	const BYTE *pSrc, int nSrcPitch,
+	// 2*k = ref backwards, 2*k+1 = ref forwards
+	const BYTE *pRef [], int Pitch [],
+	// 0 = src, 2*k+1 = ref backwards, 2*k+2 = ref forwards
+	int Wall [], int trad
+);
+
+
+
+template <int blockWidth, int blockHeight>
+void DegrainN_C (
+	BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
+	const BYTE *pSrc, int nSrcPitch,
+	const BYTE *pRef [], int Pitch [],
+	int Wall [], int trad
+)
+{
+	if (lsb_flag)
+	{
+		for (int h = 0; h < blockHeight; ++h)
+		{
+			for (int x = 0; x < blockWidth; ++x)
+			{
+				int				val = pSrc [x] * Wall [0];
+				for (int k = 0; k < trad; ++k)
+				{
+					val +=   pRef [k*2    ] [x] * Wall [k*2 + 1]
+					       + pRef [k*2 + 1] [x] * Wall [k*2 + 2];
+				}
+				
+				pDst [x]    = val >> 8;
+				pDstLsb [x] = val & 255;
+			}
+
+			pDst    += nDstPitch;
+			pDstLsb += nDstPitch;
+			pSrc    += nSrcPitch;
+			for (int k = 0; k < trad; ++k)
+			{
+				pRef [k*2    ] += Pitch [k*2    ];
+				pRef [k*2 + 1] += Pitch [k*2 + 1];
+			}
+		}
+	}
+
+	else
+	{
+		for (int h = 0; h < blockHeight; ++h)
+		{
+			for (int x = 0; x < blockWidth; ++x)
+			{
+				int				val = pSrc [x] * Wall [0] + 128;
+				for (int k = 0; k < trad; ++k)
+				{
+					val +=   pRef [k*2    ] [x] * Wall [k*2 + 1]
+					       + pRef [k*2 + 1] [x] * Wall [k*2 + 2];
+				}
+				pDst[x] = val >> 8;
+			}
+
+			pDst += nDstPitch;
+			pSrc += nSrcPitch;
+			for (int k = 0; k < trad; ++k)
+			{
+				pRef [k*2    ] += Pitch [k*2    ];
+				pRef [k*2 + 1] += Pitch [k*2 + 1];
+			}
+		}
+	}
+}
+
+
+
+template <int blockWidth, int blockHeight>
+void DegrainN_mmx (
+	BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
+	const BYTE *pSrc, int nSrcPitch,
+	const BYTE *pRef [], int Pitch [],
+	int Wall [], int trad
+)
+{
+	const __m64			z = _mm_setzero_si64();
+
+	if (lsb_flag)
+	{
+		const __m64			m = _mm_set1_pi16 (255);
+
+		for (int h = 0; h < blockHeight; ++h)
+		{
+			for (int x = 0; x < blockWidth; x += 4)
+			{
+				__m64				val = _m_pmullw (
+					_m_punpcklbw (*(__m64 *) (pSrc + x), z),
+					_mm_set1_pi16 (Wall [0])
+				);
+				for (int k = 0; k < trad; ++k)
+				{
+					const __m64		s1 = _m_pmullw (
+						_m_punpcklbw (*(__m64 *) (pRef [k * 2    ] + x), z),
+						_mm_set1_pi16 (Wall [k * 2 + 1])
+					);
+					const __m64		s2 = _m_pmullw (
+						_m_punpcklbw (*(__m64 *) (pRef [k * 2 + 1] + x), z),
+						_mm_set1_pi16 (Wall [k * 2 + 2])
+					);
+					val = _m_paddw (val, s1);
+					val = _m_paddw (val, s2);
+				}
+				*(int *)(pDst    + x) =
+					_m_to_int (_m_packuswb (_m_psrlwi    (val, 8), z));
+				*(int *)(pDstLsb + x) =
+					_m_to_int (_m_packuswb (_mm_and_si64 (val, m), z));
+			}
+
+			pDst    += nDstPitch;
+			pDstLsb += nDstPitch;
+			pSrc    += nSrcPitch;
+			for (int k = 0; k < trad; ++k)
+			{
+				pRef [k*2    ] += Pitch [k*2    ];
+				pRef [k*2 + 1] += Pitch [k*2 + 1];
+			}
+		}
+	}
+
+	else
+	{
+		const __m64		o = _mm_set1_pi16 (128);
+
+		for (int h = 0; h < blockHeight; ++h)
+		{
+			for (int x = 0; x < blockWidth; x += 4)
+			{
+				__m64				val = _m_paddw (_m_pmullw (
+					_m_punpcklbw (*(__m64 *) (pSrc + x), z),
+					_mm_set1_pi16 (Wall [0])
+				), o);
+				for (int k = 0; k < trad; ++k)
+				{
+					const __m64		s1 = _m_pmullw (
+						_m_punpcklbw (*(__m64 *) (pRef [k * 2    ] + x), z),
+						_mm_set1_pi16 (Wall [k * 2 + 1])
+					);
+					const __m64		s2 = _m_pmullw (
+						_m_punpcklbw (*(__m64 *) (pRef [k * 2 + 1] + x), z),
+						_mm_set1_pi16 (Wall [k * 2 + 2])
+					);
+					val = _m_paddw (val, s1);
+					val = _m_paddw (val, s2);
+				}
+				*(int *)(pDst + x) =
+					_m_to_int (_m_packuswb (_m_psrlwi (val, 8), z));
+			}
+
+			pDst += nDstPitch;
+			pSrc += nSrcPitch;
+			for (int k = 0; k < trad; ++k)
+			{
+				pRef [k*2    ] += Pitch [k*2    ];
+				pRef [k*2 + 1] += Pitch [k*2 + 1];
+			}
+		}
+	}
+
+	_m_empty ();
+}
+
+
+
+// The rows are processed in a single pass per reference, with all the
+// 8-pixel groups of the row kept in registers. The weights are broadcast once
+// per block.
+template <int blockWidth, int blockHeight, bool lsb_flag>
+void DegrainN_sse2_proc (
+	BYTE *pDst, BYTE *pDstLsb, int nDstPitch,
+	const BYTE *pSrc, int nSrcPitch,
+	const BYTE *pRef [], int Pitch [],
+	int Wall [], int trad
+)
+{
+	enum { NBR_GRP = blockWidth / 8 };
+
+	const __m128i	z = _mm_setzero_si128 ();
+	const __m128i	m = _mm_set1_epi16 (255);
+	const __m128i	o = _mm_set1_epi16 (lsb_flag ? 0 : 128);
+
+	__m128i			w_arr [1 + DegrainN_MAX_TRAD * 2];
+	for (int k = 0; k <= trad * 2; ++k)
+	{
+		w_arr [k] = _mm_set1_epi16 (Wall [k]);
+	}
+
+	for (int h = 0; h < blockHeight; ++h)
+	{
+		__m128i			val [NBR_GRP];
+		for (int g = 0; g < NBR_GRP; ++g)
+		{
+			val [g] = _mm_add_epi16 (_mm_mullo_epi16 (
+				_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pSrc + g * 8)), z),
+				w_arr [0]
+			), o);
+		}
+		for (int k = 0; k < trad * 2; ++k)
+		{
+			const __m128i	w = w_arr [k + 1];
+			for (int g = 0; g < NBR_GRP; ++g)
+			{
+				val [g] = _mm_add_epi16 (val [g], _mm_mullo_epi16 (
+					_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pRef [k] + g * 8)), z),
+					w
+				));
+			}
+		}
+
+		for (int g = 0; g < NBR_GRP; ++g)
+		{
+			_mm_storel_epi64 (
+				(__m128i*)(pDst + g * 8),
+				_mm_packus_epi16 (_mm_srli_epi16 (val [g], 8), z)
+			);
+			if (lsb_flag)
+			{
+				_mm_storel_epi64 (
+					(__m128i*)(pDstLsb + g * 8),
+					_mm_packus_epi16 (_mm_and_si128 (val [g], m), z)
+				);
+			}
+		}
+
+		pDst    += nDstPitch;
+		pDstLsb += nDstPitch;
+		pSrc    += nSrcPitch;
+		for (int k = 0; k < trad * 2; ++k)
+		{
+			pRef [k] += Pitch [k];
+		}
+	}
+}
+
+
+
+template <int blockWidth, int blockHeight>
+void DegrainN_sse2 (
+	BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
+	const BYTE *pSrc, int nSrcPitch,
+	const BYTE *pRef [], int Pitch [],
+	int Wall [], int trad
+)
+{
+	if (lsb_flag)
+	{
+		DegrainN_sse2_proc <blockWidth, blockHeight, true > (
+			pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad
+		);
+	}
+	else
+	{
+		DegrainN_sse2_proc <blockWidth, blockHeight, false> (
+			pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad
+		);
+	}
+}
+
+
+
+#endif	// __MV_DEGRAINN_FNC__
@@ -20,12 +20,6 @@
 
 
 
-void FakeBlockData::Init(int _x, int _y)
-{
-    x=_x;
-    y=_y;
-}
-
 FakeBlockData::FakeBlockData(int _x, int _y)
 {
 	x = _x;
@@ -43,13 +37,3 @@ FakeBlockData::~FakeBlockData()
 
 }
 
-void FakeBlockData::Update(const int *array)
-{
-	vector.x   = array [0];
-	vector.y   = array [1];
-	vector.sad = array [2];
-//	nLength    = SquareLength(vector);
-//	nPitch     = pitch;
-//	pRef       = ref + x + y * pitch;
-}
-
@@ -44,11 +44,9 @@ class FakeBlockData
 public :
     FakeBlockData();
     FakeBlockData(int _x, int _y);
+	inline FakeBlockData(int _x, int _y, const VECTOR &v) : x(_x), y(_y), vector(v) {}
     ~FakeBlockData();
 
-    void Init(int _x, int _y);
-	void Update(const int *array);
-
 	inline int GetX() const { return x; }
 	inline int GetY() const { return y; }
 	inline VECTOR GetMV() const { return vector; }
@@ -49,7 +49,6 @@ void FakeGroupOfPlanes::Create(int nBlkSizeX, int nBlkSizeY, int nLevelCount, in
 	    nBlkY1 = ((nHeight_B>>i) - nOverlapY)/(nBlkSizeY-nOverlapY);
 		planes[i] = new FakePlaneOfBlocks(nBlkSizeX, nBlkSizeY, i, 1, nOverlapX, nOverlapY, nBlkX1, nBlkY1); // fixed bug with nOverlapX in v1.10.2
 	}
-   InitializeCriticalSection(&cs);
 }
 
 FakeGroupOfPlanes::FakeGroupOfPlanes()
@@ -66,15 +65,13 @@ FakeGroupOfPlanes::~FakeGroupOfPlanes()
 	   delete[] planes;
 	   planes = 0; //v1.2.1
    }
-   DeleteCriticalSection(&cs);
 }
 
 // data_size = available data, in 32-bit words
+// The data is not copied, array must stay valid until the next Update().
 // Returns false on error.
 bool FakeGroupOfPlanes::Update(const int *array, int data_size)
 {
-	::EnterCriticalSection (&cs);
-
 	bool				ok_flag = true;
 
 	validity = GetValidity(array);
@@ -108,8 +105,6 @@ bool FakeGroupOfPlanes::Update(const int *array, int data_size)
 		}
 	}
 
-	::LeaveCriticalSection (&cs);
-
 	return (ok_flag);
 }
 
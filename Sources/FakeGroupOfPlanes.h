@@ -20,13 +20,6 @@
 
 
 
-#define	NOGDI
-#define	NOMINMAX
-#define	WIN32_LEAN_AND_MEAN
-#include	"Windows.h"
-
-
-
 class FakePlaneOfBlocks;
 
 class FakeGroupOfPlanes
@@ -42,7 +35,6 @@ class FakeGroupOfPlanes
 //   const unsigned char *compensatedPlaneU;
 //   const unsigned char *compensatedPlaneV;
 	inline static bool GetValidity(const int *array) { return (array[1] == 1); }
-   CRITICAL_SECTION cs;
 
 public :
    FakeGroupOfPlanes();
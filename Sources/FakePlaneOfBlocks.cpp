@@ -19,6 +19,7 @@
 
 
 #include "commonfunctions.h"
+#include	"def.h"
 #include "FakePlaneOfBlocks.h"
 #include	"MVInterface.h"
 
@@ -43,37 +44,46 @@ FakePlaneOfBlocks::FakePlaneOfBlocks(int sizeX, int sizeY, int lv, int pel, int
 	nLogScale = lv;
 	nScale = iexp2(nLogScale);
 
-	blocks = new FakeBlockData [nBlkCount];
+	blkPos = new int [nBlkCount * 2];
 	for ( int j = 0, blkIdx = 0; j < nBlkY; j++ )
 		for ( int i = 0; i < nBlkX; i++, blkIdx++ )
-			blocks[blkIdx].Init(i * (nBlkSizeX - nOverlapX), j * (nBlkSizeY - nOverlapY));
+		{
+			blkPos[blkIdx*2  ] = i * (nBlkSizeX - nOverlapX);
+			blkPos[blkIdx*2+1] = j * (nBlkSizeY - nOverlapY);
+		}
+
+	defaultVectors = new VECTOR [nBlkCount];
+	for ( int i = 0; i < nBlkCount; i++ )
+	{
+		defaultVectors[i].x = 0;
+		defaultVectors[i].y = 0;
+		defaultVectors[i].sad = 0;
+	}
+	vectors = defaultVectors;
 }
 
 
 
 FakePlaneOfBlocks::~FakePlaneOfBlocks()
 {
-//	for ( int i = 0; i < nBlkCount; i++ )
-//		delete blocks[i];
-
-	delete[] blocks;
+	delete[] defaultVectors;
+	delete[] blkPos;
 }
 
+// The vectors are not copied, array must stay valid until the next Update().
+// Its blocks are N_PER_BLOCK int (x, y, sad), the same layout as VECTOR.
 void FakePlaneOfBlocks::Update(const int *array)
 {
-	array += 0;
-	for ( int i = 0; i < nBlkCount; i++ )
-	{
-		blocks[i].Update(array);
-		array += N_PER_BLOCK;
-	}
+	CHECK_COMPILE_TIME (VectorLayout, (sizeof (VECTOR) == N_PER_BLOCK * sizeof (int)));
+
+	vectors = reinterpret_cast <const VECTOR *> (array);
 }
 
 bool FakePlaneOfBlocks::IsSceneChange(int nTh1, int nTh2) const
 {
 	int sum = 0;
 	for ( int i = 0; i < nBlkCount; i++ )
-		sum += ( blocks[i].GetSAD() > nTh1 ) ? 1 : 0;
+		sum += ( vectors[i].sad > nTh1 ) ? 1 : 0;
 
 	return ( sum > nTh2 );
 }
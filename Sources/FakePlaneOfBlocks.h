@@ -21,6 +21,7 @@
 
 
 #include	"FakeBlockData.h"
+#include	"MVInterface.h"
 
 
 
@@ -41,7 +42,9 @@ class FakePlaneOfBlocks
 	int nOverlapX;
 	int nOverlapY;
 
-	FakeBlockData *blocks;
+	int *blkPos; // x and y of each block, set at construction only
+	const VECTOR *vectors; // points to the vector clip data, see Update()
+	VECTOR *defaultVectors; // used before the first Update()
 
 public :
 
@@ -56,8 +59,9 @@ public :
 		return (( i >= 0 ) && ( i < nBlkCount ));
 	}
 
-	inline const FakeBlockData& operator[](const int i) const {
-		return (blocks[i]);
+	// Blocks are built on the fly from the position table and the vector data
+	inline FakeBlockData operator[](const int i) const {
+		return (GetBlock(i));
 	}
 
 	inline int GetBlockCount() const { return nBlkCount; }
@@ -70,7 +74,11 @@ public :
 	inline int GetBlockSizeX() const { return nBlkSizeX; }
 	inline int GetBlockSizeY() const { return nBlkSizeY; }
 	inline int GetPel() const { return nPel; }
-   inline const FakeBlockData& GetBlock(int i) const { return (blocks[i]); }
+   inline FakeBlockData GetBlock(int i) const { return FakeBlockData(blkPos[i*2], blkPos[i*2+1], vectors[i]); }
+	inline const VECTOR& GetMV(int i) const { return vectors[i]; }
+	inline int GetSAD(int i) const { return vectors[i].sad; }
+	inline int GetX(int i) const { return blkPos[i*2]; }
+	inline int GetY(int i) const { return blkPos[i*2+1]; }
 	inline int GetOverlapX() const { return nOverlapX; }
 	inline int GetOverlapY() const { return nOverlapY; }
 };
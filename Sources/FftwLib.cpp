@@ -0,0 +1,313 @@
+/*****************************************************************************
+
+        FftwLib.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#if defined (_WIN32)
+	#define	NOGDI
+	#define	NOMINMAX
+	#define	WIN32_LEAN_AND_MEAN
+	#include	<windows.h>
+#else
+	#include	<dlfcn.h>
+#endif
+
+#include	"conc/CritSec.h"
+#include	"FftwLib.h"
+
+#include	<new>
+#include	<stdexcept>
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: dtor
+Description:
+	Please do not destroy directly the object. This will be done automatically
+	at the end of the process.
+	The plans and the library are deliberately kept: the destructor runs from
+	the static destruction of the plug-in, inside DLL_PROCESS_DETACH on
+	Windows, where calling FFTW or unloading a library is not safe. The system
+	releases them with the process. If the plug-in itself is unloaded before,
+	they are leaked, which is harmless as they are few and small.
+==============================================================================
+*/
+
+FftwLib::~FftwLib ()
+{
+	// Nothing
+}
+
+
+
+/*
+==============================================================================
+Name: use_instance
+Description:
+	Obtain an access to the FftwLib singleton. It is created and the library
+	loaded if not accessed previously.
+Returns:
+	A reference on the library.
+Throws:
+	std::runtime_error if the library cannot be found or is not complete.
+	Next calls will try to load it again.
+==============================================================================
+*/
+
+FftwLib &	FftwLib::use_instance ()
+{
+	// First check
+	if (! _singleton_init_flag)
+	{
+		// Ensure serialization (guard constructor acquires mutex_new).
+		static conc::Mutex	mutex_new;
+		conc::CritSec	guard (mutex_new);
+
+		// Double check.
+		if (! _singleton_init_flag)
+		{
+			assert (! _singleton_init_flag && _singleton_aptr.get () == 0);
+			_singleton_aptr = std::auto_ptr <FftwLib> (new FftwLib);
+			_singleton_init_flag = true;
+		}
+
+		// guard destructor releases mutex_new.
+	}
+
+	return (*_singleton_aptr);
+}
+
+
+
+// len in floats. The buffer is suitable for the execute functions.
+float *	FftwLib::alloc_buf (size_t len)
+{
+	assert (len > 0);
+
+	float *			buf_ptr = reinterpret_cast <float *> (
+		_fftwf_malloc_ptr (sizeof (float) * len)
+	);
+	if (buf_ptr == 0)
+	{
+		throw std::bad_alloc ();
+	}
+
+	return (buf_ptr);
+}
+
+
+
+void	FftwLib::free_buf (float *buf_ptr)
+{
+	if (buf_ptr != 0)
+	{
+		_fftwf_free_ptr (buf_ptr);
+	}
+}
+
+
+
+/*
+==============================================================================
+Name: use_plan_dct_2d
+Description:
+	Returns the plan for a 2D DCT-II (FFTW_REDFT10 on both dimensions) of the
+	given size. The plan is created on the first request only; next requests
+	just return it.
+	The plan is out-of-place and stays owned by the library object.
+Input parameters:
+	- sizex: width of the transform, > 0.
+	- sizey: height of the transform, > 0.
+Returns: the plan, never 0.
+Throws: std::runtime_error if FFTW cannot create the plan.
+==============================================================================
+*/
+
+fftwf_plan	FftwLib::use_plan_dct_2d (int sizex, int sizey)
+{
+	assert (sizex > 0);
+	assert (sizey > 0);
+
+	const int		kind = FFTW_REDFT10;
+
+	conc::CritSec	lock (_plan_mutex);
+
+	for (PlanList::const_iterator it = _plan_list.begin (); it != _plan_list.end (); ++it)
+	{
+		if (it->_sizex == sizex && it->_sizey == sizey && it->_kind == kind)
+		{
+			return (it->_plan);
+		}
+	}
+
+	// FFTW_ESTIMATE does not touch the arrays, they are only required for the
+	// alignment and the in-place/out-of-place configuration.
+	const size_t	size2d = size_t (sizex) * sizey;
+	float *			in_ptr  = alloc_buf (size2d);
+	float *			out_ptr = 0;
+	try
+	{
+		out_ptr = alloc_buf (size2d);
+	}
+	catch (...)
+	{
+		free_buf (in_ptr);
+		throw;
+	}
+
+	PlanInfo			info;
+	info._sizex = sizex;
+	info._sizey = sizey;
+	info._kind  = kind;
+	info._plan  = _fftwf_plan_r2r_2d_ptr (
+		sizey, sizex, in_ptr, out_ptr, kind, kind, FFTW_ESTIMATE
+	);
+
+	free_buf (in_ptr);
+	free_buf (out_ptr);
+
+	if (info._plan == 0)
+	{
+		throw std::runtime_error ("Cannot create the FFTW plan.");
+	}
+
+	_plan_list.push_back (info);
+
+	return (info._plan);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+FftwLib::FftwLib ()
+:	_lib_hnd (load_lib ())
+,	_fftwf_malloc_ptr (0)
+,	_fftwf_free_ptr (0)
+,	_fftwf_plan_r2r_2d_ptr (0)
+,	_fftwf_execute_r2r_ptr (0)
+,	_plan_mutex ()
+,	_plan_list ()
+{
+	if (_lib_hnd == 0)
+	{
+		throw std::runtime_error ("Cannot load the FFTW library.");
+	}
+
+	resolve_name (_fftwf_malloc_ptr,       "fftwf_malloc");
+	resolve_name (_fftwf_free_ptr,         "fftwf_free");
+	resolve_name (_fftwf_plan_r2r_2d_ptr,  "fftwf_plan_r2r_2d");
+	resolve_name (_fftwf_execute_r2r_ptr,  "fftwf_execute_r2r");
+}
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+template <class T>
+void	FftwLib::resolve_name (T &fnc_ptr, const char *name_0)
+{
+	assert (&fnc_ptr != 0);
+	assert (name_0 != 0);
+	assert (_lib_hnd != 0);
+
+#if defined (_WIN32)
+	fnc_ptr = reinterpret_cast <T> (
+		::GetProcAddress (reinterpret_cast < ::HMODULE> (_lib_hnd), name_0)
+	);
+#else
+	fnc_ptr = reinterpret_cast <T> (::dlsym (_lib_hnd, name_0));
+#endif
+	if (fnc_ptr == 0)
+	{
+		unload_lib (_lib_hnd);
+		_lib_hnd = 0;
+		throw std::runtime_error ("Function missing in the FFTW library.");
+	}
+}
+
+
+
+// Returns 0 if the library cannot be found.
+void *	FftwLib::load_lib ()
+{
+	// The first name is the one of the historical single-precision build
+	// shipped with the plug-in, next ones are the official builds.
+#if defined (_WIN32)
+	static const char *	name_0_arr [] =
+	{
+		"fftw3.dll", "libfftw3f-3.dll", 0
+	};
+#else
+	static const char *	name_0_arr [] =
+	{
+		"libfftw3f.so.3", "libfftw3f.so", "libfftw3f.3.dylib", 0
+	};
+#endif
+
+	void *			lib_hnd = 0;
+	for (int k = 0; name_0_arr [k] != 0 && lib_hnd == 0; ++k)
+	{
+#if defined (_WIN32)
+		lib_hnd = reinterpret_cast <void *> (::LoadLibraryA (name_0_arr [k]));
+#else
+		lib_hnd = ::dlopen (name_0_arr [k], RTLD_NOW | RTLD_LOCAL);
+#endif
+	}
+
+	return (lib_hnd);
+}
+
+
+
+void	FftwLib::unload_lib (void *lib_hnd)
+{
+	assert (lib_hnd != 0);
+
+#if defined (_WIN32)
+	::FreeLibrary (reinterpret_cast < ::HMODULE> (lib_hnd));
+#else
+	::dlclose (lib_hnd);
+#endif
+}
+
+
+
+std::auto_ptr <FftwLib>	FftwLib::_singleton_aptr;
+volatile bool	FftwLib::_singleton_init_flag = false;
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,141 @@
+/*****************************************************************************
+
+        FftwLib.h
+        Author: agent, 2026
+
+Process-wide access to the single-precision FFTW library, loaded on the
+first use (fftw3.dll or libfftw3f-3.dll on Windows, libfftw3f.so.3 on other
+systems).
+
+Plans are created once per transform size and kept until the end of the
+process. Neither the plans nor the library are released at exit. The FFTW planner is not thread-safe, so plan creation is serialized.
+Once created, a plan can be executed concurrently on different arrays with
+execute_r2r(), as long as these arrays are allocated with alloc_buf() (same
+alignment as the arrays used for planning), and are not in-place.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (FftwLib_HEADER_INCLUDED)
+#define	FftwLib_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/Mutex.h"
+#include	"fftwlite.h"
+
+#include	<memory>
+#include	<vector>
+
+#include	<cstddef>
+
+
+
+class FftwLib
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	virtual			~FftwLib ();
+
+	static FftwLib &
+						use_instance ();
+
+	float *			alloc_buf (size_t len);
+	void				free_buf (float *buf_ptr);
+
+	fftwf_plan		use_plan_dct_2d (int sizex, int sizey);
+	inline void		execute_r2r (fftwf_plan plan, float *in_ptr, float *out_ptr) const;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+						FftwLib ();
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class PlanInfo
+	{
+	public:
+		int				_sizex;
+		int				_sizey;
+		int				_kind;
+		fftwf_plan		_plan;
+	};
+
+	typedef	std::vector <PlanInfo>	PlanList;
+
+	template <class T>
+	void				resolve_name (T &fnc_ptr, const char *name_0);
+
+	static void *	load_lib ();
+	static void		unload_lib (void *lib_hnd);
+
+	void *			_lib_hnd;	// Avoids loading windows.h or dlfcn.h just for the handle
+
+	fftwf_malloc_proc
+						_fftwf_malloc_ptr;
+	fftwf_free_proc
+						_fftwf_free_ptr;
+	fftwf_plan_r2r_2d_proc
+						_fftwf_plan_r2r_2d_ptr;
+	fftwf_execute_r2r_proc
+						_fftwf_execute_r2r_ptr;
+
+	conc::Mutex		_plan_mutex;	// Protects the planner and _plan_list
+	PlanList			_plan_list;
+
+	static std::auto_ptr <FftwLib>
+						_singleton_aptr;
+	static volatile bool
+						_singleton_init_flag;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						FftwLib (const FftwLib &other);
+	FftwLib &		operator = (const FftwLib &other);
+	bool				operator == (const FftwLib &other) const;
+	bool				operator != (const FftwLib &other) const;
+
+};	// class FftwLib
+
+
+
+#include	"FftwLib.hpp"
+
+
+
+#endif	// FftwLib_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,511 @@
+/*****************************************************************************
+
+        FlowInterAvx2.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"avisynth.h"
+#include	"FlowInterAvx2.h"
+#include	"Time256ProviderCst.h"
+#include	"Time256ProviderPlane.h"
+
+#include	<immintrin.h>
+
+#include	<cassert>
+
+
+
+/*\\\ STATIC FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Gives the time of 8 consecutive pixels, as 32-bit integers.
+template <class T256P>
+class FlowInterAvx2_T256;
+
+template <>
+class FlowInterAvx2_T256 <Time256ProviderCst>
+{
+public:
+	explicit			FlowInterAvx2_T256 (const Time256ProviderCst &t256_provider)
+	:	_t (_mm256_set1_epi32 (t256_provider.get_t (0)))
+	{
+		// Nothing
+	}
+	inline __m256i	get_t (int /*x*/) const
+	{
+		return (_t);
+	}
+	inline void		jump_to_next_row ()
+	{
+		// Nothing
+	}
+private:
+	__m256i			_t;
+};
+
+template <>
+class FlowInterAvx2_T256 <Time256ProviderPlane>
+{
+public:
+	explicit			FlowInterAvx2_T256 (const Time256ProviderPlane &t256_provider)
+	:	_pt256 (t256_provider.use_row ())
+	,	_t256_pitch (t256_provider.get_pitch ())
+	{
+		// Nothing
+	}
+	inline __m256i	get_t (int x) const
+	{
+		return (_mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (_pt256 + x))));
+	}
+	inline void		jump_to_next_row ()
+	{
+		_pt256 += _t256_pitch;
+	}
+private:
+	const BYTE *	_pt256;
+	int				_t256_pitch;
+};
+
+
+
+// Splits 8 interleaved (vx, vy) pairs into sign-extended 32-bit components.
+static inline void	FlowInterAvx2_load_vect (const int16_t *v_ptr, __m256i &vx, __m256i &vy)
+{
+	const __m256i	v = _mm256_loadu_si256 ((const __m256i *) v_ptr);
+
+	vx = _mm256_srai_epi32 (_mm256_slli_epi32 (v, 16), 16);
+	vy = _mm256_srai_epi32 (v, 16);
+}
+
+
+
+// Same as FlowInterAvx2_load_vect, but each odd pixel takes the vector of
+// the previous even pixel.
+static inline void	FlowInterAvx2_load_vect_pair (const int16_t *v_ptr, __m256i &vx, __m256i &vy)
+{
+	const __m256i	v = _mm256_shuffle_epi32 (
+		_mm256_loadu_si256 ((const __m256i *) v_ptr),
+		(2 << 6) + (2 << 4) + (0 << 2) + 0
+	);
+
+	vx = _mm256_srai_epi32 (_mm256_slli_epi32 (v, 16), 16);
+	vy = _mm256_srai_epi32 (v, 16);
+}
+
+
+
+// (v * t) / 256, rounded towards 0 like the C division.
+static inline __m256i	FlowInterAvx2_scale (__m256i v, __m256i t)
+{
+	const __m256i	p    = _mm256_mullo_epi32 (v, t);
+	const __m256i	bias = _mm256_srli_epi32 (_mm256_srai_epi32 (p, 31), 24);
+
+	return (_mm256_srai_epi32 (_mm256_add_epi32 (p, bias), 8));
+}
+
+
+
+// Position of the 8 pixels in the reference rows
+template <int NPELL2>
+static inline __m256i	FlowInterAvx2_base (int w)
+{
+	return (_mm256_slli_epi32 (
+		_mm256_setr_epi32 (w, w + 1, w + 2, w + 3, w + 4, w + 5, w + 6, w + 7),
+		NPELL2
+	));
+}
+
+
+
+// Fetches the 8 bytes located at ref_ptr + adr. The gathers load 32 bits,
+// so each byte is read within the aligned 32-bit word containing it and
+// extracted with a shift. The frame rows start on 4-byte boundaries and the
+// pitch is a multiple of 4, so this word never crosses the row of the pixel,
+// and nothing is read outside the plane, even at its right or bottom edge.
+static inline __m256i	FlowInterAvx2_gather_u8 (const uint8_t *ref_ptr, __m256i adr)
+{
+	const int		ofs      = int (reinterpret_cast <intptr_t> (ref_ptr) & 3);
+	const int *		word_ptr = reinterpret_cast <const int *> (ref_ptr - ofs);
+	const __m256i	c3       = _mm256_set1_epi32 (3);
+	const __m256i	adr_abs  = _mm256_add_epi32 (adr, _mm256_set1_epi32 (ofs));
+	const __m256i	adr_word = _mm256_andnot_si256 (c3, adr_abs);
+	const __m256i	shift    = _mm256_slli_epi32 (_mm256_and_si256 (adr_abs, c3), 3);
+	const __m256i	pix      = _mm256_i32gather_epi32 (word_ptr, adr_word, 1);
+
+	return (_mm256_and_si256 (
+		_mm256_srlv_epi32 (pix, shift),
+		_mm256_set1_epi32 (0xFF)
+	));
+}
+
+
+
+static inline __m256i	FlowInterAvx2_fetch (const uint8_t *ref_ptr, int ref_pitch, __m256i vx, __m256i vy, __m256i base)
+{
+	assert ((ref_pitch & 3) == 0);
+
+	const __m256i	adr = _mm256_add_epi32 (
+		_mm256_add_epi32 (_mm256_mullo_epi32 (vy, _mm256_set1_epi32 (ref_pitch)), vx),
+		base
+	);
+
+	return (FlowInterAvx2_gather_u8 (ref_ptr, adr));
+}
+
+
+
+// Pixels at the null vector
+template <int NPELL2>
+static inline __m256i	FlowInterAvx2_fetch_0 (const uint8_t *ref_ptr, int w, __m256i base)
+{
+	if (NPELL2 == 0)
+	{
+		return (_mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (ref_ptr + w))));
+	}
+
+	return (FlowInterAvx2_gather_u8 (ref_ptr, base));
+}
+
+
+
+static inline __m256i	FlowInterAvx2_load_mask (const uint8_t *ptr)
+{
+	return (_mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) ptr)));
+}
+
+
+
+// Values must be in the 0-255 range
+static inline void	FlowInterAvx2_store (uint8_t *ptr, __m256i v)
+{
+	__m256i			p = _mm256_packus_epi32 (v, v);
+	p = _mm256_packus_epi16 (p, p);
+	p = _mm256_permutevar8x32_epi32 (p, _mm256_setr_epi32 (0, 4, 0, 0, 0, 0, 0, 0));
+	_mm_storel_epi64 ((__m128i *) ptr, _mm256_castsi256_si128 (p));
+}
+
+
+
+static inline __m256i	FlowInterAvx2_mul (__m256i a, __m256i b)
+{
+	return (_mm256_mullo_epi32 (a, b));
+}
+
+
+
+// ((a + b + 255) >> 8)
+static inline __m256i	FlowInterAvx2_add_r8 (__m256i a, __m256i b)
+{
+	return (_mm256_srli_epi32 (
+		_mm256_add_epi32 (_mm256_add_epi32 (a, b), _mm256_set1_epi32 (255)),
+		8
+	));
+}
+
+
+
+// (a * (256 - t) + b * t) >> 8
+static inline __m256i	FlowInterAvx2_mix_t (__m256i a, __m256i b, __m256i t)
+{
+	const __m256i	tb = _mm256_sub_epi32 (_mm256_set1_epi32 (256), t);
+
+	return (_mm256_srli_epi32 (
+		_mm256_add_epi32 (FlowInterAvx2_mul (a, tb), FlowInterAvx2_mul (b, t)),
+		8
+	));
+}
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+template <class T256P, int NPELL2>
+void	FlowInter_avx2 (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider)
+{
+	assert (width >= 0);
+	assert ((width & 7) == 0);
+	assert (height >= 0);
+
+	FlowInterAvx2_T256 <T256P>	t256 (t256_provider);
+	const __m256i	c255 = _mm256_set1_epi32 (255);
+	const __m256i	c256 = _mm256_set1_epi32 (256);
+
+	for (int h = 0; h < height; ++h)
+	{
+		for (int w = 0; w < width; w += 8)
+		{
+			const __m256i	t    = t256.get_t (w);
+			const __m256i	tb   = _mm256_sub_epi32 (c256, t);
+			const __m256i	base = FlowInterAvx2_base <NPELL2> (w);
+
+			__m256i			vx;
+			__m256i			vy;
+			FlowInterAvx2_load_vect (VFullF + w * 2, vx, vy);
+			const __m256i	dstF = FlowInterAvx2_fetch (
+				prefF, ref_pitch,
+				FlowInterAvx2_scale (vx, t), FlowInterAvx2_scale (vy, t), base
+			);
+			FlowInterAvx2_load_vect (VFullB + w * 2, vx, vy);
+			const __m256i	dstB = FlowInterAvx2_fetch (
+				prefB, ref_pitch,
+				FlowInterAvx2_scale (vx, tb), FlowInterAvx2_scale (vy, tb), base
+			);
+			const __m256i	dstF0 = FlowInterAvx2_fetch_0 <NPELL2> (prefF, w, base);
+			const __m256i	dstB0 = FlowInterAvx2_fetch_0 <NPELL2> (prefB, w, base);
+
+			const __m256i	mF = FlowInterAvx2_load_mask (MaskF + w);
+			const __m256i	mB = FlowInterAvx2_load_mask (MaskB + w);
+			const __m256i	iF = _mm256_sub_epi32 (c255, mF);
+			const __m256i	iB = _mm256_sub_epi32 (c255, mB);
+
+			const __m256i	occF = FlowInterAvx2_add_r8 (FlowInterAvx2_mul (mF,
+				_mm256_add_epi32 (FlowInterAvx2_mul (dstB, iB), FlowInterAvx2_mul (mB, dstF0))
+			), _mm256_setzero_si256 ());
+			const __m256i	occB = FlowInterAvx2_add_r8 (FlowInterAvx2_mul (mB,
+				_mm256_add_epi32 (FlowInterAvx2_mul (dstF, iF), FlowInterAvx2_mul (mF, dstB0))
+			), _mm256_setzero_si256 ());
+			const __m256i	a = FlowInterAvx2_add_r8 (FlowInterAvx2_mul (dstF, iF), occF);
+			const __m256i	b = FlowInterAvx2_add_r8 (FlowInterAvx2_mul (dstB, iB), occB);
+
+			FlowInterAvx2_store (pdst + w, FlowInterAvx2_mix_t (a, b, t));
+		}
+		pdst += dst_pitch;
+		prefB += ref_pitch << NPELL2;
+		prefF += ref_pitch << NPELL2;
+		t256.jump_to_next_row ();
+		VFullB += VPitch;
+		VFullF += VPitch;
+		MaskB += MaskPitch;
+		MaskF += MaskPitch;
+	}
+}
+
+
+
+template <class T256P, int NPELL2>
+void	FlowInterExtra_avx2 (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider, const int16_t *VFullBB, const int16_t *VFullFF)
+{
+	assert (width >= 0);
+	assert ((width & 7) == 0);
+	assert (height >= 0);
+
+	FlowInterAvx2_T256 <T256P>	t256 (t256_provider);
+	const __m256i	c255 = _mm256_set1_epi32 (255);
+	const __m256i	c256 = _mm256_set1_epi32 (256);
+
+	for (int h = 0; h < height; ++h)
+	{
+		for (int w = 0; w < width; w += 8)
+		{
+			const __m256i	t    = t256.get_t (w);
+			const __m256i	tb   = _mm256_sub_epi32 (c256, t);
+			const __m256i	base = FlowInterAvx2_base <NPELL2> (w);
+
+			__m256i			vx;
+			__m256i			vy;
+			FlowInterAvx2_load_vect (VFullF + w * 2, vx, vy);
+			const __m256i	dstF = FlowInterAvx2_fetch (
+				prefF, ref_pitch,
+				FlowInterAvx2_scale (vx, t), FlowInterAvx2_scale (vy, t), base
+			);
+			FlowInterAvx2_load_vect (VFullFF + w * 2, vx, vy);
+			const __m256i	dstFF = FlowInterAvx2_fetch (
+				prefF, ref_pitch,
+				FlowInterAvx2_scale (vx, t), FlowInterAvx2_scale (vy, t), base
+			);
+			FlowInterAvx2_load_vect (VFullB + w * 2, vx, vy);
+			const __m256i	dstB = FlowInterAvx2_fetch (
+				prefB, ref_pitch,
+				FlowInterAvx2_scale (vx, tb), FlowInterAvx2_scale (vy, tb), base
+			);
+			FlowInterAvx2_load_vect (VFullBB + w * 2, vx, vy);
+			const __m256i	dstBB = FlowInterAvx2_fetch (
+				prefB, ref_pitch,
+				FlowInterAvx2_scale (vx, tb), FlowInterAvx2_scale (vy, tb), base
+			);
+
+			// Median3r (minfb, x, maxfb) is x clipped to [minfb ; maxfb]
+			const __m256i	minfb = _mm256_min_epi32 (dstF, dstB);
+			const __m256i	maxfb = _mm256_max_epi32 (dstF, dstB);
+			const __m256i	medBB = _mm256_min_epi32 (_mm256_max_epi32 (dstBB, minfb), maxfb);
+			const __m256i	medFF = _mm256_min_epi32 (_mm256_max_epi32 (dstFF, minfb), maxfb);
+
+			const __m256i	mF = FlowInterAvx2_load_mask (MaskF + w);
+			const __m256i	mB = FlowInterAvx2_load_mask (MaskB + w);
+			const __m256i	iF = _mm256_sub_epi32 (c255, mF);
+			const __m256i	iB = _mm256_sub_epi32 (c255, mB);
+
+			const __m256i	a = FlowInterAvx2_add_r8 (
+				FlowInterAvx2_mul (medBB, mF), FlowInterAvx2_mul (dstF, iF)
+			);
+			const __m256i	b = FlowInterAvx2_add_r8 (
+				FlowInterAvx2_mul (medFF, mB), FlowInterAvx2_mul (dstB, iB)
+			);
+
+			FlowInterAvx2_store (pdst + w, FlowInterAvx2_mix_t (a, b, t));
+		}
+		pdst += dst_pitch;
+		prefB += ref_pitch << NPELL2;
+		prefF += ref_pitch << NPELL2;
+		t256.jump_to_next_row ();
+		VFullB += VPitch;
+		VFullF += VPitch;
+		MaskB += MaskPitch;
+		MaskF += MaskPitch;
+		VFullBB += VPitch;
+		VFullFF += VPitch;
+	}
+}
+
+
+
+template <class T256P, int NPELL2>
+void	FlowInterSimple_avx2 (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider)
+{
+	assert (width >= 0);
+	assert ((width & 7) == 0);
+	assert (height >= 0);
+
+	FlowInterAvx2_T256 <T256P>	t256 (t256_provider);
+	const bool		half_flag = t256_provider.is_half ();
+	const __m256i	c255 = _mm256_set1_epi32 (255);
+	const __m256i	c256 = _mm256_set1_epi32 (256);
+
+	for (int h = 0; h < height; ++h)
+	{
+		for (int w = 0; w < width; w += 8)
+		{
+			const __m256i	base = FlowInterAvx2_base <NPELL2> (w);
+			__m256i			t    = t256.get_t (w);
+			if (NPELL2 == 0)
+			{
+				t = _mm256_shuffle_epi32 (t, (2 << 6) + (2 << 4) + (0 << 2) + 0);
+			}
+			const __m256i	tb   = _mm256_sub_epi32 (c256, t);
+
+			__m256i			vxF;
+			__m256i			vyF;
+			__m256i			vxB;
+			__m256i			vyB;
+			if (NPELL2 == 0)
+			{
+				FlowInterAvx2_load_vect_pair (VFullF + w * 2, vxF, vyF);
+				FlowInterAvx2_load_vect_pair (VFullB + w * 2, vxB, vyB);
+			}
+			else
+			{
+				FlowInterAvx2_load_vect (VFullF + w * 2, vxF, vyF);
+				FlowInterAvx2_load_vect (VFullB + w * 2, vxB, vyB);
+			}
+			if (half_flag)
+			{
+				vxF = _mm256_srai_epi32 (vxF, 1);
+				vyF = _mm256_srai_epi32 (vyF, 1);
+				vxB = _mm256_srai_epi32 (vxB, 1);
+				vyB = _mm256_srai_epi32 (vyB, 1);
+			}
+			else
+			{
+				vxF = FlowInterAvx2_scale (vxF, t);
+				vyF = FlowInterAvx2_scale (vyF, t);
+				vxB = FlowInterAvx2_scale (vxB, tb);
+				vyB = FlowInterAvx2_scale (vyB, tb);
+			}
+			const __m256i	dstF = FlowInterAvx2_fetch (prefF, ref_pitch, vxF, vyF, base);
+			const __m256i	dstB = FlowInterAvx2_fetch (prefB, ref_pitch, vxB, vyB, base);
+
+			const __m256i	mF = FlowInterAvx2_load_mask (MaskF + w);
+			const __m256i	mB = FlowInterAvx2_load_mask (MaskB + w);
+
+			__m256i			res;
+			if (half_flag)
+			{
+				res = _mm256_srai_epi32 (_mm256_add_epi32 (
+					_mm256_slli_epi32 (_mm256_add_epi32 (dstF, dstB), 8),
+					FlowInterAvx2_mul (
+						_mm256_sub_epi32 (dstB, dstF),
+						_mm256_sub_epi32 (mF, mB)
+					)
+				), 9);
+			}
+			else if (NPELL2 == 0)
+			{
+				const __m256i	d  = _mm256_sub_epi32 (dstB, dstF);
+				const __m256i	a  = _mm256_add_epi32 (_mm256_add_epi32 (
+					FlowInterAvx2_mul (dstF, c255), FlowInterAvx2_mul (d, mF)
+				), c255);
+				const __m256i	b  = _mm256_add_epi32 (_mm256_sub_epi32 (
+					FlowInterAvx2_mul (dstB, c255), FlowInterAvx2_mul (d, mB)
+				), c255);
+				res = _mm256_srli_epi32 (_mm256_add_epi32 (
+					FlowInterAvx2_mul (a, tb), FlowInterAvx2_mul (b, t)
+				), 16);
+			}
+			else
+			{
+				const __m256i	iF = _mm256_sub_epi32 (c255, mF);
+				const __m256i	iB = _mm256_sub_epi32 (c255, mB);
+				const __m256i	a  = FlowInterAvx2_add_r8 (
+					FlowInterAvx2_mul (dstF, iF), FlowInterAvx2_mul (dstB, mF)
+				);
+				const __m256i	b  = FlowInterAvx2_add_r8 (
+					FlowInterAvx2_mul (dstB, iB), FlowInterAvx2_mul (dstF, mB)
+				);
+				res = FlowInterAvx2_mix_t (a, b, t);
+			}
+
+			FlowInterAvx2_store (pdst + w, res);
+		}
+		pdst += dst_pitch;
+		prefB += ref_pitch << NPELL2;
+		prefF += ref_pitch << NPELL2;
+		t256.jump_to_next_row ();
+		VFullB += VPitch;
+		VFullF += VPitch;
+		MaskB += MaskPitch;
+		MaskF += MaskPitch;
+	}
+}
+
+
+
+#define FlowInterAvx2_INST(T256P, npell2) \
+	template void	FlowInter_avx2 <T256P, npell2> (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider); \
+	template void	FlowInterExtra_avx2 <T256P, npell2> (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider, const int16_t *VFullBB, const int16_t *VFullFF); \
+	template void	FlowInterSimple_avx2 <T256P, npell2> (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider);
+
+FlowInterAvx2_INST (Time256ProviderCst  , 0)
+FlowInterAvx2_INST (Time256ProviderCst  , 1)
+FlowInterAvx2_INST (Time256ProviderCst  , 2)
+FlowInterAvx2_INST (Time256ProviderPlane, 0)
+FlowInterAvx2_INST (Time256ProviderPlane, 1)
+FlowInterAvx2_INST (Time256ProviderPlane, 2)
+
+#undef FlowInterAvx2_INST
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
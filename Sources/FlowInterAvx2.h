@@ -0,0 +1,70 @@
+/*****************************************************************************
+
+        FlowInterAvx2.h
+        Author: agent, 2026
+
+AVX2 versions of the FlowInter, FlowInterExtra and FlowInterSimple pixel
+kernels from MaskFun.hpp. Eight pixels are processed at once, the motion-
+compensated pixels being fetched with gathers.
+
+They are explicitly instantiated in FlowInterAvx2.cpp for nPel = 1, 2
+and 4 (NPELL2 = 0, 1, 2) and for both Time256ProviderCst and
+Time256ProviderPlane. Results are bit-exact with the C kernels.
+
+Only the (width & ~7) first columns are processed. The remaining ones are
+left to the C code. The time provider is not modified; its current row is
+the first one.
+
+The reference pixels are fetched as aligned 32-bit words, so the reference
+frame rows must start on 4-byte boundaries and ref_pitch must be a multiple
+of 4, like Avisynth frames. Nothing is read outside the rows of the pixels.
+
+Never call these functions directly on a CPU without AVX2 support. Use the
+avx2_flag parameter of the MaskFun.h functions instead.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (FlowInterAvx2_HEADER_INCLUDED)
+#define	FlowInterAvx2_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"types.h"
+
+
+
+template <class T256P, int NPELL2>
+void	FlowInter_avx2 (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider);
+
+template <class T256P, int NPELL2>
+void	FlowInterExtra_avx2 (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider, const int16_t *VFullBB, const int16_t *VFullFF);
+
+// With NPELL2 = 0, the pixels are processed by pairs sharing the vectors
+// and time of the even pixel, like FlowInterSimple_Pel1.
+template <class T256P, int NPELL2>
+void	FlowInterSimple_avx2 (uint8_t *pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch, const int16_t *VFullB, const int16_t *VFullF, int VPitch, const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch, int width, int height, const T256P &t256_provider);
+
+
+
+#endif	// FlowInterAvx2_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
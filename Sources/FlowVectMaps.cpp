@@ -0,0 +1,206 @@
+/*****************************************************************************
+
+        FlowVectMaps.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"FlowVectMaps.h"
+#include	"MVClip.h"
+#include	"SimpleResize.h"
+
+#include	<algorithm>
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: ctor
+Input parameters:
+	- blk_x, blk_y: number of blocks of the vector clip.
+	- blk_xp, blk_yp: number of blocks covering the whole frame, including
+		the padding blocks (blk_x or blk_x + 1).
+	- w, h: size of the full luma maps, covered by the padded blocks.
+	- w_uv, h_uv: size of the full chroma maps.
+	- ratio_uv: vertical chroma subsampling ratio (1 or 2).
+==============================================================================
+*/
+
+FlowVectMaps::FlowVectMaps (int blk_x, int blk_y, int blk_xp, int blk_yp, int w, int h, int w_uv, int h_uv, int ratio_uv)
+:	_blk_x (blk_x)
+,	_blk_y (blk_y)
+,	_blk_xp (blk_xp)
+,	_blk_yp (blk_yp)
+,	_ratio_uv (ratio_uv)
+,	_small_pitch (compute_pitch (blk_xp))
+,	_arena ()
+{
+	assert (blk_x > 0);
+	assert (blk_y > 0);
+	assert (blk_xp >= blk_x);
+	assert (blk_yp >= blk_y);
+	assert (w > 0);
+	assert (h > 0);
+	assert (w_uv > 0);
+	assert (h_uv > 0);
+	assert (ratio_uv == 1 || ratio_uv == 2);
+
+	_full_pitch_arr [Res_LUMA  ] = compute_pitch (w);
+	_full_pitch_arr [Res_CHROMA] = compute_pitch (w_uv);
+
+	// All the sizes are multiple of the cache line size, so each map starts
+	// on a cache line boundary.
+	size_t			pos = 0;
+	for (int dir = 0; dir < Dir_NBR_ELT; ++dir)
+	{
+		_small_ofs_arr [dir] = pos;
+		pos += size_t (_small_pitch) * blk_yp;
+
+		_full_ofs_arr [dir] [Res_LUMA  ] = pos;
+		pos += size_t (_full_pitch_arr [Res_LUMA  ]) * h;
+
+		_full_ofs_arr [dir] [Res_CHROMA] = pos;
+		pos += size_t (_full_pitch_arr [Res_CHROMA]) * h_uv;
+	}
+
+	_arena.resize (pos, 0);
+}
+
+
+
+/*
+==============================================================================
+Name: build_small
+Description:
+	Fills the block-resolution map of a direction with the vectors of the
+	clip. The padding blocks on the right and bottom are extrapolated from
+	their neighbours, but cannot point outside the frame.
+Input parameters:
+	- dir: direction of the vectors.
+Input/output parameters:
+	- mv_clip: vector clip, already updated for the frame.
+==============================================================================
+*/
+
+void	FlowVectMaps::build_small (Dir dir, MVClip &mv_clip)
+{
+	assert (dir >= 0);
+	assert (dir < Dir_NBR_ELT);
+
+	int16_t *		v_ptr = &_arena [_small_ofs_arr [dir]];
+
+	for (int by = 0; by < _blk_y; ++by)
+	{
+		int16_t *		row_ptr = v_ptr + by * _small_pitch;
+		for (int bx = 0; bx < _blk_x; ++bx)
+		{
+			const FakeBlockData &	block = mv_clip.GetBlock (0, bx + by * _blk_x);
+			const VECTOR	mv = block.GetMV ();
+			row_ptr [bx * 2    ] = int16_t (mv.x);
+			row_ptr [bx * 2 + 1] = int16_t (mv.y);
+		}
+
+		if (_blk_xp > _blk_x)
+		{
+			row_ptr [_blk_x * 2    ] = std::min (row_ptr [_blk_x * 2 - 2], int16_t (0));
+			row_ptr [_blk_x * 2 + 1] = row_ptr [_blk_x * 2 - 1];
+		}
+	}
+
+	if (_blk_yp > _blk_y)
+	{
+		const int16_t *	src_ptr = v_ptr + (_blk_y - 1) * _small_pitch;
+		int16_t *		dst_ptr = v_ptr +  _blk_y      * _small_pitch;
+		for (int bx = 0; bx < _blk_xp; ++bx)
+		{
+			dst_ptr [bx * 2    ] = src_ptr [bx * 2];
+			dst_ptr [bx * 2 + 1] = std::min (src_ptr [bx * 2 + 1], int16_t (0));
+		}
+	}
+}
+
+
+
+/*
+==============================================================================
+Name: upsize_rows
+Description:
+	Computes a range of rows of the full-resolution maps of a direction,
+	from its block-resolution map. Different row ranges can be processed
+	concurrently.
+Input parameters:
+	- dir: direction of the vectors.
+	- yl_beg, yl_end: luma rows to compute.
+	- yc_beg, yc_end: chroma rows to compute.
+Input/output parameters:
+	- upsizer: resizer from the block resolution to the full luma resolution.
+	- upsizer_uv: resizer from the block resolution to the full chroma
+		resolution.
+==============================================================================
+*/
+
+void	FlowVectMaps::upsize_rows (Dir dir, SimpleResize &upsizer, SimpleResize &upsizer_uv, int yl_beg, int yl_end, int yc_beg, int yc_end)
+{
+	assert (dir >= 0);
+	assert (dir < Dir_NBR_ELT);
+
+	const int16_t *	small_ptr = &_arena [_small_ofs_arr [dir]];
+
+	upsizer.SimpleResizeDoVect (
+		&_arena [_full_ofs_arr [dir] [Res_LUMA]], _full_pitch_arr [Res_LUMA],
+		small_ptr, _small_pitch, yl_beg, yl_end, 0, 0
+	);
+
+	// Chroma is horizontally subsampled in all the supported formats
+	upsizer_uv.SimpleResizeDoVect (
+		&_arena [_full_ofs_arr [dir] [Res_CHROMA]], _full_pitch_arr [Res_CHROMA],
+		small_ptr, _small_pitch, yc_beg, yc_end, 1, (_ratio_uv == 2) ? 1 : 0
+	);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// w is the number of vectors, the pitch is returned in int16_t.
+int	FlowVectMaps::compute_pitch (int w)
+{
+	const int		align = CACHE_LINE_SIZE / int (sizeof (int16_t));
+
+	return ((w * 2 + align - 1) & -align);
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
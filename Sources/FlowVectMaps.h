@@ -0,0 +1,145 @@
+/*****************************************************************************
+
+        FlowVectMaps.h
+        Author: agent, 2026
+
+Motion vector fields used by the MFlowFps and MFlowInter interpolations.
+
+Each field holds the vectors of one direction (backward, forward and their
+extra counterparts), as interleaved 16-bit (vx, vy) pairs, at three
+resolutions:
+- block resolution, in luma units, built from the vector clip;
+- full luma resolution, upsized from the block resolution;
+- full chroma resolution, upsized from the same block-resolution vectors,
+	which are scaled to chroma units on the fly.
+
+The vectors are not clamped nor offset, so large motions are kept intact
+and the interpolation kernels do not need any lookup table.
+
+All the maps share a single buffer. Rows are aligned on cache lines.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (FlowVectMaps_HEADER_INCLUDED)
+#define	FlowVectMaps_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"AllocAlign.h"
+#include	"types.h"
+
+#include	<vector>
+
+
+
+class MVClip;
+class SimpleResize;
+
+class FlowVectMaps
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			CACHE_LINE_SIZE	= 64	};
+
+	enum Dir
+	{
+		Dir_B = 0,		// Backward
+		Dir_F,			// Forward
+		Dir_BB,			// Backward, from the next frame
+		Dir_FF,			// Forward, from the previous frame
+
+		Dir_NBR_ELT
+	};
+
+	enum Res
+	{
+		Res_LUMA = 0,
+		Res_CHROMA,
+
+		Res_NBR_ELT
+	};
+
+						FlowVectMaps (int blk_x, int blk_y, int blk_xp, int blk_yp, int w, int h, int w_uv, int h_uv, int ratio_uv);
+	virtual			~FlowVectMaps () {}
+
+	void				build_small (Dir dir, MVClip &mv_clip);
+	void				upsize_rows (Dir dir, SimpleResize &upsizer, SimpleResize &upsizer_uv, int yl_beg, int yl_end, int yc_beg, int yc_end);
+
+	inline const int16_t *
+						use_full (Dir dir, Res res, int y) const;
+	inline int		get_full_pitch (Res res) const;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	typedef	std::vector <int16_t, AllocAlign <int16_t, CACHE_LINE_SIZE> >	Arena;
+
+	static int		compute_pitch (int w);
+
+	const int		_blk_x;
+	const int		_blk_y;
+	const int		_blk_xp;			// Padded to cover the full frame
+	const int		_blk_yp;
+	const int		_ratio_uv;
+
+	int				_small_pitch;	// In int16_t, for a whole row of pairs
+	int				_full_pitch_arr [Res_NBR_ELT];
+	size_t			_small_ofs_arr [Dir_NBR_ELT];
+	size_t			_full_ofs_arr [Dir_NBR_ELT] [Res_NBR_ELT];
+
+	Arena				_arena;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						FlowVectMaps ();
+						FlowVectMaps (const FlowVectMaps &other);
+	FlowVectMaps &	operator = (const FlowVectMaps &other);
+	bool				operator == (const FlowVectMaps &other) const;
+	bool				operator != (const FlowVectMaps &other) const;
+
+};	// class FlowVectMaps
+
+
+
+#include	"FlowVectMaps.hpp"
+
+
+
+#endif	// FlowVectMaps_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,71 @@
+/*****************************************************************************
+
+        FlowVectMaps.hpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (FlowVectMaps_CODEHEADER_INCLUDED)
+#define	FlowVectMaps_CODEHEADER_INCLUDED
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Returns the row y of the full-resolution map. Element 2*x is vx and
+// 2*x+1 is vy, for the pixel x.
+const int16_t *	FlowVectMaps::use_full (Dir dir, Res res, int y) const
+{
+	assert (dir >= 0);
+	assert (dir < Dir_NBR_ELT);
+	assert (res >= 0);
+	assert (res < Res_NBR_ELT);
+	assert (y >= 0);
+
+	return (&_arena [_full_ofs_arr [dir] [res] + y * _full_pitch_arr [res]]);
+}
+
+
+
+// In int16_t units
+int	FlowVectMaps::get_full_pitch (Res res) const
+{
+	assert (res >= 0);
+	assert (res < Res_NBR_ELT);
+
+	return (_full_pitch_arr [res]);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+#endif	// FlowVectMaps_CODEHEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
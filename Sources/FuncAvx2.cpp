@@ -0,0 +1,675 @@
+/*****************************************************************************
+
+        FuncAvx2.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"DegrainNFnc.h"
+#include	"FuncAvx2.h"
+#include	"SADFunctions.h"
+
+#include	<immintrin.h>
+
+#include	<cassert>
+
+
+
+/*\\\ STATIC FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+static inline unsigned int	FuncAvx2_hsum_sad (__m256i sum)
+{
+	const __m128i	s = _mm_add_epi64 (
+		_mm256_castsi256_si128 (sum),
+		_mm256_extracti128_si256 (sum, 1)
+	);
+
+	return (_mm_cvtsi128_si32 (_mm_add_epi64 (s, _mm_srli_si128 (s, 8))));
+}
+
+
+
+// Two 16-pixel rows in a single register
+static inline __m256i	FuncAvx2_load_2x16 (const uint8_t *ptr, int pitch)
+{
+	return (_mm256_inserti128_si256 (
+		_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) ptr)),
+		_mm_loadu_si128 ((const __m128i *) (ptr + pitch)),
+		1
+	));
+}
+
+
+
+// Two 8-pixel rows in a single register
+static inline __m128i	FuncAvx2_load_2x8 (const uint8_t *ptr, int pitch)
+{
+	return (_mm_unpacklo_epi64 (
+		_mm_loadl_epi64 ((const __m128i *) ptr),
+		_mm_loadl_epi64 ((const __m128i *) (ptr + pitch))
+	));
+}
+
+
+
+// Gets 16 or 32 pixels (depending on W) from one or two rows, loaded into a
+// single register.
+template <int W>
+static inline __m256i	FuncAvx2_load_row (const uint8_t *ptr, int pitch)
+{
+	return (  (W == 16)
+	        ? FuncAvx2_load_2x16 (ptr, pitch)
+	        : _mm256_loadu_si256 ((const __m256i *) ptr));
+}
+
+
+
+// Gets NR rows of W pixels (W * NR <= 32) into a single register. When
+// there are less than 32 pixels, the upper part is undefined.
+template <int W, int NR>
+static inline __m256i	FuncAvx2_load_grp (const uint8_t *ptr, int pitch)
+{
+	if (W == 32)
+	{
+		return (_mm256_loadu_si256 ((const __m256i *) ptr));
+	}
+	else if (W == 16)
+	{
+		return (  (NR == 2)
+		        ? FuncAvx2_load_2x16 (ptr, pitch)
+		        : _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) ptr)));
+	}
+	else if (NR == 4)
+	{
+		return (_mm256_inserti128_si256 (
+			_mm256_castsi128_si256 (FuncAvx2_load_2x8 (ptr, pitch)),
+			FuncAvx2_load_2x8 (ptr + pitch * 2, pitch),
+			1
+		));
+	}
+
+	return (_mm256_castsi128_si256 (FuncAvx2_load_2x8 (ptr, pitch)));
+}
+
+
+
+// Reverse of FuncAvx2_load_grp
+template <int W, int NR>
+static inline void	FuncAvx2_store_grp (uint8_t *ptr, int pitch, __m256i v)
+{
+	const __m128i	v0 = _mm256_castsi256_si128 (v);
+	const __m128i	v1 = _mm256_extracti128_si256 (v, 1);
+
+	if (W == 32)
+	{
+		_mm256_storeu_si256 ((__m256i *) ptr, v);
+	}
+	else if (W == 16)
+	{
+		_mm_storeu_si128 ((__m128i *) ptr, v0);
+		if (NR == 2)
+		{
+			_mm_storeu_si128 ((__m128i *) (ptr + pitch), v1);
+		}
+	}
+	else
+	{
+		_mm_storel_epi64 ((__m128i *) ptr,           v0);
+		_mm_storel_epi64 ((__m128i *) (ptr + pitch), _mm_srli_si128 (v0, 8));
+		if (NR == 4)
+		{
+			_mm_storel_epi64 ((__m128i *) (ptr + pitch * 2), v1);
+			_mm_storel_epi64 ((__m128i *) (ptr + pitch * 3), _mm_srli_si128 (v1, 8));
+		}
+	}
+}
+
+
+
+template <int W, int H, int NBR_REF>
+static void	SadMulti_avx2_n (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch)
+{
+	enum {	RPL = (W == 16) ? 2 : 1	};	// Rows per loop
+
+	__m256i			sum_arr [NBR_REF];
+	for (int k = 0; k < NBR_REF; ++k)
+	{
+		sum_arr [k] = _mm256_setzero_si256 ();
+	}
+
+	int				ref_ofs = 0;
+	for (int y = 0; y < H; y += RPL)
+	{
+		for (int x = 0; x < W; x += 32 / RPL)
+		{
+			const __m256i	s = FuncAvx2_load_row <W> (pSrc + x, nSrcPitch);
+			for (int k = 0; k < NBR_REF; ++k)
+			{
+				const __m256i	r =
+					FuncAvx2_load_row <W> (pRef_arr [k] + ref_ofs + x, nRefPitch);
+				sum_arr [k] = _mm256_add_epi64 (sum_arr [k], _mm256_sad_epu8 (s, r));
+			}
+		}
+		pSrc    += nSrcPitch * RPL;
+		ref_ofs += nRefPitch * RPL;
+	}
+
+	for (int k = 0; k < NBR_REF; ++k)
+	{
+		sad_arr [k] = FuncAvx2_hsum_sad (sum_arr [k]);
+	}
+}
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+template <int W, int H>
+unsigned int	Sad_avx2 (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
+{
+	enum {	RPL = (W == 16) ? 2 : 1	};
+
+	__m256i			sum = _mm256_setzero_si256 ();
+	for (int y = 0; y < H; y += RPL)
+	{
+		for (int x = 0; x < W; x += 32 / RPL)
+		{
+			const __m256i	s = FuncAvx2_load_row <W> (pSrc + x, nSrcPitch);
+			const __m256i	r = FuncAvx2_load_row <W> (pRef + x, nRefPitch);
+			sum = _mm256_add_epi64 (sum, _mm256_sad_epu8 (s, r));
+		}
+		pSrc += nSrcPitch * RPL;
+		pRef += nRefPitch * RPL;
+	}
+
+	return (FuncAvx2_hsum_sad (sum));
+}
+
+
+
+// The partial SAD is checked every 4 rows (8 rows for W = 16, as two rows
+// fit in a register).
+template <int W, int H>
+unsigned int	SadThr_avx2 (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch, unsigned int thr)
+{
+	enum {	RPL = (W == 16) ? 2 : 1	};
+	enum {	RPC = RPL * 4	};	// Rows per check. H must be a multiple of it.
+
+	__m256i			sum = _mm256_setzero_si256 ();
+	unsigned int	sad = 0;
+	for (int y = 0; y < H; y += RPC)
+	{
+		for (int k = 0; k < RPC; k += RPL)
+		{
+			for (int x = 0; x < W; x += 32 / RPL)
+			{
+				const __m256i	s = FuncAvx2_load_row <W> (pSrc + x, nSrcPitch);
+				const __m256i	r = FuncAvx2_load_row <W> (pRef + x, nRefPitch);
+				sum = _mm256_add_epi64 (sum, _mm256_sad_epu8 (s, r));
+			}
+			pSrc += nSrcPitch * RPL;
+			pRef += nRefPitch * RPL;
+		}
+		sad = FuncAvx2_hsum_sad (sum);
+		if (sad >= thr)
+		{
+			break;
+		}
+	}
+
+	return (sad);
+}
+
+
+
+template <int W, int H>
+void	SadMulti_avx2 (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref)
+{
+	assert (nbr_ref > 0);
+	assert (nbr_ref <= SAD_MULTI_MAX);
+
+	switch (nbr_ref)
+	{
+	case 1:	SadMulti_avx2_n <W, H, 1> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 2:	SadMulti_avx2_n <W, H, 2> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 3:	SadMulti_avx2_n <W, H, 3> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 4:	SadMulti_avx2_n <W, H, 4> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 5:	SadMulti_avx2_n <W, H, 5> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 6:	SadMulti_avx2_n <W, H, 6> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 7:	SadMulti_avx2_n <W, H, 7> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 8:	SadMulti_avx2_n <W, H, 8> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	default:
+		assert (false);
+		break;
+	}
+}
+
+
+
+// Loads the 15 reference bytes used by a mpsadbw pair, broadcast to both
+// lanes. With LAST, the 16th byte is not read because it may be past the
+// search window.
+template <bool LAST>
+static inline __m256i	FuncAvx2_load_mpsad_ref (const uint8_t *ptr)
+{
+	__m128i			r;
+	if (LAST)
+	{
+		r = _mm_or_si128 (
+			_mm_loadl_epi64 ((const __m128i *) ptr),
+			_mm_slli_si128 (_mm_loadl_epi64 ((const __m128i *) (ptr + 7)), 7)
+		);
+	}
+	else
+	{
+		r = _mm_loadu_si128 ((const __m128i *) ptr);
+	}
+
+	return (_mm256_broadcastsi128_si256 (r));
+}
+
+
+
+// SADs of the source block for 8 consecutive horizontal offsets.
+// Each mpsadbw scores 8 source pixels (a 4-pixel group per lane) at the 8
+// offsets. Partial sums are kept on 16 bits as long as they cannot overflow.
+template <int W, int H>
+static void	SadMap_avx2_8 (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
+{
+	// Rows per 16-bit accumulation: each mpsadbw adds at most 4 * 255
+	enum {	RPA = 64 / (W / 8)	};
+
+	// imm8: low lane in bits 0-2, high lane in bits 3-5. Bits 0-1 and 3-4
+	// select the source group, bits 2 and 5 the 0 or 4 reference offset.
+	enum {	SEL_01 = (0 << 0) | (0 << 2) | (1 << 3) | (1 << 5)	};
+	enum {	SEL_23 = (2 << 0) | (0 << 2) | (3 << 3) | (1 << 5)	};
+
+	const __m256i	z = _mm256_setzero_si256 ();
+	__m256i			sum_lo = z;
+	__m256i			sum_hi = z;
+	for (int y_beg = 0; y_beg < H; y_beg += RPA)
+	{
+		const int		y_end = (y_beg + RPA < H) ? y_beg + RPA : H;
+		__m256i			acc = z;
+		for (int y = y_beg; y < y_end; ++y)
+		{
+			const uint8_t *	s_ptr = pSrc + y * nSrcPitch;
+			const uint8_t *	r_ptr = pRef + y * nRefPitch;
+			if (W == 8)
+			{
+				const __m256i	s = _mm256_broadcastsi128_si256 (
+					_mm_loadl_epi64 ((const __m128i *) s_ptr)
+				);
+				const __m256i	r = FuncAvx2_load_mpsad_ref <true> (r_ptr);
+				acc = _mm256_add_epi16 (acc, _mm256_mpsadbw_epu8 (r, s, SEL_01));
+			}
+			else
+			{
+				for (int x = 0; x < W; x += 16)
+				{
+					const __m256i	s = _mm256_broadcastsi128_si256 (
+						_mm_loadu_si128 ((const __m128i *) (s_ptr + x))
+					);
+					const __m256i	r0 = FuncAvx2_load_mpsad_ref <false> (r_ptr + x);
+					acc = _mm256_add_epi16 (acc, _mm256_mpsadbw_epu8 (r0, s, SEL_01));
+					const __m256i	r1 = (x + 16 < W)
+						? FuncAvx2_load_mpsad_ref <false> (r_ptr + x + 8)
+						: FuncAvx2_load_mpsad_ref <true > (r_ptr + x + 8);
+					acc = _mm256_add_epi16 (acc, _mm256_mpsadbw_epu8 (r1, s, SEL_23));
+				}
+			}
+		}
+		sum_lo = _mm256_add_epi32 (sum_lo, _mm256_unpacklo_epi16 (acc, z));
+		sum_hi = _mm256_add_epi32 (sum_hi, _mm256_unpackhi_epi16 (acc, z));
+	}
+
+	// Both lanes hold the partial SADs of the same offsets
+	const __m128i	s_lo = _mm_add_epi32 (
+		_mm256_castsi256_si128 (sum_lo),
+		_mm256_extracti128_si256 (sum_lo, 1)
+	);
+	const __m128i	s_hi = _mm_add_epi32 (
+		_mm256_castsi256_si128 (sum_hi),
+		_mm256_extracti128_si256 (sum_hi, 1)
+	);
+	_mm_storeu_si128 ((__m128i *) (sad_arr    ), s_lo);
+	_mm_storeu_si128 ((__m128i *) (sad_arr + 4), s_hi);
+}
+
+
+
+// Rows of offsets are processed 8 at a time. The last group of a row
+// overlaps the previous one instead of reading past the window.
+template <int W, int H>
+void	SadMap_avx2 (unsigned int sad_arr [], int sad_stride, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch, int nbr_x, int nbr_y)
+{
+	assert (nbr_x > 0);
+	assert (nbr_x <= sad_stride);
+	assert (nbr_y > 0);
+
+	if (nbr_x < 8)
+	{
+		SadMap_sse2 <W, H> (sad_arr, sad_stride, pSrc, nSrcPitch, pRef, nRefPitch, nbr_x, nbr_y);
+		return;
+	}
+
+	for (int y = 0; y < nbr_y; ++y)
+	{
+		for (int x = 0; x < nbr_x; x += 8)
+		{
+			const int		xg = (x + 8 <= nbr_x) ? x : nbr_x - 8;
+			SadMap_avx2_8 <W, H> (sad_arr + xg, pSrc, nSrcPitch, pRef + xg, nRefPitch);
+		}
+		sad_arr += sad_stride;
+		pRef += nRefPitch;
+	}
+}
+
+
+
+template <int W, int H>
+unsigned int	Luma_avx2 (const unsigned char *pSrc, int nSrcPitch)
+{
+	enum {	RPL = (W == 16) ? 2 : 1	};
+
+	const __m256i	z = _mm256_setzero_si256 ();
+	__m256i			sum = z;
+	for (int y = 0; y < H; y += RPL)
+	{
+		for (int x = 0; x < W; x += 32 / RPL)
+		{
+			const __m256i	s = FuncAvx2_load_row <W> (pSrc + x, nSrcPitch);
+			sum = _mm256_add_epi64 (sum, _mm256_sad_epu8 (s, z));
+		}
+		pSrc += nSrcPitch * RPL;
+	}
+
+	return (FuncAvx2_hsum_sad (sum));
+}
+
+
+
+// Same rounding as Var_C. The mean absolute deviation is a SAD against a
+// flat block filled with the mean luma.
+template <int W, int H>
+unsigned int	Var_avx2 (const unsigned char *pSrc, int nSrcPitch, int *pLuma)
+{
+	enum {	RPL = (W == 16) ? 2 : 1	};
+
+	const int		luma = int (Luma_avx2 <W, H> (pSrc, nSrcPitch));
+	*pLuma = luma;
+	const int		mean = (luma + ((W * H) >> 1)) / (W * H);
+
+	const __m256i	m = _mm256_set1_epi8 (char (mean));
+	__m256i			sum = _mm256_setzero_si256 ();
+	for (int y = 0; y < H; y += RPL)
+	{
+		for (int x = 0; x < W; x += 32 / RPL)
+		{
+			const __m256i	s = FuncAvx2_load_row <W> (pSrc + x, nSrcPitch);
+			sum = _mm256_add_epi64 (sum, _mm256_sad_epu8 (s, m));
+		}
+		pSrc += nSrcPitch * RPL;
+	}
+
+	return (FuncAvx2_hsum_sad (sum));
+}
+
+
+
+template <int W, int H>
+void	Copy_avx2 (uint8_t *pDst, int nDstPitch, const uint8_t *pSrc, int nSrcPitch)
+{
+	for (int y = 0; y < H; ++y)
+	{
+		for (int x = 0; x < W; x += 32)
+		{
+			_mm256_storeu_si256 (
+				(__m256i *) (pDst + x),
+				_mm256_loadu_si256 ((const __m256i *) (pSrc + x))
+			);
+		}
+		pDst += nDstPitch;
+		pSrc += nSrcPitch;
+	}
+}
+
+
+
+// Same arithmetic as Overlaps_sse2: 32-bit products, rounding, saturated
+// accumulation.
+template <int W, int H>
+void	Overlaps_avx2 (unsigned short *pDst, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch)
+{
+	const __m256i	r = _mm256_set1_epi32 (256);
+
+	for (int y = 0; y < H; ++y)
+	{
+		for (int x = 0; x < W; x += 16)
+		{
+			const __m256i	s  = _mm256_cvtepu8_epi16 (
+				_mm_loadu_si128 ((const __m128i *) (pSrc + x))
+			);
+			const __m256i	w  = _mm256_loadu_si256 ((const __m256i *) (pWin + x));
+			const __m256i	lo = _mm256_mullo_epi16 (s, w);
+			const __m256i	hi = _mm256_mulhi_epi16 (s, w);
+			__m256i			p0 = _mm256_unpacklo_epi16 (lo, hi);
+			__m256i			p1 = _mm256_unpackhi_epi16 (lo, hi);
+			p0 = _mm256_srli_epi32 (_mm256_add_epi32 (p0, r), 6);
+			p1 = _mm256_srli_epi32 (_mm256_add_epi32 (p1, r), 6);
+			// unpack and pack both work within 128-bit lanes, so the initial
+			// order is restored.
+			const __m256i	v  = _mm256_packs_epi32 (p0, p1);
+			__m256i *		d_ptr = (__m256i *) (pDst + x);
+			_mm256_storeu_si256 (d_ptr, _mm256_adds_epu16 (v, _mm256_loadu_si256 (d_ptr)));
+		}
+		pDst += nDstPitch;
+		pSrc += nSrcPitch;
+		pWin += nWinPitch;
+	}
+}
+
+
+
+// Weighted average of the source and reference blocks. Each iteration
+// processes 32 pixels, from NR consecutive rows (NR = 1 for W == 32, 2 for
+// W == 16 and 4 for W == 8, fewer if the block is not high enough).
+// The backward and forward references of the same distance are interleaved
+// and summed with a single pmaddubsw. Pixels are made signed by subtracting
+// 128 so the weights (<= 255) are the unsigned operand, the pair sum fits in
+// 16 bits without saturation because the weights of a pair total <= 256. The
+// 128 * 256 offset is restored at the end, modulo 2^16. The source weight
+// may reach 256, so it is split in two and the source is paired with itself.
+// Results are identical to DegrainN_C.
+template <int W, int H, bool LSB>
+static void	DegrainN_avx2_proc (unsigned char *pDst, unsigned char *pDstLsb, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad)
+{
+	enum {	NR = (W >= 32) ? 1 : (32 / W < H) ? 32 / W : H	};
+
+	assert (W <= 32);
+	assert (trad <= DegrainN_MAX_TRAD);
+	assert (Wall [0] >= 0);
+	assert (Wall [0] <= 256);
+
+	// Weight pairs, computed once for the whole block
+	__m256i			wgt_arr [1 + DegrainN_MAX_TRAD];
+	const int		ws_h = Wall [0] >> 1;
+	wgt_arr [0] = _mm256_set1_epi16 (short (ws_h + ((Wall [0] - ws_h) << 8)));
+	for (int k = 0; k < trad; ++k)
+	{
+		assert (Wall [k * 2 + 1] + Wall [k * 2 + 2] <= 256);
+		wgt_arr [k + 1] = _mm256_set1_epi16 (
+			short (Wall [k * 2 + 1] + (Wall [k * 2 + 2] << 8))
+		);
+	}
+
+	const __m256i	sgn  = _mm256_set1_epi8 (char (0x80));
+	const __m256i	bias = _mm256_set1_epi16 (short (LSB ? 0x8000 : 0x8080));
+	const __m256i	m    = _mm256_set1_epi16 (255);
+
+	for (int y = 0; y < H; y += NR)
+	{
+		const __m256i	s  = _mm256_xor_si256 (
+			FuncAvx2_load_grp <W, NR> (pSrc, nSrcPitch), sgn
+		);
+		__m256i			lo = _mm256_maddubs_epi16 (wgt_arr [0], _mm256_unpacklo_epi8 (s, s));
+		__m256i			hi = _mm256_maddubs_epi16 (wgt_arr [0], _mm256_unpackhi_epi8 (s, s));
+		for (int k = 0; k < trad; ++k)
+		{
+			const __m256i	rb = _mm256_xor_si256 (
+				FuncAvx2_load_grp <W, NR> (pRef [k * 2    ], Pitch [k * 2    ]), sgn
+			);
+			const __m256i	rf = _mm256_xor_si256 (
+				FuncAvx2_load_grp <W, NR> (pRef [k * 2 + 1], Pitch [k * 2 + 1]), sgn
+			);
+			const __m256i	w  = wgt_arr [k + 1];
+			lo = _mm256_add_epi16 (lo, _mm256_maddubs_epi16 (w, _mm256_unpacklo_epi8 (rb, rf)));
+			hi = _mm256_add_epi16 (hi, _mm256_maddubs_epi16 (w, _mm256_unpackhi_epi8 (rb, rf)));
+		}
+		lo = _mm256_add_epi16 (lo, bias);
+		hi = _mm256_add_epi16 (hi, bias);
+
+		// unpack and pack both work within 128-bit lanes, so the initial
+		// order is restored.
+		FuncAvx2_store_grp <W, NR> (pDst, nDstPitch, _mm256_packus_epi16 (
+			_mm256_srli_epi16 (lo, 8),
+			_mm256_srli_epi16 (hi, 8)
+		));
+		if (LSB)
+		{
+			FuncAvx2_store_grp <W, NR> (pDstLsb, nDstPitch, _mm256_packus_epi16 (
+				_mm256_and_si256 (lo, m),
+				_mm256_and_si256 (hi, m)
+			));
+		}
+
+		pDst    += nDstPitch * NR;
+		pDstLsb += nDstPitch * NR;
+		pSrc    += nSrcPitch * NR;
+		for (int k = 0; k < trad * 2; ++k)
+		{
+			pRef [k] += Pitch [k] * NR;
+		}
+	}
+}
+
+
+
+template <int W, int H>
+void	DegrainN_avx2 (unsigned char *pDst, unsigned char *pDstLsb, bool lsb_flag, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad)
+{
+	if (lsb_flag)
+	{
+		DegrainN_avx2_proc <W, H, true > (pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad);
+	}
+	else
+	{
+		DegrainN_avx2_proc <W, H, false> (pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad);
+	}
+}
+
+
+
+#define FuncAvx2_INST_SAD(w, h) \
+	template unsigned int	Sad_avx2 <w, h> (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch); \
+	template void	SadMulti_avx2 <w, h> (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref); \
+	template unsigned int	Var_avx2 <w, h> (const unsigned char *pSrc, int nSrcPitch, int *pLuma); \
+	template unsigned int	Luma_avx2 <w, h> (const unsigned char *pSrc, int nSrcPitch);
+
+#define FuncAvx2_INST_THR(w, h) \
+	template unsigned int	SadThr_avx2 <w, h> (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch, unsigned int thr);
+
+#define FuncAvx2_INST_MAP(w, h) \
+	template void	SadMap_avx2 <w, h> (unsigned int sad_arr [], int sad_stride, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch, int nbr_x, int nbr_y);
+
+#define FuncAvx2_INST_COPY(w, h) \
+	template void	Copy_avx2 <w, h> (uint8_t *pDst, int nDstPitch, const uint8_t *pSrc, int nSrcPitch);
+
+#define FuncAvx2_INST_OVR(w, h) \
+	template void	Overlaps_avx2 <w, h> (unsigned short *pDst, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch);
+
+#define FuncAvx2_INST_DEG(w, h) \
+	template void	DegrainN_avx2 <w, h> (unsigned char *pDst, unsigned char *pDstLsb, bool lsb_flag, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad);
+
+FuncAvx2_INST_SAD (32, 32)
+FuncAvx2_INST_SAD (32, 16)
+FuncAvx2_INST_SAD (16, 32)
+FuncAvx2_INST_SAD (16, 16)
+FuncAvx2_INST_SAD (16,  8)
+FuncAvx2_INST_SAD (16,  2)
+
+FuncAvx2_INST_THR (32, 32)
+FuncAvx2_INST_THR (32, 16)
+FuncAvx2_INST_THR (16, 32)
+FuncAvx2_INST_THR (16, 16)
+FuncAvx2_INST_THR (16,  8)
+
+FuncAvx2_INST_MAP (32, 32)
+FuncAvx2_INST_MAP (32, 16)
+FuncAvx2_INST_MAP (16, 32)
+FuncAvx2_INST_MAP (16, 16)
+FuncAvx2_INST_MAP (16,  8)
+FuncAvx2_INST_MAP (16,  2)
+FuncAvx2_INST_MAP (16,  1)
+FuncAvx2_INST_MAP ( 8, 16)
+FuncAvx2_INST_MAP ( 8,  8)
+FuncAvx2_INST_MAP ( 8,  4)
+FuncAvx2_INST_MAP ( 8,  2)
+FuncAvx2_INST_MAP ( 8,  1)
+
+FuncAvx2_INST_COPY (32, 32)
+FuncAvx2_INST_COPY (32, 16)
+
+FuncAvx2_INST_OVR (32, 32)
+FuncAvx2_INST_OVR (32, 16)
+FuncAvx2_INST_OVR (16, 32)
+FuncAvx2_INST_OVR (16, 16)
+FuncAvx2_INST_OVR (16,  8)
+FuncAvx2_INST_OVR (16,  2)
+FuncAvx2_INST_OVR (16,  1)
+
+FuncAvx2_INST_DEG (32, 32)
+FuncAvx2_INST_DEG (32, 16)
+FuncAvx2_INST_DEG (16, 32)
+FuncAvx2_INST_DEG (16, 16)
+FuncAvx2_INST_DEG (16,  8)
+FuncAvx2_INST_DEG (16,  2)
+FuncAvx2_INST_DEG (16,  1)
+FuncAvx2_INST_DEG ( 8, 16)
+FuncAvx2_INST_DEG ( 8,  8)
+FuncAvx2_INST_DEG ( 8,  4)
+FuncAvx2_INST_DEG ( 8,  2)
+
+#undef FuncAvx2_INST_SAD
+#undef FuncAvx2_INST_THR
+#undef FuncAvx2_INST_MAP
+#undef FuncAvx2_INST_COPY
+#undef FuncAvx2_INST_OVR
+#undef FuncAvx2_INST_DEG
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,74 @@
+/*****************************************************************************
+
+        FuncAvx2.h
+        Author: agent, 2026
+
+AVX2 versions of the block kernels. They are only declared here and
+explicitly instantiated in FuncAvx2.cpp for the block sizes that fill at
+least a full 256-bit register per iteration. The smaller sizes keep the
+SSE2/iSSE code. Access these functions through FuncDispatch rather than
+directly, because they must never be called on a CPU without AVX2 support.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (FuncAvx2_HEADER_INCLUDED)
+#define	FuncAvx2_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"types.h"
+
+
+
+// Sizes: 32x32, 32x16, 16x32, 16x16, 16x8, 16x2 (no SadThr_avx2 for 16x2)
+template <int W, int H>
+unsigned int	Sad_avx2 (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch);
+template <int W, int H>
+unsigned int	SadThr_avx2 (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch, unsigned int thr);
+template <int W, int H>
+void	SadMulti_avx2 (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref);
+template <int W, int H>
+unsigned int	Var_avx2 (const unsigned char *pSrc, int nSrcPitch, int *pLuma);
+template <int W, int H>
+unsigned int	Luma_avx2 (const unsigned char *pSrc, int nSrcPitch);
+
+// Sizes: 32x32, 32x16, 16x32, 16x16, 16x8, 16x2, 16x1, 8x16, 8x8, 8x4, 8x2, 8x1
+template <int W, int H>
+void	SadMap_avx2 (unsigned int sad_arr [], int sad_stride, const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch, int nbr_x, int nbr_y);
+
+// Sizes: 32x32, 32x16
+template <int W, int H>
+void	Copy_avx2 (uint8_t *pDst, int nDstPitch, const uint8_t *pSrc, int nSrcPitch);
+
+// Sizes: 32x32, 32x16, 16x32, 16x16, 16x8, 16x2, 16x1
+template <int W, int H>
+void	Overlaps_avx2 (unsigned short *pDst, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, short *pWin, int nWinPitch);
+
+// Sizes: 32x32, 32x16, 16x32, 16x16, 16x8, 16x2, 16x1, 8x16, 8x8, 8x4, 8x2
+template <int W, int H>
+void	DegrainN_avx2 (unsigned char *pDst, unsigned char *pDstLsb, bool lsb_flag, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad);
+
+
+
+#endif	// FuncAvx2_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
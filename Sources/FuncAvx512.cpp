@@ -0,0 +1,306 @@
+/*****************************************************************************
+
+        FuncAvx512.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"DegrainNFnc.h"
+#include	"FuncAvx512.h"
+#include	"SADFunctions.h"
+
+#include	<immintrin.h>
+
+#include	<cassert>
+
+
+
+/*\\\ STATIC FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+static inline unsigned int	FuncAvx512_hsum_sad (__m512i sum)
+{
+	const __m256i	s2 = _mm256_add_epi64 (
+		_mm512_castsi512_si256 (sum),
+		_mm512_extracti64x4_epi64 (sum, 1)
+	);
+	const __m128i	s1 = _mm_add_epi64 (
+		_mm256_castsi256_si128 (s2),
+		_mm256_extracti128_si256 (s2, 1)
+	);
+
+	return (_mm_cvtsi128_si32 (_mm_add_epi64 (s1, _mm_srli_si128 (s1, 8))));
+}
+
+
+
+static inline __m256i	FuncAvx512_load_2x16 (const uint8_t *ptr, int pitch)
+{
+	return (_mm256_inserti128_si256 (
+		_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) ptr)),
+		_mm_loadu_si128 ((const __m128i *) (ptr + pitch)),
+		1
+	));
+}
+
+
+
+// Gets 64 pixels from two 32-pixel rows (W == 32) or four 16-pixel rows
+// (W == 16).
+template <int W>
+static inline __m512i	FuncAvx512_load_rows (const uint8_t *ptr, int pitch)
+{
+	if (W == 16)
+	{
+		return (_mm512_inserti64x4 (
+			_mm512_castsi256_si512 (FuncAvx512_load_2x16 (ptr, pitch)),
+			FuncAvx512_load_2x16 (ptr + pitch * 2, pitch),
+			1
+		));
+	}
+
+	return (_mm512_inserti64x4 (
+		_mm512_castsi256_si512 (_mm256_loadu_si256 ((const __m256i *) ptr)),
+		_mm256_loadu_si256 ((const __m256i *) (ptr + pitch)),
+		1
+	));
+}
+
+
+
+// Reverse of FuncAvx512_load_rows
+template <int W>
+static inline void	FuncAvx512_store_rows (uint8_t *ptr, int pitch, __m512i v)
+{
+	const __m256i	v0 = _mm512_castsi512_si256 (v);
+	const __m256i	v1 = _mm512_extracti64x4_epi64 (v, 1);
+
+	if (W == 16)
+	{
+		_mm_storeu_si128 ((__m128i *) ptr              , _mm256_castsi256_si128 (v0));
+		_mm_storeu_si128 ((__m128i *) (ptr + pitch    ), _mm256_extracti128_si256 (v0, 1));
+		_mm_storeu_si128 ((__m128i *) (ptr + pitch * 2), _mm256_castsi256_si128 (v1));
+		_mm_storeu_si128 ((__m128i *) (ptr + pitch * 3), _mm256_extracti128_si256 (v1, 1));
+	}
+	else
+	{
+		_mm256_storeu_si256 ((__m256i *) ptr          , v0);
+		_mm256_storeu_si256 ((__m256i *) (ptr + pitch), v1);
+	}
+}
+
+
+
+template <int W, int H, int NBR_REF>
+static void	SadMulti_avx512_n (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch)
+{
+	enum {	RPL = 64 / W	};	// Rows per loop
+
+	__m512i			sum_arr [NBR_REF];
+	for (int k = 0; k < NBR_REF; ++k)
+	{
+		sum_arr [k] = _mm512_setzero_si512 ();
+	}
+
+	int				ref_ofs = 0;
+	for (int y = 0; y < H; y += RPL)
+	{
+		const __m512i	s = FuncAvx512_load_rows <W> (pSrc, nSrcPitch);
+		for (int k = 0; k < NBR_REF; ++k)
+		{
+			const __m512i	r =
+				FuncAvx512_load_rows <W> (pRef_arr [k] + ref_ofs, nRefPitch);
+			sum_arr [k] = _mm512_add_epi64 (sum_arr [k], _mm512_sad_epu8 (s, r));
+		}
+		pSrc    += nSrcPitch * RPL;
+		ref_ofs += nRefPitch * RPL;
+	}
+
+	for (int k = 0; k < NBR_REF; ++k)
+	{
+		sad_arr [k] = FuncAvx512_hsum_sad (sum_arr [k]);
+	}
+}
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+template <int W, int H>
+unsigned int	Sad_avx512 (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch)
+{
+	enum {	RPL = 64 / W	};
+
+	__m512i			sum = _mm512_setzero_si512 ();
+	for (int y = 0; y < H; y += RPL)
+	{
+		const __m512i	s = FuncAvx512_load_rows <W> (pSrc, nSrcPitch);
+		const __m512i	r = FuncAvx512_load_rows <W> (pRef, nRefPitch);
+		sum = _mm512_add_epi64 (sum, _mm512_sad_epu8 (s, r));
+		pSrc += nSrcPitch * RPL;
+		pRef += nRefPitch * RPL;
+	}
+
+	return (FuncAvx512_hsum_sad (sum));
+}
+
+
+
+template <int W, int H>
+void	SadMulti_avx512 (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref)
+{
+	assert (nbr_ref > 0);
+	assert (nbr_ref <= SAD_MULTI_MAX);
+
+	switch (nbr_ref)
+	{
+	case 1:	SadMulti_avx512_n <W, H, 1> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 2:	SadMulti_avx512_n <W, H, 2> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 3:	SadMulti_avx512_n <W, H, 3> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 4:	SadMulti_avx512_n <W, H, 4> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 5:	SadMulti_avx512_n <W, H, 5> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 6:	SadMulti_avx512_n <W, H, 6> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 7:	SadMulti_avx512_n <W, H, 7> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	case 8:	SadMulti_avx512_n <W, H, 8> (sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch);	break;
+	default:
+		assert (false);
+		break;
+	}
+}
+
+
+
+// 64 pixels per iteration, from two rows (W == 32) or four rows (W == 16).
+// Same pmaddubsw pairing as DegrainN_avx2, see the comments there.
+template <int W, int H, bool LSB>
+static void	DegrainN_avx512_proc (unsigned char *pDst, unsigned char *pDstLsb, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad)
+{
+	enum {	RPL = 64 / W	};
+
+	assert (trad <= DegrainN_MAX_TRAD);
+	assert (Wall [0] >= 0);
+	assert (Wall [0] <= 256);
+
+	__m512i			wgt_arr [1 + DegrainN_MAX_TRAD];
+	const int		ws_h = Wall [0] >> 1;
+	wgt_arr [0] = _mm512_set1_epi16 (short (ws_h + ((Wall [0] - ws_h) << 8)));
+	for (int k = 0; k < trad; ++k)
+	{
+		assert (Wall [k * 2 + 1] + Wall [k * 2 + 2] <= 256);
+		wgt_arr [k + 1] = _mm512_set1_epi16 (
+			short (Wall [k * 2 + 1] + (Wall [k * 2 + 2] << 8))
+		);
+	}
+
+	const __m512i	sgn  = _mm512_set1_epi8 (char (0x80));
+	const __m512i	bias = _mm512_set1_epi16 (short (LSB ? 0x8000 : 0x8080));
+	const __m512i	m    = _mm512_set1_epi16 (255);
+
+	for (int y = 0; y < H; y += RPL)
+	{
+		const __m512i	s  = _mm512_xor_si512 (
+			FuncAvx512_load_rows <W> (pSrc, nSrcPitch), sgn
+		);
+		__m512i			lo = _mm512_maddubs_epi16 (wgt_arr [0], _mm512_unpacklo_epi8 (s, s));
+		__m512i			hi = _mm512_maddubs_epi16 (wgt_arr [0], _mm512_unpackhi_epi8 (s, s));
+		for (int k = 0; k < trad; ++k)
+		{
+			const __m512i	rb = _mm512_xor_si512 (
+				FuncAvx512_load_rows <W> (pRef [k * 2    ], Pitch [k * 2    ]), sgn
+			);
+			const __m512i	rf = _mm512_xor_si512 (
+				FuncAvx512_load_rows <W> (pRef [k * 2 + 1], Pitch [k * 2 + 1]), sgn
+			);
+			const __m512i	w  = wgt_arr [k + 1];
+			lo = _mm512_add_epi16 (lo, _mm512_maddubs_epi16 (w, _mm512_unpacklo_epi8 (rb, rf)));
+			hi = _mm512_add_epi16 (hi, _mm512_maddubs_epi16 (w, _mm512_unpackhi_epi8 (rb, rf)));
+		}
+		lo = _mm512_add_epi16 (lo, bias);
+		hi = _mm512_add_epi16 (hi, bias);
+
+		FuncAvx512_store_rows <W> (pDst, nDstPitch, _mm512_packus_epi16 (
+			_mm512_srli_epi16 (lo, 8),
+			_mm512_srli_epi16 (hi, 8)
+		));
+		if (LSB)
+		{
+			FuncAvx512_store_rows <W> (pDstLsb, nDstPitch, _mm512_packus_epi16 (
+				_mm512_and_si512 (lo, m),
+				_mm512_and_si512 (hi, m)
+			));
+		}
+
+		pDst    += nDstPitch * RPL;
+		pDstLsb += nDstPitch * RPL;
+		pSrc    += nSrcPitch * RPL;
+		for (int k = 0; k < trad * 2; ++k)
+		{
+			pRef [k] += Pitch [k] * RPL;
+		}
+	}
+}
+
+
+
+template <int W, int H>
+void	DegrainN_avx512 (unsigned char *pDst, unsigned char *pDstLsb, bool lsb_flag, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad)
+{
+	if (lsb_flag)
+	{
+		DegrainN_avx512_proc <W, H, true > (pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad);
+	}
+	else
+	{
+		DegrainN_avx512_proc <W, H, false> (pDst, pDstLsb, nDstPitch, pSrc, nSrcPitch, pRef, Pitch, Wall, trad);
+	}
+}
+
+
+
+#define FuncAvx512_INST_SAD(w, h) \
+	template unsigned int	Sad_avx512 <w, h> (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch); \
+	template void	SadMulti_avx512 <w, h> (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref);
+
+#define FuncAvx512_INST_DEG(w, h) \
+	template void	DegrainN_avx512 <w, h> (unsigned char *pDst, unsigned char *pDstLsb, bool lsb_flag, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad);
+
+FuncAvx512_INST_SAD (32, 32)
+FuncAvx512_INST_SAD (32, 16)
+FuncAvx512_INST_SAD (16, 32)
+FuncAvx512_INST_SAD (16, 16)
+FuncAvx512_INST_SAD (16,  8)
+
+FuncAvx512_INST_DEG (32, 32)
+FuncAvx512_INST_DEG (32, 16)
+FuncAvx512_INST_DEG (16, 32)
+FuncAvx512_INST_DEG (16, 16)
+FuncAvx512_INST_DEG (16,  8)
+
+#undef FuncAvx512_INST_SAD
+#undef FuncAvx512_INST_DEG
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
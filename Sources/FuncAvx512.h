@@ -0,0 +1,54 @@
+/*****************************************************************************
+
+        FuncAvx512.h
+        Author: agent, 2026
+
+AVX-512 (F + BW) versions of the block kernels, for the sizes where a
+512-bit register can be filled. The other sizes keep the AVX2 or SSE2
+code. Same usage restrictions as FuncAvx2.h.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (FuncAvx512_HEADER_INCLUDED)
+#define	FuncAvx512_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"types.h"
+
+
+
+// Sizes: 32x32, 32x16, 16x32, 16x16, 16x8
+template <int W, int H>
+unsigned int	Sad_avx512 (const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef, int nRefPitch);
+template <int W, int H>
+void	SadMulti_avx512 (unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch, const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref);
+
+// Sizes: 32x32, 32x16, 16x32, 16x16, 16x8
+template <int W, int H>
+void	DegrainN_avx512 (unsigned char *pDst, unsigned char *pDstLsb, bool lsb_flag, int nDstPitch, const unsigned char *pSrc, int nSrcPitch, const unsigned char *pRef [], int Pitch [], int Wall [], int trad);
+
+
+
+#endif	// FuncAvx512_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,269 @@
+/*****************************************************************************
+
+        FuncDispatch.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"AnaFlags.h"
+#include	"cpu.h"
+#include	"FuncAvx2.h"
+#include	"FuncAvx512.h"
+#include	"FuncDispatch.h"
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// cpu_flags: CPU_* flags from AnaFlags, as returned by cpu_detect().
+FuncDispatch::Tier	FuncDispatch::select_tier (bool isse_flag, unsigned int cpu_flags)
+{
+	Tier				tier = Tier_C;
+
+	if (isse_flag)
+	{
+		if ((cpu_flags & CPU_AVX512BW) != 0)
+		{
+			tier = Tier_AVX512;
+		}
+		else if ((cpu_flags & CPU_AVX2) != 0)
+		{
+			tier = Tier_AVX2;
+		}
+		else if ((cpu_flags & CPU_SSE2) != 0)
+		{
+			tier = Tier_SSE2;
+		}
+		else
+		{
+			tier = Tier_ISSE;
+		}
+	}
+
+	return (tier);
+}
+
+
+
+FuncDispatch::Tier	FuncDispatch::select_tier (bool isse_flag)
+{
+	return (select_tier (isse_flag, isse_flag ? cpu_detect () : 0));
+}
+
+
+
+// Returns false if the block size is not supported. In this case, fnc is
+// left untouched.
+bool	FuncDispatch::find (BlockFnc &fnc, int blk_w, int blk_h, Tier tier)
+{
+	assert (tier >= 0);
+	assert (tier < Tier_NBR_ELT);
+
+	const int		index = find_size (blk_w, blk_h);
+	if (index < 0)
+	{
+		return (false);
+	}
+
+	fnc = _fnc_arr [Tier_C] [index];
+	for (int t = Tier_C + 1; t <= tier; ++t)
+	{
+		const BlockFnc &	ovr = _fnc_arr [t] [index];
+		if (ovr._sad_ptr != 0)          { fnc._sad_ptr          = ovr._sad_ptr;          }
+		if (ovr._sad_multi_ptr != 0)    { fnc._sad_multi_ptr    = ovr._sad_multi_ptr;    }
+		if (ovr._sad_map_ptr != 0)      { fnc._sad_map_ptr      = ovr._sad_map_ptr;      }
+		if (ovr._sad_thr_ptr != 0)      { fnc._sad_thr_ptr      = ovr._sad_thr_ptr;      }
+		if (ovr._var_ptr != 0)          { fnc._var_ptr          = ovr._var_ptr;          }
+		if (ovr._luma_ptr != 0)         { fnc._luma_ptr         = ovr._luma_ptr;         }
+		if (ovr._copy_ptr != 0)         { fnc._copy_ptr         = ovr._copy_ptr;         }
+		if (ovr._overlaps_ptr != 0)     { fnc._overlaps_ptr     = ovr._overlaps_ptr;     }
+		if (ovr._overlaps_lsb_ptr != 0) { fnc._overlaps_lsb_ptr = ovr._overlaps_lsb_ptr; }
+		if (ovr._degrain_n_ptr != 0)    { fnc._degrain_n_ptr    = ovr._degrain_n_ptr;    }
+	}
+
+	return (true);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+int	FuncDispatch::find_size (int blk_w, int blk_h)
+{
+	for (int index = 0; index < NBR_SIZES; ++index)
+	{
+		if (_size_arr [index] [0] == blk_w && _size_arr [index] [1] == blk_h)
+		{
+			return (index);
+		}
+	}
+
+	return (-1);
+}
+
+
+
+const int	FuncDispatch::_size_arr [NBR_SIZES] [2] =
+{
+	{ 32, 32 }, { 32, 16 },
+	{ 16, 32 }, { 16, 16 }, { 16,  8 }, { 16,  2 }, { 16,  1 },
+	{  8, 16 }, {  8,  8 }, {  8,  4 }, {  8,  2 }, {  8,  1 },
+	{  4,  8 }, {  4,  4 }, {  4,  2 },
+	{  2,  4 }, {  2,  2 }
+};
+
+
+
+// Field order: sad, sad_multi, sad_map, sad_thr, var, luma, copy, overlaps,
+// overlaps_lsb, degrain_n. 0 = inherited from the lower tier.
+// sad_thr is only set for the sizes having a SIMD kernel. Elsewhere it stays
+// 0 and the callers use the plain SAD, which is faster than an early
+// termination in C.
+
+#define FuncDispatch_C(w, h) \
+	{	Sad_C <w, h>, SadMulti_C <w, h>, SadMap_C <w, h>, 0, Var_C <w, h>, Luma_C <w, h>, Copy_C <w, h>, \
+		Overlaps_C <w, h>, OverlapsLsb_C <w, h>, DegrainN_C <w, h>	}
+
+#define FuncDispatch_ISSE(w, h, deg) \
+	{	Sad##w##x##h##_iSSE, 0, 0, 0, 0, 0, 0, 0, 0, deg	}
+
+// Widths 2 keep Overlaps_C, as in the original filters.
+#define FuncDispatch_SSE2(w, h, thr, var, luma, copy, ovr, deg) \
+	{	0, SadMulti_sse2 <w, h>, SadMap_sse2 <w, h>, thr, var, luma, copy, ovr, 0, deg	}
+
+#define FuncDispatch_NONE \
+	{	0, 0, 0, 0, 0, 0, 0, 0, 0, 0	}
+
+const FuncDispatch::BlockFnc	FuncDispatch::_fnc_arr [Tier_NBR_ELT] [NBR_SIZES] =
+{
+	// Tier_C
+	{
+		FuncDispatch_C (32, 32), FuncDispatch_C (32, 16),
+		FuncDispatch_C (16, 32), FuncDispatch_C (16, 16), FuncDispatch_C (16,  8), FuncDispatch_C (16,  2), FuncDispatch_C (16,  1),
+		FuncDispatch_C ( 8, 16), FuncDispatch_C ( 8,  8), FuncDispatch_C ( 8,  4), FuncDispatch_C ( 8,  2), FuncDispatch_C ( 8,  1),
+		FuncDispatch_C ( 4,  8), FuncDispatch_C ( 4,  4), FuncDispatch_C ( 4,  2),
+		FuncDispatch_C ( 2,  4), FuncDispatch_C ( 2,  2)
+	},
+
+	// Tier_ISSE
+	{
+		FuncDispatch_ISSE (32, 32, (DegrainN_mmx <32, 32>)),
+		FuncDispatch_ISSE (32, 16, (DegrainN_mmx <32, 16>)),
+		FuncDispatch_ISSE (16, 32, (DegrainN_mmx <16, 32>)),
+		FuncDispatch_ISSE (16, 16, (DegrainN_mmx <16, 16>)),
+		FuncDispatch_ISSE (16,  8, (DegrainN_mmx <16,  8>)),
+		FuncDispatch_ISSE (16,  2, (DegrainN_mmx <16,  2>)),
+		FuncDispatch_ISSE (16,  1, (DegrainN_mmx <16,  1>)),
+		FuncDispatch_ISSE ( 8, 16, (DegrainN_mmx < 8, 16>)),
+		FuncDispatch_ISSE ( 8,  8, (DegrainN_mmx < 8,  8>)),
+		FuncDispatch_ISSE ( 8,  4, (DegrainN_mmx < 8,  4>)),
+		FuncDispatch_ISSE ( 8,  2, (DegrainN_mmx < 8,  2>)),
+		FuncDispatch_ISSE ( 8,  1, (DegrainN_mmx < 8,  1>)),
+		FuncDispatch_ISSE ( 4,  8, (DegrainN_mmx < 4,  8>)),
+		FuncDispatch_ISSE ( 4,  4, (DegrainN_mmx < 4,  4>)),
+		FuncDispatch_ISSE ( 4,  2, (DegrainN_mmx < 4,  2>)),
+		FuncDispatch_ISSE ( 2,  4, 0),
+		FuncDispatch_ISSE ( 2,  2, 0)
+	},
+
+	// Tier_SSE2
+	{
+		FuncDispatch_SSE2 (32, 32, (SadThr_sse2 <32, 32>), Var32x32_sse2, Luma32x32_sse2, Copy32x32_sse2, Overlaps32x32_sse2, (DegrainN_sse2 <32, 32>)),
+		FuncDispatch_SSE2 (32, 16, (SadThr_sse2 <32, 16>), Var32x16_sse2, Luma32x16_sse2, Copy32x16_sse2, Overlaps32x16_sse2, (DegrainN_sse2 <32, 16>)),
+		FuncDispatch_SSE2 (16, 32, (SadThr_sse2 <16, 32>), Var16x32_sse2, Luma16x32_sse2, Copy16x32_sse2, Overlaps16x32_sse2, (DegrainN_sse2 <16, 32>)),
+		FuncDispatch_SSE2 (16, 16, (SadThr_sse2 <16, 16>), Var16x16_sse2, Luma16x16_sse2, Copy16x16_sse2, Overlaps16x16_sse2, (DegrainN_sse2 <16, 16>)),
+		FuncDispatch_SSE2 (16,  8, (SadThr_sse2 <16,  8>), Var16x8_sse2 , Luma16x8_sse2 , Copy16x8_sse2 , Overlaps16x8_sse2 , (DegrainN_sse2 <16,  8>)),
+		FuncDispatch_SSE2 (16,  2, 0                     , Var16x2_sse2 , Luma16x2_sse2 , Copy16x2_sse2 , Overlaps16x2_sse2 , (DegrainN_sse2 <16,  2>)),
+		FuncDispatch_SSE2 (16,  1, 0                     , 0            , 0             , 0             , 0                 , (DegrainN_sse2 <16,  1>)),
+		FuncDispatch_SSE2 ( 8, 16, (SadThr_sse2 < 8, 16>), 0            , 0             , Copy8x16_sse2 , Overlaps8x16_sse2 , (DegrainN_sse2 < 8, 16>)),
+		FuncDispatch_SSE2 ( 8,  8, (SadThr_sse2 < 8,  8>), Var8x8_sse2  , Luma8x8_sse2  , Copy8x8_sse2  , Overlaps8x8_sse2  , (DegrainN_sse2 < 8,  8>)),
+		FuncDispatch_SSE2 ( 8,  4, (SadThr_sse2 < 8,  4>), Var8x4_sse2  , Luma8x4_sse2  , Copy8x4_sse2  , Overlaps8x4_sse2  , (DegrainN_sse2 < 8,  4>)),
+		FuncDispatch_SSE2 ( 8,  2, 0                     , 0            , 0             , Copy8x2_sse2  , Overlaps8x2_sse2  , (DegrainN_sse2 < 8,  2>)),
+		FuncDispatch_SSE2 ( 8,  1, 0                     , 0            , 0             , Copy8x1_sse2  , Overlaps8x1_sse2  , (DegrainN_sse2 < 8,  1>)),
+		FuncDispatch_SSE2 ( 4,  8, 0                     , 0            , 0             , Copy4x8_sse2  , Overlaps4x8_sse2  , 0),
+		FuncDispatch_SSE2 ( 4,  4, 0                     , Var4x4_sse2  , Luma4x4_sse2  , Copy4x4_sse2  , Overlaps4x4_sse2  , 0),
+		FuncDispatch_SSE2 ( 4,  2, 0                     , 0            , 0             , Copy4x2_sse2  , Overlaps4x2_sse2  , 0),
+		FuncDispatch_SSE2 ( 2,  4, 0                     , 0            , 0             , Copy2x4_sse2  , 0                 , 0),
+		FuncDispatch_SSE2 ( 2,  2, 0                     , 0            , 0             , Copy2x2_sse2  , 0                 , 0)
+	},
+
+	// Tier_AVX2
+	{
+		{ Sad_avx2 <32, 32>, SadMulti_avx2 <32, 32>, SadMap_avx2 <32, 32>, SadThr_avx2 <32, 32>, Var_avx2 <32, 32>, Luma_avx2 <32, 32>, Copy_avx2 <32, 32>, Overlaps_avx2 <32, 32>, 0, DegrainN_avx2 <32, 32> },
+		{ Sad_avx2 <32, 16>, SadMulti_avx2 <32, 16>, SadMap_avx2 <32, 16>, SadThr_avx2 <32, 16>, Var_avx2 <32, 16>, Luma_avx2 <32, 16>, Copy_avx2 <32, 16>, Overlaps_avx2 <32, 16>, 0, DegrainN_avx2 <32, 16> },
+		{ Sad_avx2 <16, 32>, SadMulti_avx2 <16, 32>, SadMap_avx2 <16, 32>, SadThr_avx2 <16, 32>, Var_avx2 <16, 32>, Luma_avx2 <16, 32>, 0                 , Overlaps_avx2 <16, 32>, 0, DegrainN_avx2 <16, 32> },
+		{ Sad_avx2 <16, 16>, SadMulti_avx2 <16, 16>, SadMap_avx2 <16, 16>, SadThr_avx2 <16, 16>, Var_avx2 <16, 16>, Luma_avx2 <16, 16>, 0                 , Overlaps_avx2 <16, 16>, 0, DegrainN_avx2 <16, 16> },
+		{ Sad_avx2 <16,  8>, SadMulti_avx2 <16,  8>, SadMap_avx2 <16,  8>, SadThr_avx2 <16,  8>, Var_avx2 <16,  8>, Luma_avx2 <16,  8>, 0                 , Overlaps_avx2 <16,  8>, 0, DegrainN_avx2 <16,  8> },
+		{ Sad_avx2 <16,  2>, SadMulti_avx2 <16,  2>, SadMap_avx2 <16,  2>, 0                   , Var_avx2 <16,  2>, Luma_avx2 <16,  2>, 0                 , Overlaps_avx2 <16,  2>, 0, DegrainN_avx2 <16,  2> },
+		{ 0                , 0                     , SadMap_avx2 <16,  1>, 0                   , 0                , 0                 , 0                 , Overlaps_avx2 <16,  1>, 0, DegrainN_avx2 <16,  1> },
+		{ 0                , 0                     , SadMap_avx2 < 8, 16>, 0                   , 0                , 0                 , 0                 , 0                     , 0, DegrainN_avx2 < 8, 16> },
+		{ 0                , 0                     , SadMap_avx2 < 8,  8>, 0                   , 0                , 0                 , 0                 , 0                     , 0, DegrainN_avx2 < 8,  8> },
+		{ 0                , 0                     , SadMap_avx2 < 8,  4>, 0                   , 0                , 0                 , 0                 , 0                     , 0, DegrainN_avx2 < 8,  4> },
+		{ 0                , 0                     , SadMap_avx2 < 8,  2>, 0                   , 0                , 0                 , 0                 , 0                     , 0, DegrainN_avx2 < 8,  2> },
+		{ 0                , 0                     , SadMap_avx2 < 8,  1>, 0                   , 0                , 0                 , 0                 , 0                     , 0, 0                      },
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE
+	},
+
+	// Tier_AVX512
+	{
+		{ Sad_avx512 <32, 32>, SadMulti_avx512 <32, 32>, 0, 0, 0, 0, 0, 0, 0, DegrainN_avx512 <32, 32> },
+		{ Sad_avx512 <32, 16>, SadMulti_avx512 <32, 16>, 0, 0, 0, 0, 0, 0, 0, DegrainN_avx512 <32, 16> },
+		{ Sad_avx512 <16, 32>, SadMulti_avx512 <16, 32>, 0, 0, 0, 0, 0, 0, 0, DegrainN_avx512 <16, 32> },
+		{ Sad_avx512 <16, 16>, SadMulti_avx512 <16, 16>, 0, 0, 0, 0, 0, 0, 0, DegrainN_avx512 <16, 16> },
+		{ Sad_avx512 <16,  8>, SadMulti_avx512 <16,  8>, 0, 0, 0, 0, 0, 0, 0, DegrainN_avx512 <16,  8> },
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE,
+		FuncDispatch_NONE
+	}
+};
+
+#undef FuncDispatch_C
+#undef FuncDispatch_ISSE
+#undef FuncDispatch_SSE2
+#undef FuncDispatch_NONE
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
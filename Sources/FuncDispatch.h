@@ -0,0 +1,137 @@
+/*****************************************************************************
+
+        FuncDispatch.h
+        Author: agent, 2026
+
+Central table of the block kernels, indexed by block size and instruction
+set tier. Filters should select their kernels from here rather than
+rebuilding their own switch on the block size and isse flag.
+
+The tier is selected once from the cpu_detect() flags. Each tier only
+overrides the kernels it actually improves; missing entries are inherited
+from the tier below, down to the C versions which are always available.
+The only exception is the early-terminating SAD (_sad_thr_ptr), which is 0
+when there is no SIMD kernel for the size. Use the plain SAD in this case.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (FuncDispatch_HEADER_INCLUDED)
+#define	FuncDispatch_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"CopyCode.h"
+#include	"DegrainNFnc.h"
+#include	"overlap.h"
+#include	"SADFunctions.h"
+#include	"Variance.h"
+
+
+
+class FuncDispatch
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum Tier
+	{
+		Tier_C = 0,
+		Tier_ISSE,
+		Tier_SSE2,
+		Tier_AVX2,
+		Tier_AVX512,
+
+		Tier_NBR_ELT
+	};
+
+	class BlockFnc
+	{
+	public:
+		SADFunction *	_sad_ptr;
+		SADMultiFunction *
+							_sad_multi_ptr;
+		SADMapFunction *
+							_sad_map_ptr;
+		SADThrFunction *
+							_sad_thr_ptr;
+		VARFunction *	_var_ptr;
+		LUMAFunction *	_luma_ptr;
+		COPYFunction *	_copy_ptr;
+		OverlapsFunction *
+							_overlaps_ptr;
+		OverlapsLsbFunction *
+							_overlaps_lsb_ptr;
+		DegrainNFunction *
+							_degrain_n_ptr;
+	};
+
+	static Tier		select_tier (bool isse_flag, unsigned int cpu_flags);
+	static Tier		select_tier (bool isse_flag);
+	static bool		find (BlockFnc &fnc, int blk_w, int blk_h, Tier tier);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	enum {			NBR_SIZES	= 17	};
+
+	static int		find_size (int blk_w, int blk_h);
+
+	static const int
+						_size_arr [NBR_SIZES] [2];
+	static const BlockFnc
+						_fnc_arr [Tier_NBR_ELT] [NBR_SIZES];
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						FuncDispatch ();
+						FuncDispatch (const FuncDispatch &other);
+	virtual			~FuncDispatch () {}
+	FuncDispatch &	operator = (const FuncDispatch &other);
+	bool				operator == (const FuncDispatch &other) const;
+	bool				operator != (const FuncDispatch &other) const;
+
+};	// class FuncDispatch
+
+
+
+//#include	"FuncDispatch.hpp"
+
+
+
+#endif	// FuncDispatch_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
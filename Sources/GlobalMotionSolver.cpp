@@ -0,0 +1,570 @@
+/*****************************************************************************
+
+        GlobalMotionSolver.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"GlobalMotionSolver.h"
+
+#include	<xmmintrin.h>
+
+#include	<algorithm>
+
+#include	<cassert>
+#include	<cmath>
+
+
+
+/*\\\ STATIC FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// The partial sums of a row are small enough to be accumulated in floats,
+// the totals are kept in doubles.
+static inline double	GlobalMotionSolver_hsum (__m128 v)
+{
+	float				tmp [4];
+	_mm_storeu_ps (tmp, v);
+
+	return (double (tmp [0]) + double (tmp [1]) + double (tmp [2]) + double (tmp [3]));
+}
+
+
+
+static inline __m128	GlobalMotionSolver_abs (__m128 v)
+{
+	return (_mm_andnot_ps (_mm_set1_ps (-0.0f), v));
+}
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// xc, yc: coordinates of the frame center, used as origin for the
+// computations. The transforms are always given in absolute coordinates.
+GlobalMotionSolver::GlobalMotionSolver (int blk_x, int blk_y, float xc, float yc)
+:	_blk_x (blk_x)
+,	_blk_y (blk_y)
+,	_stride ((blk_x + VECT_LEN - 1) & -VECT_LEN)
+,	_x_arr ()
+,	_y_arr ()
+,	_dx_arr ()
+,	_dy_arr ()
+,	_wm_arr ()
+,	_sad_arr ()
+,	_xc (xc)
+,	_yc (yc)
+,	_ws_arr ()
+,	_w_arr ()
+{
+	assert (blk_x > 0);
+	assert (blk_y > 0);
+
+	// The padding blocks keep null coordinates and weights.
+	const int		len = _stride * blk_y;
+	_x_arr.resize (len, 0);
+	_y_arr.resize (len, 0);
+	_dx_arr.resize (len, 0);
+	_dy_arr.resize (len, 0);
+	_wm_arr.resize (len, 0);
+	_sad_arr.resize (len, 0);
+	_ws_arr.resize (len, 0);
+	_w_arr.resize (len, 0);
+}
+
+
+
+// x, y: absolute position of the block center, in pixels.
+// dx, dy: motion vector, in pixels.
+void	GlobalMotionSolver::set_block (int bx, int by, float x, float y, float dx, float dy, int sad, float weight_mask)
+{
+	assert (bx >= 0);
+	assert (bx < _blk_x);
+	assert (by >= 0);
+	assert (by < _blk_y);
+
+	const int		n = by * _stride + bx;
+	_x_arr [n]   = x - _xc;
+	_y_arr [n]   = y - _yc;
+	_dx_arr [n]  = dx;
+	_dy_arr [n]  = dy;
+	_sad_arr [n] = sad;
+	_wm_arr [n]  = weight_mask;
+}
+
+
+
+/*
+==============================================================================
+Name: solve
+Description:
+	Estimates the global motion from the blocks previously set.
+	Without warm start, the translation is estimated first, then the full
+	model. With warm start, the blocks are first checked against the given
+	transform. If it rejects too many of them (the motion changed too much),
+	the warm start is discarded.
+Input parameters:
+	- param: estimation parameters.
+	- warm_ptr: transform to start from, generally the one of a neighbour
+		frame. 0 for a cold start.
+	- warm_err: error of the warm start transform. Ignored for cold starts.
+Output parameters:
+	- tr: estimated transform.
+	- err: mean motion difference between the blocks and the transform.
+	- nbr_iter: number of iterations.
+==============================================================================
+*/
+
+void	GlobalMotionSolver::solve (Transform &tr, float &err, int &nbr_iter, const Param &param, const Transform *warm_ptr, float warm_err)
+{
+	const float		err_dif = 0.01f;	// Error difference to terminate iterations
+	const float		q = param._aspect * param._aspect;
+
+	reject_static (param);
+
+	Centered			c;
+	bool				warm_flag = false;
+	if (warm_ptr != 0)
+	{
+		c._a  = warm_ptr->_dxx;
+		c._b  = warm_ptr->_dxy;
+		c._cx = warm_ptr->_dxc + c._a * _xc + c._b * _yc - _xc;
+		c._cy = warm_ptr->_dyc - q * c._b * _xc + c._a * _yc - _yc;
+
+		const double	sum_s = compute_weight_sum (_ws_arr);
+		reject_global (c, q, warm_err * 2);
+		if (compute_weight_sum (_w_arr) >= sum_s * 0.5)
+		{
+			warm_flag = true;
+		}
+		else
+		{
+			_w_arr = _ws_arr;
+		}
+	}
+
+	if (! warm_flag)
+	{
+		c._cx = 0;
+		c._cy = 0;
+		c._a  = 1;
+		c._b  = 0;
+		solve_lin (c, false, false, q);
+	}
+
+	int				iter     = 0;
+	float				err_cur  = 0;
+	bool				cont_flag = true;
+	while (cont_flag && iter < ITER_MAX)
+	{
+		solve_lin (c, param._zoom_flag, param._rot_flag, q);
+		++ iter;
+
+		const float		err_prev = err_cur;
+		err_cur = compute_err (c, q);
+		const bool		changed_flag = reject_global (c, q, err_cur * 2);
+
+		cont_flag = (
+			   changed_flag
+			&& err_cur >= err_dif
+			&& (iter < 3 || err_prev - err_cur >= err_dif * 0.5f)
+		);
+	}
+
+	tr._dxx = float (c._a);
+	tr._dxy = float (c._b);
+	tr._dxc = float (c._cx + _xc - c._a * _xc - c._b * _yc);
+	tr._dyc = float (c._cy + _yc + q * c._b * _xc - c._a * _yc);
+	err      = err_cur;
+	nbr_iter = iter;
+}
+
+
+
+void	GlobalMotionSolver::set_null (Transform &tr)
+{
+	tr._dxc = 0;
+	tr._dxx = 1;
+	tr._dxy = 0;
+	tr._dyc = 0;
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Rejections depending only on the blocks: frame borders, big SAD and
+// vectors very different from their neighbours. The null vectors get a
+// reduced weight.
+void	GlobalMotionSolver::reject_static (const Param &param)
+{
+	const int		ib = param._ignored_border;
+
+	for (int by = 0; by < _blk_y; ++by)
+	{
+		const bool		in_y = (by > 0 && by < _blk_y - 1);
+		for (int bx = 0; bx < _blk_x; ++bx)
+		{
+			const int		n = by * _stride + bx;
+			const bool		in_xy = (in_y && bx > 0 && bx < _blk_x - 1);
+			float				w = 0;
+
+			if (   bx < ib || bx >= _blk_x - ib
+			    || by < ib || by >= _blk_y - ib)
+			{
+				// Nothing, near frame borders
+			}
+			else if (_sad_arr [n] > param._th_sad)
+			{
+				// Nothing, bad block with big SAD
+			}
+			else if (in_xy && fabs ((
+				  _dx_arr [n - 1 - _stride] + _dx_arr [n - _stride] + _dx_arr [n + 1 - _stride]
+				+ _dx_arr [n - 1          ]                           + _dx_arr [n + 1          ]
+				+ _dx_arr [n - 1 + _stride] + _dx_arr [n + _stride] + _dx_arr [n + 1 + _stride]
+				) / 8 - _dx_arr [n]) > param._wrong_dif)
+			{
+				// Nothing, very different from its neighbours
+			}
+			else if (in_xy && fabs ((
+				  _dy_arr [n - 1 - _stride] + _dy_arr [n - _stride] + _dy_arr [n + 1 - _stride]
+				+ _dy_arr [n - 1          ]                           + _dy_arr [n + 1          ]
+				+ _dy_arr [n - 1 + _stride] + _dy_arr [n + _stride] + _dy_arr [n + 1 + _stride]
+				) / 8 - _dy_arr [n]) > param._wrong_dif)
+			{
+				// Nothing, very different from its neighbours
+			}
+			else if (_dx_arr [n] == 0 && _dy_arr [n] == 0)
+			{
+				w = param._zero_weight * _wm_arr [n];
+			}
+			else
+			{
+				w = _wm_arr [n];
+			}
+
+			_ws_arr [n] = w;
+		}
+	}
+
+	_w_arr = _ws_arr;
+}
+
+
+
+// Weighted least squares with the current weights. Parameters are cx, cy,
+// a and b. a and b are kept unchanged when the zoom or the rotation are not
+// estimated. c is left untouched if the system is singular (no block).
+void	GlobalMotionSolver::solve_lin (Centered &c, bool zoom_flag, bool rot_flag, float q) const
+{
+	double			s [Sum_NBR_ELT];
+	compute_sums (s);
+
+	// Normal equations
+	const double	r = 1 - q;
+	const double	mat_full [4] [4] =
+	{
+		{ s [Sum_W], 0             , s [Sum_X]              , s [Sum_Y]                  },
+		{ 0        , s [Sum_W]     , s [Sum_Y]              , -q * s [Sum_X]             },
+		{ s [Sum_X], s [Sum_Y]     , s [Sum_XX] + s [Sum_YY], r * s [Sum_XY]             },
+		{ s [Sum_Y], -q * s [Sum_X], r * s [Sum_XY]         , s [Sum_YY] + q * q * s [Sum_XX] }
+	};
+	const double	vec_full [4] =
+	{
+		s [Sum_TX],
+		s [Sum_TY],
+		s [Sum_XTX] + s [Sum_YTY],
+		s [Sum_YTX] - q * s [Sum_XTY]
+	};
+	double			par_arr [4] = { c._cx, c._cy, c._a, c._b };
+	const bool		free_arr [4] = { true, true, zoom_flag, rot_flag };
+
+	// Removes the fixed parameters from the system
+	int				idx_arr [4];
+	int				n = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		if (free_arr [i])
+		{
+			idx_arr [n] = i;
+			++ n;
+		}
+	}
+	double			mat [4] [4];
+	double			vec [4];
+	for (int i = 0; i < n; ++i)
+	{
+		const int		ii = idx_arr [i];
+		vec [i] = vec_full [ii];
+		for (int j = 0; j < 4; ++j)
+		{
+			if (! free_arr [j])
+			{
+				vec [i] -= mat_full [ii] [j] * par_arr [j];
+			}
+		}
+		for (int j = 0; j < n; ++j)
+		{
+			mat [i] [j] = mat_full [ii] [idx_arr [j]];
+		}
+	}
+
+	if (solve_sys (mat, vec, n))
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			par_arr [idx_arr [i]] = vec [i];
+		}
+		c._cx = par_arr [0];
+		c._cy = par_arr [1];
+		c._a  = par_arr [2];
+		c._b  = par_arr [3];
+	}
+}
+
+
+
+void	GlobalMotionSolver::compute_sums (double sum_arr [Sum_NBR_ELT]) const
+{
+	for (int k = 0; k < Sum_NBR_ELT; ++k)
+	{
+		sum_arr [k] = 0;
+	}
+
+	for (int by = 0; by < _blk_y; ++by)
+	{
+		__m128			acc [Sum_NBR_ELT];
+		for (int k = 0; k < Sum_NBR_ELT; ++k)
+		{
+			acc [k] = _mm_setzero_ps ();
+		}
+
+		const int		row = by * _stride;
+		for (int bx = 0; bx < _blk_x; bx += VECT_LEN)
+		{
+			const int		n  = row + bx;
+			const __m128	x  = _mm_load_ps (&_x_arr [n]);
+			const __m128	y  = _mm_load_ps (&_y_arr [n]);
+			const __m128	w  = _mm_load_ps (&_w_arr [n]);
+			const __m128	tx = _mm_add_ps (x, _mm_load_ps (&_dx_arr [n]));
+			const __m128	ty = _mm_add_ps (y, _mm_load_ps (&_dy_arr [n]));
+			const __m128	wx = _mm_mul_ps (w, x);
+			const __m128	wy = _mm_mul_ps (w, y);
+
+			acc [Sum_W  ] = _mm_add_ps (acc [Sum_W  ], w);
+			acc [Sum_X  ] = _mm_add_ps (acc [Sum_X  ], wx);
+			acc [Sum_Y  ] = _mm_add_ps (acc [Sum_Y  ], wy);
+			acc [Sum_XX ] = _mm_add_ps (acc [Sum_XX ], _mm_mul_ps (wx, x));
+			acc [Sum_YY ] = _mm_add_ps (acc [Sum_YY ], _mm_mul_ps (wy, y));
+			acc [Sum_XY ] = _mm_add_ps (acc [Sum_XY ], _mm_mul_ps (wx, y));
+			acc [Sum_TX ] = _mm_add_ps (acc [Sum_TX ], _mm_mul_ps (w, tx));
+			acc [Sum_TY ] = _mm_add_ps (acc [Sum_TY ], _mm_mul_ps (w, ty));
+			acc [Sum_XTX] = _mm_add_ps (acc [Sum_XTX], _mm_mul_ps (wx, tx));
+			acc [Sum_YTY] = _mm_add_ps (acc [Sum_YTY], _mm_mul_ps (wy, ty));
+			acc [Sum_YTX] = _mm_add_ps (acc [Sum_YTX], _mm_mul_ps (wy, tx));
+			acc [Sum_XTY] = _mm_add_ps (acc [Sum_XTY], _mm_mul_ps (wx, ty));
+		}
+
+		for (int k = 0; k < Sum_NBR_ELT; ++k)
+		{
+			sum_arr [k] += GlobalMotionSolver_hsum (acc [k]);
+		}
+	}
+}
+
+
+
+// Weighted RMS distance between the vectors and the transform, with the
+// current weights. Same bias as the original MDepan estimation.
+float	GlobalMotionSolver::compute_err (const Centered &c, float q) const
+{
+	const __m128	cx  = _mm_set1_ps (float (c._cx));
+	const __m128	cy  = _mm_set1_ps (float (c._cy));
+	const __m128	am1 = _mm_set1_ps (float (c._a - 1));
+	const __m128	b   = _mm_set1_ps (float (c._b));
+	const __m128	mqb = _mm_set1_ps (float (-q * c._b));
+
+	double			sum_e = 0.1;
+	double			sum_w = 0.1;
+	for (int by = 0; by < _blk_y; ++by)
+	{
+		__m128			acc_e = _mm_setzero_ps ();
+		__m128			acc_w = _mm_setzero_ps ();
+
+		const int		row = by * _stride;
+		for (int bx = 0; bx < _blk_x; bx += VECT_LEN)
+		{
+			const int		n  = row + bx;
+			const __m128	x  = _mm_load_ps (&_x_arr [n]);
+			const __m128	y  = _mm_load_ps (&_y_arr [n]);
+			const __m128	w  = _mm_load_ps (&_w_arr [n]);
+			const __m128	rx = _mm_sub_ps (
+				_mm_add_ps (_mm_add_ps (cx, _mm_mul_ps (am1, x)), _mm_mul_ps (b, y)),
+				_mm_load_ps (&_dx_arr [n])
+			);
+			const __m128	ry = _mm_sub_ps (
+				_mm_add_ps (_mm_add_ps (cy, _mm_mul_ps (mqb, x)), _mm_mul_ps (am1, y)),
+				_mm_load_ps (&_dy_arr [n])
+			);
+			const __m128	e  = _mm_add_ps (_mm_mul_ps (rx, rx), _mm_mul_ps (ry, ry));
+			acc_e = _mm_add_ps (acc_e, _mm_mul_ps (w, e));
+			acc_w = _mm_add_ps (acc_w, w);
+		}
+
+		sum_e += GlobalMotionSolver_hsum (acc_e);
+		sum_w += GlobalMotionSolver_hsum (acc_w);
+	}
+
+	return (float (sqrt (sum_e / sum_w)));
+}
+
+
+
+// Rejects the blocks whose vector is too far from the transform.
+// Returns true if at least one weight has changed.
+bool	GlobalMotionSolver::reject_global (const Centered &c, float q, float dif)
+{
+	const __m128	cx  = _mm_set1_ps (float (c._cx));
+	const __m128	cy  = _mm_set1_ps (float (c._cy));
+	const __m128	am1 = _mm_set1_ps (float (c._a - 1));
+	const __m128	b   = _mm_set1_ps (float (c._b));
+	const __m128	mqb = _mm_set1_ps (float (-q * c._b));
+	const __m128	lim = _mm_set1_ps (dif);
+
+	int				changed = 0;
+	for (int by = 0; by < _blk_y; ++by)
+	{
+		const int		row = by * _stride;
+		for (int bx = 0; bx < _blk_x; bx += VECT_LEN)
+		{
+			const int		n  = row + bx;
+			const __m128	x  = _mm_load_ps (&_x_arr [n]);
+			const __m128	y  = _mm_load_ps (&_y_arr [n]);
+			const __m128	rx = _mm_sub_ps (
+				_mm_add_ps (_mm_add_ps (cx, _mm_mul_ps (am1, x)), _mm_mul_ps (b, y)),
+				_mm_load_ps (&_dx_arr [n])
+			);
+			const __m128	ry = _mm_sub_ps (
+				_mm_add_ps (_mm_add_ps (cy, _mm_mul_ps (mqb, x)), _mm_mul_ps (am1, y)),
+				_mm_load_ps (&_dy_arr [n])
+			);
+			const __m128	ok = _mm_and_ps (
+				_mm_cmple_ps (GlobalMotionSolver_abs (rx), lim),
+				_mm_cmple_ps (GlobalMotionSolver_abs (ry), lim)
+			);
+			const __m128	w_old = _mm_load_ps (&_w_arr [n]);
+			const __m128	w_new = _mm_and_ps (ok, _mm_load_ps (&_ws_arr [n]));
+			changed |= _mm_movemask_ps (_mm_cmpneq_ps (w_old, w_new));
+			_mm_store_ps (&_w_arr [n], w_new);
+		}
+	}
+
+	return (changed != 0);
+}
+
+
+
+double	GlobalMotionSolver::compute_weight_sum (const FloatArray &w_arr) const
+{
+	double			sum = 0;
+	for (int by = 0; by < _blk_y; ++by)
+	{
+		__m128			acc = _mm_setzero_ps ();
+		const int		row = by * _stride;
+		for (int bx = 0; bx < _blk_x; bx += VECT_LEN)
+		{
+			acc = _mm_add_ps (acc, _mm_load_ps (&w_arr [row + bx]));
+		}
+		sum += GlobalMotionSolver_hsum (acc);
+	}
+
+	return (sum);
+}
+
+
+
+// Gaussian elimination with partial pivoting. The solution replaces vec.
+// Returns false if the system is singular.
+bool	GlobalMotionSolver::solve_sys (double mat [4] [4], double vec [4], int n)
+{
+	assert (n > 0);
+	assert (n <= 4);
+
+	for (int k = 0; k < n; ++k)
+	{
+		int				p = k;
+		for (int i = k + 1; i < n; ++i)
+		{
+			if (fabs (mat [i] [k]) > fabs (mat [p] [k]))
+			{
+				p = i;
+			}
+		}
+		if (fabs (mat [p] [k]) <= 1e-12)
+		{
+			return (false);
+		}
+		if (p != k)
+		{
+			for (int j = 0; j < n; ++j)
+			{
+				std::swap (mat [k] [j], mat [p] [j]);
+			}
+			std::swap (vec [k], vec [p]);
+		}
+
+		for (int i = k + 1; i < n; ++i)
+		{
+			const double	f = mat [i] [k] / mat [k] [k];
+			for (int j = k; j < n; ++j)
+			{
+				mat [i] [j] -= f * mat [k] [j];
+			}
+			vec [i] -= f * vec [k];
+		}
+	}
+
+	for (int k = n - 1; k >= 0; --k)
+	{
+		double			v = vec [k];
+		for (int j = k + 1; j < n; ++j)
+		{
+			v -= mat [k] [j] * vec [j];
+		}
+		vec [k] = v / mat [k] [k];
+	}
+
+	return (true);
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,188 @@
+/*****************************************************************************
+
+        GlobalMotionSolver.h
+        Author: agent, 2026
+
+Robust estimation of the global motion of a frame from its block vectors,
+for MDepan.
+
+The model is the one of DePan: translation, zoom and rotation, with a pixel
+aspect ratio. It is linear in its 4 independent parameters, so each iteration
+solves the weighted least-squares problem exactly instead of taking a
+gradient step. Then the weights are updated by rejecting the blocks too far
+from the global motion (iteratively reweighted least squares). This converges
+in a few iterations.
+
+Blocks are stored as structure of arrays, rows padded to a multiple of 4
+blocks with null weights, so the accumulations are done with SSE.
+
+An object holds the data of a single frame. Different objects can be solved
+concurrently.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (GlobalMotionSolver_HEADER_INCLUDED)
+#define	GlobalMotionSolver_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"AllocAlign.h"
+
+#include	<vector>
+
+
+
+class GlobalMotionSolver
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			VECT_LEN	= 4	};	// Floats in a SSE register
+	enum {			ITER_MAX	= 100	};
+
+	// Independent parameters of the transform (see MVDepan.h):
+	// xsrc = dxc + dxx * x + dxy * y
+	// ysrc = dyc - aspect^2 * dxy * x + dxx * y
+	class Transform
+	{
+	public:
+		float				_dxc;
+		float				_dxx;
+		float				_dxy;
+		float				_dyc;
+	};
+
+	class Param
+	{
+	public:
+		float				_aspect;			// Pixel aspect ratio, divided by the number of fields
+		bool				_zoom_flag;
+		bool				_rot_flag;
+		float				_wrong_dif;		// Max difference with the neighbour blocks
+		float				_zero_weight;	// Weight multiplier for the null vectors
+		int				_th_sad;			// Max SAD for a block to be used
+		int				_ignored_border;	// Number of blocks
+	};
+
+						GlobalMotionSolver (int blk_x, int blk_y, float xc, float yc);
+	virtual			~GlobalMotionSolver () {}
+
+	void				set_block (int bx, int by, float x, float y, float dx, float dy, int sad, float weight_mask);
+	void				solve (Transform &tr, float &err, int &nbr_iter, const Param &param, const Transform *warm_ptr, float warm_err);
+
+	static void		set_null (Transform &tr);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	typedef	std::vector <float, AllocAlign <float, 16> >	FloatArray;
+
+	// Same as Transform, with the coordinates relative to the frame center.
+	// Sums are better conditioned this way.
+	class Centered
+	{
+	public:
+		double			_cx;
+		double			_cy;
+		double			_a;
+		double			_b;
+	};
+
+	enum Sum
+	{
+		Sum_W = 0,
+		Sum_X,
+		Sum_Y,
+		Sum_XX,
+		Sum_YY,
+		Sum_XY,
+		Sum_TX,			// Targets: TX = x + dx, TY = y + dy
+		Sum_TY,
+		Sum_XTX,
+		Sum_YTY,
+		Sum_YTX,
+		Sum_XTY,
+
+		Sum_NBR_ELT
+	};
+
+	void				reject_static (const Param &param);
+	void				solve_lin (Centered &c, bool zoom_flag, bool rot_flag, float q) const;
+	void				compute_sums (double sum_arr [Sum_NBR_ELT]) const;
+	float				compute_err (const Centered &c, float q) const;
+	bool				reject_global (const Centered &c, float q, float dif);
+	double			compute_weight_sum (const FloatArray &w_arr) const;
+
+	static bool		solve_sys (double mat [4] [4], double vec [4], int n);
+
+	// Not const, the objects are copied into std::vector
+	int				_blk_x;
+	int				_blk_y;
+	int				_stride;			// Blocks, multiple of VECT_LEN
+
+	// Block data. Coordinates are relative to the frame center.
+	FloatArray		_x_arr;
+	FloatArray		_y_arr;
+	FloatArray		_dx_arr;
+	FloatArray		_dy_arr;
+	FloatArray		_wm_arr;			// Weight from the mask
+	std::vector <int>
+						_sad_arr;
+	float				_xc;				// Frame center
+	float				_yc;
+
+	// Weights
+	FloatArray		_ws_arr;			// After the rejections not depending on the transform
+	FloatArray		_w_arr;			// Current
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						GlobalMotionSolver ();
+	bool				operator == (const GlobalMotionSolver &other) const;
+	bool				operator != (const GlobalMotionSolver &other) const;
+
+};	// class GlobalMotionSolver
+
+
+
+//#include	"GlobalMotionSolver.hpp"
+
+
+
+#endif	// GlobalMotionSolver_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -21,14 +21,14 @@
 #include "debugprintf.h"
 #include "GroupOfPlanes.h"
 #include "MVGroupOfFrames.h"
-#include "profile.h"
 
 
 
 GroupOfPlanes::GroupOfPlanes (
 	int _nBlkSizeX, int _nBlkSizeY, int _nLevelCount, int _nPel, int _nFlags,
 	int _nOverlapX, int _nOverlapY, int _nBlkX, int _nBlkY, int _yRatioUV,
-	int _divideExtra, conc::ObjPool <DCTClass> *dct_pool_ptr, bool mt_flag
+	int _divideExtra, conc::ObjPool <DCTClass> *dct_pool_ptr, Profiler *prof_ptr,
+	bool mt_flag
 )
 :	nBlkSizeX (_nBlkSizeX)
 ,	nBlkSizeY (_nBlkSizeY)
@@ -61,7 +61,7 @@ GroupOfPlanes::GroupOfPlanes (
 		}
 		nBlkX = ((nWidth_B  >> i) - nOverlapX) / (nBlkSizeX - nOverlapX);
 		nBlkY = ((nHeight_B >> i) - nOverlapY) / (nBlkSizeY - nOverlapY);
-		planes [i] = new PlaneOfBlocks(nBlkX, nBlkY, nBlkSizeX, nBlkSizeY, nPelCurrent, i, nFlagsCurrent, nOverlapX, nOverlapY, yRatioUV, dct_pool_ptr, mt_flag);
+		planes [i] = new PlaneOfBlocks(nBlkX, nBlkY, nBlkSizeX, nBlkSizeY, nPelCurrent, i, nFlagsCurrent, nOverlapX, nOverlapY, yRatioUV, dct_pool_ptr, prof_ptr, mt_flag);
 		nPelCurrent = 1;
 	}
 }
@@ -175,7 +175,6 @@ void	GroupOfPlanes::SearchMVs (
 	}
 
 	// Refining the search until we reach the highest detail interpolation.
-	PlaneOfBlocks::Slicer	slicer_glob (_mt_flag);
 	for (int i = nLevelCount - 2; i >= 0; i--)
 	{
 		SearchType		searchTypeLevel =
@@ -185,19 +184,13 @@ void	GroupOfPlanes::SearchMVs (
 		int				nSearchParamLevel =
 			(i == 0) ? nPelSearch : nSearchParam; // special case for finest level
 
-		PROFILE_START(MOTION_PROFILE_PREDICTION);
 		if (global)
 		{
 			// get updated global MV (doubled)
-			planes [i+1]->EstimateGlobalMVDoubled (&globalMV, slicer_glob);
+			planes [i+1]->EstimateGlobalMVDoubled (&globalMV);
 //			DebugPrintf("SearchMV globalMV %i, %i", globalMV.x, globalMV.y);
 		}
 		planes [i]->InterpolatePrediction (*(planes [i+1]));
-		if (global)
-		{
-			slicer_glob.wait ();
-		}
-		PROFILE_STOP(MOTION_PROFILE_PREDICTION);
 
 		fieldShiftCur = (i == 0) ? fieldShift : 0; // may be non zero for finest level only
 //		DebugPrintf("SearchMV level %i", i);
@@ -237,6 +230,28 @@ void	GroupOfPlanes::SearchMVs (
 
 
 
+// Caches the source-side block data of all the levels, for several
+// consecutive searches on the same source frame.
+void	GroupOfPlanes::PrepareSrcCache (MVGroupOfFrames *pSrcGOF)
+{
+	for (int i = 0; i < nLevelCount; i++)
+	{
+		planes [i]->PrepareSrcCache (pSrcGOF->GetFrame (i));
+	}
+}
+
+
+
+void	GroupOfPlanes::InvalidateSrcCache ()
+{
+	for (int i = 0; i < nLevelCount; i++)
+	{
+		planes [i]->InvalidateSrcCache ();
+	}
+}
+
+
+
 void	GroupOfPlanes::RecalculateMVs (
 	MVClip &mvClip,
 	MVGroupOfFrames *pSrcGOF,
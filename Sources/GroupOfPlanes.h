@@ -48,7 +48,8 @@ public :
 	GroupOfPlanes (
 		int _nBlkSizeX, int _nBlkSizeY, int _nLevelCount, int _nPel, int _nFlags,
 		int _nOverlapX, int _nOverlapY, int _nBlkX, int _nBlkY, int _yRatioUV,
-		int _divideExtra, conc::ObjPool <DCTClass> *dct_pool_ptr, bool mt_flag);
+		int _divideExtra, conc::ObjPool <DCTClass> *dct_pool_ptr, Profiler *prof_ptr,
+		bool mt_flag);
 	~GroupOfPlanes ();
 	void           SearchMVs (
 		MVGroupOfFrames *pSrcGOF, MVGroupOfFrames *pRefGOF,
@@ -56,6 +57,8 @@ public :
 		int _lsad, int _pnew, int _plevel, bool _global, int flags, int *out,
 		short * outfilebuf, int fieldShift, int _pzero, int _pglobal, int badSAD,
 		int badrange, bool meander, int *vecPrev, bool tryMany);
+	void           PrepareSrcCache (MVGroupOfFrames *pSrcGOF);
+	void           InvalidateSrcCache ();
 	void           WriteDefaultToArray (int *array);
 	int            GetArraySize ();
 	void           ExtraDivide (int *out, int flags);
@@ -50,9 +50,14 @@
 // Test & helpers filters
 #include "Padding.h"
 #include "MVFinest.h"
+#include "MLoadVect.h"
 #include "MRestoreVect.h"
 #include "MScaleVect.h"
 #include "MStoreVect.h"
+#include "Profiler.h"
+#include "SuperFrameCache.h"
+
+#include "AvstpWrapper.h"
 
 
 
@@ -188,6 +193,7 @@ AVSValue __cdecl Create_MVAnalyse(AVSValue args, void* user_data, IScriptEnviron
 		args[29].AsBool(false),  // try many
 		args[30].AsBool(false),  // multi
 		args[31].AsBool(true),   // mt
+		args[32].AsString(""),   // profile
 		env
 	);
 }
@@ -233,6 +239,7 @@ AVSValue __cdecl Create_MVDepan(AVSValue args, void* user_data, IScriptEnvironme
       args[13].AsInt(MV_DEFAULT_SCD2),
       args[14].AsBool(true),
 		args[15].AsBool(false),         // planar
+		args[16].AsBool(true),          // mt
 		env
 	);
 }
@@ -288,6 +295,7 @@ AVSValue __cdecl Create_MVFlowInter(AVSValue args, void* user_data, IScriptEnvir
       args[9].AsBool(true),   // isse
       args[10].AsBool(false), // planar
 		args[11].IsClip() ? args[11].AsClip() : 0,
+		args[12].AsBool(true),  // mt
 		env);
 }
 
@@ -312,6 +320,7 @@ AVSValue __cdecl Create_MVFlowFps(AVSValue args, void* user_data, IScriptEnviron
       args[10].AsInt(MV_DEFAULT_SCD2),
       args[11].AsBool(true),  // isse
       args[12].AsBool(false), // planar
+		args[13].AsBool(true),  // mt
 		env
 	);
 }
@@ -335,6 +344,7 @@ AVSValue __cdecl Create_MVFlowBlur(AVSValue args, void* user_data, IScriptEnviro
       args[7].AsInt(MV_DEFAULT_SCD2),
       args[8].AsBool(true),  // isse
       args[9].AsBool(false), // planar
+		args[10].AsBool(true), // mt
 		env
 	);
 }
@@ -611,6 +621,7 @@ AVSValue __cdecl Create_MDegrainN (AVSValue args, void* user_data, IScriptEnviro
 		thSAD2,                    // thSAD2
 		thSADC2,                   // thSADC2
 		args [16].AsBool (true),   // mt
+		args [17].AsString (""),   // profile
 		env
 	);
 }
@@ -658,6 +669,7 @@ AVSValue __cdecl Create_MVRecalculate(AVSValue args, void* user_data, IScriptEnv
 		args[19].AsBool(true),   // meander
 		args[20].AsInt(0),       // tr
 		args[21].AsBool(true),   // mt
+		args[22].AsString(""),   // profile
 		env
 	);
 }
@@ -698,6 +710,7 @@ AVSValue __cdecl Create_MVSuper(AVSValue args, void* user_data, IScriptEnvironme
 		args [9].AsBool(true),   // isse2
 		args [10].AsBool(false), // planar
 		args [11].AsBool (true), // mt
+		args [12].AsString (""), // profile
 		env
 	);
 }
@@ -729,6 +742,7 @@ AVSValue __cdecl Create_MStoreVect (AVSValue args, void* user_data_ptr, IScriptE
 	return new MStoreVect (
       vect_arr,               // vectors
       args [1].AsString (""), // vccs
+      args [2].AsBool (false),// compact
 		*env_ptr
 	);
 }
@@ -742,6 +756,15 @@ AVSValue __cdecl Create_MRestoreVect (AVSValue args, void* user_data_ptr, IScrip
 	);
 }
 
+AVSValue __cdecl Create_MLoadVect (AVSValue args, void* user_data_ptr, IScriptEnvironment* env_ptr)
+{
+	return new MLoadVect (
+      args [0].AsClip (),     // source
+      args [1].AsString (""), // file
+		*env_ptr
+	);
+}
+
 AVSValue __cdecl Create_MScaleVect (AVSValue args, void* user_data, IScriptEnvironment* env)
 {
 	enum { CLIP, SCALE, SCALEV, MODE, FLIP, ADJUSTSUBPEL };
@@ -754,31 +777,70 @@ AVSValue __cdecl Create_MScaleVect (AVSValue args, void* user_data, IScriptEnvir
 	                       args[ADJUSTSUBPEL].AsBool(false), env ); 
 }
 
+AVSValue __cdecl Create_MProfile (AVSValue args, void* user_data_ptr, IScriptEnvironment* env_ptr)
+{
+	const char *	name_0    = args [0].AsString ("");
+	const char *	counter_0 = args [1].AsString ("blocks");
+	const int		level     = args [2].AsInt (-1);   // -1 = all levels
+
+	double			val = 0;
+	if (! Profiler::read_value (val, name_0, counter_0, level))
+	{
+		env_ptr->ThrowError (
+			"MProfile: unknown profile \"%s\" or counter \"%s\".",
+			name_0, counter_0
+		);
+	}
+
+	return (AVSValue (val));
+}
+
+// Without argument, returns the current budget of the super frame cache, in
+// MB. Otherwise sets it and returns the previous one. 0 disables the cache.
+AVSValue __cdecl Create_MSuperCache (AVSValue args, void* user_data_ptr, IScriptEnvironment* env_ptr)
+{
+	if (! args [0].Defined ())
+	{
+		return (AVSValue (SuperFrameCache::get_budget ()));
+	}
+
+	const int		size = args [0].AsInt ();
+	if (size < 0)
+	{
+		env_ptr->ThrowError ("MSuperCache: size must be positive or null.");
+	}
+
+	return (AVSValue (SuperFrameCache::set_budget (size)));
+}
+
 
 
 extern "C" __declspec(dllexport) const char* __stdcall
 AvisynthPluginInit2(IScriptEnvironment* env)
 {
 	env->AddFunction("MShow",        "cc[scale]i[sil]i[tol]i[showsad]b[number]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVShow, 0);
-	env->AddFunction("MAnalyse",     "c[blksize]i[blksizeV]i[levels]i[search]i[searchparam]i[pelsearch]i[isb]b[lambda]i[chroma]b[delta]i[truemotion]b[lsad]i[plevel]i[global]b[pnew]i[pzero]i[pglobal]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[badSAD]i[badrange]i[isse]b[meander]b[temporal]b[trymany]b[multi]b[mt]b", Create_MVAnalyse, 0);
+	env->AddFunction("MAnalyse",     "c[blksize]i[blksizeV]i[levels]i[search]i[searchparam]i[pelsearch]i[isb]b[lambda]i[chroma]b[delta]i[truemotion]b[lsad]i[plevel]i[global]b[pnew]i[pzero]i[pglobal]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[badSAD]i[badrange]i[isse]b[meander]b[temporal]b[trymany]b[multi]b[mt]b[profile]s", Create_MVAnalyse, 0);
 	env->AddFunction("MMask",        "cc[ml]f[gamma]f[kind]i[Ysc]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVMask, 0);
 	env->AddFunction("MCompensate",  "ccc[scbehavior]b[recursion]f[thSAD]i[fields]b[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b[tr]i[center]b[cclip]c[thSAD2]i", Create_MVCompensate, 0);
    env->AddFunction("MSCDetection", "cc[Yth]i[thSCD1]i[thSCD2]i[isse]b", Create_MVSCDetection, 0);
-	env->AddFunction("MDepan",       "cc[mask]c[zoom]b[rot]b[pixaspect]f[error]f[info]b[log]s[wrong]f[zerow]f[range]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVDepan, 0);
+	env->AddFunction("MDepan",       "cc[mask]c[zoom]b[rot]b[pixaspect]f[error]f[info]b[log]s[wrong]f[zerow]f[range]i[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b", Create_MVDepan, 0);
 	env->AddFunction("MFlow",        "ccc[time]f[mode]i[fields]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c", Create_MVFlow, 0);
-	env->AddFunction("MFlowInter",   "cccc[time]f[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c", Create_MVFlowInter, 0);
-	env->AddFunction("MFlowFps",     "cccc[num]i[den]i[mask]i[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVFlowFps, 0);
-	env->AddFunction("MFlowBlur",    "cccc[blur]f[prec]i[thSCD1]i[thSCD2]i[isse]b[planar]b", Create_MVFlowBlur, 0);
+	env->AddFunction("MFlowInter",   "cccc[time]f[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[tclip]c[mt]b", Create_MVFlowInter, 0);
+	env->AddFunction("MFlowFps",     "cccc[num]i[den]i[mask]i[ml]f[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b", Create_MVFlowFps, 0);
+	env->AddFunction("MFlowBlur",    "cccc[blur]f[prec]i[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b", Create_MVFlowBlur, 0);
 	env->AddFunction("MDegrain1",    "cccc[thSAD]i[thSADC]i[plane]i[limit]i[limitC]i[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b", Create_MVDegrain1, 0);
 	env->AddFunction("MDegrain2",    "cccccc[thSAD]i[thSADC]i[plane]i[limit]i[limitC]i[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b", Create_MVDegrain2, 0);
 	env->AddFunction("MDegrain3",    "cccccccc[thSAD]i[thSADC]i[plane]i[limit]i[limitC]i[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[mt]b", Create_MVDegrain3, 0);
-	env->AddFunction("MDegrainN",    "ccci[thSAD]i[thSADC]i[plane]i[limit]i[limitC]i[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[thsad2]i[thsadc2]i[mt]b", Create_MDegrainN, 0);
-	env->AddFunction("MRecalculate", "cc[thsad]i[smooth]i[blksize]i[blksizeV]i[search]i[searchparam]i[lambda]i[chroma]b[truemotion]b[pnew]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[isse]b[meander]b[tr]i[mt]b", Create_MVRecalculate, 0);
+	env->AddFunction("MDegrainN",    "ccci[thSAD]i[thSADC]i[plane]i[limit]i[limitC]i[thSCD1]i[thSCD2]i[isse]b[planar]b[lsb]b[thsad2]i[thsadc2]i[mt]b[profile]s", Create_MDegrainN, 0);
+	env->AddFunction("MRecalculate", "cc[thsad]i[smooth]i[blksize]i[blksizeV]i[search]i[searchparam]i[lambda]i[chroma]b[truemotion]b[pnew]i[overlap]i[overlapV]i[outfile]s[dct]i[divide]i[sadx264]i[isse]b[meander]b[tr]i[mt]b[profile]s", Create_MVRecalculate, 0);
 	env->AddFunction("MBlockFps",    "cccc[num]i[den]i[mode]i[thres]i[blend]b[thSCD1]i[thSCD2]i[isse]b[planar]b[mt]b", Create_MVBlockFps, 0);
-	env->AddFunction("MSuper",       "c[hpad]i[vpad]i[pel]i[levels]i[chroma]b[sharp]i[rfilter]i[pelclip]c[isse]b[planar]b[mt]b", Create_MVSuper, 0);
-	env->AddFunction("MStoreVect",   "c+[vccs]s", Create_MStoreVect, 0);
+	env->AddFunction("MSuper",       "c[hpad]i[vpad]i[pel]i[levels]i[chroma]b[sharp]i[rfilter]i[pelclip]c[isse]b[planar]b[mt]b[profile]s", Create_MVSuper, 0);
+	env->AddFunction("MStoreVect",   "c+[vccs]s[compact]b", Create_MStoreVect, 0);
 	env->AddFunction("MRestoreVect", "c[index]i", Create_MRestoreVect, 0);
+	env->AddFunction("MLoadVect",    "c[file]s", Create_MLoadVect, 0);
 	env->AddFunction("MScaleVect",   "c[scale]f[scaleV]f[mode]i[flip]b[adjustSubPel]b", Create_MScaleVect, 0);
+	env->AddFunction("MProfile",     "s[counter]s[level]i", Create_MProfile, 0);
+	env->AddFunction("MSuperCache",  "[size]i", Create_MSuperCache, 0);
 //	env->AddFunction("MVFinest",     "c[isse]b", Create_MVFinest, 0);
 	return("MVTools : set of tools based on a motion estimation engine");
 }
@@ -834,6 +896,11 @@ BOOL WINAPI DllMain (::HINSTANCE hinst, ::DWORD reason, ::LPVOID reserved_ptr)
 		break;
 
 	case	DLL_PROCESS_DETACH:
+		// reserved_ptr is not null when the process is terminating
+		if (reserved_ptr != 0)
+		{
+			AvstpWrapper::notify_process_exit ();
+		}
 		Interface_dll_unload (hinst);
 		break;
 	}
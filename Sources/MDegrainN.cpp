@@ -1,286 +1,29 @@
 
 
+#include	"AvstpWrapper.h"
 #include "ClipFnc.h"
 #include "CopyCode.h"
 #include	"def.h"
+#include	"FuncDispatch.h"
 #include	"MDegrainN.h"
 #include "MVFrame.h"
 #include "MVPlane.h"
-#include "profile.h"
+#include	"SuperFrameCache.h"
 #include "SuperParams64Bits.h"
 
-#include	<emmintrin.h>
-#include	<mmintrin.h>
+#include	<algorithm>
 
 #include	<cassert>
 #include	<cmath>
 
 
 
-template <int blockWidth, int blockHeight>
-void DegrainN_C (
-	BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
-	const BYTE *pSrc, int nSrcPitch,
-	const BYTE *pRef [], int Pitch [],
-	int Wall [], int trad
-)
-{
-	if (lsb_flag)
-	{
-		for (int h = 0; h < blockHeight; ++h)
-		{
-			for (int x = 0; x < blockWidth; ++x)
-			{
-				int				val = pSrc [x] * Wall [0];
-				for (int k = 0; k < trad; ++k)
-				{
-					val +=   pRef [k*2    ] [x] * Wall [k*2 + 1]
-					       + pRef [k*2 + 1] [x] * Wall [k*2 + 2];
-				}
-				
-				pDst [x]    = val >> 8;
-				pDstLsb [x] = val & 255;
-			}
-
-			pDst    += nDstPitch;
-			pDstLsb += nDstPitch;
-			pSrc    += nSrcPitch;
-			for (int k = 0; k < trad; ++k)
-			{
-				pRef [k*2    ] += Pitch [k*2    ];
-				pRef [k*2 + 1] += Pitch [k*2 + 1];
-			}
-		}
-	}
-
-	else
-	{
-		for (int h = 0; h < blockHeight; ++h)
-		{
-			for (int x = 0; x < blockWidth; ++x)
-			{
-				int				val = pSrc [x] * Wall [0] + 128;
-				for (int k = 0; k < trad; ++k)
-				{
-					val +=   pRef [k*2    ] [x] * Wall [k*2 + 1]
-					       + pRef [k*2 + 1] [x] * Wall [k*2 + 2];
-				}
-				pDst[x] = val >> 8;
-			}
-
-			pDst += nDstPitch;
-			pSrc += nSrcPitch;
-			for (int k = 0; k < trad; ++k)
-			{
-				pRef [k*2    ] += Pitch [k*2    ];
-				pRef [k*2 + 1] += Pitch [k*2 + 1];
-			}
-		}
-	}
-}
-
-
-
-template <int blockWidth, int blockHeight>
-void DegrainN_mmx (
-	BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
-	const BYTE *pSrc, int nSrcPitch,
-	const BYTE *pRef [], int Pitch [],
-	int Wall [], int trad
-)
-{
-	const __m64			z = _mm_setzero_si64();
-
-	if (lsb_flag)
-	{
-		const __m64			m = _mm_set1_pi16 (255);
-
-		for (int h = 0; h < blockHeight; ++h)
-		{
-			for (int x = 0; x < blockWidth; x += 4)
-			{
-				__m64				val = _m_pmullw (
-					_m_punpcklbw (*(__m64 *) (pSrc + x), z),
-					_mm_set1_pi16 (Wall [0])
-				);
-				for (int k = 0; k < trad; ++k)
-				{
-					const __m64		s1 = _m_pmullw (
-						_m_punpcklbw (*(__m64 *) (pRef [k * 2    ] + x), z),
-						_mm_set1_pi16 (Wall [k * 2 + 1])
-					);
-					const __m64		s2 = _m_pmullw (
-						_m_punpcklbw (*(__m64 *) (pRef [k * 2 + 1] + x), z),
-						_mm_set1_pi16 (Wall [k * 2 + 2])
-					);
-					val = _m_paddw (val, s1);
-					val = _m_paddw (val, s2);
-				}
-				*(int *)(pDst    + x) =
-					_m_to_int (_m_packuswb (_m_psrlwi    (val, 8), z));
-				*(int *)(pDstLsb + x) =
-					_m_to_int (_m_packuswb (_mm_and_si64 (val, m), z));
-			}
-
-			pDst    += nDstPitch;
-			pDstLsb += nDstPitch;
-			pSrc    += nSrcPitch;
-			for (int k = 0; k < trad; ++k)
-			{
-				pRef [k*2    ] += Pitch [k*2    ];
-				pRef [k*2 + 1] += Pitch [k*2 + 1];
-			}
-		}
-	}
-
-	else
-	{
-		const __m64		o = _mm_set1_pi16 (128);
-
-		for (int h = 0; h < blockHeight; ++h)
-		{
-			for (int x = 0; x < blockWidth; x += 4)
-			{
-				__m64				val = _m_paddw (_m_pmullw (
-					_m_punpcklbw (*(__m64 *) (pSrc + x), z),
-					_mm_set1_pi16 (Wall [0])
-				), o);
-				for (int k = 0; k < trad; ++k)
-				{
-					const __m64		s1 = _m_pmullw (
-						_m_punpcklbw (*(__m64 *) (pRef [k * 2    ] + x), z),
-						_mm_set1_pi16 (Wall [k * 2 + 1])
-					);
-					const __m64		s2 = _m_pmullw (
-						_m_punpcklbw (*(__m64 *) (pRef [k * 2 + 1] + x), z),
-						_mm_set1_pi16 (Wall [k * 2 + 2])
-					);
-					val = _m_paddw (val, s1);
-					val = _m_paddw (val, s2);
-				}
-				*(int *)(pDst + x) =
-					_m_to_int (_m_packuswb (_m_psrlwi (val, 8), z));
-			}
-
-			pDst += nDstPitch;
-			pSrc += nSrcPitch;
-			for (int k = 0; k < trad; ++k)
-			{
-				pRef [k*2    ] += Pitch [k*2    ];
-				pRef [k*2 + 1] += Pitch [k*2 + 1];
-			}
-		}
-	}
-
-	_m_empty ();
-}
-
-
-
-template <int blockWidth, int blockHeight>
-void DegrainN_sse2 (
-	BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
-	const BYTE *pSrc, int nSrcPitch,
-	const BYTE *pRef [], int Pitch [],
-	int Wall [], int trad
-)
-{
-	const __m128i	z = _mm_setzero_si128 ();
-
-	if (lsb_flag)
-	{
-		const __m128i	m = _mm_set1_epi16 (255);
-
-		for (int h = 0; h < blockHeight; ++h)
-		{
-			for (int x = 0; x < blockWidth; x += 8)
-			{
-				__m128i			val = _mm_mullo_epi16 (
-					_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pSrc + x)), z),
-					_mm_set1_epi16 (Wall [0])
-				);
-				for (int k = 0; k < trad; ++k)
-				{
-					const __m128i	s1 = _mm_mullo_epi16 (
-						_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pRef [k * 2    ] + x)), z),
-						_mm_set1_epi16 (Wall [k * 2 + 1])
-					);
-					const __m128i	s2 = _mm_mullo_epi16 (
-						_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pRef [k * 2 + 1] + x)), z),
-						_mm_set1_epi16 (Wall [k * 2 + 2])
-					);
-					val = _mm_add_epi16 (val, s1);
-					val = _mm_add_epi16 (val, s2);
-				}
-				_mm_storel_epi64 (
-					(__m128i*)(pDst    + x),
-					_mm_packus_epi16 (_mm_srli_epi16 (val, 8), z)
-				);
-				_mm_storel_epi64 (
-					(__m128i*)(pDstLsb + x),
-					_mm_packus_epi16 (_mm_and_si128  (val, m), z)
-				);
-			}
-			pDst    += nDstPitch;
-			pDstLsb += nDstPitch;
-			pSrc    += nSrcPitch;
-			for (int k = 0; k < trad; ++k)
-			{
-				pRef [k*2    ] += Pitch [k*2    ];
-				pRef [k*2 + 1] += Pitch [k*2 + 1];
-			}
-		}
-	}
-
-	else
-	{
-		const __m128i	o = _mm_set1_epi16 (128);
-
-		for (int h = 0; h < blockHeight; ++h)
-		{
-			for (int x = 0; x < blockWidth; x += 8)
-			{
-				__m128i			val = _mm_add_epi16 (_mm_mullo_epi16 (
-					_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pSrc + x)), z),
-					_mm_set1_epi16 (Wall [0])
-				), o);
-				for (int k = 0; k < trad; ++k)
-				{
-					const __m128i	s1 = _mm_mullo_epi16 (
-						_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pRef [k * 2    ] + x)), z),
-						_mm_set1_epi16 (Wall [k * 2 + 1])
-					);
-					const __m128i	s2 = _mm_mullo_epi16 (
-						_mm_unpacklo_epi8 (_mm_loadl_epi64 ((__m128i *) (pRef [k * 2 + 1] + x)), z),
-						_mm_set1_epi16 (Wall [k * 2 + 2])
-					);
-					val = _mm_add_epi16 (val, s1);
-					val = _mm_add_epi16 (val, s2);
-				}
-				_mm_storel_epi64 (
-					(__m128i*)(pDst + x),
-					_mm_packus_epi16 (_mm_srli_epi16 (val, 8), z)
-				);
-			}
-
-			pDst += nDstPitch;
-			pSrc += nSrcPitch;
-			for (int k = 0; k < trad; ++k)
-			{
-				pRef [k*2    ] += Pitch [k*2    ];
-				pRef [k*2 + 1] += Pitch [k*2 + 1];
-			}
-		}
-	}
-}
-
-
-
 MDegrainN::MDegrainN (
 	::PClip child, ::PClip super, ::PClip mvmulti, int trad,
 	int thsad, int thsadc, int yuvplanes, int nlimit, int nlimitc,
 	int nscd1, int nscd2, bool isse_flag, bool planar_flag, bool lsb_flag,
-	int thsad2, int thsadc2, bool mt_flag, ::IScriptEnvironment* env_ptr
+	int thsad2, int thsadc2, bool mt_flag, const char *profile_0,
+	::IScriptEnvironment* env_ptr
 )
 :	GenericVideoFilter (child)
 ,	MVFilter (mvmulti, "MDegrainN", env_ptr, 1, 0)
@@ -307,9 +50,7 @@ MDegrainN::MDegrainN (
 ,	_overschroma_lsb_ptr (0)
 ,	_degrainluma_ptr (0)
 ,	_degrainchroma_ptr (0)
-,	_dst_short ()
 ,	_dst_short_pitch ()
-,	_dst_int ()
 ,	_dst_int_pitch ()
 //,	_usable_flag_arr ()
 //,	_planes_ptr ()
@@ -320,7 +61,11 @@ MDegrainN::MDegrainN (
 //,	_lsb_offset_arr ()
 ,	_covered_width (0)
 ,	_covered_height (0)
-,	_boundary_cnt_arr ()
+,	_plane_buf_arr ()
+,	_slice_arr ()
+,	_plane_graph ()
+,	_prof_ptr (0)
+,	_prof_slices ()
 {
 	if (trad > MAX_TEMP_RAD)
 	{
@@ -421,186 +166,64 @@ MDegrainN::MDegrainN (
 			nBlkSizeX / 2, nBlkSizeY >> _yratiouv_log,
 			nOverlapX / 2, nOverlapY >> _yratiouv_log
 		));
-		if (_lsb_flag)
-		{
-			_dst_int.resize (_dst_int_pitch * nHeight);
-		}
-		else
-		{
-			_dst_short.resize (_dst_short_pitch * nHeight);
-		}
-   }
-	if (nOverlapY > 0)
-	{
-		_boundary_cnt_arr.resize (nBlkY);
-	}
 
-	switch (nBlkSizeX)
-	{
-	case 32:
-		if (nBlkSizeY==16) {					_oversluma_lsb_ptr   = OverlapsLsb_C<32,16>; 
-			if (yRatioUV==2) {				_overschroma_lsb_ptr = OverlapsLsb_C<16,8>;  }
-			else {								_overschroma_lsb_ptr = OverlapsLsb_C<16,16>; }
-		} else if (nBlkSizeY==32) {		_oversluma_lsb_ptr   = OverlapsLsb_C<32,32>;
-			if (yRatioUV==2) {				_overschroma_lsb_ptr = OverlapsLsb_C<16,16>; }
-			else {								_overschroma_lsb_ptr = OverlapsLsb_C<16,32>; }
-		} break;
-	case 16:
-		if (nBlkSizeY==16) {					_oversluma_lsb_ptr   = OverlapsLsb_C<16,16>; 
-			if (yRatioUV==2) {				_overschroma_lsb_ptr = OverlapsLsb_C<8,8>;   }
-			else {								_overschroma_lsb_ptr = OverlapsLsb_C<8,16>;  }
-		} else if (nBlkSizeY==8) {			_oversluma_lsb_ptr   = OverlapsLsb_C<16,8>;  
-			if (yRatioUV==2) {				_overschroma_lsb_ptr = OverlapsLsb_C<8,4>;   }
-			else {								_overschroma_lsb_ptr = OverlapsLsb_C<8,8>;   }
-		} else if (nBlkSizeY==2) {			_oversluma_lsb_ptr   = OverlapsLsb_C<16,2>;  
-			if (yRatioUV==2) {				_overschroma_lsb_ptr = OverlapsLsb_C<8,1>;   }
-			else {								_overschroma_lsb_ptr = OverlapsLsb_C<8,2>;   }
-		}
-		break;
-	case 4:										_oversluma_lsb_ptr   = OverlapsLsb_C<4,4>;   
-		if (yRatioUV==2) {					_overschroma_lsb_ptr = OverlapsLsb_C<2,2>;   }
-		else {									_overschroma_lsb_ptr = OverlapsLsb_C<2,4>;   }
-		break;
-	case 8:
-	default:
-		if (nBlkSizeY==8) {					_oversluma_lsb_ptr   = OverlapsLsb_C<8,8>;   
-			if (yRatioUV==2) {				_overschroma_lsb_ptr = OverlapsLsb_C<4,4>;   }
-			else {								_overschroma_lsb_ptr = OverlapsLsb_C<4,8>;   }
-		} else if (nBlkSizeY==4) {			_oversluma_lsb_ptr   = OverlapsLsb_C<8,4>;   
-			if (yRatioUV==2) {				_overschroma_lsb_ptr = OverlapsLsb_C<4,2>;   }
-			else {								_overschroma_lsb_ptr = OverlapsLsb_C<4,4>;   }
-		}
-   }
-
-	if (((env_ptr->GetCPUFlags () & CPUF_SSE2) != 0) & _isse_flag)
-	{
-		switch (nBlkSizeX)
+		// Each plane has its own buffer so they can be processed concurrently
+		for (int p = 0; p < 3; ++p)
 		{
-		case 32:
-			if (nBlkSizeY==16) {				_oversluma_ptr   = Overlaps32x16_sse2; _degrainluma_ptr   = DegrainN_sse2<32,16>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps16x8_sse2;  _degrainchroma_ptr = DegrainN_sse2<16,8>;	}
-				else {							_overschroma_ptr = Overlaps16x16_sse2; _degrainchroma_ptr = DegrainN_sse2<16,16>;	}
-			} else if (nBlkSizeY==32) {	_oversluma_ptr   = Overlaps32x32_sse2; _degrainluma_ptr   = DegrainN_sse2<32,32>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps16x16_sse2; _degrainchroma_ptr = DegrainN_sse2<16,16>;	}
-				else {							_overschroma_ptr = Overlaps16x32_sse2; _degrainchroma_ptr = DegrainN_sse2<16,32>;	}
-			} break;
-		case 16:
-			if (nBlkSizeY==16) {          _oversluma_ptr   = Overlaps16x16_sse2; _degrainluma_ptr   = DegrainN_sse2<16,16>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps8x8_sse2;   _degrainchroma_ptr = DegrainN_sse2<8,8>;	}
-				else {							_overschroma_ptr = Overlaps8x16_sse2;  _degrainchroma_ptr = DegrainN_sse2<8,16>;	}
-			} else if (nBlkSizeY==8) {		_oversluma_ptr   = Overlaps16x8_sse2;  _degrainluma_ptr   = DegrainN_sse2<16,8>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps8x4_sse2;   _degrainchroma_ptr = DegrainN_sse2<8,4>;	}
-				else {							_overschroma_ptr = Overlaps8x8_sse2;   _degrainchroma_ptr = DegrainN_sse2<8,8>;	}
-			} else if (nBlkSizeY==2) {		_oversluma_ptr   = Overlaps16x2_sse2;  _degrainluma_ptr   = DegrainN_sse2<16,2>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps8x1_sse2;   _degrainchroma_ptr = DegrainN_sse2<8,1>;	}
-				else {							_overschroma_ptr = Overlaps8x2_sse2;   _degrainchroma_ptr = DegrainN_sse2<8,2>;	}
-			}
-			break;
-		case 4:									_oversluma_ptr   = Overlaps4x4_sse2;   _degrainluma_ptr   = DegrainN_mmx<4,4>;
-			if (yRatioUV==2) {				_overschroma_ptr = Overlaps_C<2,2>;	  _degrainchroma_ptr = DegrainN_C<2,2>;		}
-			else {								_overschroma_ptr = Overlaps_C<2,4>;   _degrainchroma_ptr = DegrainN_C<2,4>;		}
-			break;
-		case 8:
-		default:
-			if (nBlkSizeY==8) {				_oversluma_ptr   = Overlaps8x8_sse2;   _degrainluma_ptr   = DegrainN_sse2<8,8>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps4x4_sse2;   _degrainchroma_ptr = DegrainN_mmx<4,4>;		}
-				else {							_overschroma_ptr = Overlaps4x8_sse2;   _degrainchroma_ptr = DegrainN_mmx<4,8>;		}
-			} else if (nBlkSizeY==4) {		_oversluma_ptr   = Overlaps8x4_sse2;   _degrainluma_ptr   = DegrainN_sse2<8,4>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps4x2_sse2;	  _degrainchroma_ptr = DegrainN_mmx<4,2>;		}
-				else {							_overschroma_ptr = Overlaps4x4_sse2;   _degrainchroma_ptr = DegrainN_mmx<4,4>;		}
+			if (is_plane_processed (p))
+			{
+				PlaneBuf &		buf    = _plane_buf_arr [p];
+				const int		height = (p == 0) ? nHeight : nHeight >> _yratiouv_log;
+				if (_lsb_flag)
+				{
+					buf._dst_int.resize (_dst_int_pitch * height);
+				}
+				else
+				{
+					buf._dst_short.resize (_dst_short_pitch * height);
+				}
+				if (nOverlapY > 0)
+				{
+					buf._boundary_cnt_arr.resize (nBlkY);
+				}
+				buf._strip_cnt_arr.resize (nBlkY);
 			}
 		}
-	}
-	else if (_isse_flag)
+   }
+
+	const FuncDispatch::Tier	tier = FuncDispatch::select_tier (_isse_flag);
+	FuncDispatch::BlockFnc	fnc;
+	if (FuncDispatch::find (fnc, nBlkSizeX, nBlkSizeY, tier))
 	{
-		switch (nBlkSizeX)
-		{
-		case 32:
-			if (nBlkSizeY==16) {				_oversluma_ptr   = Overlaps32x16_sse2; _degrainluma_ptr   = DegrainN_mmx<32,16>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps16x8_sse2;  _degrainchroma_ptr = DegrainN_mmx<16,8>;	}
-				else {							_overschroma_ptr = Overlaps16x16_sse2; _degrainchroma_ptr = DegrainN_mmx<16,16>;	}
-			} else if (nBlkSizeY==32) {	_oversluma_ptr   = Overlaps32x32_sse2; _degrainluma_ptr   = DegrainN_mmx<32,32>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps16x16_sse2; _degrainchroma_ptr = DegrainN_mmx<16,16>;	}
-				else {							_overschroma_ptr = Overlaps16x32_sse2; _degrainchroma_ptr = DegrainN_mmx<16,32>;	}
-			} break;
-		case 16:
-			if (nBlkSizeY==16) {				_oversluma_ptr   = Overlaps16x16_sse2; _degrainluma_ptr   = DegrainN_mmx<16,16>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps8x8_sse2;   _degrainchroma_ptr = DegrainN_mmx<8,8>;		}
-				else {							_overschroma_ptr = Overlaps8x16_sse2;  _degrainchroma_ptr = DegrainN_mmx<8,16>;	}
-			} else if (nBlkSizeY==8) {		_oversluma_ptr   = Overlaps16x8_sse2;  _degrainluma_ptr   = DegrainN_mmx<16,8>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps8x4_sse2;   _degrainchroma_ptr = DegrainN_mmx<8,4>;		}
-				else {							_overschroma_ptr = Overlaps8x8_sse2;   _degrainchroma_ptr = DegrainN_mmx<8,8>;		}
-			} else if (nBlkSizeY==2) {		_oversluma_ptr   = Overlaps16x2_sse2;  _degrainluma_ptr   = DegrainN_mmx<16,2>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps8x1_sse2;   _degrainchroma_ptr = DegrainN_mmx<8,1>;		}
-				else {							_overschroma_ptr = Overlaps8x2_sse2;   _degrainchroma_ptr = DegrainN_mmx<8,2>;		}
-			}
-			break;
-		case 4:									_oversluma_ptr   = Overlaps4x4_sse2;   _degrainluma_ptr   = DegrainN_mmx<4,4>;
-			if (yRatioUV==2) {				_overschroma_ptr = Overlaps_C<2,2>;   _degrainchroma_ptr = DegrainN_C<2,2>;		}
-			else {								_overschroma_ptr = Overlaps_C<2,4>;   _degrainchroma_ptr = DegrainN_C<2,4>;		}
-			break;
-		case 8:
-			default:
-			if (nBlkSizeY==8) {				_oversluma_ptr   = Overlaps8x8_sse2;   _degrainluma_ptr   = DegrainN_mmx<8,8>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps4x4_sse2;   _degrainchroma_ptr = DegrainN_mmx<4,4>;		}
-				else {							_overschroma_ptr = Overlaps4x8_sse2;   _degrainchroma_ptr = DegrainN_mmx<4,8>;		}
-			} else if (nBlkSizeY==4) {		_oversluma_ptr   = Overlaps8x4_sse2;	  _degrainluma_ptr   = DegrainN_mmx<8,4>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps4x2_sse2;	  _degrainchroma_ptr = DegrainN_mmx<4,2>;		}
-				else {							_overschroma_ptr = Overlaps4x4_sse2;   _degrainchroma_ptr = DegrainN_mmx<4,4>;		}
-			}
-		}
+		_oversluma_ptr     = fnc._overlaps_ptr;
+		_oversluma_lsb_ptr = fnc._overlaps_lsb_ptr;
+		_degrainluma_ptr   = fnc._degrain_n_ptr;
 	}
-	else
+	if (FuncDispatch::find (fnc, nBlkSizeX >> 1, nBlkSizeY >> _yratiouv_log, tier))
 	{
-		switch (nBlkSizeX)
-		{
-		case 32:
-			if (nBlkSizeY==16) {				_oversluma_ptr   = Overlaps_C<32,16>; _degrainluma_ptr   = DegrainN_C<32,16>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps_C<16,8>;  _degrainchroma_ptr = DegrainN_C<16,8>;		}
-				else {							_overschroma_ptr = Overlaps_C<16,16>; _degrainchroma_ptr = DegrainN_C<16,16>;		}
-			} else if (nBlkSizeY==32) {	_oversluma_ptr   = Overlaps_C<32,32>; _degrainluma_ptr   = DegrainN_C<32,32>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps_C<16,16>; _degrainchroma_ptr = DegrainN_C<16,16>;		}
-				else {							_overschroma_ptr = Overlaps_C<16,32>; _degrainchroma_ptr = DegrainN_C<16,32>;		}
-			} break;
-		case 16:
-			if (nBlkSizeY==16) {				_oversluma_ptr   = Overlaps_C<16,16>; _degrainluma_ptr   = DegrainN_C<16,16>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps_C<8,8>;   _degrainchroma_ptr = DegrainN_C<8,8>;		}
-				else {							_overschroma_ptr = Overlaps_C<8,16>;  _degrainchroma_ptr = DegrainN_C<8,16>;		}
-			} else if (nBlkSizeY==8) {		_oversluma_ptr   = Overlaps_C<16,8>;  _degrainluma_ptr   = DegrainN_C<16,8>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps_C<8,4>;   _degrainchroma_ptr = DegrainN_C<8,4>;		}
-				else {							_overschroma_ptr = Overlaps_C<8,8>;   _degrainchroma_ptr = DegrainN_C<8,8>;		}
-			} else if (nBlkSizeY==2) {		_oversluma_ptr   = Overlaps_C<16,2>;  _degrainluma_ptr   = DegrainN_C<16,2>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps_C<8,1>;   _degrainchroma_ptr = DegrainN_C<8,1>;		}
-				else {							_overschroma_ptr = Overlaps_C<8,2>;   _degrainchroma_ptr = DegrainN_C<8,2>;		}
-			}
-			break;
-		case 4:									_oversluma_ptr   = Overlaps_C<4,4>;   _degrainluma_ptr   = DegrainN_C<4,4>;
-			if (yRatioUV==2) {				_overschroma_ptr = Overlaps_C<2,2>;   _degrainchroma_ptr = DegrainN_C<2,2>;		}
-			else {								_overschroma_ptr = Overlaps_C<2,4>;   _degrainchroma_ptr = DegrainN_C<2,4>;		}
-			break;
-		case 8:
-		default:
-			if (nBlkSizeY==8) {				_oversluma_ptr   = Overlaps_C<8,8>;   _degrainluma_ptr   = DegrainN_C<8,8>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps_C<4,4>;   _degrainchroma_ptr = DegrainN_C<4,4>;		}
-				else {							_overschroma_ptr = Overlaps_C<4,8>;   _degrainchroma_ptr = DegrainN_C<4,8>;		}
-			} else if (nBlkSizeY==4) {		_oversluma_ptr   = Overlaps_C<8,4>;   _degrainluma_ptr   = DegrainN_C<8,4>;
-				if (yRatioUV==2) {			_overschroma_ptr = Overlaps_C<4,2>;   _degrainchroma_ptr = DegrainN_C<4,2>;		}
-				else {							_overschroma_ptr = Overlaps_C<4,4>;   _degrainchroma_ptr = DegrainN_C<4,4>;		}
-			}
-		}
+		_overschroma_ptr     = fnc._overlaps_ptr;
+		_overschroma_lsb_ptr = fnc._overlaps_lsb_ptr;
+		_degrainchroma_ptr   = fnc._degrain_n_ptr;
 	}
 
 	if (_lsb_flag)
 	{
 		vi.height <<= 1;
 	}
+
+	build_plane_graph ();
+
+	_prof_ptr = Profiler::acquire (profile_0);
+	SuperFrameCache::add_client (_super);
 }
 
 
 
 MDegrainN::~MDegrainN ()
 {
-	// Nothing
+	SuperFrameCache::remove_client (_super);
+	Profiler::release (_prof_ptr);
+	_prof_ptr = 0;
 }
 
 
@@ -622,8 +245,7 @@ MDegrainN::~MDegrainN ()
 		// reorder ror regular frames order in v2.0.9.2
 		const int		k = reorder_ref (k2);
 
-		// v2.0.9.2 - it seems we do not need in vectors clip anymore when we
-		// finished copying them to fakeblockdatas
+		// The vector frame is kept by the MVClip until its next Update()
 		MVClip &			mv_clip = *(_mv_clip_arr [k]._clip_sptr);
 		::PVideoFrame	mv = mv_clip.GetFrame (n, env_ptr);
 		mv_clip.Update (mv, env_ptr);
@@ -776,141 +398,41 @@ MDegrainN::~MDegrainN ()
 		}
 	}
 
-	PROFILE_START (MOTION_PROFILE_COMPENSATION);
-
 	//-------------------------------------------------------------------------
-	// LUMA plane Y
+	// All the slices of all the planes are run at once, so there is a single
+	// synchronisation point for the whole frame.
 
-	if ((_yuvplanes & YPLANE) == 0)
+	if (nOverlapX > 0 || nOverlapY > 0)
 	{
-		BitBlt (
-			_dst_ptr_arr [0], _dst_pitch_arr [0],
-			_src_ptr_arr [0], _src_pitch_arr [0],
-			nWidth, nHeight, _isse_flag
-		);
+		reset_overlap_cnt ();
 	}
 
-	else
-	{
-		Slicer			slicer (_mt_flag);
-
-		if (nOverlapX == 0 && nOverlapY == 0)
-		{
-			slicer.start (
-				nBlkY,
-				*this,
-				&MDegrainN::process_luma_normal_slice
-			);
-			slicer.wait ();
-		}
+	const int64_t	prof_t_beg = prof_begin_run ();
+	Scheduler		sched (_mt_flag);
+	sched.start (_plane_graph, *this, &MDegrainN::process_task);
 
-		// Overlap
-		else
+	// Meanwhile, copies the planes we don't process
+	for (int p = 0; p < 3; ++p)
+	{
+		if (! is_plane_processed (p))
 		{
-			unsigned short *	pDstShort = (_dst_short.empty ()) ? 0 : &_dst_short [0];
-			int *					pDstInt   = (_dst_int.empty ()  ) ? 0 : &_dst_int [0];
-
-			if (_lsb_flag)
-			{
-				MemZoneSet (
-					reinterpret_cast <unsigned char *> (pDstInt), 0,
-					_covered_width * 4, _covered_height, 0, 0, _dst_int_pitch * 4
-				);
-			}
-			else
-			{
-				MemZoneSet (
-					reinterpret_cast <unsigned char *> (pDstShort), 0,
-					_covered_width * 2, _covered_height, 0, 0, _dst_short_pitch * 2
-				);
-			}
-
-			if (nOverlapY > 0)
-			{
-				memset (
-					&_boundary_cnt_arr [0],
-					0,
-					_boundary_cnt_arr.size () * sizeof (_boundary_cnt_arr [0])
-				);
-			}
-
-			slicer.start (
-				nBlkY,
-				*this,
-				&MDegrainN::process_luma_overlap_slice,
-				2
+			const int		xlog = (p == 0) ? 0 : 1;
+			const int		ylog = (p == 0) ? 0 : _yratiouv_log;
+			BitBlt (
+				_dst_ptr_arr [p], _dst_pitch_arr [p],
+				_src_ptr_arr [p], _src_pitch_arr [p],
+				nWidth >> xlog, nHeight >> ylog, _isse_flag
 			);
-			slicer.wait ();
-
-			if (_lsb_flag)
-			{
-				Short2BytesLsb (
-					_dst_ptr_arr [0],
-					_dst_ptr_arr [0] + _lsb_offset_arr [0],
-					_dst_pitch_arr [0],
-					&_dst_int [0], _dst_int_pitch,
-					_covered_width, _covered_height
-				);
-			}
-			else
-			{
-				Short2Bytes (
-					_dst_ptr_arr [0], _dst_pitch_arr [0],
-					&_dst_short [0], _dst_short_pitch,
-					_covered_width, _covered_height
-				);
-			}
-			if (_covered_width < nWidth)
-			{
-				BitBlt (
-					_dst_ptr_arr [0] + _covered_width, _dst_pitch_arr [0],
-					_src_ptr_arr [0] + _covered_width, _src_pitch_arr [0],
-					nWidth - _covered_width, _covered_height, _isse_flag
-				);
-			}
-			if (_covered_height < nHeight) // bottom noncovered region
-			{
-				BitBlt (
-					_dst_ptr_arr [0] + _covered_height * _dst_pitch_arr [0], _dst_pitch_arr [0],
-					_src_ptr_arr [0] + _covered_height * _src_pitch_arr [0], _src_pitch_arr [0],
-					nWidth, nHeight - _covered_height, _isse_flag
-				);
-			}
-		}	// overlap - end
-
-		if (_nlimit < 255)
-		{
-			if (_isse_flag)
-			{
-				LimitChanges_sse2 (
-					_dst_ptr_arr [0], _dst_pitch_arr [0],
-					_src_ptr_arr [0], _src_pitch_arr [0],
-					nWidth, nHeight, _nlimit
-				);
-			}
-			else
-			{
-				LimitChanges_c (
-					_dst_ptr_arr [0], _dst_pitch_arr [0],
-					_src_ptr_arr [0], _src_pitch_arr [0],
-					nWidth, nHeight, _nlimit
-				);
-			}
 		}
 	}
 
-	//-------------------------------------------------------------------------
-	// CHROMA planes
-
-	process_chroma <1> (UPLANE & _nsupermodeyuv);
-	process_chroma <2> (VPLANE & _nsupermodeyuv);
+	sched.wait ();
+	prof_end_run (prof_t_beg);
 
 	//-------------------------------------------------------------------------
 
 	_mm_empty (); // (we may use double-float somewhere) Fizick
 
-	PROFILE_STOP (MOTION_PROFILE_COMPENSATION);
-
 	if ((pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && ! _planar_flag)
 	{
 		YUY2FromPlanes (
@@ -939,145 +461,120 @@ int	MDegrainN::reorder_ref (int index) const
 
 
 
-template <int P>
-void	MDegrainN::process_chroma (int plane_mask)
+bool	MDegrainN::is_plane_processed (int p) const
 {
-	if ((_yuvplanes & plane_mask) == 0)
-	{
-		BitBlt (
-			_dst_ptr_arr [P], _dst_pitch_arr [P],
-			_src_ptr_arr [P], _src_pitch_arr [P],
-			nWidth >> 1, nHeight >> _yratiouv_log, _isse_flag
-		);
-	}
+	assert (p >= 0);
+	assert (p < 3);
 
-	else
-	{
-		Slicer			slicer (_mt_flag);
+	static const int	plane_mask_arr [3] = { YPLANE, UPLANE, VPLANE };
+	const int		plane_mask =
+		(p == 0) ? YPLANE : (plane_mask_arr [p] & _nsupermodeyuv);
 
-		if (nOverlapX == 0 && nOverlapY == 0)
-		{
-			slicer.start (
-				nBlkY,
-				*this,
-				&MDegrainN::process_chroma_normal_slice <P>
-			);
-			slicer.wait ();
-		}
+	return ((_yuvplanes & plane_mask) != 0);
+}
 
-		// Overlap
-		else
-		{
-			unsigned short *	pDstShort = (_dst_short.empty ()) ? 0 : &_dst_short [0];
-			int *					pDstInt   = (_dst_int.empty ()  ) ? 0 : &_dst_int [0];
 
-			if (_lsb_flag)
-			{
-				MemZoneSet (
-					reinterpret_cast <unsigned char *> (pDstInt), 0,
-					_covered_width * 2, _covered_height >> _yratiouv_log,
-					0, 0, _dst_int_pitch * 4
-				);
-			}
-			else
-			{
-				MemZoneSet (
-					reinterpret_cast <unsigned char *> (pDstShort), 0,
-					_covered_width, _covered_height >> _yratiouv_log,
-					0, 0, _dst_short_pitch * 2
-				);
-			}
 
-			if (nOverlapY > 0)
+// Cuts each processed plane in slices of block rows, all of them depending
+// only on the root task so they can all run in parallel.
+void	MDegrainN::build_plane_graph ()
+{
+	const int		min_slice_h =
+		(nOverlapX > 0 || nOverlapY > 0) ? 2 : 1;
+	int				nbr_slices  =
+		  (_mt_flag)
+		? AvstpWrapper::use_instance ().get_nbr_threads ()
+		: 1;
+	nbr_slices = std::min (nbr_slices, int (MAX_SLICES_PER_PLANE));
+	nbr_slices = std::min (nbr_slices, nBlkY / min_slice_h);
+	nbr_slices = std::max (nbr_slices, 1);
+
+	_slice_arr.clear ();
+	_plane_graph.clear ();
+	for (int p = 0; p < 3; ++p)
+	{
+		if (is_plane_processed (p))
+		{
+			for (int s = 0; s < nbr_slices; ++s)
 			{
-				memset (
-					&_boundary_cnt_arr [0],
-					0,
-					_boundary_cnt_arr.size () * sizeof (_boundary_cnt_arr [0])
-				);
+				SliceInfo		info;
+				info._plane = p;
+				info._y_beg =  s      * nBlkY / nbr_slices;
+				info._y_end = (s + 1) * nBlkY / nbr_slices;
+				_slice_arr.push_back (info);
+
+				// Task 0 is the root
+				_plane_graph.add_dep (0, int (_slice_arr.size ()));
 			}
+		}
+	}
+}
 
-			slicer.start (
-				nBlkY,
-				*this,
-				&MDegrainN::process_chroma_overlap_slice <P>,
-				2
-			);
-			slicer.wait ();
 
-			if (_lsb_flag)
-			{
-				Short2BytesLsb (
-					_dst_ptr_arr [P],
-					_dst_ptr_arr [P] + _lsb_offset_arr [P],
-					_dst_pitch_arr [P],
-					&_dst_int [0], _dst_int_pitch,
-					_covered_width >> 1, _covered_height >> _yratiouv_log
-				);
-			}
-			else
-			{
-				Short2Bytes (
-					_dst_ptr_arr [P], _dst_pitch_arr [P],
-					&_dst_short [0], _dst_short_pitch,
-					_covered_width >> 1, _covered_height >> _yratiouv_log
-				);
-			}
-			if (_covered_width < nWidth)
-			{
-				BitBlt (
-					_dst_ptr_arr [P] + (_covered_width >> 1), _dst_pitch_arr [P],
-					_src_ptr_arr [P] + (_covered_width >> 1), _src_pitch_arr [P],
-					(nWidth - _covered_width) >> 1, _covered_height >> _yratiouv_log,
-					_isse_flag
-				);
-			}
-			if (_covered_height < nHeight) // bottom noncovered region
-			{
-				BitBlt (
-					_dst_ptr_arr [P] + ((_dst_pitch_arr [P] * _covered_height) >> _yratiouv_log), _dst_pitch_arr [P],
-					_src_ptr_arr [P] + ((_src_pitch_arr [P] * _covered_height) >> _yratiouv_log), _src_pitch_arr [P],
-					nWidth >> 1, ((nHeight - _covered_height) >> _yratiouv_log),
-					_isse_flag
-				);
-			}
-		}	// overlap - end
 
-		if (_nlimitc < 255)
+void	MDegrainN::process_task (Scheduler::TaskData &td)
+{
+	assert (&td != 0);
+
+	// Root task: nothing to do
+	if (td._task_index == 0)
+	{
+		return;
+	}
+
+	const int64_t	prof_t_beg = prof_begin_slice ();
+
+	const SliceInfo &	info = _slice_arr [td._task_index - 1];
+	const bool		overlap_flag = (nOverlapX > 0 || nOverlapY > 0);
+	switch (info._plane)
+	{
+	case 0:
+		if (overlap_flag)
 		{
-			if (_isse_flag)
-			{
-				LimitChanges_sse2 (
-					_dst_ptr_arr [P], _dst_pitch_arr [P],
-					_src_ptr_arr [P], _src_pitch_arr [P],
-					nWidth >> 1, nHeight >> _yratiouv_log,
-					_nlimitc
-				);
-			}
-			else
-			{
-				LimitChanges_c (
-					_dst_ptr_arr [P], _dst_pitch_arr [P],
-					_src_ptr_arr [P], _src_pitch_arr [P],
-					nWidth >> 1, nHeight >> _yratiouv_log,
-					_nlimitc
-				);
-			}
+			process_luma_overlap_slice (info._y_beg, info._y_end);
 		}
+		else
+		{
+			process_luma_normal_slice (info._y_beg, info._y_end);
+		}
+		break;
+	case 1:
+		if (overlap_flag)
+		{
+			process_chroma_overlap_slice <1> (info._y_beg, info._y_end);
+		}
+		else
+		{
+			process_chroma_normal_slice <1> (info._y_beg, info._y_end);
+		}
+		break;
+	case 2:
+		if (overlap_flag)
+		{
+			process_chroma_overlap_slice <2> (info._y_beg, info._y_end);
+		}
+		else
+		{
+			process_chroma_normal_slice <2> (info._y_beg, info._y_end);
+		}
+		break;
+	default:
+		assert (false);
+		break;
 	}
+
+	prof_end_slice (prof_t_beg);
 }
 
 
 
-void	MDegrainN::process_luma_normal_slice (Slicer::TaskData &td)
+void	MDegrainN::process_luma_normal_slice (int y_beg, int y_end)
 {
-	assert (&td != 0);
-
 	const int		rowsize = nBlkSizeY;
-	BYTE *			pDstCur = _dst_ptr_arr [0] + td._y_beg * rowsize * _dst_pitch_arr [0];
-	const BYTE *	pSrcCur = _src_ptr_arr [0] + td._y_beg * rowsize * _src_pitch_arr [0];
+	BYTE *			pDstCur = _dst_ptr_arr [0] + y_beg * rowsize * _dst_pitch_arr [0];
+	const BYTE *	pSrcCur = _src_ptr_arr [0] + y_beg * rowsize * _src_pitch_arr [0];
 
-	for (int by = td._y_beg; by < td._y_end; ++by)
+	for (int by = y_beg; by < y_end; ++by)
 	{
 		int				xx = 0;
 		for (int bx = 0; bx < nBlkX; ++bx)
@@ -1137,63 +634,67 @@ void	MDegrainN::process_luma_normal_slice (Slicer::TaskData &td)
 			);
 		}
 	}	// for by
+
+	// The limit is applied here too, while the rows are still in the cache.
+	// The last slice includes the bottom uncovered region.
+	const int		y_end_pix = (y_end == nBlkY) ? nHeight : y_end * rowsize;
+	limit_rows <0> (y_beg * rowsize, y_end_pix, nWidth);
 }
 
 
 
-void	MDegrainN::process_luma_overlap_slice (Slicer::TaskData &td)
+void	MDegrainN::process_luma_overlap_slice (int y_beg, int y_end)
 {
-	assert (&td != 0);
-
 	if (   nOverlapY == 0
-	    || (td._y_beg == 0 && td._y_end == nBlkY))
+	    || (y_beg == 0 && y_end == nBlkY))
 	{
-		process_luma_overlap_slice (td._y_beg, td._y_end);
+		process_luma_overlap_rows (y_beg, y_end);
 	}
 
 	else
 	{
-		assert (td._y_end - td._y_beg >= 2);
+		assert (y_end - y_beg >= 2);
 
-		process_luma_overlap_slice (td._y_beg, td._y_end - 1);
+		process_luma_overlap_rows (y_beg, y_end - 1);
 
 		const conc::AioAdd <int>	inc_ftor (+1);
 
 		const int		cnt_top = conc::AtomicIntOp::exec_new (
-			_boundary_cnt_arr [td._y_beg],
+			_plane_buf_arr [0]._boundary_cnt_arr [y_beg],
 			inc_ftor
 		);
-		if (td._y_beg > 0 && cnt_top == 2)
+		if (y_beg > 0 && cnt_top == 2)
 		{
-			process_luma_overlap_slice (td._y_beg - 1, td._y_beg);
+			process_luma_overlap_rows (y_beg - 1, y_beg);
 		}
 
 		int				cnt_bot = 2;
-		if (td._y_end < nBlkY)
+		if (y_end < nBlkY)
 		{
 			cnt_bot = conc::AtomicIntOp::exec_new (
-				_boundary_cnt_arr [td._y_end],
+				_plane_buf_arr [0]._boundary_cnt_arr [y_end],
 				inc_ftor
 			);
 		}
 		if (cnt_bot == 2)
 		{
-			process_luma_overlap_slice (td._y_end - 1, td._y_end);
+			process_luma_overlap_rows (y_end - 1, y_end);
 		}
 	}
 }
 
 
 
-void	MDegrainN::process_luma_overlap_slice (int y_beg, int y_end)
+void	MDegrainN::process_luma_overlap_rows (int y_beg, int y_end)
 {
 	TmpBlock       tmp_block;
 
 	const int      rowsize = nBlkSizeY - nOverlapY;
 	const BYTE *   pSrcCur = _src_ptr_arr [0] + y_beg * rowsize * _src_pitch_arr [0];
 
-	unsigned short *	pDstShort = (_dst_short.empty ()) ? 0 : &_dst_short [0] + y_beg * rowsize * _dst_short_pitch;
-	int *					pDstInt   = (_dst_int.empty ()  ) ? 0 : &_dst_int [0]   + y_beg * rowsize * _dst_int_pitch;
+	PlaneBuf &			buf       = _plane_buf_arr [0];
+	unsigned short *	pDstShort = (buf._dst_short.empty ()) ? 0 : &buf._dst_short [0] + y_beg * rowsize * _dst_short_pitch;
+	int *					pDstInt   = (buf._dst_int.empty ()  ) ? 0 : &buf._dst_int [0]   + y_beg * rowsize * _dst_int_pitch;
 	const int			tmpPitch  = nBlkSizeX;
 	assert (tmpPitch <= TmpBlock::MAX_SIZE);
 
@@ -1259,21 +760,21 @@ void	MDegrainN::process_luma_overlap_slice (int y_beg, int y_end)
 		pSrcCur   += rowsize * _src_pitch_arr [0];
 		pDstShort += rowsize * _dst_short_pitch;
 		pDstInt   += rowsize * _dst_int_pitch;
+
+		overlap_row_done <0> (by);
 	}	// for by
 }
 
 
 
 template <int P>
-void	MDegrainN::process_chroma_normal_slice (Slicer::TaskData &td)
+void	MDegrainN::process_chroma_normal_slice (int y_beg, int y_end)
 {
-	assert (&td != 0);
-
 	const int		rowsize = nBlkSizeY >> _yratiouv_log;
-	BYTE *			pDstCur = _dst_ptr_arr [P] + td._y_beg * rowsize * _dst_pitch_arr [P];
-	const BYTE *	pSrcCur = _src_ptr_arr [P] + td._y_beg * rowsize * _src_pitch_arr [P];
+	BYTE *			pDstCur = _dst_ptr_arr [P] + y_beg * rowsize * _dst_pitch_arr [P];
+	const BYTE *	pSrcCur = _src_ptr_arr [P] + y_beg * rowsize * _src_pitch_arr [P];
 
-	for (int by = td._y_beg; by < td._y_end; ++by)
+	for (int by = y_beg; by < y_end; ++by)
 	{
 		int				xx = 0;
 		for (int bx = 0; bx < nBlkX; ++bx)
@@ -1337,49 +838,52 @@ void	MDegrainN::process_chroma_normal_slice (Slicer::TaskData &td)
 			);
 		}
 	}	// for by
+
+	// The limit is applied here too, while the rows are still in the cache.
+	// The last slice includes the bottom uncovered region.
+	const int		y_end_pix = (y_end == nBlkY) ? nHeight >> _yratiouv_log : y_end * rowsize;
+	limit_rows <P> (y_beg * rowsize, y_end_pix, nWidth >> 1);
 }
 
 
 
 template <int P>
-void	MDegrainN::process_chroma_overlap_slice (Slicer::TaskData &td)
+void	MDegrainN::process_chroma_overlap_slice (int y_beg, int y_end)
 {
-	assert (&td != 0);
-
 	if (   nOverlapY == 0
-	    || (td._y_beg == 0 && td._y_end == nBlkY))
+	    || (y_beg == 0 && y_end == nBlkY))
 	{
-		process_chroma_overlap_slice <P> (td._y_beg, td._y_end);
+		process_chroma_overlap_rows <P> (y_beg, y_end);
 	}
 
 	else
 	{
-		assert (td._y_end - td._y_beg >= 2);
+		assert (y_end - y_beg >= 2);
 
-		process_chroma_overlap_slice <P> (td._y_beg, td._y_end - 1);
+		process_chroma_overlap_rows <P> (y_beg, y_end - 1);
 
 		const conc::AioAdd <int>	inc_ftor (+1);
 
 		const int		cnt_top = conc::AtomicIntOp::exec_new (
-			_boundary_cnt_arr [td._y_beg],
+			_plane_buf_arr [P]._boundary_cnt_arr [y_beg],
 			inc_ftor
 		);
-		if (td._y_beg > 0 && cnt_top == 2)
+		if (y_beg > 0 && cnt_top == 2)
 		{
-			process_chroma_overlap_slice <P> (td._y_beg - 1, td._y_beg);
+			process_chroma_overlap_rows <P> (y_beg - 1, y_beg);
 		}
 
 		int				cnt_bot = 2;
-		if (td._y_end < nBlkY)
+		if (y_end < nBlkY)
 		{
 			cnt_bot = conc::AtomicIntOp::exec_new (
-				_boundary_cnt_arr [td._y_end],
+				_plane_buf_arr [P]._boundary_cnt_arr [y_end],
 				inc_ftor
 			);
 		}
 		if (cnt_bot == 2)
 		{
-			process_chroma_overlap_slice <P> (td._y_end - 1, td._y_end);
+			process_chroma_overlap_rows <P> (y_end - 1, y_end);
 		}
 	}
 }
@@ -1387,15 +891,16 @@ void	MDegrainN::process_chroma_overlap_slice (Slicer::TaskData &td)
 
 
 template <int P>
-void	MDegrainN::process_chroma_overlap_slice (int y_beg, int y_end)
+void	MDegrainN::process_chroma_overlap_rows (int y_beg, int y_end)
 {
 	TmpBlock       tmp_block;
 
 	const int		rowsize = (nBlkSizeY - nOverlapY) >> _yratiouv_log;
 	const BYTE *	pSrcCur = _src_ptr_arr [P] + y_beg * rowsize * _src_pitch_arr [P];
 
-	unsigned short *	pDstShort = (_dst_short.empty ()) ? 0 : &_dst_short [0] + y_beg * rowsize * _dst_short_pitch;
-	int *					pDstInt   = (_dst_int.empty ()  ) ? 0 : &_dst_int [0]   + y_beg * rowsize * _dst_int_pitch;
+	PlaneBuf &			buf       = _plane_buf_arr [P];
+	unsigned short *	pDstShort = (buf._dst_short.empty ()) ? 0 : &buf._dst_short [0] + y_beg * rowsize * _dst_short_pitch;
+	int *					pDstInt   = (buf._dst_int.empty ()  ) ? 0 : &buf._dst_int [0]   + y_beg * rowsize * _dst_int_pitch;
 	const int			tmpPitch  = nBlkSizeX;
 	assert (tmpPitch <= TmpBlock::MAX_SIZE);
 
@@ -1461,11 +966,188 @@ void	MDegrainN::process_chroma_overlap_slice (int y_beg, int y_end)
 		pSrcCur   += rowsize * _src_pitch_arr [P];
 		pDstShort += rowsize * _dst_short_pitch;
 		pDstInt   += rowsize * _dst_int_pitch;
+
+		overlap_row_done <P> (by);
 	}	// for by
 }
 
 
 
+void	MDegrainN::reset_overlap_cnt ()
+{
+	for (int p = 0; p < 3; ++p)
+	{
+		PlaneBuf &		buf = _plane_buf_arr [p];
+		if (! buf._boundary_cnt_arr.empty ())
+		{
+			memset (
+				&buf._boundary_cnt_arr [0],
+				0,
+				buf._boundary_cnt_arr.size () * sizeof (buf._boundary_cnt_arr [0])
+			);
+		}
+		if (! buf._strip_cnt_arr.empty ())
+		{
+			memset (
+				&buf._strip_cnt_arr [0],
+				0,
+				buf._strip_cnt_arr.size () * sizeof (buf._strip_cnt_arr [0])
+			);
+		}
+	}
+}
+
+
+
+// Called by the slices once the block row by has been accumulated. Counts
+// the completed rows covering each strip and finalises the strips which are
+// complete. Strip s starts at the top of block row s and ends at the top of
+// row s + 1, so it is covered by the rows s - 1 (vertical overlap only) and s.
+// The last strip extends to the bottom of the covered area.
+template <int P>
+void	MDegrainN::overlap_row_done (int by)
+{
+	assert (by >= 0);
+	assert (by < nBlkY);
+
+	const conc::AioAdd <int>	inc_ftor (+1);
+
+	const int		s_end = (nOverlapY > 0) ? std::min (by + 2, nBlkY) : by + 1;
+	for (int s = by; s < s_end; ++s)
+	{
+		const int		nbr_rows = (s > 0 && nOverlapY > 0) ? 2 : 1;
+		const int		cnt      = conc::AtomicIntOp::exec_new (
+			_plane_buf_arr [P]._strip_cnt_arr [s],
+			inc_ftor
+		);
+		if (cnt == nbr_rows)
+		{
+			finish_overlap_strip <P> (s);
+		}
+	}
+}
+
+
+
+// Converts a complete strip of the accumulation buffer to the output format,
+// clears it for the next plane, fills the uncovered areas and limits the
+// changes, in a single pass while the data is still in the cache.
+// The whole accumulation buffer is then back to 0 when all the strips are
+// finished, so it doesn't need to be cleared before the next plane.
+template <int P>
+void	MDegrainN::finish_overlap_strip (int s)
+{
+	assert (s >= 0);
+	assert (s < nBlkY);
+	assert (nOverlapY * 2 <= nBlkSizeY);
+
+	Profiler::Scope	prof_scope (_prof_ptr, Profiler::STG_OVERLAP);
+
+	const int		xlog     = (P == 0) ? 0 : 1;
+	const int		ylog     = (P == 0) ? 0 : _yratiouv_log;
+	const int		width    = nWidth >> xlog;
+	const int		height   = nHeight >> ylog;
+	const int		cov_w    = _covered_width >> xlog;
+	const int		cov_h    = _covered_height >> ylog;
+	const int		step     = (nBlkSizeY - nOverlapY) >> ylog;
+	const int		y_beg    = s * step;
+	const int		y_end    = (s == nBlkY - 1) ? cov_h : y_beg + step;
+	const int		h        = y_end - y_beg;
+	const int		dst_pitch = _dst_pitch_arr [P];
+	const int		src_pitch = _src_pitch_arr [P];
+	BYTE *			dst_ptr  = _dst_ptr_arr [P] + y_beg * dst_pitch;
+	const BYTE *	src_ptr  = _src_ptr_arr [P] + y_beg * src_pitch;
+
+	PlaneBuf &		buf = _plane_buf_arr [P];
+	if (_lsb_flag)
+	{
+		int *				acc_ptr = &buf._dst_int [y_beg * _dst_int_pitch];
+		Short2BytesLsb (
+			dst_ptr, dst_ptr + _lsb_offset_arr [P], dst_pitch,
+			acc_ptr, _dst_int_pitch,
+			cov_w, h
+		);
+		MemZoneSet (
+			reinterpret_cast <unsigned char *> (acc_ptr), 0,
+			cov_w * 4, h, 0, 0, _dst_int_pitch * 4
+		);
+	}
+	else
+	{
+		unsigned short *	acc_ptr = &buf._dst_short [y_beg * _dst_short_pitch];
+		Short2Bytes (
+			dst_ptr, dst_pitch,
+			acc_ptr, _dst_short_pitch,
+			cov_w, h
+		);
+		MemZoneSet (
+			reinterpret_cast <unsigned char *> (acc_ptr), 0,
+			cov_w * 2, h, 0, 0, _dst_short_pitch * 2
+		);
+	}
+
+	if (cov_w < width) // right noncovered region
+	{
+		BitBlt (
+			dst_ptr + cov_w, dst_pitch,
+			src_ptr + cov_w, src_pitch,
+			width - cov_w, h, _isse_flag
+		);
+	}
+
+	// The uncovered regions are copies of the source, the limit doesn't change
+	// them.
+	limit_rows <P> (y_beg, y_end, cov_w);
+
+	if (s == nBlkY - 1 && cov_h < height) // bottom noncovered region
+	{
+		BitBlt (
+			_dst_ptr_arr [P] + cov_h * dst_pitch, dst_pitch,
+			_src_ptr_arr [P] + cov_h * src_pitch, src_pitch,
+			width, height - cov_h, _isse_flag
+		);
+	}
+}
+
+
+
+// y_beg, y_end and w in pixels of the plane P.
+// The SSE2 code works on 16-pixel groups and may write past the specified
+// width, so the remaining columns are processed by the C code. This way we
+// don't step on the data of the other planes when they are packed in the
+// same rows (YUY2 planar), which could be processed concurrently.
+template <int P>
+void	MDegrainN::limit_rows (int y_beg, int y_end, int w)
+{
+	assert (y_beg >= 0);
+	assert (y_beg <= y_end);
+	assert (w >= 0);
+
+	const int		nlimit = (P == 0) ? _nlimit : _nlimitc;
+	const int		h      = y_end - y_beg;
+	if (nlimit < 255 && h > 0)
+	{
+		const int		dst_pitch = _dst_pitch_arr [P];
+		const int		src_pitch = _src_pitch_arr [P];
+		BYTE *			dst_ptr   = _dst_ptr_arr [P] + y_beg * dst_pitch;
+		const BYTE *	src_ptr   = _src_ptr_arr [P] + y_beg * src_pitch;
+		const int		w16       = (_isse_flag) ? (w & -16) : 0;
+		if (w16 > 0)
+		{
+			LimitChanges_sse2 (dst_ptr, dst_pitch, src_ptr, src_pitch, w16, h, nlimit);
+		}
+		if (w16 < w)
+		{
+			LimitChanges_c (
+				dst_ptr + w16, dst_pitch, src_ptr + w16, src_pitch,
+				w - w16, h, nlimit
+			);
+		}
+	}
+}
+
+
+
 void	MDegrainN::use_block_y (
 	const BYTE * &p, int &np, int &wref, bool usable_flag, const MvClipInfo &c_info,
 	int i, const MVPlane *plane_ptr, const BYTE *src_ptr, int xx, int src_pitch
@@ -1538,3 +1220,47 @@ void	MDegrainN::norm_weights (int wref_arr [], int trad)
 	wref_arr [0] = wsrc;
 }
 
+
+
+// Starts a slicer run. Returns the start time, or 0 when not profiled.
+int64_t	MDegrainN::prof_begin_run ()
+{
+	int64_t			t_beg = 0;
+	if (_prof_ptr != 0)
+	{
+		_prof_slices.clear ();
+		t_beg = Profiler::get_time ();
+	}
+
+	return (t_beg);
+}
+
+
+
+void	MDegrainN::prof_end_run (int64_t t_beg)
+{
+	if (_prof_ptr != 0)
+	{
+		_prof_ptr->add_run (
+			Profiler::STG_DEGRAIN, Profiler::get_time () - t_beg, _prof_slices
+		);
+	}
+}
+
+
+
+int64_t	MDegrainN::prof_begin_slice () const
+{
+	return ((_prof_ptr != 0) ? Profiler::get_time () : 0);
+}
+
+
+
+void	MDegrainN::prof_end_slice (int64_t t_beg)
+{
+	if (_prof_ptr != 0)
+	{
+		_prof_slices.add (Profiler::get_time () - t_beg);
+	}
+}
+
@@ -4,11 +4,14 @@
 
 
 #include	"conc/AtomicInt.h"
-#include "MTSlicer.h"
+#include	"DegrainNFnc.h"
+#include	"MTFlowGraphSched.h"
+#include	"MTFlowGraphSimple.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include	"MVGroupOfFrames.h"
 #include "overlap.h"
+#include	"Profiler.h"
 #include "SharedPtr.h"
 #include "yuy2planes.h"
 
@@ -26,13 +29,14 @@ class MDegrainN
 
 public:
 
-	enum {			MAX_TEMP_RAD	= 128	};
+	enum {			MAX_TEMP_RAD	= DegrainN_MAX_TRAD	};
 
 						MDegrainN (
 							::PClip child, ::PClip super, ::PClip mvmulti, int trad,
 							int thsad, int thsadc, int yuvplanes, int nlimit, int nlimitc,
 							int nscd1, int nscd2, bool isse_flag, bool planar_flag, bool lsb_flag,
-							int thsad2, int thsadc2, bool mt_flag, ::IScriptEnvironment* env_ptr
+							int thsad2, int thsadc2, bool mt_flag, const char *profile_0,
+							::IScriptEnvironment* env_ptr
 						);
 						~MDegrainN ();
 
@@ -44,15 +48,6 @@ protected:
 
 private:
 
-	typedef void (DenoiseNFunction) (
-		BYTE *pDst, BYTE *pDstLsb, bool lsb_flag, int nDstPitch,
-		const BYTE *pSrc, int nSrcPitch,
-		// 2*k = ref backwards, 2*k+1 = ref forwards
-		const BYTE *pRef [], int Pitch [],
-		// 0 = src, 2*k+1 = ref backwards, 2*k+2 = ref forwards
-		int Wall [], int trad
-	);
-
 	class MvClipInfo
 	{
 	public:
@@ -65,7 +60,48 @@ private:
 	};
 	typedef	std::vector <MvClipInfo>	MvClipArray;
 
-	typedef	MTSlicer <MDegrainN>	Slicer;
+	enum {			MAX_SLICES_PER_PLANE = 64	};
+	enum {			MAX_TASKS = 1 + MAX_SLICES_PER_PLANE * 3	};	// Root + slices
+
+	typedef	MTFlowGraphSimple <MAX_TASKS>	PlaneGraph;
+	typedef	MTFlowGraphSched <MDegrainN, PlaneGraph, MDegrainN, MAX_TASKS>	Scheduler;
+
+	// Horizontal band of a plane, in block rows
+	class SliceInfo
+	{
+	public:
+		int				_plane;
+		int				_y_beg;
+		int				_y_end;
+	};
+	typedef	std::vector <SliceInfo>	SliceArray;
+
+	// Per-plane processing buffers, so the planes can be processed
+	// concurrently.
+	class PlaneBuf
+	{
+	public:
+		std::vector <unsigned short>
+							_dst_short;
+		std::vector <int>
+							_dst_int;
+
+		// This array has an nBlkY size. It is used in vertical overlap mode
+		// to avoid read/write sync problems when processing is multithreaded.
+		// Only elements corresponding to the first row of each sub-plane are
+		// actually used. They count how many sub-planes (excepted their last
+		// row) have been processed on each side of the boundary. When a
+		// counter reaches 2, the boundary row (just above the element
+		// position) can be processed safely.
+		std::vector <conc::AtomicInt <int> >
+							_boundary_cnt_arr;
+
+		// nBlkY elements, for the overlap mode. Counts how many block rows
+		// covering each output strip have been accumulated. The strip is
+		// finalised as soon as all of them are done.
+		std::vector <conc::AtomicInt <int> >
+							_strip_cnt_arr;
+	};
 
 	class TmpBlock
 	{
@@ -78,19 +114,28 @@ private:
 	};
 
 	inline int		reorder_ref (int index) const;
-	template <int P>
-	inline void		process_chroma (int plane_mask);
+	bool				is_plane_processed (int p) const;
+	void				build_plane_graph ();
+	void				process_task (Scheduler::TaskData &td);
 
-	void				process_luma_normal_slice (Slicer::TaskData &td);
-	void				process_luma_overlap_slice (Slicer::TaskData &td);
+	void				process_luma_normal_slice (int y_beg, int y_end);
 	void				process_luma_overlap_slice (int y_beg, int y_end);
+	void				process_luma_overlap_rows (int y_beg, int y_end);
 
 	template <int P>
-	void				process_chroma_normal_slice (Slicer::TaskData &td);
-	template <int P>
-	void				process_chroma_overlap_slice (Slicer::TaskData &td);
+	void				process_chroma_normal_slice (int y_beg, int y_end);
 	template <int P>
 	void				process_chroma_overlap_slice (int y_beg, int y_end);
+	template <int P>
+	void				process_chroma_overlap_rows (int y_beg, int y_end);
+
+	void				reset_overlap_cnt ();
+	template <int P>
+	void				overlap_row_done (int by);
+	template <int P>
+	void				finish_overlap_strip (int s);
+	template <int P>
+	void				limit_rows (int y_beg, int y_end, int w);
 
 	__forceinline void
 						use_block_y (
@@ -106,6 +151,11 @@ private:
 	static inline void
 						norm_weights (int wref_arr [], int trad);
 
+	int64_t			prof_begin_run ();
+	void				prof_end_run (int64_t t_beg);
+	int64_t			prof_begin_slice () const;
+	void				prof_end_slice (int64_t t_beg);
+
 	MvClipArray		_mv_clip_arr;
 
 	int				_trad;	// Temporal radius (nbr frames == _trad * 2 + 1)
@@ -140,19 +190,15 @@ private:
 						_oversluma_lsb_ptr;
 	OverlapsLsbFunction *
 						_overschroma_lsb_ptr;
-	DenoiseNFunction *
+	DegrainNFunction *
 						_degrainluma_ptr;
-	DenoiseNFunction *
+	DegrainNFunction *
 						_degrainchroma_ptr;
 
 	// -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 	// Processing variables
 
-	std::vector <unsigned short>
-						_dst_short;
 	int				_dst_short_pitch;
-	std::vector <int>
-						_dst_int;
 	int				_dst_int_pitch;
 
 	bool				_usable_flag_arr [MAX_TEMP_RAD * 2];
@@ -165,15 +211,14 @@ private:
 	int				_covered_width;
 	int				_covered_height;
 
-	// This array has an nBlkY size. It is used in vertical overlap mode
-	// to avoid read/write sync problems when processing is multithreaded.
-	// Only elements corresponding to the first row of each sub-plane are
-	// actually used. They count how many sub-planes (excepted their last
-	// row) have been processed on each side of the boundary. When a counter
-	// reaches 2, the boundary row (just above the element position) can be
-	// processed safely.
-	std::vector <conc::AtomicInt <int> >
-						_boundary_cnt_arr;
+	PlaneBuf			_plane_buf_arr [3];
+
+	SliceArray		_slice_arr;		// Task index - 1 -> slice
+	PlaneGraph		_plane_graph;
+
+	Profiler *		_prof_ptr;		// 0 = not profiled
+	Profiler::SliceRun
+						_prof_slices;
 };
 
 
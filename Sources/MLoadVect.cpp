@@ -0,0 +1,331 @@
+/*****************************************************************************
+
+        MLoadVect.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"ClipFnc.h"
+#include	"MLoadVect.h"
+#include	"MVInterface.h"
+
+#include	<algorithm>
+
+#include	<cassert>
+#include	<cstring>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+MLoadVect::MLoadVect (::PClip src, const char *filename_0, ::IScriptEnvironment &env)
+:	::GenericVideoFilter (src)
+,	_mad ()
+,	_vect_array_size (0)
+,	_verybig_sad (0)
+,	_file_hnd (INVALID_HANDLE_VALUE)
+,	_map_hnd (0)
+,	_granularity (1 << 16)
+,	_rec_size (0)
+,	_nbr_rec (0)
+,	_rec_index_arr ()
+{
+	assert (filename_0 != 0);
+	CHECK_COMPILE_TIME (HeaderSize, (sizeof (int32_t) + sizeof (MVAnalysisData) <= HEADER_SIZE));
+
+	_file_hnd = ::CreateFileA (
+		filename_0,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		0,
+		OPEN_EXISTING,
+		FILE_FLAG_RANDOM_ACCESS,
+		0
+	);
+	if (_file_hnd == INVALID_HANDLE_VALUE)
+	{
+		env.ThrowError ("MLoadVect: cannot open file %s.", filename_0);
+	}
+
+	// Header
+	const char *	err_0 = 0;
+	::LARGE_INTEGER	file_size;
+	::DWORD			read_len = 0;
+	if (   ! ::GetFileSizeEx (_file_hnd, &file_size)
+	    || file_size.QuadPart < int64_t (sizeof (_mad))
+	    || ! ::ReadFile (_file_hnd, &_mad, sizeof (_mad), &read_len, 0)
+	    || read_len != sizeof (_mad))
+	{
+		err_0 = "MLoadVect: cannot read the file header.";
+	}
+	else if (   _mad.GetMagicKey () != MVAnalysisData::MOTION_MAGIC_KEY
+	         || _mad.nVersion != MVAnalysisData::VERSION)
+	{
+		err_0 = "MLoadVect: invalid or incompatible vector file.";
+	}
+	else if (   _mad.nBlkX <= 0 || _mad.nBlkY <= 0
+	         || _mad.nBlkSizeX <= 0 || _mad.nBlkSizeY <= 0)
+	{
+		err_0 = "MLoadVect: corrupted file header.";
+	}
+
+	if (err_0 == 0)
+	{
+		_map_hnd = ::CreateFileMappingW (_file_hnd, 0, PAGE_READONLY, 0, 0, 0);
+		if (_map_hnd == 0)
+		{
+			err_0 = "MLoadVect: cannot map the file.";
+		}
+	}
+
+	if (err_0 == 0)
+	{
+		::SYSTEM_INFO	sys_info;
+		::GetSystemInfo (&sys_info);
+		_granularity = sys_info.dwAllocationGranularity;
+
+		const int		nbr_blk = _mad.nBlkX * _mad.nBlkY;
+		_rec_size = sizeof (int32_t) + nbr_blk * SHORTS_PER_BLOCK * sizeof (int16_t);
+		_nbr_rec  = int ((file_size.QuadPart - sizeof (_mad)) / _rec_size);
+
+		if (! build_index ())
+		{
+			err_0 = "MLoadVect: cannot read the file.";
+		}
+	}
+
+	if (err_0 != 0)
+	{
+		close_file ();
+		env.ThrowError (err_0);
+	}
+
+	// Output: the finest level only
+	_mad.nLvCount    = 1;
+	_verybig_sad     = _mad.nBlkSizeX * _mad.nBlkSizeY * 256;
+	_vect_array_size = 2 + 1 + _mad.nBlkX * _mad.nBlkY * N_PER_BLOCK;
+
+	const int		width_bytes = HEADER_SIZE + _vect_array_size * sizeof (int32_t);
+	ClipFnc::format_vector_clip (
+		vi, true, _mad.nBlkX, "rgb32", width_bytes, "MLoadVect", env
+	);
+	CHECK_COMPILE_TIME (SizeOfIntPtr, (sizeof (int) <= sizeof (void *)));
+#if !defined(_WIN64)
+	vi.nchannels = reinterpret_cast <uintptr_t> (&_mad);
+#else
+	uintptr_t p = reinterpret_cast <uintptr_t> (&_mad);
+	vi.nchannels = 0x80000000L | (int)(p >> 32);
+	vi.sample_type = (int)(p & 0xffffffffUL);
+#endif
+}
+
+
+
+MLoadVect::~MLoadVect ()
+{
+	close_file ();
+}
+
+
+
+::PVideoFrame __stdcall	MLoadVect::GetFrame (int n, ::IScriptEnvironment *env_ptr)
+{
+	assert (n >= 0);
+	assert (n < vi.num_frames);
+	assert (env_ptr != 0);
+
+	::PVideoFrame	dst_ptr = env_ptr->NewVideoFrame (vi);
+	uint8_t *		data_ptr = dst_ptr->GetWritePtr ();
+
+	// Header
+	const int32_t	header_size = HEADER_SIZE;
+	memset (data_ptr, 0, HEADER_SIZE);
+	memcpy (data_ptr, &header_size, sizeof (header_size));
+	memcpy (data_ptr + sizeof (header_size), &_mad, sizeof (_mad));
+
+	// Group of planes, single level
+	const int		nbr_blk = _mad.nBlkX * _mad.nBlkY;
+	int32_t *		gop_ptr = reinterpret_cast <int32_t *> (data_ptr + HEADER_SIZE);
+	int32_t *		blk_ptr = gop_ptr + 3;
+	gop_ptr [0] = _vect_array_size;
+	gop_ptr [2] = nbr_blk * N_PER_BLOCK + 1;
+
+	const int		rec_index = _rec_index_arr [n];
+	if (rec_index >= 0)
+	{
+		const View		view (
+			_map_hnd,
+			compute_rec_pos (rec_index) + sizeof (int32_t),
+			nbr_blk * SHORTS_PER_BLOCK * sizeof (int16_t),
+			_granularity
+		);
+		const int16_t*	src_ptr = reinterpret_cast <const int16_t *> (view.use ());
+		if (src_ptr == 0)
+		{
+			env_ptr->ThrowError ("MLoadVect: cannot read frame %d from the file.", n);
+		}
+
+		for (int blk = 0; blk < nbr_blk; ++blk)
+		{
+			const int16_t*	s_ptr = src_ptr + blk * SHORTS_PER_BLOCK;
+			int32_t *		d_ptr = blk_ptr + blk * N_PER_BLOCK;
+			d_ptr [0] = s_ptr [0];
+			d_ptr [1] = s_ptr [1];
+			d_ptr [2] = uint16_t (s_ptr [2]) | (int32_t (s_ptr [3]) << 16);
+		}
+		gop_ptr [1] = 1;
+	}
+
+	else
+	{
+		for (int blk = 0; blk < nbr_blk; ++blk)
+		{
+			int32_t *		d_ptr = blk_ptr + blk * N_PER_BLOCK;
+			d_ptr [0] = 0;
+			d_ptr [1] = 0;
+			d_ptr [2] = _verybig_sad;
+		}
+		gop_ptr [1] = 0;
+	}
+
+	return (dst_ptr);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+MLoadVect::View::View (::HANDLE map_hnd, int64_t pos, int len, int granularity)
+:	_base_ptr (0)
+,	_data_ptr (0)
+{
+	assert (map_hnd != 0);
+	assert (pos >= 0);
+	assert (len > 0);
+	assert (granularity > 0);
+
+	const int64_t	base_pos = pos - pos % granularity;
+	const int		offset   = int (pos - base_pos);
+	_base_ptr = ::MapViewOfFile (
+		map_hnd,
+		FILE_MAP_READ,
+		::DWORD (uint64_t (base_pos) >> 32),
+		::DWORD (base_pos),
+		::SIZE_T (offset + len)
+	);
+	if (_base_ptr != 0)
+	{
+		_data_ptr = reinterpret_cast <const uint8_t *> (_base_ptr) + offset;
+	}
+}
+
+
+
+MLoadVect::View::~View ()
+{
+	if (_base_ptr != 0)
+	{
+		::UnmapViewOfFile (_base_ptr);
+		_base_ptr = 0;
+	}
+}
+
+
+
+// Returns 0 if the mapping failed.
+const uint8_t *	MLoadVect::View::use () const
+{
+	return (_data_ptr);
+}
+
+
+
+// Collects the position of each frame. When a frame is stored several times,
+// the last record is used.
+// Returns false on error.
+bool	MLoadVect::build_index ()
+{
+	_rec_index_arr.assign (vi.num_frames, -1);
+
+	const int		rec_per_window = std::max (int (INDEX_WINDOW) / _rec_size, 1);
+	for (int rec_beg = 0; rec_beg < _nbr_rec; rec_beg += rec_per_window)
+	{
+		const int		nbr_rec = std::min (rec_per_window, _nbr_rec - rec_beg);
+		const int		len     = (nbr_rec - 1) * _rec_size + sizeof (int32_t);
+		const View		view (_map_hnd, compute_rec_pos (rec_beg), len, _granularity);
+		const uint8_t*	data_ptr = view.use ();
+		if (data_ptr == 0)
+		{
+			return (false);
+		}
+
+		for (int rec_cnt = 0; rec_cnt < nbr_rec; ++rec_cnt)
+		{
+			int32_t			frame;
+			memcpy (&frame, data_ptr + rec_cnt * _rec_size, sizeof (frame));
+			if (frame >= 0 && frame < vi.num_frames)
+			{
+				_rec_index_arr [frame] = rec_beg + rec_cnt;
+			}
+		}
+	}
+
+	return (true);
+}
+
+
+
+int64_t	MLoadVect::compute_rec_pos (int rec_index) const
+{
+	assert (rec_index >= 0);
+	assert (rec_index < _nbr_rec);
+
+	return (sizeof (_mad) + int64_t (rec_index) * _rec_size);
+}
+
+
+
+void	MLoadVect::close_file ()
+{
+	if (_map_hnd != 0)
+	{
+		::CloseHandle (_map_hnd);
+		_map_hnd = 0;
+	}
+	if (_file_hnd != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle (_file_hnd);
+		_file_hnd = INVALID_HANDLE_VALUE;
+	}
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,151 @@
+/*****************************************************************************
+
+        MLoadVect.h
+        Author: agent, 2026
+
+Reads the vector files written by the outfile parameter of MAnalyse and
+MRecalculate, and makes a vector clip from them.
+
+File format:
+	MVAnalysisData
+	Records, in any order:
+		int32_t		Frame number
+		int16_t		x, y, SAD low word, SAD high word, for each block
+
+Only the finest level is stored, so the output clip has a single level.
+Frames missing from the file are output as invalid vectors.
+
+The records have a fixed size. The file is scanned once for the frame
+numbers, then each frame is read by mapping only the corresponding part of
+the file. Therefore the frames can be accessed in any order, and the file
+size is not limited by the address space.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MLoadVect_HEADER_INCLUDED)
+#define	MLoadVect_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"def.h"
+#include	"MVAnalysisData.h"
+#include	"types.h"
+
+#define	NOGDI
+#define	NOMINMAX
+#define	WIN32_LEAN_AND_MEAN
+#include "Windows.h"
+#include	"avisynth.h"
+
+#include	<vector>
+
+
+
+class MLoadVect
+:	public ::GenericVideoFilter
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	explicit			MLoadVect (::PClip src, const char *filename_0, ::IScriptEnvironment &env);
+	virtual			~MLoadVect ();
+
+	// GenericVideoFilter
+	::PVideoFrame __stdcall
+						GetFrame (int n, ::IScriptEnvironment *env_ptr);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	CHECK_COMPILE_TIME (SizeOfInt, (sizeof (int) == sizeof (int32_t)));
+
+	enum {			HEADER_SIZE      = 256	};	// Bytes, same as MAnalyse
+	enum {			SHORTS_PER_BLOCK = 4	};
+	enum {			INDEX_WINDOW     = 1 << 24	};	// Bytes mapped at once during the scan
+
+	// Mapped part of the file. The view start is rounded down to the
+	// allocation granularity.
+	class View
+	{
+	public:
+							View (::HANDLE map_hnd, int64_t pos, int len, int granularity);
+							~View ();
+		const uint8_t *
+							use () const;
+	private:
+		void *			_base_ptr;
+		const uint8_t*	_data_ptr;
+	private:
+							View ();
+							View (const View &other);
+		View &			operator = (const View &other);
+	};
+
+	bool				build_index ();
+	int64_t			compute_rec_pos (int rec_index) const;
+	void				close_file ();
+
+	MVAnalysisData	_mad;
+	int				_vect_array_size;		// int32_t words
+	int				_verybig_sad;
+	::HANDLE			_file_hnd;
+	::HANDLE			_map_hnd;
+	int				_granularity;			// Bytes
+	int				_rec_size;				// Bytes
+	int				_nbr_rec;
+	std::vector <int>
+						_rec_index_arr;		// For each frame, record index in the file or -1
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						MLoadVect ();
+						MLoadVect (const MLoadVect &other);
+	MLoadVect &		operator = (const MLoadVect &other);
+	bool				operator == (const MLoadVect &other) const;
+	bool				operator != (const MLoadVect &other) const;
+
+};	// class MLoadVect
+
+
+
+//#include	"MLoadVect.hpp"
+
+
+
+#endif	// MLoadVect_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
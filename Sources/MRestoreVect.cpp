@@ -18,8 +18,10 @@
 
 #include	"ClipFnc.h"
 #include	"MRestoreVect.h"
+#include	"VectCodec.h"
 
 #include	<algorithm>
+#include	<vector>
 
 #include	<cassert>
 
@@ -53,9 +55,12 @@ MRestoreVect::MRestoreVect (::PClip src, int clip_index, ::IScriptEnvironment &e
 	::PVideoFrame	frame_ptr = src->GetFrame (0, &env);
 	int				data_offset     = 0;		// Bytes
 	int				data_len        = 0;		// Bytes
+	int				codec           = 0;
+	int				enc_len         = 0;		// Bytes
 	bool				contiguous_flag = false;
-	read_frame_info (data_offset, data_len, contiguous_flag, frame_ptr, env);
+	read_frame_info (data_offset, data_len, codec, enc_len, contiguous_flag, frame_ptr, env);
 
+	// The compact format keeps the header unchanged
 	const uint8_t*	data_ptr = frame_ptr->GetReadPtr ();
 	const int		pitch    = frame_ptr->GetPitch ();
 	int				pos      = data_offset + sizeof (int32_t);
@@ -91,14 +96,43 @@ MRestoreVect::MRestoreVect (::PClip src, int clip_index, ::IScriptEnvironment &e
 
 	int				data_offset     = 0;		// Bytes
 	int				data_len        = 0;		// Bytes
+	int				codec           = 0;
+	int				enc_len         = 0;		// Bytes
 	bool				contiguous_flag = false;
-	read_frame_info (data_offset, data_len, contiguous_flag, src_ptr, *env_ptr);
+	read_frame_info (data_offset, data_len, codec, enc_len, contiguous_flag, src_ptr, *env_ptr);
 	if (data_len > vi.width * vi.height * _bytes_per_pix)
 	{
 		env_ptr->ThrowError ("MRestoreVect: invalid content at frame %d.", n);
 	}
 
-	if (contiguous_flag)
+	if (codec != 0)
+	{
+		dst_ptr = env_ptr->NewVideoFrame (vi);
+
+		const uint8_t*	src_data_ptr = src_ptr->GetReadPtr ();
+		const int		src_pitch    = src_ptr->GetPitch ();
+		uint8_t *		dst_data_ptr = dst_ptr->GetWritePtr ();
+		assert (vi.height == 1 || dst_ptr->GetPitch () == vi.width * _bytes_per_pix);
+
+		std::vector <uint8_t>	enc_arr;
+		const uint8_t*	enc_ptr = src_data_ptr + data_offset;
+		if (! contiguous_flag)
+		{
+			enc_arr.resize (enc_len);
+			read_from_clip (data_offset, src_data_ptr, &enc_arr [0], enc_len, src_pitch);
+			enc_ptr = &enc_arr [0];
+		}
+
+		const bool		ok_flag = VectCodec::decode (
+			reinterpret_cast <int32_t *> (dst_data_ptr), data_len, enc_ptr, enc_len
+		);
+		if (! ok_flag)
+		{
+			env_ptr->ThrowError ("MRestoreVect: invalid content at frame %d.", n);
+		}
+	}
+
+	else if (contiguous_flag)
 	{
 		const int		dst_pitch = vi.width * _bytes_per_pix;
 		dst_ptr = env_ptr->Subframe (
@@ -132,10 +166,14 @@ MRestoreVect::MRestoreVect (::PClip src, int clip_index, ::IScriptEnvironment &e
 
 
 
-// data_offset and data_len are in bytes
-void	MRestoreVect::read_frame_info (int &data_offset, int &data_len, bool &contiguous_flag, ::PVideoFrame frame_ptr, ::IScriptEnvironment &env) const
+// data_offset, data_len and enc_len are in bytes
+// data_len is the size of the vector clip frame, enc_len the size of the
+// data actually stored, which may be encoded (codec != 0).
+void	MRestoreVect::read_frame_info (int &data_offset, int &data_len, int &codec, int &enc_len, bool &contiguous_flag, ::PVideoFrame frame_ptr, ::IScriptEnvironment &env) const
 {
 	assert (&data_offset != 0);
+	assert (&codec != 0);
+	assert (&enc_len != 0);
 	assert (&contiguous_flag != 0);
 	assert (frame_ptr != 0);
 	assert (&env != 0);
@@ -155,7 +193,8 @@ void	MRestoreVect::read_frame_info (int &data_offset, int &data_len, bool &conti
 	{
 		env.ThrowError ("MRestoreVect: clip does not wrap motion vector data.");
 	}
-	if (ver != MVAnalysisData::STORE_VERSION)
+	if (   ver != MVAnalysisData::STORE_VERSION
+	    && ver != MVAnalysisData::STORE_VERSION_COMPACT)
 	{
 		env.ThrowError (
 			"MRestoreVect: unsupported version (%d) of the motion vector wrapper.",
@@ -176,8 +215,35 @@ void	MRestoreVect::read_frame_info (int &data_offset, int &data_len, bool &conti
 	data_offset =               offset_beg  * sizeof (int32_t);
 	data_len    = (offset_end - offset_beg) * sizeof (int32_t);
 	if (   data_offset            <  pos
-	    || data_len               <= sizeof (int32_t) + sizeof (_mad)
-	    || data_offset + data_len >= _available_size)
+	    || data_offset + data_len >  _available_size)
+	{
+		env.ThrowError ("MRestoreVect: corrupted data.");
+	}
+
+	codec   = 0;
+	enc_len = data_len;
+	if (ver == MVAnalysisData::STORE_VERSION_COMPACT)
+	{
+		int32_t			slot_hdr [2];
+		if (data_len <= int (sizeof (slot_hdr)))
+		{
+			env.ThrowError ("MRestoreVect: corrupted data.");
+		}
+		pos = data_offset;
+		read_from_clip (pos, data_ptr, slot_hdr, sizeof (slot_hdr), pitch);
+		codec        = slot_hdr [0];
+		enc_len      = slot_hdr [1];
+		data_offset += sizeof (slot_hdr);
+		data_len    -= sizeof (slot_hdr);
+		if (   codec < 0 || codec > 1
+		    || enc_len <= 0 || enc_len > data_len
+		    || (codec == 0 && enc_len != data_len))
+		{
+			env.ThrowError ("MRestoreVect: corrupted data.");
+		}
+	}
+
+	if (enc_len <= sizeof (int32_t) + sizeof (_mad))
 	{
 		env.ThrowError ("MRestoreVect: corrupted data.");
 	}
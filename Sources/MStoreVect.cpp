@@ -18,6 +18,7 @@
 
 #include	"ClipFnc.h"
 #include	"MStoreVect.h"
+#include	"VectCodec.h"
 
 #include	<algorithm>
 
@@ -30,9 +31,10 @@
 
 
 
-MStoreVect::MStoreVect (std::vector <::PClip> clip_arr, const char *vccs_0, ::IScriptEnvironment &env)
+MStoreVect::MStoreVect (std::vector <::PClip> clip_arr, const char *vccs_0, bool compact_flag, ::IScriptEnvironment &env)
 :	GenericVideoFilter (clip_arr [0])
 ,	_vect_arr ()
+,	_compact_flag (compact_flag)
 {
 	assert (! clip_arr.empty ());
 	assert (&env != 0);
@@ -80,6 +82,14 @@ MStoreVect::MStoreVect (std::vector <::PClip> clip_arr, const char *vccs_0, ::IS
 		const int		data_len_bytes = data_len_pix * bytes_per_pix;
 		const int		data_len       = data_len_bytes / sizeof (int32_t);
 
+		// Room for the raw data, which is also the worst case for the
+		// compact format.
+		vect_data._slot_offset = data_offset;
+		if (_compact_flag)
+		{
+			data_offset += SLOT_HEADER_LEN;
+		}
+
 		// Done with this one
 		vect_data._clip_sptr   = clip_arr [clip_cnt];
 		vect_data._data_offset = data_offset;
@@ -112,9 +122,22 @@ MStoreVect::MStoreVect (std::vector <::PClip> clip_arr, const char *vccs_0, ::IS
 	const int		pitch    = dst_ptr->GetPitch ();
 	int				dst_pos = 0;
 
+	// Unused parts are cleared, so a lossless codec can squeeze them.
+	if (_compact_flag)
+	{
+		const int		row_size = vi.width * (vi.BitsPerPixel () >> 3);
+		for (int y = 0; y < vi.height; ++y)
+		{
+			memset (data_ptr + y * pitch, 0, row_size);
+		}
+	}
+
 	// Header
 	static const int32_t	key = MVAnalysisData::STORE_KEY;
-	static const int32_t	ver = MVAnalysisData::STORE_VERSION;
+	const int32_t	ver =
+		  (_compact_flag)
+		? MVAnalysisData::STORE_VERSION_COMPACT
+		: MVAnalysisData::STORE_VERSION;
 	write_to_clip (dst_pos, data_ptr, &key, sizeof (key), pitch);
 	write_to_clip (dst_pos, data_ptr, &ver, sizeof (ver), pitch);
 	const int32_t	nbr_clips = _vect_arr.size ();
@@ -124,24 +147,56 @@ MStoreVect::MStoreVect (std::vector <::PClip> clip_arr, const char *vccs_0, ::IS
 	for (int clip_cnt = 0; clip_cnt < nbr_clips; ++clip_cnt)
 	{
 		const VectData &	vect_info = _vect_arr [clip_cnt];
-		const int32_t	data_offset = vect_info._data_offset;
-		write_to_clip (dst_pos, data_ptr, &data_offset, sizeof (data_offset), pitch);
+		const int32_t	slot_offset = vect_info._slot_offset;
+		write_to_clip (dst_pos, data_ptr, &slot_offset, sizeof (slot_offset), pitch);
 	}
 	const int32_t	end_offset = _end_offset;
 	write_to_clip (dst_pos, data_ptr, &end_offset, sizeof (end_offset), pitch);
 
 	// Data
+	std::vector <uint8_t>	enc_arr;
 	for (int clip_cnt = 0; clip_cnt < nbr_clips; ++clip_cnt)
 	{
 		const VectData &	vect_info = _vect_arr [clip_cnt];
-		assert (vect_info._data_offset * sizeof (int32_t) == dst_pos);
 
 		::PVideoFrame	clip_ptr = vect_info._clip_sptr->GetFrame (n, env_ptr);
 		const uint8_t*	src_ptr = clip_ptr->GetReadPtr ();
 		const int		len_bytes = vect_info._data_len * sizeof (int32_t);
-		write_to_clip (dst_pos, data_ptr, src_ptr, len_bytes, pitch);
+
+		int				enc_len = -1;
+		if (_compact_flag)
+		{
+			dst_pos = vect_info._slot_offset * sizeof (int32_t);
+
+			// Falls back on the raw data if the encoded data is larger
+			enc_arr.resize (len_bytes);
+			enc_len = VectCodec::encode (
+				&enc_arr [0], len_bytes,
+				reinterpret_cast <const int32_t *> (src_ptr), len_bytes
+			);
+			const int32_t	slot_hdr [SLOT_HEADER_LEN] =
+			{
+				(enc_len > 0) ? 1 : 0,
+				(enc_len > 0) ? enc_len : len_bytes
+			};
+			write_to_clip (dst_pos, data_ptr, slot_hdr, sizeof (slot_hdr), pitch);
+		}
+
+		assert (vect_info._data_offset * sizeof (int32_t) == dst_pos);
+		if (enc_len > 0)
+		{
+			write_to_clip (dst_pos, data_ptr, &enc_arr [0], enc_len, pitch);
+		}
+		else
+		{
+			write_to_clip (dst_pos, data_ptr, src_ptr, len_bytes, pitch);
+		}
 	}
 
+#if ! defined (NDEBUG)
+	check_frame (data_ptr, pitch, n, *env_ptr);
+#endif
+
 	return (dst_ptr);
 }
 
@@ -196,4 +251,96 @@ void	MStoreVect::write_to_clip (int &dst_pos, uint8_t base_ptr [], const void *s
 
 
 
+// Round-trip check: reads back a frame the same way MRestoreVect does and
+// checks the restored data against the source. Debug only.
+void	MStoreVect::check_frame (const uint8_t data_ptr [], int pitch, int n, ::IScriptEnvironment &env) const
+{
+	assert (data_ptr != 0);
+
+	int				pos = 3 * sizeof (int32_t);
+	const int		nbr_clips = int (_vect_arr.size ());
+	std::vector <int32_t>	offset_arr (nbr_clips + 1);
+	read_from_clip (pos, data_ptr, &offset_arr [0], (nbr_clips + 1) * sizeof (int32_t), pitch);
+	assert (offset_arr [nbr_clips] == _end_offset);
+
+	std::vector <uint8_t>	enc_arr;
+	std::vector <int32_t>	dec_arr;
+	for (int clip_cnt = 0; clip_cnt < nbr_clips; ++clip_cnt)
+	{
+		const VectData &	vect_info = _vect_arr [clip_cnt];
+		assert (offset_arr [clip_cnt] == vect_info._slot_offset);
+
+		pos = offset_arr [clip_cnt] * sizeof (int32_t);
+		int				data_len = (offset_arr [clip_cnt + 1] - offset_arr [clip_cnt]) * sizeof (int32_t);
+		int				codec    = 0;
+		int				enc_len  = data_len;
+		if (_compact_flag)
+		{
+			int32_t			slot_hdr [SLOT_HEADER_LEN];
+			read_from_clip (pos, data_ptr, slot_hdr, sizeof (slot_hdr), pitch);
+			codec     = slot_hdr [0];
+			enc_len   = slot_hdr [1];
+			data_len -= sizeof (slot_hdr);
+		}
+		assert (data_len == vect_info._data_len * int (sizeof (int32_t)));
+		assert (codec == 0 || codec == 1);
+		assert (enc_len > 0 && enc_len <= data_len);
+
+		enc_arr.resize (enc_len);
+		read_from_clip (pos, data_ptr, &enc_arr [0], enc_len, pitch);
+		dec_arr.resize (vect_info._data_len);
+		if (codec == 0)
+		{
+			::PVideoFrame	clip_ptr = vect_info._clip_sptr->GetFrame (n, &env);
+			assert (memcmp (&enc_arr [0], clip_ptr->GetReadPtr (), data_len) == 0);
+		}
+
+		// The SADs may be quantised, so the decoded data is encoded again and
+		// compared with the stored stream. Vectors are lossless.
+		else
+		{
+			const bool		ok_flag = VectCodec::decode (
+				&dec_arr [0], data_len, &enc_arr [0], enc_len
+			);
+			assert (ok_flag);
+			std::vector <uint8_t>	reenc_arr (data_len);
+			const int		reenc_len = VectCodec::encode (
+				&reenc_arr [0], data_len, &dec_arr [0], data_len
+			);
+			assert (reenc_len == enc_len);
+			assert (memcmp (&reenc_arr [0], &enc_arr [0], enc_len) == 0);
+		}
+	}
+}
+
+
+
+void	MStoreVect::read_from_clip (int &src_pos, const uint8_t base_ptr [], void *dst_ptr, int len, int stride) const
+{
+	const int		bytes_per_pix  = vi.BitsPerPixel () >> 3;
+	const int		row_size       = vi.width  * bytes_per_pix;
+	assert (src_pos >= 0);
+	assert (src_pos + len <= vi.height * row_size);
+	assert (base_ptr != 0);
+	assert (len > 0);
+	assert (dst_ptr != 0);
+
+	int				dst_pos = 0;
+	while (dst_pos < len)
+	{
+		const int		y = src_pos / row_size;
+		const int		x = src_pos - y * row_size;	// In bytes
+		const int		work_len = std::min (len - dst_pos, row_size - x);
+		memcpy (
+			reinterpret_cast <uint8_t *> (dst_ptr) + dst_pos,
+			base_ptr + y * stride + x,
+			work_len
+		);
+		dst_pos += work_len;
+		src_pos += work_len;
+	}
+}
+
+
+
 /*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
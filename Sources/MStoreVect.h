@@ -41,7 +41,7 @@ class MStoreVect
 
 public:
 
-	explicit			MStoreVect (std::vector <::PClip> clip_arr, const char *vccs_0, ::IScriptEnvironment &env);
+	explicit			MStoreVect (std::vector <::PClip> clip_arr, const char *vccs_0, bool compact_flag, ::IScriptEnvironment &env);
 	virtual			~MStoreVect () {}
 
 	// GenericVideoFilter
@@ -62,19 +62,28 @@ private:
 
 	CHECK_COMPILE_TIME (SizeOfInt, (sizeof (int) == sizeof (int32_t)));
 
+	// Compact format: each clip slot starts with the codec (0 = raw,
+	// 1 = VectCodec) and the length in bytes of the following data. The offset
+	// table points to the slot starts, so the header is part of the slot.
+	enum {			SLOT_HEADER_LEN = 2	};	// int32_t words
+
 	class VectData
 	{
 	public:
 		::PClip			_clip_sptr;
-		int				_data_offset;	// int32_t words, based only on width, not pitch
+		int				_slot_offset;	// int32_t words, based only on width, not pitch. Recorded in the offset table
+		int				_data_offset;	// int32_t words, same as above. After the slot header, if any
 		int				_data_len;		// int32_t words, same as above.
 	};
 	typedef	std::vector <VectData>	VectArray;
 
 	void				write_to_clip (int &dst_pos, uint8_t base_ptr [], const void *src_ptr, int len, int stride);
+	void				read_from_clip (int &src_pos, const uint8_t base_ptr [], void *dst_ptr, int len, int stride) const;
+	void				check_frame (const uint8_t data_ptr [], int pitch, int n, ::IScriptEnvironment &env) const;
 
 	VectArray		_vect_arr;
 	int				_end_offset;		// int32_t words
+	bool				_compact_flag;
 
 
 
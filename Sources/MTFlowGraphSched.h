@@ -35,8 +35,8 @@ Template parameters:
 - GD: Global task data. If different of T, it requires:
 	T * GD::_this_ptr;
 
-- MAXT: limit to the number of tasks (because task-specific data is allocated
-	on the stack).
+- MAXT: number of tasks the task-specific data is preallocated for. Larger
+	graphs are accepted, the storage grows in start() when required.
 
 --- Legal stuff ---
 
@@ -62,10 +62,11 @@ http://sam.zoy.org/wtfpl/COPYING for more details.
 
 /*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
 
-#include	"conc/Array.h"
 #include	"conc/AtomicInt.h"
 #include	"avstp.h"
 
+#include	<vector>
+
 
 
 class AvstpWrapper;
@@ -123,9 +124,9 @@ private:
 	avstp_TaskDispatcher * volatile
 						_dispatcher_ptr;
 	const GR * volatile	_dep_graph_ptr;
-	conc::Array <TaskData, MAXT>
+	std::vector <TaskData>
 						_task_data_arr;
-	conc::Array <conc::AtomicInt <int>, MAXT>
+	std::vector <conc::AtomicInt <int> >
 						_in_cnt_arr;
 
 	const bool		_mt_flag;
@@ -67,9 +67,9 @@ MTFlowGraphSched <T, GR, GD, MAXT>::MTFlowGraphSched (bool mt_flag)
 ,	_proc_ptr (0)
 ,	_dispatcher_ptr (0)
 ,	_dep_graph_ptr (0)
-,	_task_data_arr ()
-,	_in_cnt_arr ()
-,	_mt_flag ()
+,	_task_data_arr (MAXT)
+,	_in_cnt_arr (MAXT)
+,	_mt_flag (mt_flag)
 {
 	// Nothing
 }
@@ -139,7 +139,7 @@ Input parameters:
 		next tasks, the scheduler will do it for you.
 	- glob_data: A structure containing data accessed by all the working
 	threads.
-Throws: Depends on dispatcher creation failures.
+Throws: Depends on dispatcher creation failures and memory allocation.
 ==============================================================================
 */
 
@@ -154,6 +154,12 @@ void	MTFlowGraphSched <T, GR, GD, MAXT>::start (const GR &dep_graph, GD &glob_da
 	_dep_graph_ptr = &dep_graph;
 
 	const int		last_node_index = _dep_graph_ptr->get_last_node ();
+	assert (last_node_index >= 0);
+	if (last_node_index >= int (_task_data_arr.size ()))
+	{
+		_task_data_arr.resize (last_node_index + 1);
+		_in_cnt_arr.resize (last_node_index + 1);
+	}
 	memset (	// Not very clean but should work correctly.
 		&_in_cnt_arr [0],
 		0,
@@ -262,7 +268,7 @@ void	MTFlowGraphSched <T, GR, GD, MAXT>::complete_task (TaskData &td)
 	{
 		const int		out_index = it.get_index ();
 		assert (out_index >= 0);
-		assert (out_index < MAXT);
+		assert (out_index < int (_task_data_arr.size ()));
 		const int		count_new = ++ _in_cnt_arr [out_index];
 		const int		nbr_in    = _dep_graph_ptr->get_nbr_in (out_index);
 		if (count_new >= nbr_in)
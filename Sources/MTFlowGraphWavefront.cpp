@@ -0,0 +1,204 @@
+/*****************************************************************************
+
+        MTFlowGraphWavefront.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"MTFlowGraphWavefront.h"
+
+#include	<algorithm>
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+MTFlowGraphWavefront::MTFlowGraphWavefront ()
+:	_nbr_rows (1)
+,	_nbr_cols (1)
+,	_nbr_chunks (1)
+{
+	// Nothing
+}
+
+
+
+/*
+==============================================================================
+Name: init
+Description:
+	Sets the grid dimensions. Task indexes are laid out row by row, from left
+	to right: task = row * nbr_chunks + chunk. The index order is a valid
+	sequential processing order.
+Input parameters:
+	- nbr_rows: Number of rows of blocks, > 0.
+	- nbr_cols: Number of blocks per row, > 0.
+	- nbr_chunks: Number of chunks per row, in [1 ; nbr_cols].
+Throws: Nothing
+==============================================================================
+*/
+
+void	MTFlowGraphWavefront::init (int nbr_rows, int nbr_cols, int nbr_chunks)
+{
+	assert (nbr_rows > 0);
+	assert (nbr_cols > 0);
+	assert (nbr_chunks > 0);
+	assert (nbr_chunks <= nbr_cols);
+
+	_nbr_rows     = nbr_rows;
+	_nbr_cols     = nbr_cols;
+	_nbr_chunks   = nbr_chunks;
+}
+
+
+
+int	MTFlowGraphWavefront::get_nbr_chunks () const
+{
+	return (_nbr_chunks);
+}
+
+
+
+int	MTFlowGraphWavefront::get_last_node () const
+{
+	return (_nbr_rows * _nbr_chunks - 1);
+}
+
+
+
+int	MTFlowGraphWavefront::get_nbr_in (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	const int		row = task_index / _nbr_chunks;
+	const int		chunk = task_index - row * _nbr_chunks;
+
+	return (((chunk > 0) ? 1 : 0) + ((row > 0) ? 1 : 0));
+}
+
+
+
+MTFlowGraphWavefront::Iterator	MTFlowGraphWavefront::get_out_node_it (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	return (Iterator (*this, task_index));
+}
+
+
+
+int	MTFlowGraphWavefront::get_row (int task_index) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	return (task_index / _nbr_chunks);
+}
+
+
+
+// Gives the range of columns (blocks) covered by the task, [col_beg ; col_end[
+void	MTFlowGraphWavefront::get_col_range (int task_index, int &col_beg, int &col_end) const
+{
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	const int		row   = task_index / _nbr_chunks;
+	const int		chunk = task_index - row * _nbr_chunks;
+
+	col_beg =  chunk      * _nbr_cols / _nbr_chunks;
+	col_end = (chunk + 1) * _nbr_cols / _nbr_chunks;
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Finds the task of the previous row a chunk depends on. This is the chunk
+// located on the right, or above for the last chunk. The chunks on the left
+// are processed before.
+// Returns the task index.
+int	MTFlowGraphWavefront::find_dep_above (int row, int chunk) const
+{
+	assert (row > 0);
+	assert (row < _nbr_rows);
+	assert (chunk >= 0);
+	assert (chunk < _nbr_chunks);
+
+	const int		row_above = row - 1;
+	const int		chunk_r   = std::min (chunk + 1, _nbr_chunks - 1);
+
+	return (row_above * _nbr_chunks + chunk_r);
+}
+
+
+
+void	MTFlowGraphWavefront::fill_out_nodes (int out_arr [], int &nbr_out, int task_index) const
+{
+	assert (out_arr != 0);
+	assert (task_index >= 0);
+	assert (task_index <= get_last_node ());
+
+	const int		row   = task_index / _nbr_chunks;
+	const int		chunk = task_index - row * _nbr_chunks;
+
+	nbr_out = 0;
+
+	// Next chunk on the same row
+	if (chunk + 1 < _nbr_chunks)
+	{
+		out_arr [nbr_out] = task_index + 1;
+		++ nbr_out;
+	}
+
+	// Chunks of the next row for which this task is the last dependency
+	const int		row_below = row + 1;
+	if (row_below < _nbr_rows)
+	{
+		const int		chunk_l = std::max (chunk - 1, 0);
+		const int		chunk_r = std::min (chunk + 1, _nbr_chunks - 1);
+		for (int chunk_below = chunk_l; chunk_below <= chunk_r; ++chunk_below)
+		{
+			if (find_dep_above (row_below, chunk_below) == task_index)
+			{
+				out_arr [nbr_out] = row_below * _nbr_chunks + chunk_below;
+				++ nbr_out;
+			}
+		}
+	}
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,134 @@
+/*****************************************************************************
+
+        MTFlowGraphWavefront.h
+        Author: agent, 2026
+
+Dependency graph for MTFlowGraphSched, organising the processing of a grid
+of blocks as a wavefront.
+
+Each row of blocks is cut into a fixed number of chunks. A task processes a
+single chunk. The chunks of a row are always processed from left to right.
+Inside a chunk, the blocks may be scanned in either direction, so the
+meander mode of the motion search reverses the scan of the odd rows chunk by
+chunk instead of on the whole row.
+
+A task can start when:
+- The previous chunk of the same row is complete, and
+- The chunks of the previous row located just above and on the right are
+	complete.
+Therefore each block sees the final state of its left, top, top-left and
+top-right neighbours, and the blocks of the next row located below, on the
+left and on the right are not processed yet, whatever the scan direction in
+the chunks. The result is the same as a sequential processing of the tasks
+in index order, whatever the number of threads.
+
+Task 0 is the first chunk of the first row.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphWavefront_HEADER_INCLUDED)
+#define	MTFlowGraphWavefront_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+class MTFlowGraphWavefront
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	typedef	MTFlowGraphWavefront	ThisType;
+
+	class Iterator
+	{
+	public:
+		inline 			Iterator (const ThisType &fg, int node);
+		inline void		next ();
+		inline bool		cont () const;
+		inline int		get_index () const;
+	private:
+		enum {			MAX_OUT = 4	};
+		int				_out_arr [MAX_OUT];
+		int				_nbr_out;
+		int				_pos;
+	};
+
+						MTFlowGraphWavefront ();
+	virtual			~MTFlowGraphWavefront () {}
+
+	void				init (int nbr_rows, int nbr_cols, int nbr_chunks);
+	int				get_nbr_chunks () const;
+
+	int				get_last_node () const;
+	int				get_nbr_in (int task_index) const;
+	Iterator			get_out_node_it (int task_index) const;
+
+	int				get_row (int task_index) const;
+	void				get_col_range (int task_index, int &col_beg, int &col_end) const;
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	friend class Iterator;
+
+	int				find_dep_above (int row, int chunk) const;
+	void				fill_out_nodes (int out_arr [], int &nbr_out, int task_index) const;
+
+	int				_nbr_rows;
+	int				_nbr_cols;
+	int				_nbr_chunks;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						MTFlowGraphWavefront (const MTFlowGraphWavefront &other);
+	MTFlowGraphWavefront &
+						operator = (const MTFlowGraphWavefront &other);
+	bool				operator == (const MTFlowGraphWavefront &other) const;
+	bool				operator != (const MTFlowGraphWavefront &other) const;
+
+};	// class MTFlowGraphWavefront
+
+
+
+#include	"MTFlowGraphWavefront.hpp"
+
+
+
+#endif	// MTFlowGraphWavefront_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
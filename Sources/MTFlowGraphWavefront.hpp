@@ -0,0 +1,80 @@
+/*****************************************************************************
+
+        MTFlowGraphWavefront.hpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (MTFlowGraphWavefront_CODEHEADER_INCLUDED)
+#define	MTFlowGraphWavefront_CODEHEADER_INCLUDED
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+MTFlowGraphWavefront::Iterator::Iterator (const ThisType &fg, int node)
+:	_nbr_out (0)
+,	_pos (0)
+{
+	fg.fill_out_nodes (_out_arr, _nbr_out, node);
+	assert (_nbr_out <= MAX_OUT);
+}
+
+
+
+void	MTFlowGraphWavefront::Iterator::next ()
+{
+	assert (cont ());
+
+	++ _pos;
+}
+
+
+
+bool	MTFlowGraphWavefront::Iterator::cont () const
+{
+	return (_pos < _nbr_out);
+}
+
+
+
+int	MTFlowGraphWavefront::Iterator::get_index () const
+{
+	assert (cont ());
+
+	return (_out_arr [_pos]);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+#endif	// MTFlowGraphWavefront_CODEHEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
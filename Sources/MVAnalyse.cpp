@@ -20,6 +20,7 @@
 // Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
 // http://www.gnu.org/copyleft/gpl.html .
 
+#include	"conc/CritSec.h"
 #include	"ClipFnc.h"
 #include "commonfunctions.h"
 #include "cpu.h"
@@ -28,7 +29,6 @@
 #include "MVAnalyse.h"
 #include "MVGroupOfFrames.h"
 #include "MVSuper.h"
-#include "profile.h"
 #include "SuperParams64Bits.h"
 
 #include <cmath>
@@ -43,17 +43,22 @@ MVAnalyse::MVAnalyse (
 	int _overlapx, int _overlapy, const char* _outfilename, int _dctmode,
 	int _divide, int _sadx264, int _badSAD, int _badrange, bool _isse,
 	bool _meander, bool temporal_flag, bool _tryMany, bool multi_flag,
-	bool mt_flag, IScriptEnvironment* env
+	bool mt_flag, const char *profile_0, IScriptEnvironment* env
 )
 :	::GenericVideoFilter (_child)
 ,	_srd_arr (1)
-,	_vectorfields_aptr ()
 ,	_multi_flag (multi_flag)
 ,	_temporal_flag (temporal_flag)
 ,	_mt_flag (mt_flag)
 ,	_dct_factory_ptr ()
 ,	_dct_pool ()
 ,	_delta_max (0)
+,	_ctx_fact_aptr ()
+,	_ctx_pool ()
+,	_vect_array_size (0)
+,	_temporal_mutex ()
+,	_outfile_mutex ()
+,	_prof_ptr (0)
 {
 	if (multi_flag && df < 1)
 	{
@@ -101,16 +106,6 @@ MVAnalyse::MVAnalyse (
 	analysisData.xRatioUV  = 2;	// for YV12 and YUY2, really do not used and assumed to 2
 
 //	env->ThrowError ("MVAnalyse: %d, %d, %d, %d, %d", nPrepHPad, nPrepVPad, nPrepPel, nPrepModeYUV, nPrepLevels);
-	pSrcGOF = new MVGroupOfFrames (
-		nSuperLevels, analysisData.nWidth, analysisData.nHeight,
-		nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
-		_isse, analysisData.yRatioUV, mt_flag
-	);
-	pRefGOF = new MVGroupOfFrames (
-		nSuperLevels, analysisData.nWidth, analysisData.nHeight,
-		nSuperPel, nSuperHPad, nSuperVPad, nSuperModeYUV,
-		_isse, analysisData.yRatioUV, mt_flag
-	);
 
 	analysisData.nBlkSizeX = _blksizex;
 	analysisData.nBlkSizeY = _blksizey;
@@ -323,22 +318,6 @@ MVAnalyse::MVAnalyse (
 		);
 	}
 
-	_vectorfields_aptr = std::auto_ptr <GroupOfPlanes> (new GroupOfPlanes (
-		analysisData.nBlkSizeX,
-		analysisData.nBlkSizeY,
-		analysisData.nLvCount,
-		analysisData.nPel,
-		analysisData.nFlags,
-		analysisData.nOverlapX,
-		analysisData.nOverlapY,
-		analysisData.nBlkX,
-		analysisData.nBlkY,
-		analysisData.yRatioUV,
-		divideExtra,
-		(_dct_factory_ptr.get () != 0) ? &_dct_pool : 0,
-		_mt_flag
-	));
-
 	analysisData.nMagicKey = MVAnalysisData::MOTION_MAGIC_KEY;
 	analysisData.nHPadding = nSuperHPad; // v2.0
 	analysisData.nVPadding = nSuperVPad;
@@ -358,18 +337,41 @@ MVAnalyse::MVAnalyse (
 		else
 		{
 			fwrite (&analysisData, sizeof (analysisData), 1, outfile);
-			// short vx, short vy, int SAD = 4 words = 8 bytes per block
-			outfilebuf = new short [nBlkX * nBlkY * 4];
 		}
 	}
 	else
 	{
 		outfile    = NULL;
-		outfilebuf = NULL;
 	}
 
+	_prof_ptr = Profiler::acquire (profile_0);
+
+	_ctx_fact_aptr = std::auto_ptr <AnalysisContextFactory> (
+		new AnalysisContextFactory (
+			analysisData,
+			nSuperLevels, nSuperHPad, nSuperVPad, nSuperModeYUV,
+			divideExtra,
+			(_dct_factory_ptr.get () != 0) ? &_dct_pool : 0,
+			_prof_ptr,
+			_isse, (outfile != NULL), _mt_flag
+		)
+	);
+	_ctx_pool.set_factory (*_ctx_fact_aptr);
+
+	// Creates a first context right now, to report the allocation errors
+	// at construction time and to get the size of the vector data.
+	AnalysisContext *	ctx_ptr = _ctx_pool.take_obj ();
+	if (ctx_ptr == 0)
+	{
+		Profiler::release (_prof_ptr);
+		_prof_ptr = 0;
+		env->ThrowError ("MAnalyse: cannot allocate the analysis data.");
+	}
+	_vect_array_size = ctx_ptr->_vectorfields_aptr->GetArraySize ();
+	_ctx_pool.return_obj (*ctx_ptr);
+
 	// Defines the format of the output vector clip
-	const int		width_bytes = headerSize + _vectorfields_aptr->GetArraySize () * 4;
+	const int		width_bytes = headerSize + _vect_array_size * 4;
 	ClipFnc::format_vector_clip (
 		vi, true, nBlkX, "rgb32", width_bytes, "MAnalyse", *env
 	);
@@ -388,9 +390,9 @@ MVAnalyse::MVAnalyse (
 
 	if (_temporal_flag)
 	{
-		_srd_arr [0]._vec_prev.resize (_vectorfields_aptr->GetArraySize ()); // array for prev vectors
+		_srd_arr [0]._vec_prev._vec.resize (_vect_array_size); // array for prev vectors
 	}
-	_srd_arr [0]._vec_prev_frame = -2;
+	_srd_arr [0]._vec_prev._frame = -2;
 
 	// From this point, analysisData and analysisDataDivided references will
 	// become invalid, because of the _srd_arr.resize(). Don't use them any more.
@@ -462,14 +464,10 @@ MVAnalyse::~MVAnalyse()
 	{
 		fclose (outfile);
 		outfile = 0;
-		delete [] outfilebuf;
-		outfilebuf = 0;
 	}
 
-	delete pSrcGOF;
-	pSrcGOF = 0;
-	delete pRefGOF;
-	pRefGOF = 0;
+	Profiler::release (_prof_ptr);
+	_prof_ptr = 0;
 }
 
 
@@ -480,28 +478,7 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 	const int		nsrc      = n / ndiv;
 	const int		srd_index = n % ndiv;
 
-	SrcRefData &	srd = _srd_arr [srd_index];
-
-	const int		nbr_src_frames = child->GetVideoInfo ().num_frames;
-	int				minframe;
-	int				maxframe;
-	int				nref;
-	if (srd._analysis_data.nDeltaFrame > 0)
-	{
-		const int		offset =
-			  (srd._analysis_data.isBackward)
-			?  srd._analysis_data.nDeltaFrame
-			: -srd._analysis_data.nDeltaFrame;
-		minframe =                  std::max (-offset, 0);
-		maxframe = nbr_src_frames + std::min (-offset, 0);
-		nref     = nsrc + offset;
-	}
-	else // special static mode
-	{
-		nref     = -srd._analysis_data.nDeltaFrame;	// positive fixed frame number
-		minframe = 0;
-		maxframe = nbr_src_frames;
-	}
+	const SrcRefData &	srd = _srd_arr [srd_index];
 
 	PVideoFrame			dst = env->NewVideoFrame (vi);
 	unsigned char *	pDst = dst->GetWritePtr ();
@@ -526,21 +503,93 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 	}
 	pDst += headerSize;
 
+	AnalysisContext *	ctx_ptr = _ctx_pool.take_obj ();
+	if (ctx_ptr == 0)
+	{
+		env->ThrowError ("MAnalyse: cannot allocate the analysis data.");
+	}
+
+	try
+	{
+		if (_temporal_flag)
+		{
+			// The temporal predictor is taken from the frame analysed just
+			// before, so the frames are analysed one at a time. This way a
+			// linear access gives the same result as a single-threaded one.
+			conc::CritSec	lock (_temporal_mutex);
+			analyse_frame (*ctx_ptr, pDst, n, nsrc, srd_index, env);
+		}
+		else
+		{
+			analyse_frame (*ctx_ptr, pDst, n, nsrc, srd_index, env);
+		}
+	}
+	catch (...)
+	{
+		_ctx_pool.return_obj (*ctx_ptr);
+		throw;
+	}
+	_ctx_pool.return_obj (*ctx_ptr);
+
+	return dst;
+}
+
+
+
+// Can be called concurrently from several threads, each one with its own
+// context. The data shared between the calls are accessed under a lock.
+// In temporal mode, the calls are serialised by the caller.
+void	MVAnalyse::analyse_frame (AnalysisContext &ctx, unsigned char *pDst, int n, int nsrc, int srd_index, ::IScriptEnvironment* env)
+{
+	SrcRefData &	srd = _srd_arr [srd_index];
+	GroupOfPlanes &	vectorfields = *ctx._vectorfields_aptr;
+	MVGroupOfFrames &	src_gof = *ctx._src_gof_aptr;
+	MVGroupOfFrames &	ref_gof = *ctx._ref_gof_aptr;
+	short *			outfilebuf = (ctx._outfilebuf.empty ()) ? 0 : &ctx._outfilebuf [0];
+
+	const int		nbr_src_frames = child->GetVideoInfo ().num_frames;
+	int				minframe;
+	int				maxframe;
+	int				nref;
+	if (srd._analysis_data.nDeltaFrame > 0)
+	{
+		const int		offset =
+			  (srd._analysis_data.isBackward)
+			?  srd._analysis_data.nDeltaFrame
+			: -srd._analysis_data.nDeltaFrame;
+		minframe =                  std::max (-offset, 0);
+		maxframe = nbr_src_frames + std::min (-offset, 0);
+		nref     = nsrc + offset;
+	}
+	else // special static mode
+	{
+		nref     = -srd._analysis_data.nDeltaFrame;	// positive fixed frame number
+		minframe = 0;
+		maxframe = nbr_src_frames;
+	}
+
 	if (nsrc < minframe || nsrc >= maxframe)
 	{
-		_vectorfields_aptr->WriteDefaultToArray (reinterpret_cast <int *> (pDst));
+		vectorfields.WriteDefaultToArray (reinterpret_cast <int *> (pDst));
 	}
 
 	else
 	{
 //		DebugPrintf ("MVAnalyse: Get src frame %d",nsrc);
 		::PVideoFrame	src = child->GetFrame (nsrc, env); // v2.0
-		load_src_frame (*pSrcGOF, src, srd._analysis_data);
+		load_src_frame (src_gof, src, srd._analysis_data);
+		if (_multi_flag && nsrc != ctx._src_cache_frame)
+		{
+			// All the deltas of a frame share the same source. Its block data
+			// are computed once here, then reused by all the searches.
+			vectorfields.PrepareSrcCache (&src_gof);
+			ctx._src_cache_frame = nsrc;
+		}
 
 //		DebugPrintf ("MVAnalyse: Get ref frame %d", nref);
 //		DebugPrintf ("MVAnalyse frame %i backward=%i", nsrc, srd._analysis_data.isBackward);
 		::PVideoFrame	ref = child->GetFrame (nref, env); // v2.0
-		load_src_frame (*pRefGOF, ref, srd._analysis_data);
+		load_src_frame (ref_gof, ref, srd._analysis_data);
 
 		const int		fieldShift = ClipFnc::compute_fieldshift (
 			child,
@@ -550,20 +599,15 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 			nref
 		);
 
-		if (outfile != NULL)
-		{
-			fwrite (&n, sizeof (int), 1, outfile);	// write frame number
-		}
-
 		// temporal predictor dst if prev frame was really prev
 		int *			pVecPrevOrNull = 0;
-		if (_temporal_flag && srd._vec_prev_frame == nsrc - 1)
+		if (_temporal_flag && srd._vec_prev._frame == nsrc - 1)
 		{
-			pVecPrevOrNull = &srd._vec_prev [0];
+			pVecPrevOrNull = &srd._vec_prev._vec [0];
 		}
 
-		_vectorfields_aptr->SearchMVs (
-			pSrcGOF, pRefGOF,
+		vectorfields.SearchMVs (
+			&src_gof, &ref_gof,
 			searchType, nSearchParam, nPelSearch, nLambda, lsad, pnew, plevel,
 			global, srd._analysis_data.nFlags, reinterpret_cast<int*>(pDst),
 			outfilebuf, fieldShift, pzero, pglobal, badSAD, badrange,
@@ -574,15 +618,16 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 		{
 			// make extra level with divided sublocks with median (not estimated)
 			// motion
-			_vectorfields_aptr->ExtraDivide (
+			vectorfields.ExtraDivide (
 				reinterpret_cast <int *> (pDst),
 				srd._analysis_data.nFlags
 			);
 		}
 
-//		PROFILE_CUMULATE ();
 		if (outfile != NULL)
 		{
+			conc::CritSec	lock (_outfile_mutex);
+			fwrite (&n, sizeof (int), 1, outfile);	// write frame number
 			fwrite (
 				outfilebuf,
 				sizeof (short) * 4 * srd._analysis_data.nBlkX
@@ -597,21 +642,18 @@ PVideoFrame __stdcall MVAnalyse::GetFrame(int n, IScriptEnvironment* env)
 	{
 		// store previous vectors for use as predictor in next frame
 		memcpy (
-			&srd._vec_prev [0],
+			&srd._vec_prev._vec [0],
 			reinterpret_cast <int *> (pDst),
-			_vectorfields_aptr->GetArraySize ()
+			_vect_array_size
 		);
-		srd._vec_prev_frame = nsrc;
+		srd._vec_prev._frame = nsrc;
 	}
-
-	return dst;
 }
 
 
 
 void	MVAnalyse::load_src_frame (MVGroupOfFrames &gof, ::PVideoFrame &src, const MVAnalysisData &ana_data)
 {
-	PROFILE_START (MOTION_PROFILE_YUY2CONVERT);
 	const unsigned char *	pSrcY;
 	const unsigned char *	pSrcU;
 	const unsigned char *	pSrcV;
@@ -635,7 +677,6 @@ void	MVAnalyse::load_src_frame (MVGroupOfFrames &gof, ::PVideoFrame &src, const
 		nSrcPitchY  = src->GetPitch (PLANAR_Y);
 		nSrcPitchUV = src->GetPitch (PLANAR_U);
 	}
-	PROFILE_STOP (MOTION_PROFILE_YUY2CONVERT);
 
 	gof.Update (
 		nModeYUV,
@@ -645,3 +686,99 @@ void	MVAnalyse::load_src_frame (MVGroupOfFrames &gof, ::PVideoFrame &src, const
 	); // v2.0
 }
 
+
+
+
+MVAnalyse::AnalysisContext::AnalysisContext ()
+:	_vectorfields_aptr ()
+,	_src_gof_aptr ()
+,	_ref_gof_aptr ()
+,	_outfilebuf ()
+,	_src_cache_frame (-1)
+{
+	// Nothing
+}
+
+
+
+MVAnalyse::AnalysisContext::~AnalysisContext ()
+{
+	// Nothing
+}
+
+
+
+MVAnalyse::AnalysisContextFactory::AnalysisContextFactory (const MVAnalysisData &ana_data, int super_levels, int super_hpad, int super_vpad, int super_mode_yuv, int divide, conc::ObjPool <DCTClass> *dct_pool_ptr, Profiler *prof_ptr, bool isse_flag, bool outfile_flag, bool mt_flag)
+:	_ana_data (ana_data)
+,	_super_levels (super_levels)
+,	_super_hpad (super_hpad)
+,	_super_vpad (super_vpad)
+,	_super_mode_yuv (super_mode_yuv)
+,	_divide (divide)
+,	_dct_pool_ptr (dct_pool_ptr)
+,	_prof_ptr (prof_ptr)
+,	_isse_flag (isse_flag)
+,	_outfile_flag (outfile_flag)
+,	_mt_flag (mt_flag)
+{
+	// Nothing
+}
+
+
+
+MVAnalyse::AnalysisContext *	MVAnalyse::AnalysisContextFactory::do_create ()
+{
+	AnalysisContext *	ctx_ptr = 0;
+
+	try
+	{
+		std::auto_ptr <AnalysisContext>	ctx_aptr (new AnalysisContext);
+
+		ctx_aptr->_vectorfields_aptr = std::auto_ptr <GroupOfPlanes> (
+			new GroupOfPlanes (
+				_ana_data.nBlkSizeX,
+				_ana_data.nBlkSizeY,
+				_ana_data.nLvCount,
+				_ana_data.nPel,
+				_ana_data.nFlags,
+				_ana_data.nOverlapX,
+				_ana_data.nOverlapY,
+				_ana_data.nBlkX,
+				_ana_data.nBlkY,
+				_ana_data.yRatioUV,
+				_divide,
+				_dct_pool_ptr,
+				_prof_ptr,
+				_mt_flag
+			)
+		);
+		ctx_aptr->_src_gof_aptr = std::auto_ptr <MVGroupOfFrames> (
+			new MVGroupOfFrames (
+				_super_levels, _ana_data.nWidth, _ana_data.nHeight,
+				_ana_data.nPel, _super_hpad, _super_vpad, _super_mode_yuv,
+				_isse_flag, _ana_data.yRatioUV, _mt_flag
+			)
+		);
+		ctx_aptr->_ref_gof_aptr = std::auto_ptr <MVGroupOfFrames> (
+			new MVGroupOfFrames (
+				_super_levels, _ana_data.nWidth, _ana_data.nHeight,
+				_ana_data.nPel, _super_hpad, _super_vpad, _super_mode_yuv,
+				_isse_flag, _ana_data.yRatioUV, _mt_flag
+			)
+		);
+
+		if (_outfile_flag)
+		{
+			// short vx, short vy, int SAD = 4 words = 8 bytes per block
+			ctx_aptr->_outfilebuf.resize (_ana_data.nBlkX * _ana_data.nBlkY * 4);
+		}
+
+		ctx_ptr = ctx_aptr.release ();
+	}
+	catch (...)
+	{
+		ctx_ptr = 0;
+	}
+
+	return (ctx_ptr);
+}
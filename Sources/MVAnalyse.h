@@ -24,10 +24,12 @@
 #define	NOMINMAX
 #define	WIN32_LEAN_AND_MEAN
 
+#include	"conc/Mutex.h"
 #include	"conc/ObjPool.h"
 #include "DCTFactory.h"
 #include "GroupOfPlanes.h"
 #include "MVAnalysisData.h"
+#include "Profiler.h"
 #include "yuy2planes.h"
 
 #include "Windows.h"
@@ -46,24 +48,74 @@ protected:
 	// One instance per Src/Ref combination
 	// Multi mode order (bwd/fwd delta): B1, F1, B2, F2, B3, F3...
 	// In single mode, only the first element is used.
+	// Vectors of the last analysed frame, kept as temporal predictor for the
+	// next frame.
+	class VecPrev
+	{
+	public:
+		std::vector <int>
+							_vec;
+		int				_frame;	// Source frame of the vectors, -2: none
+	};
+
 	class SrcRefData
 	{
 	public:
 	   MVAnalysisData _analysis_data;
 	   MVAnalysisData _analysis_data_divided;
 
-		std::vector <int>
-							_vec_prev;
-		int				_vec_prev_frame;
+		VecPrev			_vec_prev;
 	};
 
 	typedef	std::vector <SrcRefData>	SrcRefArray;
 
 	SrcRefArray		_srd_arr;
 
-	/*! \brief Frames of blocks for which motion vectors will be computed */
-	std::auto_ptr <GroupOfPlanes>
-						_vectorfields_aptr;	// Temporary data, structure initialised once.
+	// Working data of a single GetFrame() call. Contexts are taken from a
+	// pool, so several frames can be analysed concurrently.
+	class AnalysisContext
+	{
+	public:
+		/*! \brief Frames of blocks for which motion vectors will be computed */
+		std::auto_ptr <GroupOfPlanes>
+							_vectorfields_aptr;
+		std::auto_ptr <MVGroupOfFrames>
+							_src_gof_aptr;
+		std::auto_ptr <MVGroupOfFrames>
+							_ref_gof_aptr;
+		std::vector <short>
+							_outfilebuf;
+		int				_src_cache_frame;	// Source frame whose block data is cached in _vectorfields_aptr, multi mode only. -1: none
+
+							AnalysisContext ();
+		virtual			~AnalysisContext ();
+	};
+
+	class AnalysisContextFactory
+	:	public conc::ObjFactoryInterface <AnalysisContext>
+	{
+	public:
+							AnalysisContextFactory (const MVAnalysisData &ana_data, int super_levels, int super_hpad, int super_vpad, int super_mode_yuv, int divide, conc::ObjPool <DCTClass> *dct_pool_ptr, Profiler *prof_ptr, bool isse_flag, bool outfile_flag, bool mt_flag);
+	protected:
+		// conc::ObjFactoryInterface
+		virtual AnalysisContext *
+							do_create ();
+	private:
+		MVAnalysisData	_ana_data;
+		int				_super_levels;
+		int				_super_hpad;
+		int				_super_vpad;
+		int				_super_mode_yuv;
+		int				_divide;
+		conc::ObjPool <DCTClass> *
+							_dct_pool_ptr;
+		Profiler *		_prof_ptr;
+		bool				_isse_flag;
+		bool				_outfile_flag;
+		bool				_mt_flag;
+	};
+
+	typedef	conc::ObjPool <AnalysisContext>	AnalysisContextPool;
 
    /*! \brief isse optimisations enabled */
 	bool isse;
@@ -97,7 +149,6 @@ protected:
 	const bool     _mt_flag;
 
 	FILE *outfile;
-	short * outfilebuf;
 
 //	YUY2Planes * SrcPlanes;
 //	YUY2Planes * RefPlanes;
@@ -109,12 +160,19 @@ protected:
 
 	int headerSize;
 
-	MVGroupOfFrames *pSrcGOF, *pRefGOF; //v2.0. Temporary data, structure initialised once.
-
 	int nModeYUV;
 
 	int            _delta_max;
 
+	std::auto_ptr <AnalysisContextFactory>
+	               _ctx_fact_aptr;
+	AnalysisContextPool
+	               _ctx_pool;
+	int            _vect_array_size;	// Size of the vector data, in int
+	conc::Mutex    _temporal_mutex;	// Serialises the analysis in temporal mode
+	conc::Mutex    _outfile_mutex;
+	Profiler *     _prof_ptr;        // 0 if profiling is disabled
+
 public :
 
 	MVAnalyse (
@@ -124,7 +182,7 @@ public :
 		int _overlapx, int _overlapy, const char* _outfilename, int _dctmode,
 		int _divide, int _sadx264, int _badSAD, int _badrange, bool _isse,
 		bool _meander, bool temporal_flag, bool _tryMany, bool multi_flag,
-		bool mt_flag, IScriptEnvironment* env);
+		bool mt_flag, const char *profile_0, IScriptEnvironment* env);
 	~MVAnalyse();
 
 	::PVideoFrame __stdcall	GetFrame (int n, ::IScriptEnvironment* env);
@@ -132,6 +190,7 @@ public :
 private:
 
 	void				load_src_frame (MVGroupOfFrames &gof, ::PVideoFrame &src, const MVAnalysisData &ana_data);
+	void				analyse_frame (AnalysisContext &ctx, unsigned char *pDst, int n, int nsrc, int srd_index, ::IScriptEnvironment* env);
 };
 
 #endif
@@ -38,7 +38,8 @@ public:
 
 		// Additional header for storage
 		STORE_KEY        = 0xBEAD,
-		STORE_VERSION    = 5
+		STORE_VERSION    = 5,
+		STORE_VERSION_COMPACT = 6	// Each clip may be encoded with VectCodec
 	};
 
    /*! \brief Unique identifier, not very useful */
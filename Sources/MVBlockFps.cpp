@@ -27,7 +27,7 @@
 #include	"MVGroupOfFrames.h"
 #include "MVPlane.h"
 #include "Padding.h"
-#include "profile.h"
+#include	"SuperFrameCache.h"
 #include "SuperParams64Bits.h"
 #include "Time256ProviderCst.h"
 
@@ -45,6 +45,7 @@ MVBlockFps::MVBlockFps(
 ,	mvClipB(mvbw, nSCD1, nSCD2, env, 1, 0)
 ,	mvClipF(mvfw, nSCD1, nSCD2, env, 1, 0)
 ,	super(_super)
+,	_mt_flag (mt_flag)
 {
     	if (!vi.IsYV12() && !vi.IsYUY2())
 		env->ThrowError("MBlockFps: Clip must be YV12 or YUY2");
@@ -304,10 +305,14 @@ MVBlockFps::MVBlockFps(
    {
 		DstPlanes =  new YUY2Planes(nWidth, nHeight);
    }
+
+	SuperFrameCache::add_client (super);
 }
 
 MVBlockFps::~MVBlockFps()
 {
+	SuperFrameCache::remove_client (super);
+
 	delete upsizer;
 	delete upsizerUV;
 
@@ -582,8 +587,8 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 	mvClipB.Update(mvB, env);// backward from next to current
 	mvB = 0;
 
-	PVideoFrame	src	= super->GetFrame(nleft, env);
-	PVideoFrame ref = super->GetFrame(nright, env);//  ref for backward compensation
+	PVideoFrame	src	= SuperFrameCache::get_frame (super, nleft, *env);
+	PVideoFrame ref = SuperFrameCache::get_frame (super, nright, *env);//  ref for backward compensation
 
 	const Time256ProviderCst	t256_prov_cst (time256, 0, 0);
 
@@ -598,8 +603,6 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 		//         PMVGroupOfFrames pRefGOFF = pFrames->GetFrame(nleft); // forward ref
 		//         PMVGroupOfFrames pRefGOFB = pFrames->GetFrame(nright); // backward ref
 
-		PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
-
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
 		{
 			pSrc[0] = src->GetReadPtr();
@@ -660,32 +663,27 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 			nSrcPitches[1] = UPITCH(src);
 			nSrcPitches[2] = VPITCH(src);
 		}
-		PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
 
 		pRefBGOF->Update(YUVPLANES, (BYTE*)pRef[0], nRefPitches[0], (BYTE*)pRef[1], nRefPitches[1], (BYTE*)pRef[2], nRefPitches[2]);// v2.0
 		pRefFGOF->Update(YUVPLANES, (BYTE*)pSrc[0], nSrcPitches[0], (BYTE*)pSrc[1], nSrcPitches[1], (BYTE*)pSrc[2], nSrcPitches[2]);
 
-		MVPlane *pPlanesB[3];
-		MVPlane *pPlanesF[3];
-
-		pPlanesB[0] = pRefBGOF->GetFrame(0)->GetPlane(YPLANE);
-		pPlanesB[1] = pRefBGOF->GetFrame(0)->GetPlane(UPLANE);
-		pPlanesB[2] = pRefBGOF->GetFrame(0)->GetPlane(VPLANE);
+		_plane_b_arr [0] = pRefBGOF->GetFrame(0)->GetPlane(YPLANE);
+		_plane_b_arr [1] = pRefBGOF->GetFrame(0)->GetPlane(UPLANE);
+		_plane_b_arr [2] = pRefBGOF->GetFrame(0)->GetPlane(VPLANE);
 
-		pPlanesF[0] = pRefFGOF->GetFrame(0)->GetPlane(YPLANE);
-		pPlanesF[1] = pRefFGOF->GetFrame(0)->GetPlane(UPLANE);
-		pPlanesF[2] = pRefFGOF->GetFrame(0)->GetPlane(VPLANE);
+		_plane_f_arr [0] = pRefFGOF->GetFrame(0)->GetPlane(YPLANE);
+		_plane_f_arr [1] = pRefFGOF->GetFrame(0)->GetPlane(UPLANE);
+		_plane_f_arr [2] = pRefFGOF->GetFrame(0)->GetPlane(VPLANE);
 
 		MemZoneSet(MaskFullYB, 0, nWidthP, nHeightP, 0, 0, nPitchY); // put zeros
 		MemZoneSet(MaskFullYF, 0, nWidthP, nHeightP, 0, 0, nPitchY);
 
-		int dummyplane = PLANAR_Y; // always use it for resizer
-
-		PROFILE_START(MOTION_PROFILE_COMPENSATION);
 		int blocks = mvClipB.GetBlkCount();
 
 		int maxoffset = nPitchY*(nHeightP-nBlkSizeY)-nBlkSizeX;
 
+		// The block-resolution masks are built here, the upsizing to the full
+		// frame size is done by the slices.
 		if (mode == 3 || mode==4 || mode==5)
 		{
 			// make forward shifted images by projection to build occlusion mask
@@ -708,41 +706,18 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 			// make small binary mask from  occlusion  regions
 			MakeSmallMask(MaskFullYF, nPitchY, smallMaskF, nBlkXP, nBlkYP, nBlkSizeX, nBlkSizeY, thres);
 			InflateMask(smallMaskF, nBlkXP, nBlkYP);
-			// upsize small mask to full frame size
-			upsizer->SimpleResizeDo(MaskFullYF, nWidthP, nHeightP, nPitchY, smallMaskF, nBlkXP, nBlkXP, dummyplane);
-			upsizerUV->SimpleResizeDo(MaskFullUVF, nWidthPUV, nHeightPUV, nPitchUV, smallMaskF, nBlkXP, nBlkXP, dummyplane);
-			// now we have forward fullframe blured occlusion mask in maskF arrays
 
 			// make small binary mask from  occlusion  regions
 			MakeSmallMask(MaskFullYB, nPitchY, smallMaskB, nBlkXP, nBlkYP, nBlkSizeX, nBlkSizeY, thres);
 			InflateMask(smallMaskB, nBlkXP, nBlkYP);
-			// upsize small mask to full frame size
-			upsizer->SimpleResizeDo(MaskFullYB, nWidthP, nHeightP, nPitchY, smallMaskB, nBlkXP, nBlkXP, dummyplane);
-			upsizerUV->SimpleResizeDo(MaskFullUVB, nWidthPUV, nHeightPUV, nPitchUV, smallMaskB, nBlkXP, nBlkXP, dummyplane);
 		}
 		if (mode==4 || mode==5)
 		{
 			// make final (both directions) occlusion mask
 			MultMasks(smallMaskF, smallMaskB, smallMaskO,  nBlkXP, nBlkYP);
 			InflateMask(smallMaskO, nBlkXP, nBlkYP);
-			// upsize small mask to full frame size
-			upsizer->SimpleResizeDo(MaskOccY, nWidthP, nHeightP, nPitchY, smallMaskO, nBlkXP, nBlkXP, dummyplane);
-			upsizerUV->SimpleResizeDo(MaskOccUV, nWidthPUV, nHeightPUV, nPitchUV, smallMaskO, nBlkXP, nBlkXP, dummyplane);
 		}
 
-		// pointers
-		BYTE * pMaskFullYB = MaskFullYB;
-		BYTE * pMaskFullYF = MaskFullYF;
-		BYTE * pMaskFullUVB = MaskFullUVB;
-		BYTE * pMaskFullUVF = MaskFullUVF;
-		BYTE * pMaskOccY = MaskOccY;
-		BYTE * pMaskOccUV = MaskOccUV;
-
-		BYTE *pDstSave[3];
-		pDstSave[0] = pDst[0];
-		pDstSave[1] = pDst[1];
-		pDstSave[2] = pDst[2];
-
 		pSrc[0] += nSuperHPad + nSrcPitches[0]*nSuperVPad; // add offset source in super
 		pSrc[1] += (nSuperHPad>>1) + nSrcPitches[1]*(nSuperVPad>>1);
 		pSrc[2] += (nSuperHPad>>1) + nSrcPitches[2]*(nSuperVPad>>1);
@@ -750,102 +725,26 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 		pRef[1] += (nSuperHPad>>1) + nRefPitches[1]*(nSuperVPad>>1);
 		pRef[2] += (nSuperHPad>>1) + nRefPitches[2]*(nSuperVPad>>1);
 
-		// fetch image blocks
-		for ( int i = 0; i < blocks; i++ )
+		for (int p = 0; p < 3; ++p)
 		{
-			const FakeBlockData &blockB = mvClipB.GetBlock(0, i);
-			const FakeBlockData &blockF = mvClipF.GetBlock(0, i);
-
-			// luma
-			ResultBlock(pDst[0], nDstPitches[0],
-			pPlanesB[0]->GetPointer(blockB.GetX() * nPel + ((blockB.GetMV().x*(256-time256))>>8), blockB.GetY() * nPel + ((blockB.GetMV().y*(256-time256))>>8)),
-			pPlanesB[0]->GetPitch(),
-			pPlanesF[0]->GetPointer(blockF.GetX() * nPel + ((blockF.GetMV().x*time256)>>8), blockF.GetY() * nPel + ((blockF.GetMV().y*time256)>>8)),
-			pPlanesF[0]->GetPitch(),
-			pRef[0], nRefPitches[0],
-			pSrc[0], nSrcPitches[0],
-			pMaskFullYB, nPitchY,
-			pMaskFullYF, pMaskOccY,
-			nBlkSizeX, nBlkSizeY, time256, mode);
-			// chroma u
-			if (nSuperModeYUV & UPLANE) ResultBlock(pDst[1], nDstPitches[1],
-			pPlanesB[1]->GetPointer((blockB.GetX() * nPel + ((blockB.GetMV().x*(256-time256))>>8))>>1, (blockB.GetY() * nPel + ((blockB.GetMV().y*(256-time256))>>8))/yRatioUV),
-			pPlanesB[1]->GetPitch(),
-			pPlanesF[1]->GetPointer((blockF.GetX() * nPel + ((blockF.GetMV().x*time256)>>8))>>1, (blockF.GetY() * nPel + ((blockF.GetMV().y*time256)>>8))/yRatioUV),
-			pPlanesF[1]->GetPitch(),
-			pRef[1], nRefPitches[1],
-			pSrc[1], nSrcPitches[1],
-			pMaskFullUVB, nPitchUV,
-			pMaskFullUVF, pMaskOccUV,
-			nBlkSizeX>>1, nBlkSizeY/yRatioUV, time256, mode);
-			// chroma v
-			if (nSuperModeYUV & VPLANE) ResultBlock(pDst[2], nDstPitches[2],
-			pPlanesB[2]->GetPointer((blockB.GetX() * nPel + ((blockB.GetMV().x*(256-time256))>>8))>>1, (blockB.GetY() * nPel + ((blockB.GetMV().y*(256-time256))>>8))/yRatioUV),
-			pPlanesB[2]->GetPitch(),
-			pPlanesF[2]->GetPointer((blockF.GetX() * nPel + ((blockF.GetMV().x*time256)>>8))>>1, (blockF.GetY() * nPel + ((blockF.GetMV().y*time256)>>8))/yRatioUV),
-			pPlanesF[2]->GetPitch(),
-			pRef[2], nRefPitches[2],
-			pSrc[2], nSrcPitches[2],
-			pMaskFullUVB, nPitchUV,
-			pMaskFullUVF, pMaskOccUV,
-			nBlkSizeX>>1, nBlkSizeY/yRatioUV, time256, mode);
-
-
-			// update pDsts
-			pDst[0] += nBlkSizeX;
-			pDst[1] += nBlkSizeX >> 1;
-			pDst[2] += nBlkSizeX >> 1;
-			pRef[0] += nBlkSizeX;
-			pRef[1] += nBlkSizeX >> 1;
-			pRef[2] += nBlkSizeX >> 1;
-			pSrc[0] += nBlkSizeX;
-			pSrc[1] += nBlkSizeX >> 1;
-			pSrc[2] += nBlkSizeX >> 1;
-			pMaskFullYB += nBlkSizeX;
-			pMaskFullUVB += nBlkSizeX>>1;
-			pMaskFullYF += nBlkSizeX;
-			pMaskFullUVF += nBlkSizeX>>1;
-			pMaskOccY += nBlkSizeX;
-			pMaskOccUV += nBlkSizeX>>1;
-
-
-			if ( !((i + 1) % nBlkX)  )
-			{
-				// blend rest right with time weight
-				Blend(pDst[0], pSrc[0], pRef[0], nBlkSizeY, nWidth-nBlkSizeX*nBlkX, nDstPitches[0], nSrcPitches[0], nRefPitches[0], t256_prov_cst, isse2);
-				if (nSuperModeYUV & UPLANE) Blend(pDst[1], pSrc[1], pRef[1], nBlkSizeY /yRatioUV, nWidthUV-(nBlkSizeX>>1)*nBlkX, nDstPitches[1], nSrcPitches[1], nRefPitches[1], t256_prov_cst, isse2);
-				if (nSuperModeYUV & VPLANE) Blend(pDst[2], pSrc[2], pRef[2], nBlkSizeY /yRatioUV, nWidthUV-(nBlkSizeX>>1)*nBlkX, nDstPitches[2], nSrcPitches[2], nRefPitches[2], t256_prov_cst, isse2);
-
-				pDst[0] += nBlkSizeY * nDstPitches[0] - nBlkSizeX*nBlkX;
-				pDst[1] += ( nBlkSizeY /yRatioUV ) * nDstPitches[1] - (nBlkSizeX>>1)*nBlkX;
-				pDst[2] += ( nBlkSizeY /yRatioUV ) * nDstPitches[2] - (nBlkSizeX>>1)*nBlkX;
-				pRef[0] += nBlkSizeY * nRefPitches[0] - nBlkSizeX*nBlkX;
-				pRef[1] += ( nBlkSizeY /yRatioUV ) * nRefPitches[1] - (nBlkSizeX>>1)*nBlkX;
-				pRef[2] += ( nBlkSizeY /yRatioUV ) * nRefPitches[2] - (nBlkSizeX>>1)*nBlkX;
-				pSrc[0] += nBlkSizeY * nSrcPitches[0] - nBlkSizeX*nBlkX;
-				pSrc[1] += ( nBlkSizeY /yRatioUV ) * nSrcPitches[1] - (nBlkSizeX>>1)*nBlkX;
-				pSrc[2] += ( nBlkSizeY /yRatioUV ) * nSrcPitches[2] - (nBlkSizeX>>1)*nBlkX;
-				pMaskFullYB += nBlkSizeY * nPitchY - nBlkSizeX*nBlkX;
-				pMaskFullUVB += (nBlkSizeY /yRatioUV) * nPitchUV - (nBlkSizeX>>1)*nBlkX;
-				pMaskFullYF += nBlkSizeY * nPitchY - nBlkSizeX*nBlkX;
-				pMaskFullUVF += (nBlkSizeY /yRatioUV) * nPitchUV - (nBlkSizeX>>1)*nBlkX;
-				pMaskOccY += nBlkSizeY * nPitchY - nBlkSizeX*nBlkX;
-				pMaskOccUV += (nBlkSizeY /yRatioUV) * nPitchUV - (nBlkSizeX>>1)*nBlkX;
-			}
+			_dst_ptr_arr [p]   = pDst [p];
+			_dst_pitch_arr [p] = nDstPitches [p];
+			_ref_ptr_arr [p]   = pRef [p];
+			_ref_pitch_arr [p] = nRefPitches [p];
+			_src_ptr_arr [p]   = pSrc [p];
+			_src_pitch_arr [p] = nSrcPitches [p];
 		}
-		// blend rest bottom with time weight
-		Blend(pDst[0], pSrc[0], pRef[0], nHeight-nBlkSizeY*nBlkY, nWidth, nDstPitches[0], nSrcPitches[0], nRefPitches[0], t256_prov_cst, isse2);
-		if (nSuperModeYUV & UPLANE) Blend(pDst[1], pSrc[1], pRef[1], nHeightUV-(nBlkSizeY /yRatioUV)*nBlkY, nWidthUV, nDstPitches[1], nSrcPitches[1], nRefPitches[1], t256_prov_cst, isse2);
-		if (nSuperModeYUV & VPLANE) Blend(pDst[2], pSrc[2], pRef[2], nHeightUV-(nBlkSizeY /yRatioUV)*nBlkY, nWidthUV, nDstPitches[2], nSrcPitches[2], nRefPitches[2], t256_prov_cst, isse2);
-		PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+		_time256 = time256;
+
+		Slicer			slicer (_mt_flag);
+		slicer.start (nBlkYP, *this, &MVBlockFps::process_slice, 1);
+		slicer.wait ();
 
-		PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 		{
 			YUY2FromPlanes(pDstYUY2, nDstPitchYUY2, nWidth, nHeight,
-			pDstSave[0], nDstPitches[0], pDstSave[1], pDstSave[2], nDstPitches[1], isse2);
+			pDst[0], nDstPitches[0], pDst[1], pDst[2], nDstPitches[1], isse2);
 		}
-		PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
 
 		return dst;
 	}
@@ -856,7 +755,6 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 		if (blend) //let's blend src with ref frames like ConvertFPS
 		{
 			PVideoFrame ref = child->GetFrame(nright,env);
-			PROFILE_START(MOTION_PROFILE_FLOWINTER);
 			if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
 			{
 				pSrc[0] = src->GetReadPtr(); // we can blend YUY2
@@ -894,7 +792,6 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 				if (nSuperModeYUV & UPLANE) Blend(pDst[1], pSrc[1], pRef[1], nHeightUV, nWidthUV, nDstPitches[1], nSrcPitches[1], nRefPitches[1], t256_prov_cst, isse2);
 				if (nSuperModeYUV & VPLANE) Blend(pDst[2], pSrc[2], pRef[2], nHeightUV, nWidthUV, nDstPitches[2], nSrcPitches[2], nRefPitches[2], t256_prov_cst, isse2);
 			}
-			PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
 
 			return dst;
 		}
@@ -905,3 +802,152 @@ PVideoFrame __stdcall MVBlockFps::GetFrame(int n, IScriptEnvironment* env)
 	}
 
 }
+
+
+
+// Slices are made of block rows. The last slice includes the padding rows
+// of the masks and the bottom rest of the picture.
+void MVBlockFps::process_slice (Slicer::TaskData &td)
+{
+	const int      by_beg    = td._y_beg;
+	const int      by_end    = td._y_end;
+	const bool     last_flag = (by_end == nBlkYP);
+	const int      yl_beg    = by_beg * nBlkSizeY;
+	const int      yl_end    = last_flag ? nHeightP : by_end * nBlkSizeY;
+	const int      yc_beg    = yl_beg / yRatioUV;
+	const int      yc_end    = last_flag ? nHeightPUV : yl_end / yRatioUV;
+	const int      dummyplane = PLANAR_Y; // always use it for resizer
+
+	// upsize small masks to full frame size
+	if (mode == 3 || mode==4 || mode==5)
+	{
+		upsizer->SimpleResizeDo(MaskFullYF, nWidthP, nHeightP, nPitchY, smallMaskF, nBlkXP, nBlkXP, dummyplane, yl_beg, yl_end);
+		upsizerUV->SimpleResizeDo(MaskFullUVF, nWidthPUV, nHeightPUV, nPitchUV, smallMaskF, nBlkXP, nBlkXP, dummyplane, yc_beg, yc_end);
+		upsizer->SimpleResizeDo(MaskFullYB, nWidthP, nHeightP, nPitchY, smallMaskB, nBlkXP, nBlkXP, dummyplane, yl_beg, yl_end);
+		upsizerUV->SimpleResizeDo(MaskFullUVB, nWidthPUV, nHeightPUV, nPitchUV, smallMaskB, nBlkXP, nBlkXP, dummyplane, yc_beg, yc_end);
+	}
+	if (mode==4 || mode==5)
+	{
+		upsizer->SimpleResizeDo(MaskOccY, nWidthP, nHeightP, nPitchY, smallMaskO, nBlkXP, nBlkXP, dummyplane, yl_beg, yl_end);
+		upsizerUV->SimpleResizeDo(MaskOccUV, nWidthPUV, nHeightPUV, nPitchUV, smallMaskO, nBlkXP, nBlkXP, dummyplane, yc_beg, yc_end);
+	}
+
+	const int      time256  = _time256;
+	const Time256ProviderCst	t256_prov_cst (time256, 0, 0);
+	const int      nBlkSizeYUV = nBlkSizeY / yRatioUV;
+	const int      by_stop  = std::min (by_end, nBlkY);
+
+	BYTE *         pDst [3];
+	const BYTE *   pRef [3];
+	const BYTE *   pSrc [3];
+	for (int p = 0; p < 3; ++p)
+	{
+		const int      y = (p == 0) ? yl_beg : yc_beg;
+		pDst [p] = _dst_ptr_arr [p] + y * _dst_pitch_arr [p];
+		pRef [p] = _ref_ptr_arr [p] + y * _ref_pitch_arr [p];
+		pSrc [p] = _src_ptr_arr [p] + y * _src_pitch_arr [p];
+	}
+
+	for (int by = by_beg; by < by_stop; ++by)
+	{
+		const int      yl = by * nBlkSizeY;
+		const int      yc = by * nBlkSizeYUV;
+		BYTE * pMaskFullYB = MaskFullYB + yl * nPitchY;
+		BYTE * pMaskFullYF = MaskFullYF + yl * nPitchY;
+		BYTE * pMaskFullUVB = MaskFullUVB + yc * nPitchUV;
+		BYTE * pMaskFullUVF = MaskFullUVF + yc * nPitchUV;
+		BYTE * pMaskOccY = MaskOccY + yl * nPitchY;
+		BYTE * pMaskOccUV = MaskOccUV + yc * nPitchUV;
+
+		// fetch image blocks
+		for (int bx = 0; bx < nBlkX; ++bx)
+		{
+			const int      i = by * nBlkX + bx;
+			const FakeBlockData &blockB = mvClipB.GetBlock(0, i);
+			const FakeBlockData &blockF = mvClipF.GetBlock(0, i);
+
+			// luma
+			ResultBlock(pDst[0], _dst_pitch_arr[0],
+			_plane_b_arr[0]->GetPointer(blockB.GetX() * nPel + ((blockB.GetMV().x*(256-time256))>>8), blockB.GetY() * nPel + ((blockB.GetMV().y*(256-time256))>>8)),
+			_plane_b_arr[0]->GetPitch(),
+			_plane_f_arr[0]->GetPointer(blockF.GetX() * nPel + ((blockF.GetMV().x*time256)>>8), blockF.GetY() * nPel + ((blockF.GetMV().y*time256)>>8)),
+			_plane_f_arr[0]->GetPitch(),
+			pRef[0], _ref_pitch_arr[0],
+			pSrc[0], _src_pitch_arr[0],
+			pMaskFullYB, nPitchY,
+			pMaskFullYF, pMaskOccY,
+			nBlkSizeX, nBlkSizeY, time256, mode);
+			// chroma u
+			if (nSuperModeYUV & UPLANE) ResultBlock(pDst[1], _dst_pitch_arr[1],
+			_plane_b_arr[1]->GetPointer((blockB.GetX() * nPel + ((blockB.GetMV().x*(256-time256))>>8))>>1, (blockB.GetY() * nPel + ((blockB.GetMV().y*(256-time256))>>8))/yRatioUV),
+			_plane_b_arr[1]->GetPitch(),
+			_plane_f_arr[1]->GetPointer((blockF.GetX() * nPel + ((blockF.GetMV().x*time256)>>8))>>1, (blockF.GetY() * nPel + ((blockF.GetMV().y*time256)>>8))/yRatioUV),
+			_plane_f_arr[1]->GetPitch(),
+			pRef[1], _ref_pitch_arr[1],
+			pSrc[1], _src_pitch_arr[1],
+			pMaskFullUVB, nPitchUV,
+			pMaskFullUVF, pMaskOccUV,
+			nBlkSizeX>>1, nBlkSizeYUV, time256, mode);
+			// chroma v
+			if (nSuperModeYUV & VPLANE) ResultBlock(pDst[2], _dst_pitch_arr[2],
+			_plane_b_arr[2]->GetPointer((blockB.GetX() * nPel + ((blockB.GetMV().x*(256-time256))>>8))>>1, (blockB.GetY() * nPel + ((blockB.GetMV().y*(256-time256))>>8))/yRatioUV),
+			_plane_b_arr[2]->GetPitch(),
+			_plane_f_arr[2]->GetPointer((blockF.GetX() * nPel + ((blockF.GetMV().x*time256)>>8))>>1, (blockF.GetY() * nPel + ((blockF.GetMV().y*time256)>>8))/yRatioUV),
+			_plane_f_arr[2]->GetPitch(),
+			pRef[2], _ref_pitch_arr[2],
+			pSrc[2], _src_pitch_arr[2],
+			pMaskFullUVB, nPitchUV,
+			pMaskFullUVF, pMaskOccUV,
+			nBlkSizeX>>1, nBlkSizeYUV, time256, mode);
+
+			// update pDsts
+			pDst[0] += nBlkSizeX;
+			pDst[1] += nBlkSizeX >> 1;
+			pDst[2] += nBlkSizeX >> 1;
+			pRef[0] += nBlkSizeX;
+			pRef[1] += nBlkSizeX >> 1;
+			pRef[2] += nBlkSizeX >> 1;
+			pSrc[0] += nBlkSizeX;
+			pSrc[1] += nBlkSizeX >> 1;
+			pSrc[2] += nBlkSizeX >> 1;
+			pMaskFullYB += nBlkSizeX;
+			pMaskFullUVB += nBlkSizeX>>1;
+			pMaskFullYF += nBlkSizeX;
+			pMaskFullUVF += nBlkSizeX>>1;
+			pMaskOccY += nBlkSizeX;
+			pMaskOccUV += nBlkSizeX>>1;
+		}
+
+		// blend rest right with time weight
+		Blend(pDst[0], pSrc[0], pRef[0], nBlkSizeY, nWidth-nBlkSizeX*nBlkX, _dst_pitch_arr[0], _src_pitch_arr[0], _ref_pitch_arr[0], t256_prov_cst, isse2);
+		if (nSuperModeYUV & UPLANE) Blend(pDst[1], pSrc[1], pRef[1], nBlkSizeYUV, nWidthUV-(nBlkSizeX>>1)*nBlkX, _dst_pitch_arr[1], _src_pitch_arr[1], _ref_pitch_arr[1], t256_prov_cst, isse2);
+		if (nSuperModeYUV & VPLANE) Blend(pDst[2], pSrc[2], pRef[2], nBlkSizeYUV, nWidthUV-(nBlkSizeX>>1)*nBlkX, _dst_pitch_arr[2], _src_pitch_arr[2], _ref_pitch_arr[2], t256_prov_cst, isse2);
+
+		for (int p = 0; p < 3; ++p)
+		{
+			const int      h = (p == 0) ? nBlkSizeY   : nBlkSizeYUV;
+			const int      w = (p == 0) ? nBlkSizeX*nBlkX : (nBlkSizeX>>1)*nBlkX;
+			pDst[p] += h * _dst_pitch_arr[p] - w;
+			pRef[p] += h * _ref_pitch_arr[p] - w;
+			pSrc[p] += h * _src_pitch_arr[p] - w;
+		}
+	}
+
+	if (last_flag)
+	{
+		// The slice may contain only padding rows, so restart from the bottom
+		// of the last complete block row.
+		for (int p = 0; p < 3; ++p)
+		{
+			const int      y = (p == 0) ? nBlkSizeY*nBlkY : nBlkSizeYUV*nBlkY;
+			pDst [p] = _dst_ptr_arr [p] + y * _dst_pitch_arr [p];
+			pRef [p] = _ref_ptr_arr [p] + y * _ref_pitch_arr [p];
+			pSrc [p] = _src_ptr_arr [p] + y * _src_pitch_arr [p];
+		}
+
+		// blend rest bottom with time weight
+		Blend(pDst[0], pSrc[0], pRef[0], nHeight-nBlkSizeY*nBlkY, nWidth, _dst_pitch_arr[0], _src_pitch_arr[0], _ref_pitch_arr[0], t256_prov_cst, isse2);
+		if (nSuperModeYUV & UPLANE) Blend(pDst[1], pSrc[1], pRef[1], nHeightUV-nBlkSizeYUV*nBlkY, nWidthUV, _dst_pitch_arr[1], _src_pitch_arr[1], _ref_pitch_arr[1], t256_prov_cst, isse2);
+		if (nSuperModeYUV & VPLANE) Blend(pDst[2], pSrc[2], pRef[2], nHeightUV-nBlkSizeYUV*nBlkY, nWidthUV, _dst_pitch_arr[2], _src_pitch_arr[2], _ref_pitch_arr[2], t256_prov_cst, isse2);
+	}
+}
@@ -2,6 +2,7 @@
 #define __MV_INTER__
 
 #include "CopyCode.h"
+#include "MTSlicer.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "SimpleResize.h"
@@ -10,6 +11,7 @@
 
 
 class MVGroupOfFrames;
+class MVPlane;
 
 /*! \brief Filter that change fps by blocks moving
  */
@@ -73,6 +75,23 @@ private:
 
    int nSuperHPad, nSuperVPad;
 
+	typedef	MTSlicer <MVBlockFps>	Slicer;
+
+	void           process_slice (Slicer::TaskData &td);
+
+	bool           _mt_flag;
+
+	// Processing variables
+	BYTE *         _dst_ptr_arr [3];
+	int            _dst_pitch_arr [3];
+	const BYTE *   _ref_ptr_arr [3];	// Top-left of the picture, padding skipped
+	const BYTE *   _src_ptr_arr [3];
+	int            _ref_pitch_arr [3];
+	int            _src_pitch_arr [3];
+	MVPlane *      _plane_b_arr [3];
+	MVPlane *      _plane_f_arr [3];
+	int            _time256;
+
 public:
 	MVBlockFps(
 		PClip _child, PClip _super, PClip _mvbw, PClip _mvfw,
@@ -18,6 +18,7 @@
 // http://www.gnu.org/copyleft/gpl.html .
 
 #include "MVClip.h"
+#include	"SuperFrameCache.h"
 
 #include	<cassert>
 
@@ -28,6 +29,7 @@ MVClip::MVClip(const PClip &vectors, int _nSCD1, int _nSCD2, IScriptEnvironment
 ,	_group_len (group_len)
 ,	_group_ofs (group_ofs)
 ,	_frame_update_flag (true)
+,	_vect_frame_ptr (0)
 {
 	vi.num_frames = (vi.num_frames - group_ofs + group_len - 1) / group_len;
 	vi.MulDivFPS (1, group_len);
@@ -64,6 +66,7 @@ MVClip::MVClip(const PClip &vectors, int _nSCD1, int _nSCD2, IScriptEnvironment
 
 MVClip::~MVClip()
 {
+	delete _vect_frame_ptr.swap (0);
 }
 
 
@@ -194,11 +197,16 @@ void MVClip::Update (::PVideoFrame &fn, ::IScriptEnvironment *env)
 	const int		hs_i32 = header_size / sizeof(int);
 	pMv       += hs_i32;									// go to data - v1.8.1
 	data_size -= hs_i32;
+
 	const bool		ok_flag = FakeGroupOfPlanes::Update(pMv, data_size);	// fixed a bug with lost frames
 	if (! ok_flag)
 	{
 		env->ThrowError("MVTools: vector clip is too small (corrupted?)");
 	}
+
+	// The planes keep pointers on the frame data
+	::PVideoFrame *	old_frame_ptr = _vect_frame_ptr.swap (new ::PVideoFrame (fn));
+	delete old_frame_ptr;
 }
 
 
@@ -234,7 +242,7 @@ void	MVClip::use_ref_frame (::PVideoFrame &ref, bool &usable_flag, ::PClip &supe
 	use_ref_frame (ref_index, usable_flag, super, n, env_ptr);
 	if (usable_flag)
 	{
-		ref = super->GetFrame (ref_index, env_ptr);
+		ref = SuperFrameCache::get_frame (super, ref_index, *env_ptr);
 	}
 }
 
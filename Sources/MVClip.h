@@ -27,6 +27,7 @@
 #include	"Windows.h"
 #include	"avisynth.h"
 
+#include	"conc/AtomicPtr.h"
 #include	"FakeGroupOfPlanes.h"
 #include	"FakePlaneOfBlocks.h"
 #include	"MVAnalysisData.h"
@@ -59,6 +60,13 @@ class MVClip
 	int				_group_ofs;
 	bool				_frame_update_flag;
 
+	// Frame containing the vectors of the last Update(). The blocks read
+	// them directly from it. Each Update() allocates its own reference and
+	// swaps it atomically, so concurrent calls never release the same
+	// reference twice. 0 before the first Update().
+	conc::AtomicPtr <PVideoFrame>
+						_vect_frame_ptr;
+
 public :
 	MVClip(const ::PClip &vectors, int nSCD1, int nSCD2, ::IScriptEnvironment *env, int group_len, int group_ofs);
    ~MVClip();
@@ -83,7 +91,7 @@ public :
    inline int GetVPadding() const { return nVPadding; }
    inline int GetThSCD1() const { return nSCD1; }
    inline int GetThSCD2() const { return nSCD2; }
-   inline const FakeBlockData& GetBlock(int nLevel, int nBlk) const { return GetPlane(nLevel)[nBlk]; }
+   inline FakeBlockData GetBlock(int nLevel, int nBlk) const { return GetPlane(nLevel).GetBlock(nBlk); }
    bool IsUsable(int nSCD1_, int nSCD2_) const;
    bool IsUsable() const { return IsUsable(nSCD1, nSCD2); }
    bool IsSceneChange() const { return FakeGroupOfPlanes::IsSceneChange(nSCD1, nSCD2); }
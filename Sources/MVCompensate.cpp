@@ -18,19 +18,23 @@
 // Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
 // http://www.gnu.org/copyleft/gpl.html .
 
+#include	"AvstpWrapper.h"
 #include	"ClipFnc.h"
 #include "commonfunctions.h"
+#include "FuncDispatch.h"
 #include "maskfun.h"
 #include "MVCompensate.h"
 #include "MVFrame.h"
 #include	"MVGroupOfFrames.h"
 #include "MVPlane.h"
-#include "profile.h"
+#include	"SuperFrameCache.h"
 #include "SuperParams64Bits.h"
 #include "Time256ProviderCst.h"
 
 #include	<mmintrin.h>
 
+#include	<algorithm>
+
 
 
 MVCompensate::MVCompensate(
@@ -50,6 +54,8 @@ MVCompensate::MVCompensate(
 ,	_mt_flag (mt_flag)
 ,	ySubUV ((yRatioUV == 2) ? 1 : 0)
 ,	_boundary_cnt_arr ()
+,	_task_arr ()
+,	_plane_graph ()
 {
 	if (trad < 0)
 	{
@@ -111,173 +117,17 @@ MVCompensate::MVCompensate(
 		c_info._thsad = ClipFnc::interpolate_thsad (thsadn, thsadn2, d, _trad);
 	}
 
-	if (isse2)
+	const FuncDispatch::Tier	tier = FuncDispatch::select_tier (isse2);
+	FuncDispatch::BlockFnc	fnc;
+	if (FuncDispatch::find (fnc, nBlkSizeX, nBlkSizeY, tier))
 	{
-		switch (nBlkSizeX)
-		{
-		case 32:
-			if (nBlkSizeY==16) {
-				BLITLUMA = Copy32x16_sse2;
-				OVERSLUMA = Overlaps32x16_sse2;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy16x8_sse2;
-					OVERSCHROMA = Overlaps16x8_sse2;
-				} else {
-					BLITCHROMA = Copy16x16_sse2;
-					OVERSCHROMA = Overlaps16x16_sse2;
-				}
-			} else if (nBlkSizeY==32) {
-				BLITLUMA = Copy32x32_sse2;
-				OVERSLUMA = Overlaps32x32_sse2;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy16x16_sse2;
-					OVERSCHROMA = Overlaps16x16_sse2;
-				} else {
-					BLITCHROMA = Copy16x32_sse2;
-					OVERSCHROMA = Overlaps16x32_sse2;
-				}
-			} break;
-		case 16:
-			if (nBlkSizeY==16) {
-				BLITLUMA = Copy16x16_sse2;
-				OVERSLUMA = Overlaps16x16_sse2;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy8x8_sse2;
-					OVERSCHROMA = Overlaps8x8_sse2;
-				} else {
-					BLITCHROMA = Copy8x16_sse2;
-					OVERSCHROMA = Overlaps8x16_sse2;
-				}
-			} else if (nBlkSizeY==8) {
-				BLITLUMA = Copy16x8_sse2;
-				OVERSLUMA = Overlaps16x8_sse2;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy8x4_sse2;
-					OVERSCHROMA = Overlaps8x4_sse2;
-				} else {
-					BLITCHROMA = Copy8x8_sse2;
-					OVERSCHROMA = Overlaps8x8_sse2;
-				}
-			} else if (nBlkSizeY==2) {
-				BLITLUMA = Copy16x2_sse2;
-				OVERSLUMA = Overlaps16x2_sse2;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy8x1_sse2;
-					OVERSCHROMA = Overlaps8x1_sse2;
-				} else {
-					BLITCHROMA = Copy8x2_sse2;
-					OVERSCHROMA = Overlaps8x2_sse2;
-				}
-			}
-			break;
-		case 4:
-			BLITLUMA = Copy4x4_sse2;
-			OVERSLUMA = Overlaps4x4_sse2;
-			if (yRatioUV==2) {
-				BLITCHROMA = Copy2x2_sse2;
-				OVERSCHROMA = Overlaps_C<2,2>;
-			} else {
-				BLITCHROMA = Copy2x4_sse2;
-				OVERSCHROMA = Overlaps_C<2,4>;
-			}
-			break;
-		case 8:
-		default:
-			if (nBlkSizeY==8) {
-				BLITLUMA = Copy8x8_sse2;
-				OVERSLUMA = Overlaps8x8_sse2;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy4x4_sse2;
-					OVERSCHROMA = Overlaps4x4_sse2;
-				} else {
-					BLITCHROMA = Copy4x8_sse2;
-					OVERSCHROMA = Overlaps4x8_sse2;
-				}
-			} else if (nBlkSizeY==4) { // 8x4
-				BLITLUMA = Copy8x4_sse2;
-				OVERSLUMA = Overlaps8x4_sse2;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy4x2_sse2; // idem
-					OVERSCHROMA = Overlaps4x2_sse2;
-				} else {
-					BLITCHROMA = Copy4x4_sse2; // idem
-					OVERSCHROMA = Overlaps4x4_sse2;
-				}
-			}
-		}
+		BLITLUMA = fnc._copy_ptr;
+		OVERSLUMA = fnc._overlaps_ptr;
 	}
-
-	else // pure C, no isse2 opimization ("mmx" version could be used, but it's more like a debugging version)
+	if (FuncDispatch::find (fnc, nBlkSizeX / 2, nBlkSizeY / yRatioUV, tier))
 	{
-		switch (nBlkSizeX)
-		{
-		case 32:
-			if (nBlkSizeY==16) {
-				BLITLUMA = Copy_C<32,16>;         OVERSLUMA   = Overlaps_C<32,16>;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy_C<16,8>;	    OVERSCHROMA = Overlaps_C<16,8>;
-				} else {
-					BLITCHROMA = Copy_C<16>;       OVERSCHROMA = Overlaps_C<16,16>;
-				}
-				} else if (nBlkSizeY==32) {
-				BLITLUMA = Copy_C<32,32>;         OVERSLUMA   = Overlaps_C<32,32>;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy_C<16,16>;    OVERSCHROMA = Overlaps_C<16,16>;
-				} else {
-					BLITCHROMA = Copy_C<16,32>;	 OVERSCHROMA = Overlaps_C<16,32>;
-				}
-			} break;
-		case 16:
-			if (nBlkSizeY==16) {
-				BLITLUMA = Copy_C<16>;            OVERSLUMA   = Overlaps_C<16,16>;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy_C<8>;	       OVERSCHROMA = Overlaps_C<8,8>;
-				} else {
-					BLITCHROMA = Copy_C<8,16>;	    OVERSCHROMA = Overlaps_C<8,16>;
-				}
-			} else if (nBlkSizeY==8) {
-				BLITLUMA = Copy_C<16,8>;          OVERSLUMA   = Overlaps_C<16,8>;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy_C<8,4>;	    OVERSCHROMA = Overlaps_C<8,4>;
-				} else {
-					BLITCHROMA = Copy_C<8>;	       OVERSCHROMA = Overlaps_C<8,8>;
-				}
-			} else if (nBlkSizeY==2) {
-				BLITLUMA = Copy_C<16,2>;          OVERSLUMA   = Overlaps_C<16,2>;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy_C<8,1>;	    OVERSCHROMA = Overlaps_C<8,1>;
-				} else {
-					BLITCHROMA = Copy_C<8,2>;	    OVERSCHROMA = Overlaps_C<8,2>;
-				}
-			}
-			break;
-		case 4:
-			BLITLUMA = Copy_C<4>;                OVERSLUMA   = Overlaps_C<4,4>;
-			if (yRatioUV==2) {
-				BLITCHROMA = Copy_C<2>;           OVERSCHROMA = Overlaps_C<2,2>;
-			} else {
-				BLITCHROMA = Copy_C<2,4>;         OVERSCHROMA = Overlaps_C<2,4>;
-			}
-			break;
-		case 8:
-		default:
-			if (nBlkSizeY==8) {
-				BLITLUMA = Copy_C<8>;             OVERSLUMA   = Overlaps_C<8,8>;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy_C<4>;	       OVERSCHROMA = Overlaps_C<4,4>;
-				}
-				else {
-					BLITCHROMA = Copy_C<4,8>;	    OVERSCHROMA = Overlaps_C<4,8>;
-				}
-			} else if (nBlkSizeY==4) { // 8x4
-				BLITLUMA = Copy_C<8,4>;           OVERSLUMA   = Overlaps_C<8,4>;
-				if (yRatioUV==2) {
-					BLITCHROMA = Copy_C<4,2>;	    OVERSCHROMA = Overlaps_C<4,2>;
-				} else {
-					BLITCHROMA = Copy_C<4>;	       OVERSCHROMA = Overlaps_C<4,4>;
-				}
-			}
-		}
+		BLITCHROMA = fnc._copy_ptr;
+		OVERSCHROMA = fnc._overlaps_ptr;
 	}
 
 
@@ -316,15 +166,23 @@ MVCompensate::MVCompensate(
 	{
 		OverWins = new OverlapWindows(nBlkSizeX, nBlkSizeY, nOverlapX, nOverlapY);
 		OverWinsUV = new OverlapWindows(nBlkSizeX/2, nBlkSizeY/yRatioUV, nOverlapX/2, nOverlapY/yRatioUV);
-		DstShort = new unsigned short[dstShortPitch*nHeight];
-		DstShortU = new unsigned short[dstShortPitchUV*nHeight];
-		DstShortV = new unsigned short[dstShortPitchUV*nHeight];
+		DstShort[0] = new unsigned short[dstShortPitch*nHeight];
+		DstShort[1] = new unsigned short[dstShortPitchUV*nHeight];
+		DstShort[2] = new unsigned short[dstShortPitchUV*nHeight];
+		memset (DstShort[0], 0, dstShortPitch*nHeight*sizeof(DstShort[0][0]));
+		memset (DstShort[1], 0, dstShortPitchUV*nHeight*sizeof(DstShort[1][0]));
+		memset (DstShort[2], 0, dstShortPitchUV*nHeight*sizeof(DstShort[2][0]));
 	}
 	if (nOverlapY > 0)
 	{
-		_boundary_cnt_arr.resize (nBlkY);
+		for (int p = 0; p < 3; ++p)
+		{
+			_boundary_cnt_arr [p].resize (nBlkY);
+		}
 	}
 
+	build_plane_graph (nSuperModeYUV);
+
 	if (recursion>0)
 	{
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
@@ -347,10 +205,13 @@ MVCompensate::MVCompensate(
 		}
 	}
 
+	SuperFrameCache::add_client (super);
 }
 
 MVCompensate::~MVCompensate()
 {
+	SuperFrameCache::remove_client (super);
+
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2  && !planar)
 	{
 		delete DstPlanes;
@@ -359,9 +220,9 @@ MVCompensate::~MVCompensate()
 	{
 		delete OverWins;
 		delete OverWinsUV;
-		delete [] DstShort;
-		delete [] DstShortU;
-		delete [] DstShortV;
+		delete [] DstShort[0];
+		delete [] DstShort[1];
+		delete [] DstShort[2];
 	}
 	delete pRefGOF; // v2.0
 	delete pSrcGOF;
@@ -393,9 +254,6 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 	_mv_clip_ptr = info._clip_sptr.get ();
 	_thsad       = info._thsad;
 
-	int nWidth_B = nBlkX*(nBlkSizeX - nOverlapX) + nOverlapX;
-	int nHeight_B = nBlkY*(nBlkSizeY - nOverlapY) + nOverlapY;
-
 	const BYTE *pRef[3];
 	int nRefPitches[3];
 	unsigned char *pDstYUY2;
@@ -412,7 +270,7 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 	_mv_clip_ptr->Update(mvn, env_ptr);
 	mvn = 0; // free
 
-	PVideoFrame	src = super->GetFrame(nsrc, env_ptr);
+	PVideoFrame	src = SuperFrameCache::get_frame (super, nsrc, *env_ptr);
 	PVideoFrame dst = env_ptr->NewVideoFrame(vi);
 	bool				usable_flag = _mv_clip_ptr->IsUsable();
 	int				nref;
@@ -466,7 +324,7 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 			nSrcPitches[2] = VPITCH(src);
 		}
 
-		PVideoFrame ref = super->GetFrame(nref, env_ptr);
+		PVideoFrame ref = SuperFrameCache::get_frame (super, nref, *env_ptr);
 
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
 		{
@@ -512,84 +370,34 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 
 		fieldShift = ClipFnc::compute_fieldshift (child, fields, nPel, nsrc, nref);
 
-		PROFILE_START(MOTION_PROFILE_COMPENSATION);
-
-		Slicer         slicer (_mt_flag);
-
-		// No overlap
-		if (nOverlapX==0 && nOverlapY==0)
+		// Source of the non-covered regions
+		for (int p = 0; p < 3; ++p)
 		{
-			slicer.start (nBlkY, *this, &MVCompensate::compensate_slice_normal);
-			slicer.wait ();
+			const int      xlog = (p == 0) ? 0 : 1;
+			const int      ylog = (p == 0) ? 0 : ySubUV;
+			nPadSrcPitches[p] = (scBehavior) ? nSrcPitches[p] : nRefPitches[p];
+			pPadSrc[p]        = (scBehavior) ? pSrc[p] : pRef[p];
+			pPadSrc[p]       += (nHPadding >> xlog) + (nVPadding >> ylog) * nPadSrcPitches[p];
 		}
 
-		// Overlap
-		else
+		// All the slices of all the planes are run at once. Each plane is
+		// finalised as soon as its own slices are done, so there is a single
+		// synchronisation point for the whole frame.
+		if (nOverlapY > 0)
 		{
-			if (nOverlapY > 0)
+			for (int p = 0; p < 3; ++p)
 			{
 				memset (
-					&_boundary_cnt_arr [0],
+					&_boundary_cnt_arr [p] [0],
 					0,
-					_boundary_cnt_arr.size () * sizeof (_boundary_cnt_arr [0])
+					_boundary_cnt_arr [p].size () * sizeof (_boundary_cnt_arr [p] [0])
 				);
 			}
-
-			MemZoneSet(reinterpret_cast<unsigned char*>(DstShort), 0, nWidth_B*2, nHeight_B, 0, 0, dstShortPitch*2);
-			if (pPlanes[1])
-			{
-				MemZoneSet(reinterpret_cast<unsigned char*>(DstShortU), 0, nWidth_B, nHeight_B>>ySubUV, 0, 0, dstShortPitchUV*2);
-			}
-			if (pPlanes[2])
-			{
-				MemZoneSet(reinterpret_cast<unsigned char*>(DstShortV), 0, nWidth_B, nHeight_B>>ySubUV, 0, 0, dstShortPitchUV*2);
-			}
-
-			slicer.start (nBlkY, *this, &MVCompensate::compensate_slice_overlap, 2);
-			slicer.wait ();
-
-			Short2Bytes(pDst[0], nDstPitches[0], DstShort, dstShortPitch, nWidth_B, nHeight_B);
-			if(pPlanes[1])
-			{
-				Short2Bytes(pDst[1], nDstPitches[1], DstShortU, dstShortPitchUV, nWidth_B>>1, nHeight_B>>ySubUV);
-			}
-			if(pPlanes[2])
-			{
-				Short2Bytes(pDst[2], nDstPitches[2], DstShortV, dstShortPitchUV, nWidth_B>>1, nHeight_B>>ySubUV);
-			}
 		}
 
-		// padding of the non-covered regions
-		const BYTE **  pSrcMapped     = (scBehavior) ? pSrc        : pRef;
-		int *          pPitchesMapped = (scBehavior) ? nSrcPitches : nRefPitches;
-
-		if (nWidth_B < nWidth) // Right padding
-		{
-			BitBlt(pDst[0] + nWidth_B, nDstPitches[0], pSrcMapped[0] + nWidth_B + nHPadding + nVPadding * pPitchesMapped[0], pPitchesMapped[0], nWidth-nWidth_B, nHeight_B, isse2);
-			if(pPlanes[1]) // chroma u
-			{
-				BitBlt(pDst[1] + (nWidth_B>>1), nDstPitches[1], pSrcMapped[1] + (nWidth_B>>1) + (nHPadding>>1) + (nVPadding>>ySubUV) * pPitchesMapped[1], pPitchesMapped[1], (nWidth-nWidth_B)>>1, nHeight_B>>ySubUV, isse2);
-			}
-			if(pPlanes[2])	// chroma v
-			{
-				BitBlt(pDst[2] + (nWidth_B>>1), nDstPitches[2], pSrcMapped[2] + (nWidth_B>>1) + (nHPadding>>1) + (nVPadding>>ySubUV) * pPitchesMapped[2], pPitchesMapped[2], (nWidth-nWidth_B)>>1, nHeight_B>>ySubUV, isse2);
-			}
-		}
-
-		if (nHeight_B < nHeight) // Bottom padding
-		{
-			BitBlt(pDst[0] + nHeight_B*nDstPitches[0], nDstPitches[0], pSrcMapped[0] + nHPadding + (nHeight_B + nVPadding) * pPitchesMapped[0], pPitchesMapped[0], nWidth, nHeight-nHeight_B, isse2);
-			if(pPlanes[1])	// chroma u
-			{
-				BitBlt(pDst[1] + (nHeight_B>>ySubUV)*nDstPitches[1], nDstPitches[1], pSrcMapped[1] + nHPadding + ((nHeight_B + nVPadding)>>ySubUV) * pPitchesMapped[1], pPitchesMapped[1], nWidth>>1, (nHeight-nHeight_B)>>ySubUV, isse2);
-			}
-			if(pPlanes[2])	// chroma v
-			{
-				BitBlt(pDst[2] + (nHeight_B>>ySubUV)*nDstPitches[2], nDstPitches[2], pSrcMapped[2] + nHPadding + ((nHeight_B + nVPadding)>>ySubUV) * pPitchesMapped[2], pPitchesMapped[2], nWidth>>1, (nHeight-nHeight_B)>>ySubUV, isse2);
-			}
-		}
-
-		PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
+		Scheduler      sched (_mt_flag);
+		sched.start (_plane_graph, *this, &MVCompensate::process_task);
+		sched.wait ();
 
 		// if we're in in-loop recursive mode, we copy the frame
 		if ( recursion>0 )
@@ -613,11 +421,11 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 	{
 		if ( !scBehavior && ( nref < vi.num_frames ) && ( nref >= 0 ))
 		{
-			src = super->GetFrame (nref, env_ptr);
+			src = SuperFrameCache::get_frame (super, nref, *env_ptr);
 		}
 		else
 		{
-			src = super->GetFrame (nsrc, env_ptr);
+			src = SuperFrameCache::get_frame (super, nsrc, *env_ptr);
 		}
 
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
@@ -696,23 +504,91 @@ PVideoFrame __stdcall MVCompensate::GetFrame(int n, IScriptEnvironment* env_ptr)
 
 
 
-void	MVCompensate::compensate_slice_normal (Slicer::TaskData &td)
+// Cuts each plane in slices of block rows. The slices depend only on the
+// root, and the finalisation task of a plane depends on all its slices.
+void	MVCompensate::build_plane_graph (int plane_mask)
+{
+	const int		min_slice_h = (nOverlapX > 0 || nOverlapY > 0) ? 2 : 1;
+	int				nbr_slices  =
+		  (_mt_flag)
+		? AvstpWrapper::use_instance ().get_nbr_threads ()
+		: 1;
+	nbr_slices = std::min (nbr_slices, int (MAX_SLICES_PER_PLANE));
+	nbr_slices = std::min (nbr_slices, nBlkY / min_slice_h);
+	nbr_slices = std::max (nbr_slices, 1);
+
+	static const int	mask_arr [3] = { YPLANE, UPLANE, VPLANE };
+
+	_task_arr.clear ();
+	_plane_graph.clear ();
+	for (int p = 0; p < 3; ++p)
+	{
+		if (p == 0 || (plane_mask & mask_arr [p]) != 0)
+		{
+			TaskInfo       info;
+			info._plane       = p;
+			info._finish_flag = false;
+			const int      slice_beg = int (_task_arr.size ()) + 1;
+			for (int s = 0; s < nbr_slices; ++s)
+			{
+				info._y_beg =  s      * nBlkY / nbr_slices;
+				info._y_end = (s + 1) * nBlkY / nbr_slices;
+				_task_arr.push_back (info);
+				_plane_graph.add_dep (0, int (_task_arr.size ()));
+			}
+
+			info._finish_flag = true;
+			info._y_beg       = 0;
+			info._y_end       = nBlkY;
+			_task_arr.push_back (info);
+			const int      finish_index = int (_task_arr.size ());
+			for (int s = 0; s < nbr_slices; ++s)
+			{
+				_plane_graph.add_dep (slice_beg + s, finish_index);
+			}
+		}
+	}
+}
+
+
+
+void	MVCompensate::process_task (Scheduler::TaskData &td)
 {
 	assert (&td != 0);
 
-	const int		rowsize_l = nBlkSizeY;
-	const int		rowsize_c = rowsize_l >> ySubUV;
+	// Root task: nothing to do
+	if (td._task_index == 0)
+	{
+		return;
+	}
+
+	const TaskInfo &  info = _task_arr [td._task_index - 1];
+	if (info._finish_flag)
+	{
+		finish_plane (info._plane);
+	}
+	else if (nOverlapX == 0 && nOverlapY == 0)
+	{
+		compensate_slice_normal (info._plane, info._y_beg, info._y_end);
+	}
+	else
+	{
+		compensate_slice_overlap (info._plane, info._y_beg, info._y_end);
+	}
+}
 
-	BYTE *         pDstCur[3];
-	const BYTE *   pSrcCur[3];
-	pDstCur[0] = pDst[0] + td._y_beg * rowsize_l * (nDstPitches[0]);
-	pDstCur[1] = pDst[1] + td._y_beg * rowsize_c * (nDstPitches[1]);
-	pDstCur[2] = pDst[2] + td._y_beg * rowsize_c * (nDstPitches[2]);
-	pSrcCur[0] = pSrc[0] + td._y_beg * rowsize_l * (nSrcPitches[0]);
-	pSrcCur[1] = pSrc[1] + td._y_beg * rowsize_c * (nSrcPitches[1]);
-	pSrcCur[2] = pSrc[2] + td._y_beg * rowsize_c * (nSrcPitches[2]);
 
-	for (int by = td._y_beg; by < td._y_end; ++by)
+
+void	MVCompensate::compensate_slice_normal (int p, int y_beg, int y_end)
+{
+	const int		xlog    = (p == 0) ? 0 : 1;
+	const int		ylog    = (p == 0) ? 0 : ySubUV;
+	const int		rowsize = nBlkSizeY >> ylog;
+	COPYFunction * blit_ptr = (p == 0) ? BLITLUMA : BLITCHROMA;
+
+	BYTE *         pDstCur = pDst[p] + y_beg * rowsize * nDstPitches[p];
+
+	for (int by = y_beg; by < y_end; ++by)
 	{
 		int xx = 0;
 		for (int bx = 0; bx < nBlkX; ++bx)
@@ -723,133 +599,85 @@ void	MVCompensate::compensate_slice_normal (Slicer::TaskData &td)
 			const int      bly = block.GetY() * nPel + block.GetMV().y + fieldShift;
 			if (block.GetSAD() < _thsad)
 			{
-				// luma
-				BLITLUMA (
-					pDstCur[0] + xx, nDstPitches[0],
-					pPlanes[0]->GetPointer(blx, bly), pPlanes[0]->GetPitch()
+				blit_ptr (
+					pDstCur + (xx>>xlog), nDstPitches[p],
+					pPlanes[p]->GetPointer(blx>>xlog, bly>>ylog), pPlanes[p]->GetPitch()
 				);
-				// chroma u
-				if (pPlanes[1])
-				{
-					BLITCHROMA (
-						pDstCur[1] + (xx>>1), nDstPitches[1],
-						pPlanes[1]->GetPointer(blx>>1, bly>>ySubUV), pPlanes[1]->GetPitch()
-					);
-				}
-				// chroma v
-				if (pPlanes[2])
-				{
-					BLITCHROMA (
-						pDstCur[2] + (xx>>1), nDstPitches[2],
-						pPlanes[2]->GetPointer(blx>>1, bly>>ySubUV), pPlanes[2]->GetPitch()
-					);
-				}
 			}
 			else
 			{
 				int blxsrc = bx * nBlkSizeX * nPel;
 				int blysrc = by * nBlkSizeY * nPel + fieldShift;
 
-				BLITLUMA (
-					pDstCur[0] + xx, nDstPitches[0],
-					pSrcPlanes[0]->GetPointer(blxsrc, blysrc), pSrcPlanes[0]->GetPitch()
+				blit_ptr (
+					pDstCur + (xx>>xlog), nDstPitches[p],
+					pSrcPlanes[p]->GetPointer(blxsrc>>xlog, blysrc>>ylog), pSrcPlanes[p]->GetPitch()
 				);
-				// chroma u
-				if (pSrcPlanes[1])
-				{
-					BLITCHROMA (
-						pDstCur[1] + (xx>>1), nDstPitches[1],
-						pSrcPlanes[1]->GetPointer(blxsrc>>1, blysrc>>ySubUV), pSrcPlanes[1]->GetPitch()
-					);
-				}
-				// chroma v
-				if (pSrcPlanes[2])
-				{
-					BLITCHROMA (
-						pDstCur[2] + (xx>>1), nDstPitches[2],
-						pSrcPlanes[2]->GetPointer(blxsrc>>1, blysrc>>ySubUV), pSrcPlanes[2]->GetPitch()
-					);
-				}
 			}
 
 			xx += nBlkSizeX;
 		}	// for bx
 
-		pDstCur[0] += rowsize_l * nDstPitches[0];
-		pDstCur[1] += rowsize_c * nDstPitches[1];
-		pDstCur[2] += rowsize_c * nDstPitches[2];
-		pSrcCur[0] += rowsize_l * nSrcPitches[0];
-		pSrcCur[1] += rowsize_c * nSrcPitches[1];
-		pSrcCur[2] += rowsize_c * nSrcPitches[2];
+		pDstCur += rowsize * nDstPitches[p];
 	}	// for by
 }
 
 
 
 
-void	MVCompensate::compensate_slice_overlap (Slicer::TaskData &td)
+void	MVCompensate::compensate_slice_overlap (int p, int y_beg, int y_end)
 {
-	assert (&td != 0);
-
 	if (   nOverlapY == 0
-	    || (td._y_beg == 0 && td._y_end == nBlkY))
+	    || (y_beg == 0 && y_end == nBlkY))
 	{
-		compensate_slice_overlap (td._y_beg, td._y_end);
+		compensate_rows_overlap (p, y_beg, y_end);
 	}
 
 	else
 	{
-		assert (td._y_end - td._y_beg >= 2);
+		assert (y_end - y_beg >= 2);
 
-		compensate_slice_overlap (td._y_beg, td._y_end - 1);
+		compensate_rows_overlap (p, y_beg, y_end - 1);
 
 		const conc::AioAdd <int>	inc_ftor (+1);
 
 		const int		cnt_top = conc::AtomicIntOp::exec_new (
-			_boundary_cnt_arr [td._y_beg],
+			_boundary_cnt_arr [p] [y_beg],
 			inc_ftor
 		);
-		if (td._y_beg > 0 && cnt_top == 2)
+		if (y_beg > 0 && cnt_top == 2)
 		{
-			compensate_slice_overlap (td._y_beg - 1, td._y_beg);
+			compensate_rows_overlap (p, y_beg - 1, y_beg);
 		}
 
 		int				cnt_bot = 2;
-		if (td._y_end < nBlkY)
+		if (y_end < nBlkY)
 		{
 			cnt_bot = conc::AtomicIntOp::exec_new (
-				_boundary_cnt_arr [td._y_end],
+				_boundary_cnt_arr [p] [y_end],
 				inc_ftor
 			);
 		}
 		if (cnt_bot == 2)
 		{
-			compensate_slice_overlap (td._y_end - 1, td._y_end);
+			compensate_rows_overlap (p, y_end - 1, y_end);
 		}
 	}
 }
 
 
 
-void	MVCompensate::compensate_slice_overlap (int y_beg, int y_end)
+void	MVCompensate::compensate_rows_overlap (int p, int y_beg, int y_end)
 {
-	const int		rowsize_l = nBlkSizeY - nOverlapY;
-	const int		rowsize_c = rowsize_l >> ySubUV;
-
-	unsigned short *pDstShort;
-	unsigned short *pDstShortU;
-	unsigned short *pDstShortV;
-	BYTE *         pDstCur[3];
-	const BYTE *   pSrcCur[3];
-	pDstShort  = DstShort  + y_beg * rowsize_l * dstShortPitch;
-	pDstShortU = DstShortU + y_beg * rowsize_c * dstShortPitchUV;
-	pDstShortV = DstShortV + y_beg * rowsize_c * dstShortPitchUV;
-	pDstCur[0] = pDst[0]   + y_beg * rowsize_l * nDstPitches[0];
-	pDstCur[1] = pDst[1]   + y_beg * rowsize_c * nDstPitches[1];
-	pDstCur[2] = pDst[2]   + y_beg * rowsize_c * nDstPitches[2];
-	pSrcCur[0] = pSrc[0]   + y_beg * rowsize_l * nSrcPitches[0];
-	pSrcCur[1] = pSrc[1]   + y_beg * rowsize_c * nSrcPitches[1];
-	pSrcCur[2] = pSrc[2]   + y_beg * rowsize_c * nSrcPitches[2];
+	const int		xlog    = (p == 0) ? 0 : 1;
+	const int		ylog    = (p == 0) ? 0 : ySubUV;
+	const int		rowsize = (nBlkSizeY - nOverlapY) >> ylog;
+	const int		pitch   = (p == 0) ? dstShortPitch : dstShortPitchUV;
+	OverlapsFunction *	overs_ptr = (p == 0) ? OVERSLUMA : OVERSCHROMA;
+	OverlapWindows *	wins_ptr  = (p == 0) ? OverWins  : OverWinsUV;
+	const int		blk_w   = nBlkSizeX >> xlog;
+
+	unsigned short *pDstShort = DstShort[p] + y_beg * rowsize * pitch;
 
 	for (int by = y_beg; by < y_end; ++by)
 	{
@@ -859,8 +687,7 @@ void	MVCompensate::compensate_slice_overlap (int y_beg, int y_end)
 		{
 			// select window
 			int            wbx = (bx + nBlkX - 3) / (nBlkX - 2);
-			short *        winOver   = OverWins->GetWindow(wby + wbx);
-			short *        winOverUV = OverWinsUV->GetWindow(wby + wbx);
+			short *        winOver = wins_ptr->GetWindow(wby + wbx);
 
 			int            i = by*nBlkX + bx;
 			const FakeBlockData & block = _mv_clip_ptr->GetBlock(0, i);
@@ -870,30 +697,11 @@ void	MVCompensate::compensate_slice_overlap (int y_beg, int y_end)
 
 			if (block.GetSAD() < _thsad)
 			{
-				// luma
-				OVERSLUMA (
-					pDstShort + xx, dstShortPitch,
-					pPlanes[0]->GetPointer(blx, bly), pPlanes[0]->GetPitch(),
-					winOver, nBlkSizeX
+				overs_ptr (
+					pDstShort + (xx>>xlog), pitch,
+					pPlanes[p]->GetPointer(blx>>xlog, bly>>ylog), pPlanes[p]->GetPitch(),
+					winOver, blk_w
 				);
-				// chroma u
-				if (pPlanes[1])
-				{
-					OVERSCHROMA (
-						pDstShortU + (xx>>1), dstShortPitchUV,
-						pPlanes[1]->GetPointer(blx>>1, bly>>ySubUV), pPlanes[1]->GetPitch(),
-						winOverUV, nBlkSizeX/2
-					);
-				}
-				// chroma v
-				if (pPlanes[2])
-				{
-					OVERSCHROMA (
-						pDstShortV + (xx>>1), dstShortPitchUV,
-						pPlanes[2]->GetPointer(blx>>1, bly>>ySubUV), pPlanes[2]->GetPitch(),
-						winOverUV, nBlkSizeX/2
-					);
-				}
 			}
 
 			// bad compensation, use src
@@ -902,48 +710,53 @@ void	MVCompensate::compensate_slice_overlap (int y_beg, int y_end)
 				int blxsrc = bx * (nBlkSizeX - nOverlapX) * nPel;
 				int blysrc = by * (nBlkSizeY - nOverlapY) * nPel + fieldShift;
 
-				OVERSLUMA (
-					pDstShort + xx, dstShortPitch,
-					pSrcPlanes[0]->GetPointer(blxsrc, blysrc), pSrcPlanes[0]->GetPitch(),
-					winOver, nBlkSizeX
+				overs_ptr (
+					pDstShort + (xx>>xlog), pitch,
+					pSrcPlanes[p]->GetPointer(blxsrc>>xlog, blysrc>>ylog), pSrcPlanes[p]->GetPitch(),
+					winOver, blk_w
 				);
-				// chroma u
-				if (pSrcPlanes[1])
-				{
-					OVERSCHROMA (
-						pDstShortU + (xx>>1), dstShortPitchUV,
-						pSrcPlanes[1]->GetPointer(blxsrc>>1, blysrc>>ySubUV), pSrcPlanes[1]->GetPitch(),
-						winOverUV, nBlkSizeX/2
-					);
-				}
-				// chroma v
-				if (pSrcPlanes[2])
-				{
-					OVERSCHROMA (
-						pDstShortV + (xx>>1), dstShortPitchUV,
-						pSrcPlanes[2]->GetPointer(blxsrc>>1, blysrc>>ySubUV), pSrcPlanes[2]->GetPitch(),
-						winOverUV, nBlkSizeX/2
-					);
-				}
 			}
 
 			xx += (nBlkSizeX - nOverlapX);
 		}	// for bx
 
-		pDstShort  += rowsize_l * dstShortPitch;
-		pDstShortU += rowsize_c * dstShortPitchUV;
-		pDstShortV += rowsize_c * dstShortPitchUV;
-		pDstCur[0] += rowsize_l * nDstPitches[0];
-		pDstCur[1] += rowsize_c * nDstPitches[1];
-		pDstCur[2] += rowsize_c * nDstPitches[2];
-		pSrcCur[0] += rowsize_l * nSrcPitches[0];
-		pSrcCur[1] += rowsize_c * nSrcPitches[1];
-		pSrcCur[2] += rowsize_c * nSrcPitches[2];
+		pDstShort += rowsize * pitch;
 	}	// for by
 }
 
 
 
+// Converts the accumulated plane (overlap mode) and clears the accumulator
+// for the next frame, then fills the uncovered regions.
+void	MVCompensate::finish_plane (int p)
+{
+	const int		xlog      = (p == 0) ? 0 : 1;
+	const int		ylog      = (p == 0) ? 0 : ySubUV;
+	const int		nWidth_B  = nBlkX*(nBlkSizeX - nOverlapX) + nOverlapX;
+	const int		nHeight_B = nBlkY*(nBlkSizeY - nOverlapY) + nOverlapY;
+	const int		w_b       = nWidth_B  >> xlog;
+	const int		h_b       = nHeight_B >> ylog;
+
+	if (nOverlapX > 0 || nOverlapY > 0)
+	{
+		const int		pitch = (p == 0) ? dstShortPitch : dstShortPitchUV;
+		Short2Bytes(pDst[p], nDstPitches[p], DstShort[p], pitch, w_b, h_b);
+		MemZoneSet(reinterpret_cast<unsigned char*>(DstShort[p]), 0, w_b*2, h_b, 0, 0, pitch*2);
+	}
+
+	if (nWidth_B < nWidth) // Right padding
+	{
+		BitBlt(pDst[p] + w_b, nDstPitches[p], pPadSrc[p] + w_b, nPadSrcPitches[p], (nWidth-nWidth_B)>>xlog, h_b, isse2);
+	}
+
+	if (nHeight_B < nHeight) // Bottom padding
+	{
+		BitBlt(pDst[p] + h_b*nDstPitches[p], nDstPitches[p], pPadSrc[p] + h_b*nPadSrcPitches[p], nPadSrcPitches[p], nWidth>>xlog, (nHeight-nHeight_B)>>ylog, isse2);
+	}
+}
+
+
+
 // Returns false if center frame should be used.
 bool	MVCompensate::compute_src_frame (int &nsrc, int &nvec, int &vindex, int n) const
 {
@@ -3,7 +3,8 @@
 
 #include	"conc/AtomicInt.h"
 #include "CopyCode.h"
-#include	"MTSlicer.h"
+#include	"MTFlowGraphSched.h"
+#include	"MTFlowGraphSimple.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "overlap.h"
@@ -46,11 +47,28 @@ private:
 	};
 	typedef	std::vector <MvClipInfo>	MvClipArray;
 
-	typedef	MTSlicer <MVCompensate>	Slicer;
+	enum {         MAX_SLICES_PER_PLANE = 64 };
+	enum {         MAX_TASKS = 1 + (MAX_SLICES_PER_PLANE + 1) * 3 };	// Root + slices + plane finalisation
 
-	void           compensate_slice_normal (Slicer::TaskData &td);
-	void           compensate_slice_overlap (Slicer::TaskData &td);
-	void           compensate_slice_overlap (int y_beg, int y_end);
+	typedef	MTFlowGraphSimple <MAX_TASKS>	PlaneGraph;
+	typedef	MTFlowGraphSched <MVCompensate, PlaneGraph, MVCompensate, MAX_TASKS>	Scheduler;
+
+	class TaskInfo
+	{
+	public:
+		int            _plane;
+		bool           _finish_flag;  // Plane finalisation, once all its slices are done
+		int            _y_beg;        // Block rows
+		int            _y_end;
+	};
+	typedef	std::vector <TaskInfo>	TaskArray;
+
+	void           build_plane_graph (int plane_mask);
+	void           process_task (Scheduler::TaskData &td);
+	void           compensate_slice_normal (int p, int y_beg, int y_end);
+	void           compensate_slice_overlap (int p, int y_beg, int y_end);
+	void           compensate_rows_overlap (int p, int y_beg, int y_end);
+	void           finish_plane (int p);
 	bool           compute_src_frame (int &nsrc, int &nvec, int &vindex, int n) const;
 
 	MvClipArray    _mv_clip_arr;
@@ -71,9 +89,7 @@ private:
 
 	OverlapsFunction *OVERSLUMA;
 	OverlapsFunction *OVERSCHROMA;
-	unsigned short * DstShort;
-	unsigned short * DstShortU;
-	unsigned short * DstShortV;
+	unsigned short * DstShort [3];	// Accumulators, kept cleared between frames
 	int dstShortPitch;
 	int dstShortPitchUV;
 
@@ -105,16 +121,21 @@ private:
 	int            nSrcPitches[3];
 	MVPlane *      pPlanes[3];
 	MVPlane *      pSrcPlanes[3];
-
-	// This array has an nBlkY size. It is used in vertical overlap mode
-	// to avoid read/write sync problems when processing is multithreaded.
-	// Only elements corresponding to the first row of each sub-plane are
-	// actually used. They count how many sub-planes (excepted their last
-	// row) have been processed on each side of the boundary. When a counter
-	// reaches 2, the boundary row (just above the element position) can be
-	// processed safely.
+	const BYTE *   pPadSrc [3];   // Source of the uncovered regions, at the top-left of the picture
+	int            nPadSrcPitches [3];
+
+	// These arrays have an nBlkY size, one per plane. They are used in
+	// vertical overlap mode to avoid read/write sync problems when processing
+	// is multithreaded. Only elements corresponding to the first row of each
+	// sub-plane are actually used. They count how many sub-planes (excepted
+	// their last row) have been processed on each side of the boundary. When
+	// a counter reaches 2, the boundary row (just above the element position)
+	// can be processed safely.
 	std::vector <conc::AtomicInt <int> >
-						_boundary_cnt_arr;
+						_boundary_cnt_arr [3];
+
+	TaskArray      _task_arr;     // Task index - 1 -> task
+	PlaneGraph     _plane_graph;
 
 };
 
@@ -22,7 +22,7 @@
 #include "MVFrame.h"
 #include	"MVGroupOfFrames.h"
 #include "MVPlane.h"
-#include "profile.h"
+#include	"SuperFrameCache.h"
 #include "SuperParams64Bits.h"
 
 #include	<mmintrin.h>
@@ -275,11 +275,15 @@ MVDegrain1::MVDegrain1(
 	{
 		vi.height <<= 1;
 	}
+
+	SuperFrameCache::add_client (super);
 }
 
 
 MVDegrain1::~MVDegrain1()
 {
+	SuperFrameCache::remove_client (super);
+
    if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
    {
 	delete DstPlanes;
@@ -485,7 +489,6 @@ PVideoFrame __stdcall MVDegrain1::GetFrame(int n, IScriptEnvironment* env)
 			pPlanesB[2] = pRefBGOF->GetFrame(0)->GetPlane(VPLANE);
 	}
 
-	PROFILE_START(MOTION_PROFILE_COMPENSATION);
 	pDstCur[0] = pDst[0];
 	pDstCur[1] = pDst[1];
 	pDstCur[2] = pDst[2];
@@ -664,8 +667,6 @@ PVideoFrame __stdcall MVDegrain1::GetFrame(int n, IScriptEnvironment* env)
 
 	_mm_empty ();	// (we may use double-float somewhere) Fizick
 
-	PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
-
 
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 	{
@@ -25,7 +25,7 @@
 #include	"MVGroupOfFrames.h"
 #include "MVPlane.h"
 #include "Padding.h"
-#include "profile.h"
+#include	"SuperFrameCache.h"
 #include "SuperParams64Bits.h"
 
 
@@ -278,11 +278,15 @@ MVDegrain2::MVDegrain2(
 	{
 		vi.height <<= 1;
 	}
+
+	SuperFrameCache::add_client (super);
 }
 
 
 MVDegrain2::~MVDegrain2()
 {
+	SuperFrameCache::remove_client (super);
+
    if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
    {
 	delete DstPlanes;
@@ -553,7 +557,6 @@ PVideoFrame __stdcall MVDegrain2::GetFrame(int n, IScriptEnvironment* env)
 			pPlanesB2[2] = pRefB2GOF->GetFrame(0)->GetPlane(VPLANE);
 	}
 
-	PROFILE_START(MOTION_PROFILE_COMPENSATION);
 	pDstCur[0] = pDst[0];
 	pDstCur[1] = pDst[1];
 	pDstCur[2] = pDst[2];
@@ -740,8 +743,6 @@ PVideoFrame __stdcall MVDegrain2::GetFrame(int n, IScriptEnvironment* env)
 
 	_mm_empty ();	// (we may use double-float somewhere) Fizick
 
-	PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
-
 
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 	{
@@ -24,7 +24,7 @@
 #include "MVGroupOfFrames.h"
 #include "MVPlane.h"
 #include "Padding.h"
-#include "profile.h"
+#include	"SuperFrameCache.h"
 #include "SuperParams64Bits.h"
 
 #include	<mmintrin.h>
@@ -280,11 +280,15 @@ MVDegrain3::MVDegrain3 (
 	{
 		vi.height <<= 1;
 	}
+
+	SuperFrameCache::add_client (super);
 }
 
 
 MVDegrain3::~MVDegrain3()
 {
+	SuperFrameCache::remove_client (super);
+
    if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
    {
 		delete DstPlanes;
@@ -628,7 +632,6 @@ PVideoFrame __stdcall MVDegrain3::GetFrame(int n, IScriptEnvironment* env)
 			pPlanesB3[2] = pRefB3GOF->GetFrame(0)->GetPlane(VPLANE);
 	}
 
-	PROFILE_START(MOTION_PROFILE_COMPENSATION);
 	pDstCur[0] = pDst[0];
 	pDstCur[1] = pDst[1];
 	pDstCur[2] = pDst[2];
@@ -819,8 +822,6 @@ PVideoFrame __stdcall MVDegrain3::GetFrame(int n, IScriptEnvironment* env)
 
 	_mm_empty ();	// (we may use double-float somewhere) Fizick
 
-	PROFILE_STOP(MOTION_PROFILE_COMPENSATION);
-
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 	{
 		YUY2FromPlanes(pDstYUY2, nDstPitchYUY2, nWidth, nHeight * height_lsb_mul,
@@ -30,7 +30,7 @@
 
 
 MVDepan::MVDepan(PClip _child, PClip mvs, PClip _mask, bool _zoom, bool _rot, float _pixaspect,
-		float _error, bool _info, const char * _logfilename, float _wrong, float _zerow, int _range, int nSCD1, int nSCD2, bool isse, bool _planar, IScriptEnvironment* env) :
+		float _error, bool _info, const char * _logfilename, float _wrong, float _zerow, int _range, int nSCD1, int nSCD2, bool isse, bool _planar, bool mt_flag, IScriptEnvironment* env) :
 GenericVideoFilter(_child),
 mvclip(mvs, nSCD1, nSCD2, env, 1, 0),
 MVFilter(mvs, "MDepan", env, 1, 0),
@@ -38,16 +38,15 @@ mask(_mask),
 planar(_planar),
 wrongDif(_wrong),
 zeroWeight(_zerow), range(_range),
-ifZoom(_zoom), ifRot(_rot), pixaspect(_pixaspect), error(_error), info(_info), logfilename(_logfilename)
+ifZoom(_zoom), ifRot(_rot), pixaspect(_pixaspect), error(_error), info(_info), logfilename(_logfilename),
+_mt_flag(mt_flag),
+_solver_arr(),
+_job_arr(),
+_solver_param(),
+_tr_arr(),
+_err_arr(),
+_iter_arr()
 {
-	blockDx = new float[nBlkX * nBlkY]; // dx vector
-	blockDy = new float[nBlkX * nBlkY]; // dy
-	blockSAD = new int[nBlkX * nBlkY];
-	blockX = new int[nBlkX * nBlkY]; // block x position
-	blockY = new int[nBlkX * nBlkY];
-	blockWeight = new float[nBlkX * nBlkY];
-	blockWeightMask = new float[nBlkX * nBlkY];
-
 	if (lstrlen(logfilename) > 0) { // v.1.2.3
 		logfile = fopen(logfilename,"wt");
 		if (logfile == NULL)	env->ThrowError("MDePan: Log file can not be created!");
@@ -65,18 +64,31 @@ ifZoom(_zoom), ifRot(_rot), pixaspect(_pixaspect), error(_error), info(_info), l
 
 	for (int i=0; i<=vi.num_frames; i++)
         motionx[i] = MOTIONUNKNOWN;
+
+	GlobalMotionSolver::Transform tr_null;
+	GlobalMotionSolver::set_null (tr_null);
+	_tr_arr.resize (vi.num_frames + 1, tr_null);
+	_err_arr.resize (vi.num_frames + 1, error * 2);
+	_iter_arr.resize (vi.num_frames + 1, 0);
+
+	// All the frames of the window may have to be estimated at once, as well
+	// as the even frame preceding it.
+	const GlobalMotionSolver solver (nBlkX, nBlkY, (float)vi.width/2, (float)vi.height/2);
+	_solver_arr.resize (std::max (range, 0) * 2 + 2, solver);
+
+	const int nFields = (vi.IsFieldBased()) ? 2 : 1;
+	_solver_param._aspect = pixaspect/nFields;
+	_solver_param._zoom_flag = ifZoom;
+	_solver_param._rot_flag = ifRot;
+	_solver_param._wrong_dif = wrongDif;
+	_solver_param._zero_weight = zeroWeight;
+	_solver_param._th_sad = mvclip.GetThSCD1();
+	_solver_param._ignored_border = (mask) ? 0 : 4; // 4: old pre v.2.4.3 method
 }
 
 
 MVDepan::~MVDepan()
 {
-	delete [] blockDx;
-	delete [] blockDy;
-	delete [] blockSAD;
-	delete [] blockX;
-	delete [] blockY;
-	delete [] blockWeight;
-	delete [] blockWeightMask;
 	if (logfile != NULL)
 		fclose(logfile);
 
@@ -327,109 +339,6 @@ void MVDepan::inversetransform(transform ta, transform *tinv)
 	tinv->dyc = - tinv->dyx * ta.dxc - tinv->dyy * ta.dyc;
 }
 
-//----------------------------------------------------------------------------
-void MVDepan::TrasformUpdate(transform *tr, float blockDx[], float blockDy[], int blockSAD[], int blockX[], int blockY[], float blockWeight[], int nBlkX, int nBlkY, float safety, bool ifZoom1, bool ifRot1, float *error1, float pixaspect)
-{
-	transform trderiv;
-	int n = nBlkX*nBlkY;
-	trderiv.dxc = 0;
-	trderiv.dxx = 0;
-	trderiv.dxy = 0;
-	trderiv.dyc = 0;
-	trderiv.dyx = 0;
-	trderiv.dyy = 0;
-	float norm = 0.1f;
-	float x2 = 0.1f;
-	float y2 = 0.1f;
-	float error2 = 0.1f;
-	for (int i=0; i<n; i++)
-	{
-		float bw = blockWeight[i];
-		float xdif = (tr->dxc + tr->dxx*blockX[i] + tr->dxy*blockY[i] - blockX[i]- blockDx[i]);
-		trderiv.dxc +=  2*xdif*bw;
-		if (ifZoom1) trderiv.dxx +=  2*blockX[i]*xdif*bw;
-		if (ifRot1)	trderiv.dxy +=  2*blockY[i]*xdif*bw;
-		float ydif =(tr->dyc + tr->dyx*blockX[i] + tr->dyy*blockY[i] - blockY[i]- blockDy[i]);
-		trderiv.dyc +=  2*ydif*bw;
-		if (ifRot1) trderiv.dyx +=  2*blockX[i]*ydif*bw;
-		if (ifZoom1) trderiv.dyy +=  2*blockY[i]*ydif*bw;
-		norm += bw;
-		x2 += blockX[i]*blockX[i]*bw;
-		y2 += blockY[i]*blockY[i]*bw;
-		error2 += (xdif*xdif + ydif*ydif)*bw;
-	}
-	trderiv.dxc /= norm*2;
-	trderiv.dxx /= x2*2*1.5f; // with additional safety factors
-	trderiv.dxy /= y2*2*3;
-	trderiv.dyc /= norm*2;
-	trderiv.dyx /= x2*2*3;
-	trderiv.dyy /= y2*2*1.5f;
-
-	error2 /= norm;
-	*error1 = sqrtf(error2);
-
-	tr->dxc -= safety*trderiv.dxc;
-	if (ifZoom1) 	tr->dxx -= safety*0.5f*(trderiv.dxx + trderiv.dyy);
-
-	tr->dxy -= safety*0.5f*(trderiv.dxy - trderiv.dyx/(pixaspect*pixaspect));
-	tr->dyc -= safety*trderiv.dyc;
-//	tr->dyx -= safety*trderiv.dyx;
-//	tr->dyy -= safety*trderiv.dyy;
-	if (ifZoom1) 	tr->dyy = tr->dxx;
-//	float pixaspect=1; // was for test and forgot remove?! disabled in v1.2.5
-	tr->dyx = -pixaspect*pixaspect * tr->dxy ;
-
-}
-//----------------------------------------------------------------------------
-
-void MVDepan::RejectBadBlocks (transform tr, float blockDx[], float blockDy[], int blockSAD[], int blockX[], int blockY[], float blockWeight[], int nBlkX, int nBlkY, float wrongDif, float globalDif, int thSCD1, float zeroWeight, float blockWeightMask[], int ignoredBorder)
-{
-	for (int j=0; j< nBlkY; j++)
-	{
-		for (int i=0; i<nBlkX; i++)
-		{
-			int n = j*nBlkX+i;
-			if (i<ignoredBorder || i>= nBlkX-ignoredBorder || j<ignoredBorder || j>= nBlkY-ignoredBorder)
-			{
-				blockWeight[n] = 0; // disable  blocks near frame borders
-			}
-			else if (blockSAD[n] > thSCD1)
-			{
-					blockWeight[n] = 0; // disable bad block with big SAD
-			}
-			else if (i>0 && i<(nBlkX-1) && ( fabs((blockDx[n-1-nBlkX] + blockDx[n-nBlkX] + blockDx[n+1-nBlkX]+
-					blockDx[n-1] + blockDx[n+1]+
-					blockDx[n-1+nBlkX] + blockDx[n+nBlkX] + blockDx[n+1+nBlkX])/8 - blockDx[n]) > wrongDif))
-			{
-					blockWeight[n] = 0; // disable blocks very different from neighbours
-			}
-			else if (j>0 && j<(nBlkY-1) && ( fabs((blockDy[n-1-nBlkX] + blockDy[n-nBlkX] + blockDy[n+1-nBlkX]+
-					blockDy[n-1] + blockDy[n+1]+
-					blockDy[n-1+nBlkX] + blockDy[n+nBlkX] + blockDy[n+1+nBlkX])/8 - blockDy[n]) > wrongDif))
-			{
-					blockWeight[n] = 0; // disable blocks very different from neighbours
-			}
-			else if (fabs(tr.dxc + tr.dxx*blockX[n] + tr.dxy*blockY[n] - blockX[n] - blockDx[n]) > globalDif)
-			{
-					blockWeight[n] = 0; // disable blocks very different from global
-			}
-			else if (fabs(tr.dyc + tr.dyx*blockX[n] + tr.dyy*blockY[n] - blockY[n] - blockDy[n])> globalDif)
-			{
-					blockWeight[n] = 0; // disable blocks very different from global
-			}
-			else if (blockDx[n] == 0 && blockDy[n] == 0 )
-			{
-					blockWeight[n] = zeroWeight*blockWeightMask[n];//0.05f; // decrease weight of blocks with strictly zero motion - added in v1.2.5
-			}
-			else
-			{
-				blockWeight[n] = blockWeightMask[n]; // good block
-			}
-		}
-	}
-
-}
-
 //------------------------------------------------------------------------------------
 
 PVideoFrame __stdcall MVDepan::GetFrame(int ndest, IScriptEnvironment* env)
@@ -517,9 +426,6 @@ PVideoFrame __stdcall MVDepan::GetFrame(int ndest, IScriptEnvironment* env)
 
 	float dPel = 1.0f/nPel;  // subpixel precision value
 
-	// declare motion transform structure
-	transform tr;
-
  	int backward;
    if (mvclip.IsBackward())
 		backward = 1; // for backward transform
@@ -529,154 +435,156 @@ PVideoFrame __stdcall MVDepan::GetFrame(int ndest, IScriptEnvironment* env)
 	int framefirst = std::max(ndest - range, 0);
 	int framelast  = std::min(ndest + range, vi.num_frames-1);
 
-	float safety;
-	float errorcur;
-	int iter;
-	float errordif = 0.01f; // error difference to terminate iterations
-	int itermax = 150; // maximum iteration number
-	float zeroWeight = 0.05f; // zero vector weight
-
-for (int nframe=framefirst; nframe<=framelast; nframe++)
-{
-
-	// init motion transform as null
-	tr.dxc=0;
-	tr.dxx=1;
-	tr.dxy=0;
-	tr.dyc=0;
-	tr.dyx=0;
-	tr.dyy=1;
+	int BPP; // step bytes luma per pixel
+	if (!planar && vi.IsYUY2())
+		BPP = 2;
+	else
+		BPP = 1;
+
+	// Even frames always start from the null transform. Odd frames start
+	// from the result of the previous (even) frame when it is reliable, so
+	// the result of a frame doesn't depend on the access history. Therefore
+	// the even frame preceding the window is estimated too if required.
+	int framebeg = framefirst;
+	if ((framefirst & 1) != 0 && motionx[framefirst-1] == MOTIONUNKNOWN)
+		framebeg = framefirst - 1;
+
+	// Collects the blocks of all the unknown frames of the window.
+	// The vector frames are fetched serially, then the estimations run
+	// concurrently, each frame having its own solver: even frames first,
+	// then odd frames.
+	_job_arr.clear ();
+	std::vector <EstimJob> job_odd_arr;
+	for (int nframe=framebeg; nframe<=framelast; nframe++)
+	{
+		if (motionx[nframe] != MOTIONUNKNOWN)
+			continue;
 
-	errorcur = error*2; // v1.2.3
-	iter = 0; // start iteration
+		// null transform if scenechange
+		GlobalMotionSolver::set_null (_tr_arr[nframe]);
+		_err_arr[nframe] = error*2; // v1.2.3
+		_iter_arr[nframe] = 0;
 
-    if (motionx[nframe] == MOTIONUNKNOWN)
-    {
 		int nframemv = (backward) ? nframe-1: nframe; // set prev frame number as data frame if backward
-	PVideoFrame mvn = mvclip.GetFrame(nframemv, env);
-   mvclip.Update(mvn, env);
-
-   int BPP; // step bytes luma per pixel
-   if (!planar && vi.IsYUY2())
-        BPP = 2;
-    else
-        BPP = 1;
+		PVideoFrame mvn = mvclip.GetFrame(nframemv, env);
+		mvclip.Update(mvn, env);
 
-	if ( nframemv >= 0 && mvclip.IsUsable() )
-	{
-//		float testDx = 0;
-//		float testDy = 0;
-
-		for (int j=0; j< nBlkY; j++)
+		if ( nframemv >= 0 && mvclip.IsUsable() )
 		{
-			for (int i=0; i<nBlkX; i++)
+			EstimJob job;
+			job._nframe = nframe;
+			job._solver_index = nframe - framebeg;
+			GlobalMotionSolver & solver = _solver_arr[job._solver_index];
+
+			for (int j=0; j< nBlkY; j++)
 			{
-				int nb = j*nBlkX+i;
-				blockDx[nb] = mvclip.GetBlock(0,nb).GetMV().x * dPel;
-				blockDy[nb] = mvclip.GetBlock(0,nb).GetMV().y * dPel;
-				blockSAD[nb] = mvclip.GetBlock(0,nb).GetSAD();
-				blockX[nb] = mvclip.GetBlock(0,nb).GetX()+ nBlkSizeX/2;//i*nBlkSize + nBlkSize/2;// rewritten in v1.2.5
-				blockY[nb] = mvclip.GetBlock(0,nb).GetY()+ nBlkSizeY/2;//j*nBlkSize + nBlkSize/2;//
-				if (mask && blockX[nb]<vi.width && blockY[nb]<vi.height)
-                    blockWeightMask[nb] = maskp[blockX[nb]*BPP + blockY[nb]*mask_pitch];
-                else
-                    blockWeightMask[nb] = 1;
-				blockWeight[nb] = blockWeightMask[nb];
-
-//				testDx += blockDx[nb];
-//				testDy += blockDy[nb];
+				for (int i=0; i<nBlkX; i++)
+				{
+					const FakeBlockData & block = mvclip.GetBlock(0, j*nBlkX+i);
+					const VECTOR mv = block.GetMV();
+					const int x = block.GetX() + nBlkSizeX/2; // rewritten in v1.2.5
+					const int y = block.GetY() + nBlkSizeY/2;
+					float weightMask = 1;
+					if (mask && x<vi.width && y<vi.height)
+						weightMask = maskp[x*BPP + y*mask_pitch];
+					solver.set_block (i, j, float (x), float (y), mv.x * dPel, mv.y * dPel, block.GetSAD(), weightMask);
+				}
 			}
+
+			job._warm_flag = false;
+			job._warm_err = 0;
+			if ((nframe & 1) == 0)
+				_job_arr.push_back (job);
+			else
+				job_odd_arr.push_back (job);
 		}
-//		testDx /= nBlkX*nBlkY;
-//		testDy /= nBlkX*nBlkY;
-
-//		char debugbuf[200];
-//		sprintf(debugbuf,"MVDEPAN: %d %f %f %d %d", n, testDx, testDy, blockX[nBlkX*nBlkY-1], blockY[nBlkX*nBlkY-1]);
-//		OutputDebugString(debugbuf);
-
-		// begin with translation only
-		safety = 0.3f; // begin with small safety factor
-		bool ifRot0 = false;
-		bool ifZoom0 = false;
-		float globalDif0 = 1000.0f;
-		int ignoredBorder;
-		if (mask)
-            ignoredBorder=0;
-        else
-            ignoredBorder=4; // old pre v.2.4.3 method
-
-
-		for (; iter<5; iter++)
-		{
-			TrasformUpdate(&tr, blockDx, blockDy, blockSAD, blockX, blockY, blockWeight, nBlkX, nBlkY, safety, ifZoom0, ifRot0, &errorcur, pixaspect/nFields);
-         RejectBadBlocks(tr, blockDx, blockDy, blockSAD, blockX, blockY, blockWeight, nBlkX, nBlkY, wrongDif, globalDif0, mvclip.GetThSCD1(), zeroWeight, blockWeightMask, ignoredBorder );
-		}
+	}
 
+	if (! _job_arr.empty ())
+	{
+		Slicer slicer (_mt_flag);
+		slicer.start (int (_job_arr.size ()), *this, &MVDepan::process_slice, 1);
+		slicer.wait ();
+	}
 
-		for (; iter<100; iter++)
+	// The even frames are now all estimated
+	for (size_t k = 0; k < job_odd_arr.size (); ++k)
+	{
+		EstimJob & job = job_odd_arr[k];
+		const int nprev = job._nframe - 1;
+		if (_err_arr[nprev] < error)
 		{
-			if (iter < 8)
-				safety = 0.3f; // use for safety
-			else if (iter < 10)
-				safety = 0.6f;
-			else
-				safety = 1.0f;
-			float errorprev = errorcur;
-			TrasformUpdate(&tr, blockDx, blockDy, blockSAD, blockX, blockY, blockWeight, nBlkX, nBlkY, safety, ifZoom, ifRot, &errorcur, pixaspect/nFields);
-			if (((errorprev - errorcur) < errordif*0.5 && iter > 9) || errorcur<errordif) break; // check convergence, accuracy increased in v1.2.5
-			float globalDif = errorcur*2;
-			RejectBadBlocks(tr, blockDx, blockDy, blockSAD, blockX, blockY, blockWeight, nBlkX, nBlkY, wrongDif, globalDif, mvclip.GetThSCD1(), zeroWeight, blockWeightMask, ignoredBorder );
+			job._warm_flag = true;
+			job._warm_tr = _tr_arr[nprev];
+			job._warm_err = _err_arr[nprev];
 		}
-
 	}
+	_job_arr.swap (job_odd_arr);
 
-	// we get transform (null if scenechange)
+	if (! _job_arr.empty ())
+	{
+		Slicer slicer (_mt_flag);
+		slicer.start (int (_job_arr.size ()), *this, &MVDepan::process_slice, 1);
+		slicer.wait ();
+	}
 
 	float xcenter = (float)vi.width/2;
 	float ycenter = (float)vi.height/2;
+	const float aspect = pixaspect/nFields;
 
-	motionx[nframe] = 0;
-	motiony[nframe] = 0;
-	motionrot[nframe] = 0;
-	motionzoom[nframe] = 1;
-
-	if (errorcur < error) // if not bad result
+	for (int nframe=framebeg; nframe<=framelast; nframe++)
 	{
-		// convert transform data to ordinary motion format
-		if (mvclip.IsBackward())
-		{
-			transform trinv;
-			inversetransform(tr, &trinv);
-			transform2motion (trinv, 0, xcenter, ycenter, pixaspect/nFields,  &motionx[nframe],  &motiony[nframe],  &motionrot[nframe],  &motionzoom[nframe]);
-		}
-		else
-			transform2motion (tr, 1, xcenter, ycenter, pixaspect/nFields, &motionx[nframe],  &motiony[nframe],  &motionrot[nframe],  &motionzoom[nframe]);
+		if (motionx[nframe] != MOTIONUNKNOWN)
+			continue;
+
+		motionx[nframe] = 0;
+		motiony[nframe] = 0;
+		motionrot[nframe] = 0;
+		motionzoom[nframe] = 1;
 
-		// fieldbased correction - added in v1.2.3
-		int isnframeodd = nframe%2;  // =0 for even,    =1 for odd
-		float yadd = 0;
-		if (vi.IsFieldBased()) { // correct line shift for fields, if not scenechange
-			// correct unneeded fields matching
+		if (_err_arr[nframe] < error) // if not bad result
+		{
+			const GlobalMotionSolver::Transform & trs = _tr_arr[nframe];
+			transform tr;
+			tr.dxc = trs._dxc;
+			tr.dxx = trs._dxx;
+			tr.dxy = trs._dxy;
+			tr.dyc = trs._dyc;
+			tr.dyx = -aspect*aspect * trs._dxy;
+			tr.dyy = trs._dxx;
+
+			// convert transform data to ordinary motion format
+			if (mvclip.IsBackward())
 			{
-				if ( vi.IsTFF())
-					yadd += 0.5f - isnframeodd; // TFF
-				else
-					yadd += - 0.5f + isnframeodd; // BFF (or undefined?)
+				transform trinv;
+				inversetransform(tr, &trinv);
+				transform2motion (trinv, 0, xcenter, ycenter, aspect,  &motionx[nframe],  &motiony[nframe],  &motionrot[nframe],  &motionzoom[nframe]);
+			}
+			else
+				transform2motion (tr, 1, xcenter, ycenter, aspect, &motionx[nframe],  &motiony[nframe],  &motionrot[nframe],  &motionzoom[nframe]);
+
+			// fieldbased correction - added in v1.2.3
+			int isnframeodd = nframe%2;  // =0 for even,    =1 for odd
+			float yadd = 0;
+			if (vi.IsFieldBased()) { // correct line shift for fields, if not scenechange
+				// correct unneeded fields matching
+				{
+					if ( vi.IsTFF())
+						yadd += 0.5f - isnframeodd; // TFF
+					else
+						yadd += - 0.5f + isnframeodd; // BFF (or undefined?)
+				}
+				// scale dy for fieldbased frame by factor 2 (for compatibility)
+				yadd = yadd *2;
+				motiony[nframe] += yadd;
 			}
-			// scale dy for fieldbased frame by factor 2 (for compatibility)
-			yadd = yadd *2;
-			motiony[nframe] += yadd;
-		}
-
-		if (fabs(motionx[nframe]) < 0.01f)  // if it is accidentally very small, reset it to small, but non-zero value ,
-			motionx[nframe] = (2*rand()-RAND_MAX) > 0 ? 0.011f : -0.011f; // to differ from pure 0, which be interpreted as bad value mark (scene change)
 
+			if (fabs(motionx[nframe]) < 0.01f)  // if it is accidentally very small, reset it to small, but non-zero value ,
+				motionx[nframe] = (2*rand()-RAND_MAX) > 0 ? 0.011f : -0.011f; // to differ from pure 0, which be interpreted as bad value mark (scene change)
+		}
 	}
-//		char debugbuf[200];
-//		sprintf(debugbuf,"MVDEPAN: %d %d %d", ndest, nframe, nframemv);
-//		OutputDebugString(debugbuf);
-    }
-	if (info && nframe == ndest) // type text info to output frame
+
+	if (info) // type text info to output frame
 	{
 		int xmsg = 0;
 		int ymsg = 1;
@@ -687,7 +595,7 @@ for (int nframe=framefirst; nframe<=framelast; nframe++)
 		else
 			DrawString(dst,xmsg,ymsg,messagebuf);
 
-		sprintf(messagebuf,"fn=%5d iter=%3d error=%7.3f", nframe, iter, errorcur);
+		sprintf(messagebuf,"fn=%5d iter=%3d error=%7.3f", ndest, _iter_arr[ndest], _err_arr[ndest]);
 		ymsg++;
 		if (vi.IsYUY2())
 			DrawStringYUY2(dst,xmsg,ymsg,messagebuf);
@@ -701,7 +609,7 @@ for (int nframe=framefirst; nframe<=framelast; nframe++)
 		else
 			DrawString(dst,xmsg,ymsg,messagebuf);
 
-		sprintf(messagebuf,"%7.2f %7.2f %7.3f %7.5f", motionx[nframe],  motiony[nframe],  motionrot[nframe],  motionzoom[nframe]);
+		sprintf(messagebuf,"%7.2f %7.2f %7.3f %7.5f", motionx[ndest],  motiony[ndest],  motionrot[ndest],  motionzoom[ndest]);
 		ymsg++;
 		if (vi.IsYUY2())
 			DrawStringYUY2(dst,xmsg,ymsg,messagebuf);
@@ -709,8 +617,6 @@ for (int nframe=framefirst; nframe<=framelast; nframe++)
 			DrawString(dst,xmsg,ymsg,messagebuf);
 	}
 
-}
-
 	// write global motion data in Depan plugin format to start of dest frame buffer
 	write_depan_data(dst->GetWritePtr(), framefirst, framelast, motionx,  motiony,  motionzoom,  motionrot);
 
@@ -723,3 +629,18 @@ for (int nframe=framefirst; nframe<=framelast; nframe++)
 
 	return dst;
 }
+
+
+
+void MVDepan::process_slice (Slicer::TaskData &td)
+{
+	for (int k = td._y_beg; k < td._y_end; ++k)
+	{
+		const EstimJob & job = _job_arr[k];
+		const int nframe = job._nframe;
+		_solver_arr[job._solver_index].solve (
+			_tr_arr[nframe], _err_arr[nframe], _iter_arr[nframe], _solver_param,
+			(job._warm_flag) ? &job._warm_tr : 0, job._warm_err
+		);
+	}
+}
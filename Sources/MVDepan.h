@@ -19,9 +19,13 @@
 #ifndef __MV_DEPAN__
 #define __MV_DEPAN__
 
+#include "GlobalMotionSolver.h"
+#include "MTSlicer.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 
+#include	<vector>
+
 #include	<cstdio>
 
 
@@ -62,13 +66,39 @@ private:
 
 	FILE *logfile;
 
-	float *blockDx ; // dx vector
-	float *blockDy ; // dy
-	int *blockSAD ;
-	int *blockX; // blocks x position
-	int *blockY;
-	float *blockWeight;
-	float *blockWeightMask;
+	typedef	MTSlicer <MVDepan>	Slicer;
+
+	class EstimJob
+	{
+	public:
+		int            _nframe;
+		int            _solver_index;
+		bool           _warm_flag;
+		GlobalMotionSolver::Transform
+		               _warm_tr;
+		float          _warm_err;
+	};
+
+	void           process_slice (Slicer::TaskData &td);
+
+	bool           _mt_flag;
+
+	// One solver per frame of the window, so they can run concurrently
+	std::vector <GlobalMotionSolver>
+	               _solver_arr;
+	std::vector <EstimJob>
+	               _job_arr;
+	GlobalMotionSolver::Param
+	               _solver_param;
+
+	// Estimation results, per frame
+	std::vector <GlobalMotionSolver::Transform>
+	               _tr_arr;
+	std::vector <float>
+	               _err_arr;
+	std::vector <int>
+	               _iter_arr;
+
 	float *motionx;
 	float *motiony;
 	float *motionzoom;
@@ -84,12 +114,10 @@ private:
 	void motion2transform (float dx1, float dy1, float rot, float zoom1, float pixaspect, float xcenter, float ycenter, int forward, float fractoffset, transform *tr);
 	void transform2motion (transform tr, int forward, float xcenter, float ycenter, float pixaspect, float *dx, float *dy, float *rot, float *zoom);
 	void inversetransform(transform ta, transform *tinv);
-	void TrasformUpdate(transform *tr, float blockDx[], float blockDy[], int blockSAD[], int blockX[], int blockY[], float blockWeight[], int nBlkX, int nBlkY, float safety, bool ifZoom, bool ifRot, float *error, float pixaspect);
-	void RejectBadBlocks (transform tr, float blockDx[], float blockDy[], int blockSAD[], int blockX[], int blockY[], float blockWeight[], int nBlkX, int nBlkY, float neighboursDif, float globalDif, int thSCD1, float zeroWeight, float blockWeightMask[], int ignoredBorder );
 
 public:
 	MVDepan::MVDepan(PClip _child, PClip mvs, PClip _mask, bool _zoom, bool _rot, float _pixaspect,
-			float _error, bool _info, const char * _logfilename, float _wrong, float _zerow, int _range, int nSCD1, int nSCD2, bool isse, bool _planar, IScriptEnvironment* env);
+			float _error, bool _info, const char * _logfilename, float _wrong, float _zerow, int _range, int nSCD1, int nSCD2, bool isse, bool _planar, bool mt_flag, IScriptEnvironment* env);
 	~MVDepan();
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env);
 };
@@ -137,10 +137,16 @@ timeclip (_timeclip)
    {
 		DstPlanes =  new YUY2Planes(nWidth, nHeight);
    }
+
+	_super      = super;
+	finest_view = (nPel == 1) ? SuperFrameCache::View_SUPER : SuperFrameCache::View_FINEST;
+	SuperFrameCache::add_client (_super);
 }
 
 MVFlow::~MVFlow()
 {
+	SuperFrameCache::remove_client (_super);
+
    if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2  && !planar)
    {
 	delete DstPlanes;
@@ -306,7 +312,7 @@ PVideoFrame __stdcall MVFlow::GetFrame(int n, IScriptEnvironment* env)
 
 	if (usable_flag)
 	{
-		ref = finest->GetFrame(nref, env);//  ref for  compensation
+		ref = SuperFrameCache::get_frame (_super, nref, *env, finest_view, &finest);//  ref for  compensation
 		dst = env->NewVideoFrame(vi);
 		if (timeclip != 0)
 		{
@@ -4,6 +4,7 @@
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "SimpleResize.h"
+#include "SuperFrameCache.h"
 #include "Time256ProviderCst.h"
 #include "Time256ProviderPlane.h"
 #include "yuy2planes.h"
@@ -28,6 +29,8 @@ private:
    bool planar;
 
    PClip finest; // v2.0
+   PClip _super; // Key for the SuperFrameCache
+   SuperFrameCache::View finest_view;
 	PClip	timeclip;
 
    BYTE *VXFullY; // fullframe vector mask
@@ -25,11 +25,12 @@
 
 
 MVFlowBlur::MVFlowBlur(PClip _child, PClip super, PClip _mvbw, PClip _mvfw,  int _blur256, int _prec,
-                           int nSCD1, int nSCD2, bool _isse, bool _planar, IScriptEnvironment* env) :
+                           int nSCD1, int nSCD2, bool _isse, bool _planar, bool mt_flag, IScriptEnvironment* env) :
 GenericVideoFilter(_child),
 MVFilter(_mvfw, "MFlowBlur", env, 1, 0),
 mvClipB(_mvbw, nSCD1, nSCD2, env, 1, 0),
-mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
+mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0),
+_mt_flag(mt_flag)
 {
    blur256 = _blur256;
    prec = _prec;
@@ -116,10 +117,16 @@ mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
 	{
 		DstPlanes =  new YUY2Planes(nWidth, nHeight);
 	}
+
+	_super      = super;
+	finest_view = (nPel == 1) ? SuperFrameCache::View_SUPER : SuperFrameCache::View_FINEST;
+	SuperFrameCache::add_client (_super);
 }
 
 MVFlowBlur::~MVFlowBlur()
 {
+	SuperFrameCache::remove_client (_super);
+
    if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2  && !planar)
    {
 		delete DstPlanes;
@@ -342,7 +349,7 @@ PVideoFrame __stdcall MVFlowBlur::GetFrame(int n, IScriptEnvironment* env)
 
    if ( mvClipB.IsUsable()  && mvClipF.IsUsable() )
    {
-		PVideoFrame ref = finest->GetFrame(n, env);//  ref for  compensation
+		PVideoFrame ref = SuperFrameCache::get_frame (_super, n, *env, finest_view, &finest);//  ref for  compensation
 		dst = env->NewVideoFrame(vi);
 
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
@@ -409,32 +416,20 @@ PVideoFrame __stdcall MVFlowBlur::GetFrame(int n, IScriptEnvironment* env)
 	VectorSmallMaskYToHalfUV(VXSmallYF, nBlkX, nBlkY, VXSmallUVF, 2);
 	VectorSmallMaskYToHalfUV(VYSmallYF, nBlkX, nBlkY, VYSmallUVF, yRatioUV);
 
-	  // analyse vectors field to detect occlusion
-
-	  // upsize (bilinear interpolate) vector masks to fullframe size
-
-
-	  int dummyplane = PLANAR_Y; // use luma plane resizer code for all planes if we resize from luma small mask
-	  upsizer->SimpleResizeDo(VXFullYB, nWidth, nHeight, VPitchY, VXSmallYB, nBlkX, nBlkX, dummyplane);
-	  upsizer->SimpleResizeDo(VYFullYB, nWidth, nHeight, VPitchY, VYSmallYB, nBlkX, nBlkX, dummyplane);
-	  upsizerUV->SimpleResizeDo(VXFullUVB, nWidthUV, nHeightUV, VPitchUV, VXSmallUVB, nBlkX, nBlkX, dummyplane);
-	  upsizerUV->SimpleResizeDo(VYFullUVB, nWidthUV, nHeightUV, VPitchUV, VYSmallUVB, nBlkX, nBlkX, dummyplane);
-
-	  upsizer->SimpleResizeDo(VXFullYF, nWidth, nHeight, VPitchY, VXSmallYF, nBlkX, nBlkX, dummyplane);
-	  upsizer->SimpleResizeDo(VYFullYF, nWidth, nHeight, VPitchY, VYSmallYF, nBlkX, nBlkX, dummyplane);
-	  upsizerUV->SimpleResizeDo(VXFullUVF, nWidthUV, nHeightUV, VPitchUV, VXSmallUVF, nBlkX, nBlkX, dummyplane);
-	  upsizerUV->SimpleResizeDo(VYFullUVF, nWidthUV, nHeightUV, VPitchUV, VYSmallUVF, nBlkX, nBlkX, dummyplane);
-
+	for (int p = 0; p < 3; ++p)
+	{
+		_dst_ptr_arr [p]   = pDst [p];
+		_dst_pitch_arr [p] = nDstPitches [p];
+		_ref_ptr_arr [p]   = pRef [p] + ((p == 0) ? nOffsetY : nOffsetUV);
+		_ref_pitch_arr [p] = nRefPitches [p];
+	}
 
-			FlowBlur(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, nRefPitches[0],
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, VPitchY,
-				nWidth, nHeight, blur256, prec);
-			FlowBlur(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, nRefPitches[1],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, blur256, prec);
-			FlowBlur(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, nRefPitches[2],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, blur256, prec);
+	// upsize (bilinear interpolate) vector masks to fullframe size and blur,
+	// slice by slice. Slices are made of chroma rows, so the luma and chroma
+	// rows of a slice always match.
+	Slicer         slicer (_mt_flag);
+	slicer.start (nHeightUV, *this, &MVFlowBlur::process_slice, 4);
+	slicer.wait ();
 
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 		{
@@ -449,3 +444,52 @@ PVideoFrame __stdcall MVFlowBlur::GetFrame(int n, IScriptEnvironment* env)
    }
 
 }
+
+
+
+// Slices are counted in chroma rows. The last slice includes the remaining
+// luma rows when the luma height is not a multiple of the chroma ratio.
+void MVFlowBlur::process_slice (Slicer::TaskData &td)
+{
+	const int      yc_beg = td._y_beg;
+	const int      yc_end = td._y_end;
+	const int      yl_beg = yc_beg * yRatioUV;
+	const int      yl_end = (yc_end == nHeightUV) ? nHeight : yc_end * yRatioUV;
+	const int      dummyplane = PLANAR_Y; // use luma plane resizer code for all planes if we resize from luma small mask
+
+	// A blurred row only uses the same row of the full-size vector masks,
+	// so there is no need to wait for the other slices.
+	upsizer->SimpleResizeDo(VXFullYB, nWidth, nHeight, VPitchY, VXSmallYB, nBlkX, nBlkX, dummyplane, yl_beg, yl_end);
+	upsizer->SimpleResizeDo(VYFullYB, nWidth, nHeight, VPitchY, VYSmallYB, nBlkX, nBlkX, dummyplane, yl_beg, yl_end);
+	upsizerUV->SimpleResizeDo(VXFullUVB, nWidthUV, nHeightUV, VPitchUV, VXSmallUVB, nBlkX, nBlkX, dummyplane, yc_beg, yc_end);
+	upsizerUV->SimpleResizeDo(VYFullUVB, nWidthUV, nHeightUV, VPitchUV, VYSmallUVB, nBlkX, nBlkX, dummyplane, yc_beg, yc_end);
+
+	upsizer->SimpleResizeDo(VXFullYF, nWidth, nHeight, VPitchY, VXSmallYF, nBlkX, nBlkX, dummyplane, yl_beg, yl_end);
+	upsizer->SimpleResizeDo(VYFullYF, nWidth, nHeight, VPitchY, VYSmallYF, nBlkX, nBlkX, dummyplane, yl_beg, yl_end);
+	upsizerUV->SimpleResizeDo(VXFullUVF, nWidthUV, nHeightUV, VPitchUV, VXSmallUVF, nBlkX, nBlkX, dummyplane, yc_beg, yc_end);
+	upsizerUV->SimpleResizeDo(VYFullUVF, nWidthUV, nHeightUV, VPitchUV, VYSmallUVF, nBlkX, nBlkX, dummyplane, yc_beg, yc_end);
+
+	blur_rows (0, yl_beg, yl_end);
+	blur_rows (1, yc_beg, yc_end);
+	blur_rows (2, yc_beg, yc_end);
+}
+
+
+
+void MVFlowBlur::blur_rows (int p, int y_beg, int y_end)
+{
+	const bool     luma_flag = (p == 0);
+	const int      vpitch    = luma_flag ? VPitchY : VPitchUV;
+	const int      v_ofs     = y_beg * vpitch;
+
+	FlowBlur(
+		_dst_ptr_arr [p] + y_beg * _dst_pitch_arr [p], _dst_pitch_arr [p],
+		_ref_ptr_arr [p] + y_beg * _ref_pitch_arr [p] * nPel, _ref_pitch_arr [p],
+		(luma_flag ? VXFullYB : VXFullUVB) + v_ofs,
+		(luma_flag ? VXFullYF : VXFullUVF) + v_ofs,
+		(luma_flag ? VYFullYB : VYFullUVB) + v_ofs,
+		(luma_flag ? VYFullYF : VYFullUVF) + v_ofs,
+		vpitch,
+		luma_flag ? nWidth : nWidthUV, y_end - y_beg,
+		blur256, prec);
+}
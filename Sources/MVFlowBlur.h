@@ -1,9 +1,11 @@
 #ifndef __MV_FLOWBLUR__
 #define __MV_FLOWBLUR__
 
+#include "MTSlicer.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "SimpleResize.h"
+#include "SuperFrameCache.h"
 #include "yuy2planes.h"
 
 class MVFlowBlur
@@ -17,6 +19,8 @@ private:
    int blur256; // blur time interval
    int prec; // blur precision (pixels)
    PClip finest;
+   PClip _super; // Key for the SuperFrameCache
+   SuperFrameCache::View finest_view;
    bool isse;
    bool planar;
 
@@ -64,9 +68,22 @@ private:
 
 	YUY2Planes * DstPlanes;
 
+	typedef	MTSlicer <MVFlowBlur>	Slicer;
+
+	void           process_slice (Slicer::TaskData &td);
+	void           blur_rows (int p, int y_beg, int y_end);
+
+	bool           _mt_flag;
+
+	// Processing variables
+	BYTE *         _dst_ptr_arr [3];
+	int            _dst_pitch_arr [3];
+	const BYTE *   _ref_ptr_arr [3];	// Top-left of the picture, padding skipped
+	int            _ref_pitch_arr [3];
+
 public:
 	MVFlowBlur(PClip _child, PClip _finest, PClip _mvbw, PClip _mvfw, int _blur256, int _prec,
-                int nSCD1, int nSCD2, bool isse, bool _planar, IScriptEnvironment* env);
+                int nSCD1, int nSCD2, bool isse, bool _planar, bool mt_flag, IScriptEnvironment* env);
 	~MVFlowBlur();
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env);
 };
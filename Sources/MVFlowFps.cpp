@@ -19,20 +19,21 @@
 
 #include "ClipFnc.h"
 #include "commonfunctions.h"
+#include "FuncDispatch.h"
 #include "MaskFun.h"
 #include "MVFinest.h"
 #include "MVFlowFps.h"
-#include "profile.h"
 #include "SuperParams64Bits.h"
 #include "Time256ProviderCst.h"
 
 
 MVFlowFps::MVFlowFps(PClip _child, PClip super, PClip _mvbw, PClip _mvfw,  unsigned int _num, unsigned int _den, int _maskmode, double _ml,
-                           bool _blend, int nSCD1, int nSCD2, bool _isse, bool _planar, IScriptEnvironment* env) :
+                           bool _blend, int nSCD1, int nSCD2, bool _isse, bool _planar, bool mt_flag, IScriptEnvironment* env) :
 GenericVideoFilter(_child),
 MVFilter(_mvfw, "MFlowFps", env, 1, 0),
 mvClipB(_mvbw, nSCD1, nSCD2, env, 1, 0),
-mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
+mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0),
+_mt_flag(mt_flag)
 {
 	numeratorOld = vi.fps_numerator;
 	denominatorOld = vi.fps_denominator;
@@ -68,6 +69,7 @@ mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
    ml = _ml;
 //   nIdx = _nIdx;
    isse = _isse;
+	_avx2_flag = (FuncDispatch::select_tier (isse) >= FuncDispatch::Tier_AVX2);
    planar = _planar;
    blend = _blend;
 
@@ -135,46 +137,6 @@ mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
 	VPitchY = (nWidthP + 15) & (~15);
 	VPitchUV = (nWidthPUV + 15) & (~15);
 
-	VXFullYB = new BYTE [nHeightP*VPitchY];
-	VXFullUVB = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYB = new BYTE [nHeightP*VPitchY];
-	VYFullUVB = new BYTE [nHeightPUV*VPitchUV];
-
-	VXFullYF = new BYTE [nHeightP*VPitchY];
-	VXFullUVF = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYF = new BYTE [nHeightP*VPitchY];
-	VYFullUVF = new BYTE [nHeightPUV*VPitchUV];
-
-	VXSmallYB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYB = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVB = new BYTE [nBlkXP*nBlkYP];
-
-	VXSmallYF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYF = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVF = new BYTE [nBlkXP*nBlkYP];
-
-	VXFullYBB = new BYTE [nHeightP*VPitchY];
-	VXFullUVBB = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYBB = new BYTE [nHeightP*VPitchY];
-	VYFullUVBB = new BYTE [nHeightPUV*VPitchUV];
-
-	VXFullYFF = new BYTE [nHeightP*VPitchY];
-	VXFullUVFF = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYFF = new BYTE [nHeightP*VPitchY];
-	VYFullUVFF = new BYTE [nHeightPUV*VPitchUV];
-
-	VXSmallYBB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYBB = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVBB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVBB = new BYTE [nBlkXP*nBlkYP];
-
-	VXSmallYFF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYFF = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVFF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVFF = new BYTE [nBlkXP*nBlkYP];
-
 	MaskSmallB = new BYTE [nBlkXP*nBlkYP];
 	MaskFullYB = new BYTE [nHeightP*VPitchY];
 	MaskFullUVB = new BYTE [nHeightPUV*VPitchUV];
@@ -192,8 +154,10 @@ mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
 	upsizer = new SimpleResize(nWidthP, nHeightP, nBlkXP, nBlkYP, CPUF_Resize);
 	upsizerUV = new SimpleResize(nWidthPUV, nHeightPUV, nBlkXP, nBlkYP, CPUF_Resize);
 
-	LUTVB = new short[256];
-	LUTVF = new short[256];
+	_vect_maps_aptr = std::auto_ptr <FlowVectMaps> (new FlowVectMaps (
+		nBlkX, nBlkY, nBlkXP, nBlkYP,
+		nWidthP, nHeightP, nWidthPUV, nHeightPUV, yRatioUV
+	));
 
 	nleftLast = -1000;
 	nrightLast = -1000;
@@ -210,10 +174,15 @@ mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0)
 //		}
    }
 
+	_super      = super;
+	finest_view = (nPel == 1) ? SuperFrameCache::View_SUPER : SuperFrameCache::View_FINEST;
+	SuperFrameCache::add_client (_super);
 }
 
 MVFlowFps::~MVFlowFps()
 {
+	SuperFrameCache::remove_client (_super);
+
    if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2  && !planar)
    {
 //	delete SrcPlanes;
@@ -229,40 +198,6 @@ MVFlowFps::~MVFlowFps()
 	delete upsizer;
 	delete upsizerUV;
 
-	delete [] VXFullYB;
-	delete [] VXFullUVB;
-	delete [] VYFullYB;
-	delete [] VYFullUVB;
-	delete [] VXSmallYB;
-	delete [] VYSmallYB;
-	delete [] VXSmallUVB;
-	delete [] VYSmallUVB;
-	delete [] VXFullYF;
-	delete [] VXFullUVF;
-	delete [] VYFullYF;
-	delete [] VYFullUVF;
-	delete [] VXSmallYF;
-	delete [] VYSmallYF;
-	delete [] VXSmallUVF;
-	delete [] VYSmallUVF;
-
-	delete [] VXFullYBB;
-	delete [] VXFullUVBB;
-	delete [] VYFullYBB;
-	delete [] VYFullUVBB;
-	delete [] VXSmallYBB;
-	delete [] VYSmallYBB;
-	delete [] VXSmallUVBB;
-	delete [] VYSmallUVBB;
-	delete [] VXFullYFF;
-	delete [] VXFullUVFF;
-	delete [] VYFullYFF;
-	delete [] VYFullUVFF;
-	delete [] VXSmallYFF;
-	delete [] VYSmallYFF;
-	delete [] VXSmallUVFF;
-	delete [] VYSmallUVFF;
-
 	delete [] MaskSmallB;
 	delete [] MaskFullYB;
 	delete [] MaskFullUVB;
@@ -272,8 +207,6 @@ MVFlowFps::~MVFlowFps()
 
 	delete [] SADMaskSmallB;
 	delete [] SADMaskSmallF;
-	 delete [] LUTVB;
-	 delete [] LUTVF;
 
 //    if (isSuper)
 //    {
@@ -338,11 +271,10 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
 	if (mvClipF.IsBackward())
 			env->ThrowError("MFlowFps: wrong forward vectors");
 
-	PVideoFrame	src	= finest->GetFrame(nleft, env); // move here - v2.0
-	PVideoFrame ref = finest->GetFrame(nright, env);//  right frame for  compensation
+	PVideoFrame	src	= SuperFrameCache::get_frame (_super, nleft, *env, finest_view, &finest); // move here - v2.0
+	PVideoFrame ref = SuperFrameCache::get_frame (_super, nright, *env, finest_view, &finest);//  right frame for  compensation
 
-	Create_LUTV(time256, LUTVB, LUTVF); // lookup table
-	const Time256ProviderCst	t256_prov_cst (time256, LUTVB, LUTVF);
+	const Time256ProviderCst	t256_prov_cst (time256, 0, 0);
 
 //   int sharp = mvClipB.GetSharp();
 
@@ -355,8 +287,6 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
 //         PMVGroupOfFrames pRefGOFF = pFrames->GetFrame(nleft); // forward ref
 //         PMVGroupOfFrames pRefGOFB = pFrames->GetFrame(nright); // backward ref
 
-      PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
-
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
 		{
             // planar data packed to interleaved format (same as interleved2planar by kassandro) - v2.0.0.5
@@ -419,8 +349,6 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
          nSrcPitches[2] = VPITCH(src);
 		}
 
-      PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
-
 //         MVPlane *pPlanesB[3];
 //         MVPlane *pPlanesF[3];
 
@@ -441,51 +369,33 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
     int nOffsetY = nRefPitches[0] * nVPadding*nPel + nHPadding*nPel;
     int nOffsetUV = nRefPitches[1] * nVPaddingUV*nPel + nHPaddingUV*nPel;
 
-		int dummyplane = PLANAR_Y; // use luma plane resizer code for all planes if we resize from luma small mask
-
-		 if (nright != nrightLast)
-		 {
-      PROFILE_START(MOTION_PROFILE_MASK);
-			// make  vector vx and vy small masks
-			// 1. ATTENTION: vectors are assumed SHORT (|vx|, |vy| < 127) !
-			// 2. they will be zeroed if not
-			// 3. added 128 to all values
-			MakeVectorSmallMasks(mvClipB, nBlkX, nBlkY, VXSmallYB, nBlkXP, VYSmallYB, nBlkXP);
-			if (nBlkXP > nBlkX) // fill right
-			{
-				for (int j=0; j<nBlkY; j++)
-				{
-					VXSmallYB[j*nBlkXP + nBlkX] = std::min(VXSmallYB[j*nBlkXP + nBlkX-1], uint8_t (128));
-					VYSmallYB[j*nBlkXP + nBlkX] = VYSmallYB[j*nBlkXP + nBlkX-1];
-				}
-			}
-			if (nBlkYP > nBlkY) // fill bottom
-			{
-				for (int i=0; i<nBlkXP; i++)
-				{
-					VXSmallYB[nBlkXP*nBlkY +i] = VXSmallYB[nBlkXP*(nBlkY-1) +i];
-					VYSmallYB[nBlkXP*nBlkY +i] = std::min(VYSmallYB[nBlkXP*(nBlkY-1) +i], uint8_t (128));
-				}
-			}
-			VectorSmallMaskYToHalfUV(VXSmallYB, nBlkXP, nBlkYP, VXSmallUVB, 2);
-			VectorSmallMaskYToHalfUV(VYSmallYB, nBlkXP, nBlkYP, VYSmallUVB, yRatioUV);
-
-      PROFILE_STOP(MOTION_PROFILE_MASK);
-			// upsize (bilinear interpolate) vector masks to fullframe size
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-
-		  upsizer->SimpleResizeDo(VXFullYB, nWidthP, nHeightP, VPitchY, VXSmallYB, nBlkXP, nBlkXP, dummyplane);
-		  upsizer->SimpleResizeDo(VYFullYB, nWidthP, nHeightP, VPitchY, VYSmallYB, nBlkXP, nBlkXP, dummyplane);
-		  upsizerUV->SimpleResizeDo(VXFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVB, nBlkXP, nBlkXP, dummyplane);
-		  upsizerUV->SimpleResizeDo(VYFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVB, nBlkXP, nBlkXP, dummyplane);
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
-
-		 }
+		_dst_ptr_arr [0] = pDst [0];
+		_dst_ptr_arr [1] = pDst [1];
+		_dst_ptr_arr [2] = pDst [2];
+		_dst_pitch_arr [0] = nDstPitches [0];
+		_dst_pitch_arr [1] = nDstPitches [1];
+		_dst_pitch_arr [2] = nDstPitches [2];
+		_ref_ptr_arr [0] = pRef [0] + nOffsetY;
+		_ref_ptr_arr [1] = pRef [1] + nOffsetUV;
+		_ref_ptr_arr [2] = pRef [2] + nOffsetUV;
+		_src_ptr_arr [0] = pSrc [0] + nOffsetY;
+		_src_ptr_arr [1] = pSrc [1] + nOffsetUV;
+		_src_ptr_arr [2] = pSrc [2] + nOffsetUV;
+		_ref_pitch_arr [0] = nRefPitches [0];
+		_ref_pitch_arr [1] = nRefPitches [1];
+		_ref_pitch_arr [2] = nRefPitches [2];
+		_time256 = time256;
+
+		// The vector masks are built here at the block resolution. Their
+		// upsizing to the full frame size and the interpolation itself are
+		// done later, slice by slice.
+		_upsize_b_flag = (nright != nrightLast);
+		if (_upsize_b_flag)
+		{
+			_vect_maps_aptr->build_small (FlowVectMaps::Dir_B, mvClipB);
+		}
 		// analyse vectors field to detect occlusion
-      PROFILE_START(MOTION_PROFILE_MASK);
-//		double occNormB = (256-time256)/(256*ml);
-//		MakeVectorOcclusionMask(mvClipB, nBlkX, nBlkY, occNormB, 1.0, nPel, MaskSmallB, nBlkXP);
-        MakeVectorOcclusionMaskTime(mvClipB, nBlkX, nBlkY, ml, 1.0, nPel, MaskSmallB, nBlkXP, (256-time256), nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY);
+		MakeVectorOcclusionMaskTime(mvClipB, nBlkX, nBlkY, ml, 1.0, nPel, MaskSmallB, nBlkXP, (256-time256), nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY);
 		if (nBlkXP > nBlkX) // fill right
 		{
 			for (int j=0; j<nBlkY; j++)
@@ -500,59 +410,15 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
 				MaskSmallB[nBlkXP*nBlkY +i] = MaskSmallB[nBlkXP*(nBlkY-1) +i];
 			}
 		}
-      PROFILE_STOP(MOTION_PROFILE_MASK);
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-	  // upsize (bilinear interpolate) vector masks to fullframe size
-	    upsizer->SimpleResizeDo(MaskFullYB, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(MaskFullUVB, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP, dummyplane);
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
-
-		 nrightLast = nright;
-
-
-		 if(nleft != nleftLast)
-		 {
-			// make  vector vx and vy small masks
-			// 1. ATTENTION: vectors are assumed SHORT (|vx|, |vy| < 127) !
-			// 2. they will be zeroed if not
-			// 3. added 128 to all values
-      PROFILE_START(MOTION_PROFILE_MASK);
-			MakeVectorSmallMasks(mvClipF, nBlkX, nBlkY, VXSmallYF, nBlkXP, VYSmallYF, nBlkXP);
-			if (nBlkXP > nBlkX) // fill right
-			{
-				for (int j=0; j<nBlkY; j++)
-				{
-					VXSmallYF[j*nBlkXP + nBlkX] = std::min(VXSmallYF[j*nBlkXP + nBlkX-1], uint8_t (128));
-					VYSmallYF[j*nBlkXP + nBlkX] = VYSmallYF[j*nBlkXP + nBlkX-1];
-				}
-			}
-			if (nBlkYP > nBlkY) // fill bottom
-			{
-				for (int i=0; i<nBlkXP; i++)
-				{
-					VXSmallYF[nBlkXP*nBlkY +i] = VXSmallYF[nBlkXP*(nBlkY-1) +i];
-					VYSmallYF[nBlkXP*nBlkY +i] = std::min(VYSmallYF[nBlkXP*(nBlkY-1) +i], uint8_t (128));
-				}
-			}
-			VectorSmallMaskYToHalfUV(VXSmallYF, nBlkXP, nBlkYP, VXSmallUVF, 2);
-			VectorSmallMaskYToHalfUV(VYSmallYF, nBlkXP, nBlkYP, VYSmallUVF, yRatioUV);
-
-      PROFILE_STOP(MOTION_PROFILE_MASK);
-			// upsize (bilinear interpolate) vector masks to fullframe size
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-
-		  upsizer->SimpleResizeDo(VXFullYF, nWidthP, nHeightP, VPitchY, VXSmallYF, nBlkXP, nBlkXP, dummyplane);
-		  upsizer->SimpleResizeDo(VYFullYF, nWidthP, nHeightP, VPitchY, VYSmallYF, nBlkXP, nBlkXP, dummyplane);
-		  upsizerUV->SimpleResizeDo(VXFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVF, nBlkXP, nBlkXP, dummyplane);
-		  upsizerUV->SimpleResizeDo(VYFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVF, nBlkXP, nBlkXP, dummyplane);
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
+		nrightLast = nright;
 
-		 }
+		_upsize_f_flag = (nleft != nleftLast);
+		if (_upsize_f_flag)
+		{
+			_vect_maps_aptr->build_small (FlowVectMaps::Dir_F, mvClipF);
+		}
 		// analyse vectors field to detect occlusion
-      PROFILE_START(MOTION_PROFILE_MASK);
-//		double occNormF = time256/(256*ml);
-//		MakeVectorOcclusionMask(mvClipF, nBlkX, nBlkY, occNormF, 1.0, nPel, MaskSmallF, nBlkXP);
-        MakeVectorOcclusionMaskTime(mvClipF, nBlkX, nBlkY, ml, 1.0, nPel, MaskSmallF, nBlkXP, time256, nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY);
+		MakeVectorOcclusionMaskTime(mvClipF, nBlkX, nBlkY, ml, 1.0, nPel, MaskSmallF, nBlkXP, time256, nBlkSizeX - nOverlapX, nBlkSizeY - nOverlapY);
 		if (nBlkXP > nBlkX) // fill right
 		{
 			for (int j=0; j<nBlkY; j++)
@@ -567,210 +433,45 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
 				MaskSmallF[nBlkXP*nBlkY +i] = MaskSmallF[nBlkXP*(nBlkY-1) +i];
 			}
 		}
-      PROFILE_STOP(MOTION_PROFILE_MASK);
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-	  // upsize (bilinear interpolate) vector masks to fullframe size
-	    upsizer->SimpleResizeDo(MaskFullYF, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(MaskFullUVF, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP, dummyplane);
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
+		nleftLast = nleft;
 
-		 nleftLast = nleft;
+		// Get motion info from more frames for occlusion areas
+		PVideoFrame mvFF = mvClipF.GetFrame(nleft, env);
+		mvClipF.Update(mvFF, env);// forward from prev to cur
+		mvFF = 0;
 
-    // Get motion info from more frames for occlusion areas
-	PVideoFrame mvFF = mvClipF.GetFrame(nleft, env);
-    mvClipF.Update(mvFF, env);// forward from prev to cur
-    mvFF = 0;
+		PVideoFrame mvBB = mvClipB.GetFrame(nright, env);
+		mvClipB.Update(mvBB, env);// backward from next next to next
+		mvBB = 0;
 
-	PVideoFrame mvBB = mvClipB.GetFrame(nright, env);
-    mvClipB.Update(mvBB, env);// backward from next next to next
-    mvBB = 0;
+		if ( mvClipB.IsUsable()  && mvClipF.IsUsable() && maskmode==2) // slow method with extra frames
+		{
+			_inter_mode = InterMode_EXTRA;
 
-   if ( mvClipB.IsUsable()  && mvClipF.IsUsable() && maskmode==2) // slow method with extra frames
-   {
-    // get vector mask from extra frames
-      PROFILE_START(MOTION_PROFILE_MASK);
-	MakeVectorSmallMasks(mvClipB, nBlkX, nBlkY, VXSmallYBB, nBlkXP, VYSmallYBB, nBlkXP);
-	MakeVectorSmallMasks(mvClipF, nBlkX, nBlkY, VXSmallYFF, nBlkXP, VYSmallYFF, nBlkXP);
-	if (nBlkXP > nBlkX) // fill right
-	{
-		for (int j=0; j<nBlkY; j++)
+			// get vector mask from extra frames
+			_vect_maps_aptr->build_small (FlowVectMaps::Dir_BB, mvClipB);
+			_vect_maps_aptr->build_small (FlowVectMaps::Dir_FF, mvClipF);
+		}
+		else if (maskmode==1) // old method without extra frames
 		{
-			VXSmallYBB[j*nBlkXP + nBlkX] = std::min(VXSmallYBB[j*nBlkXP + nBlkX-1], uint8_t (128));
-			VYSmallYBB[j*nBlkXP + nBlkX] = VYSmallYBB[j*nBlkXP + nBlkX-1];
-			VXSmallYFF[j*nBlkXP + nBlkX] = std::min(VXSmallYFF[j*nBlkXP + nBlkX-1], uint8_t (128));
-			VYSmallYFF[j*nBlkXP + nBlkX] = VYSmallYFF[j*nBlkXP + nBlkX-1];
+			_inter_mode = InterMode_NORMAL;
 		}
-	}
-	if (nBlkYP > nBlkY) // fill bottom
-	{
-		for (int i=0; i<nBlkXP; i++)
+		else // mode=0, faster simple method
 		{
-			VXSmallYBB[nBlkXP*nBlkY +i] = VXSmallYBB[nBlkXP*(nBlkY-1) +i];
-			VYSmallYBB[nBlkXP*nBlkY +i] = std::min(VYSmallYBB[nBlkXP*(nBlkY-1) +i], uint8_t (128));
-			VXSmallYFF[nBlkXP*nBlkY +i] = VXSmallYFF[nBlkXP*(nBlkY-1) +i];
-			VYSmallYFF[nBlkXP*nBlkY +i] = std::min(VYSmallYFF[nBlkXP*(nBlkY-1) +i], uint8_t (128));
+			_inter_mode = InterMode_SIMPLE;
 		}
-	}
-	VectorSmallMaskYToHalfUV(VXSmallYBB, nBlkXP, nBlkYP, VXSmallUVBB, 2);
-	VectorSmallMaskYToHalfUV(VYSmallYBB, nBlkXP, nBlkYP, VYSmallUVBB, yRatioUV);
-	VectorSmallMaskYToHalfUV(VXSmallYFF, nBlkXP, nBlkYP, VXSmallUVFF, 2);
-	VectorSmallMaskYToHalfUV(VYSmallYFF, nBlkXP, nBlkYP, VYSmallUVFF, yRatioUV);
-      PROFILE_STOP(MOTION_PROFILE_MASK);
-
-      PROFILE_START(MOTION_PROFILE_RESIZE);
-    // upsize vectors to full frame
-	  upsizer->SimpleResizeDo(VXFullYBB, nWidthP, nHeightP, VPitchY, VXSmallYBB, nBlkXP, nBlkXP, dummyplane);
-	  upsizer->SimpleResizeDo(VYFullYBB, nWidthP, nHeightP, VPitchY, VYSmallYBB, nBlkXP, nBlkXP, dummyplane);
-	  upsizerUV->SimpleResizeDo(VXFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVBB, nBlkXP, nBlkXP, dummyplane);
-	  upsizerUV->SimpleResizeDo(VYFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVBB, nBlkXP, nBlkXP, dummyplane);
-
-	  upsizer->SimpleResizeDo(VXFullYFF, nWidthP, nHeightP, VPitchY, VXSmallYFF, nBlkXP, nBlkXP, dummyplane);
-	  upsizer->SimpleResizeDo(VYFullYFF, nWidthP, nHeightP, VPitchY, VYSmallYFF, nBlkXP, nBlkXP, dummyplane);
-	  upsizerUV->SimpleResizeDo(VXFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVFF, nBlkXP, nBlkXP, dummyplane);
-	  upsizerUV->SimpleResizeDo(VYFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVFF, nBlkXP, nBlkXP, dummyplane);
-      PROFILE_STOP(MOTION_PROFILE_RESIZE);
-
-      PROFILE_START(MOTION_PROFILE_FLOWINTER);
-/*      if (isSuper)
-      {
-		  if (nPel>=2)
-		  {
-			FlowInterExtraPel(pDst[0], nDstPitches[0], pPlanesB[0], pPlanesF[0], 0,
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, time256, nPel, LUTVB, LUTVF, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-			if (nSuperModeYUV & UPLANE) FlowInterExtraPel(pDst[1], nDstPitches[1], pPlanesB[1], pPlanesF[1], 0,
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-			if (nSuperModeYUV & VPLANE) FlowInterExtraPel(pDst[2], nDstPitches[2], pPlanesB[2], pPlanesF[2], 0,
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-
-		  }
-		  else if (nPel==1)
-		  {
-			FlowInterExtra(pDst[0], nDstPitches[0], pPlanesB[0]->GetPointerPel1(0,0), pPlanesF[0]->GetPointerPel1(0,0), pPlanesB[0]->GetPitch(),
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, time256, nPel, LUTVB, LUTVF, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-			if (nSuperModeYUV & UPLANE) FlowInterExtra(pDst[1], nDstPitches[1], pPlanesB[1]->GetPointerPel1(0,0), pPlanesF[1]->GetPointerPel1(0,0), pPlanesB[1]->GetPitch(),
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-			if (nSuperModeYUV & VPLANE) FlowInterExtra(pDst[2], nDstPitches[2], pPlanesB[2]->GetPointerPel1(0,0), pPlanesF[2]->GetPointerPel1(0,0), pPlanesB[2]->GetPitch(),
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-		  }
-      }
-      else // finest mode
-*/      {
-			FlowInterExtra(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, nPel, t256_prov_cst, VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-			FlowInterExtra(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, nPel, t256_prov_cst, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-			FlowInterExtra(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, nPel, t256_prov_cst, VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-      }
-      PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
-   }
-   else if (maskmode==1) // old method without extra frames
-   {
-     PROFILE_START(MOTION_PROFILE_FLOWINTER);
-/*     if (isSuper)
-     {
-		  if (nPel>=2)
-		  {
-			FlowInterPel(pDst[0], nDstPitches[0], pPlanesB[0], pPlanesF[0], 0,
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & UPLANE) FlowInterPel(pDst[1], nDstPitches[1], pPlanesB[1], pPlanesF[1], 0,
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & VPLANE) FlowInterPel(pDst[2], nDstPitches[2], pPlanesB[2], pPlanesF[2], 0,
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-
-		  }
-		  else if (nPel==1)
-		  {
-			FlowInter(pDst[0], nDstPitches[0], pPlanesB[0]->GetPointerPel1(0,0), pPlanesF[0]->GetPointerPel1(0,0), pPlanesB[0]->GetPitch(),
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & UPLANE) FlowInter(pDst[1], nDstPitches[1], pPlanesB[1]->GetPointerPel1(0,0), pPlanesF[1]->GetPointerPel1(0,0), pPlanesB[1]->GetPitch(),
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & VPLANE) FlowInter(pDst[2], nDstPitches[2], pPlanesB[2]->GetPointerPel1(0,0), pPlanesF[2]->GetPointerPel1(0,0), pPlanesB[2]->GetPitch(),
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-		  }
-     }
-     else // finest
-*/     {
-			FlowInter(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, nPel, t256_prov_cst);
-			FlowInter(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, nPel, t256_prov_cst);
-			FlowInter(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, nPel, t256_prov_cst);
-     }
-    PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
-   }
-   else // mode=0, faster simple method
-   {
 
-     PROFILE_START(MOTION_PROFILE_FLOWINTER);
-/*     if (isSuper)
-     {
-		  if (nPel>=2)
-		  {
-			FlowInterSimplePel(pDst[0], nDstPitches[0], pPlanesB[0], pPlanesF[0], 0,
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & UPLANE) FlowInterSimplePel(pDst[1], nDstPitches[1], pPlanesB[1], pPlanesF[1], 0,
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & VPLANE) FlowInterSimplePel(pDst[2], nDstPitches[2], pPlanesB[2], pPlanesF[2], 0,
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-
-		  }
-		  else if (nPel==1)
-		  {
-			FlowInterSimple(pDst[0], nDstPitches[0], pPlanesB[0]->GetPointerPel1(0,0), pPlanesF[0]->GetPointerPel1(0,0), pPlanesB[0]->GetPitch(),
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & UPLANE) FlowInterSimple(pDst[1], nDstPitches[1], pPlanesB[1]->GetPointerPel1(0,0), pPlanesF[1]->GetPointerPel1(0,0), pPlanesB[1]->GetPitch(),
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-			if (nSuperModeYUV & VPLANE) FlowInterSimple(pDst[2], nDstPitches[2], pPlanesB[2]->GetPointerPel1(0,0), pPlanesF[2]->GetPointerPel1(0,0), pPlanesB[2]->GetPitch(),
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, time256, nPel, LUTVB, LUTVF);
-		  }
-     }
-     else // finest
-*/     {
-			FlowInterSimple(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-				VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-				nWidth, nHeight, nPel, t256_prov_cst);
-			FlowInterSimple(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, nPel, t256_prov_cst);
-			FlowInterSimple(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-				VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-				nWidthUV, nHeightUV, nPel, t256_prov_cst);
-     }
-     PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
-   }
-      PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
+		// Slices are made of chroma rows, so the luma and chroma rows of a
+		// slice always match.
+		Slicer         slicer (_mt_flag);
+		slicer.start (nHeightPUV, *this, &MVFlowFps::process_slice, 4);
+		slicer.wait ();
+
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 		{
 			YUY2FromPlanes(pDstYUY2, nDstPitchYUY2, nWidth, nHeight,
 								  pDst[0], nDstPitches[0], pDst[1], pDst[2], nDstPitches[1], isse);
 		}
-      PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
 		return dst;
    }
    else
@@ -783,7 +484,6 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
 	if (blend) //let's blend src with ref frames like ConvertFPS
 	{
         PVideoFrame ref = child->GetFrame(nright,env);
-      PROFILE_START(MOTION_PROFILE_FLOWINTER);
         if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
 		{
 			pSrc[0] = src->GetReadPtr(); // we can blend YUY2
@@ -821,7 +521,6 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
         Blend(pDst[1], pSrc[1], pRef[1], nHeightUV, nWidthUV, nDstPitches[1], nSrcPitches[1], nRefPitches[1], t256_prov_cst, isse);
         Blend(pDst[2], pSrc[2], pRef[2], nHeightUV, nWidthUV, nDstPitches[2], nSrcPitches[2], nRefPitches[2], t256_prov_cst, isse);
 		}
-     PROFILE_STOP(MOTION_PROFILE_FLOWINTER);
 
 		return dst;
 	}
@@ -833,3 +532,103 @@ PVideoFrame __stdcall MVFlowFps::GetFrame(int n, IScriptEnvironment* env)
    }
 
 }
+
+
+
+// Slices are counted in chroma rows. The last slice includes the remaining
+// luma rows when the luma height is not a multiple of the chroma ratio.
+void MVFlowFps::process_slice (Slicer::TaskData &td)
+{
+	const int      yc_beg = td._y_beg;
+	const int      yc_end = td._y_end;
+	const int      yl_beg = yc_beg * yRatioUV;
+	const int      yl_end = (yc_end == nHeightPUV) ? nHeightP : yc_end * yRatioUV;
+
+	// A row of the interpolated picture only uses the same row of the
+	// full-size masks, so there is no need to wait for the other slices.
+	upsize_rows (yl_beg, yl_end, yc_beg, yc_end);
+
+	interpolate_rows (0, std::min (yl_beg, nHeight  ), std::min (yl_end, nHeight  ));
+	interpolate_rows (1, std::min (yc_beg, nHeightUV), std::min (yc_end, nHeightUV));
+	interpolate_rows (2, std::min (yc_beg, nHeightUV), std::min (yc_end, nHeightUV));
+}
+
+
+
+void MVFlowFps::upsize_rows (int yl_beg, int yl_end, int yc_beg, int yc_end)
+{
+	const int      dummyplane = PLANAR_Y; // use luma plane resizer code for all planes if we resize from luma small mask
+	FlowVectMaps & vm = *_vect_maps_aptr;
+
+	if (_upsize_b_flag)
+	{
+		vm.upsize_rows (FlowVectMaps::Dir_B, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+	}
+	upsizer->SimpleResizeDo(MaskFullYB, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP, dummyplane, yl_beg, yl_end);
+	upsizerUV->SimpleResizeDo(MaskFullUVB, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP, dummyplane, yc_beg, yc_end);
+
+	if (_upsize_f_flag)
+	{
+		vm.upsize_rows (FlowVectMaps::Dir_F, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+	}
+	upsizer->SimpleResizeDo(MaskFullYF, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP, dummyplane, yl_beg, yl_end);
+	upsizerUV->SimpleResizeDo(MaskFullUVF, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP, dummyplane, yc_beg, yc_end);
+
+	if (_inter_mode == InterMode_EXTRA)
+	{
+		vm.upsize_rows (FlowVectMaps::Dir_BB, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+		vm.upsize_rows (FlowVectMaps::Dir_FF, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+	}
+}
+
+
+
+void MVFlowFps::interpolate_rows (int p, int y_beg, int y_end)
+{
+	if (y_beg >= y_end)
+	{
+		return;
+	}
+
+	const bool     luma_flag = (p == 0);
+	const FlowVectMaps::Res	res = luma_flag ? FlowVectMaps::Res_LUMA : FlowVectMaps::Res_CHROMA;
+	const FlowVectMaps &	vm = *_vect_maps_aptr;
+	const int      vpitch    = vm.get_full_pitch (res);
+	const int      mpitch    = luma_flag ? VPitchY : VPitchUV;
+	const int      m_ofs     = y_beg * mpitch;
+	const int      ref_ofs   = y_beg * _ref_pitch_arr [p] * nPel;
+	BYTE *         pdst      = _dst_ptr_arr [p] + y_beg * _dst_pitch_arr [p];
+	const BYTE *   prefB     = _ref_ptr_arr [p] + ref_ofs;
+	const BYTE *   prefF     = _src_ptr_arr [p] + ref_ofs;
+	const int      width     = luma_flag ? nWidth : nWidthUV;
+	const int      height    = y_end - y_beg;
+
+	const int16_t* vb  = vm.use_full (FlowVectMaps::Dir_B, res, y_beg);
+	const int16_t* vf  = vm.use_full (FlowVectMaps::Dir_F, res, y_beg);
+	const BYTE *   mb  = (luma_flag ? MaskFullYB  : MaskFullUVB ) + m_ofs;
+	const BYTE *   mf  = (luma_flag ? MaskFullYF  : MaskFullUVF ) + m_ofs;
+
+	// No LUT needed, the vectors are scaled on the fly
+	const Time256ProviderCst	t256_prov_cst (_time256, 0, 0);
+
+	switch (_inter_mode)
+	{
+	case InterMode_EXTRA:
+		FlowInterExtra(pdst, _dst_pitch_arr [p], prefB, prefF, _ref_pitch_arr [p],
+			vb, vf, vpitch, mb, mf, mpitch,
+			width, height, nPel, t256_prov_cst,
+			vm.use_full (FlowVectMaps::Dir_BB, res, y_beg),
+			vm.use_full (FlowVectMaps::Dir_FF, res, y_beg), _avx2_flag);
+		break;
+	case InterMode_NORMAL:
+		FlowInter(pdst, _dst_pitch_arr [p], prefB, prefF, _ref_pitch_arr [p],
+			vb, vf, vpitch, mb, mf, mpitch,
+			width, height, nPel, t256_prov_cst, _avx2_flag);
+		break;
+	default:
+		FlowInterSimple(pdst, _dst_pitch_arr [p], prefB, prefF, _ref_pitch_arr [p],
+			vb, vf, vpitch, mb, mf, mpitch,
+			width, height, nPel, t256_prov_cst, _avx2_flag);
+		break;
+	}
+}
@@ -1,11 +1,16 @@
 #ifndef __MV_FLOWFPS__
 #define __MV_FLOWFPS__
 
+#include "FlowVectMaps.h"
+#include "MTSlicer.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "SimpleResize.h"
+#include "SuperFrameCache.h"
 #include "yuy2planes.h"
 
+#include <memory>
+
 class MVFlowFps
 :	public GenericVideoFilter
 ,	public MVFilter
@@ -26,6 +31,8 @@ private:
    bool blend;
 
    PClip finest; // v2.0
+   PClip _super; // Key for the SuperFrameCache
+   SuperFrameCache::View finest_view;
 
 /*   PClip super; // v2.0
     int nSuperWidth;
@@ -41,42 +48,6 @@ private:
 
    __int64 fa, fb;
 
-   // fullframe vector mask
-   BYTE *VXFullYB; //backward
-   BYTE *VXFullUVB;
-   BYTE *VYFullYB;
-   BYTE *VYFullUVB;
-   BYTE *VXFullYF;
-   BYTE *VXFullUVF;
-   BYTE *VYFullYF;
-   BYTE *VYFullUVF;
-   BYTE *VXFullYBB; //backward backward
-   BYTE *VXFullUVBB;
-   BYTE *VYFullYBB;
-   BYTE *VYFullUVBB;
-   BYTE *VXFullYFF; // forward forward
-   BYTE *VXFullUVFF;
-   BYTE *VYFullYFF;
-   BYTE *VYFullUVFF;
-
-   // Small vector mask
-   BYTE *VXSmallYB;
-   BYTE *VXSmallUVB;
-   BYTE *VYSmallYB;
-   BYTE *VYSmallUVB;
-   BYTE *VXSmallYF;
-   BYTE *VXSmallUVF;
-   BYTE *VYSmallYF;
-   BYTE *VYSmallUVF;
-   BYTE *VXSmallYBB;
-   BYTE *VXSmallUVBB;
-   BYTE *VYSmallYBB;
-   BYTE *VYSmallUVBB;
-   BYTE *VXSmallYFF;
-   BYTE *VXSmallUVFF;
-   BYTE *VYSmallYFF;
-   BYTE *VYSmallUVFF;
-
    BYTE *MaskSmallB;
    BYTE *MaskFullYB;
    BYTE *MaskFullUVB;
@@ -101,8 +72,8 @@ private:
 	 int nHPaddingUV;
 	 int nVPaddingUV;
 
-	short *LUTVB; // lookup table
-	short *LUTVF;
+	std::auto_ptr <FlowVectMaps>
+	               _vect_maps_aptr;
 
 
 /*	int pel2PitchY, pel2HeightY, pel2PitchUV, pel2HeightUV, pel2OffsetY, pel2OffsetUV;
@@ -135,9 +106,36 @@ private:
 //    MVGroupOfFrames *pRefFGOF, *pRefBGOF;
 //    int nSuperModeYUV;
 
+	typedef	MTSlicer <MVFlowFps>	Slicer;
+
+	enum InterMode
+	{
+		InterMode_SIMPLE = 0,	// maskmode 0
+		InterMode_NORMAL,			// maskmode 1
+		InterMode_EXTRA			// maskmode 2, with the extra vectors
+	};
+
+	void           process_slice (Slicer::TaskData &td);
+	void           upsize_rows (int yl_beg, int yl_end, int yc_beg, int yc_end);
+	void           interpolate_rows (int p, int y_beg, int y_end);
+
+	bool           _mt_flag;
+	bool           _avx2_flag;
+
+	// Processing variables
+	BYTE *         _dst_ptr_arr [3];
+	int            _dst_pitch_arr [3];
+	const BYTE *   _ref_ptr_arr [3];	// Top-left of the picture, padding skipped
+	const BYTE *   _src_ptr_arr [3];
+	int            _ref_pitch_arr [3];
+	int            _time256;
+	bool           _upsize_b_flag;	// Backward vector masks have to be upsized
+	bool           _upsize_f_flag;
+	InterMode      _inter_mode;
+
 public:
 	MVFlowFps(PClip _child, PClip _super, PClip _mvbw, PClip _mvfw, unsigned int _num, unsigned int _den, int _maskmode, double _ml,
-                bool _blend, int nSCD1, int nSCD2, bool isse, bool _planar, IScriptEnvironment* env);
+                bool _blend, int nSCD1, int nSCD2, bool isse, bool _planar, bool mt_flag, IScriptEnvironment* env);
 	~MVFlowFps();
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env);
 };
@@ -19,6 +19,7 @@
 // http://www.gnu.org/copyleft/gpl.html .
 
 #include "ClipFnc.h"
+#include "FuncDispatch.h"
 #include "MVFlowInter.h"
 #include "MaskFun.h"
 #include "MVFinest.h"
@@ -27,12 +28,13 @@
 #include "Time256ProviderPlane.h"
 
 MVFlowInter::MVFlowInter(PClip _child, PClip super, PClip _mvbw, PClip _mvfw,  int _time256, double _ml,
-                           bool _blend, int nSCD1, int nSCD2, bool _isse, bool _planar, PClip _timeclip, IScriptEnvironment* env) :
+                           bool _blend, int nSCD1, int nSCD2, bool _isse, bool _planar, PClip _timeclip, bool mt_flag, IScriptEnvironment* env) :
 GenericVideoFilter(_child),
 MVFilter(_mvfw, "MFlowInter", env, 1, 0),
 mvClipB(_mvbw, nSCD1, nSCD2, env, 1, 0),
 mvClipF(_mvfw, nSCD1, nSCD2, env, 1, 0),
-timeclip (_timeclip)
+timeclip (_timeclip),
+_mt_flag (mt_flag)
 {
 	if (_timeclip != 0)
 	{
@@ -50,6 +52,7 @@ timeclip (_timeclip)
 	time256 = _time256;
 	ml = _ml;
 	isse = _isse;
+	_avx2_flag = (FuncDispatch::select_tier (isse) >= FuncDispatch::Tier_AVX2);
 	planar = _planar;
 	blend = _blend;
 
@@ -104,46 +107,6 @@ timeclip (_timeclip)
 	VPitchY = (nWidthP + 15) & (~15);
 	VPitchUV = (nWidthPUV + 15) & (~15);
 
-	VXFullYB = new BYTE [nHeightP*VPitchY];
-	VXFullUVB = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYB = new BYTE [nHeightP*VPitchY];
-	VYFullUVB = new BYTE [nHeightPUV*VPitchUV];
-
-	VXFullYF = new BYTE [nHeightP*VPitchY];
-	VXFullUVF = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYF = new BYTE [nHeightP*VPitchY];
-	VYFullUVF = new BYTE [nHeightPUV*VPitchUV];
-
-	VXSmallYB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYB = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVB = new BYTE [nBlkXP*nBlkYP];
-
-	VXSmallYF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYF = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVF = new BYTE [nBlkXP*nBlkYP];
-
-	VXFullYBB = new BYTE [nHeightP*VPitchY];
-	VXFullUVBB = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYBB = new BYTE [nHeightP*VPitchY];
-	VYFullUVBB = new BYTE [nHeightPUV*VPitchUV];
-
-	VXFullYFF = new BYTE [nHeightP*VPitchY];
-	VXFullUVFF = new BYTE [nHeightPUV*VPitchUV];
-	VYFullYFF = new BYTE [nHeightP*VPitchY];
-	VYFullUVFF = new BYTE [nHeightPUV*VPitchUV];
-
-	VXSmallYBB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYBB = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVBB = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVBB = new BYTE [nBlkXP*nBlkYP];
-
-	VXSmallYFF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallYFF = new BYTE [nBlkXP*nBlkYP];
-	VXSmallUVFF = new BYTE [nBlkXP*nBlkYP];
-	VYSmallUVFF = new BYTE [nBlkXP*nBlkYP];
-
 	MaskSmallB = new BYTE [nBlkXP*nBlkYP];
 	MaskFullYB = new BYTE [nHeightP*VPitchY];
 	MaskFullUVB = new BYTE [nHeightPUV*VPitchUV];
@@ -162,31 +125,25 @@ timeclip (_timeclip)
 	upsizer = new SimpleResize(nWidthP, nHeightP, nBlkXP, nBlkYP, CPUF_Resize);
 	upsizerUV = new SimpleResize(nWidthPUV, nHeightPUV, nBlkXP, nBlkYP, CPUF_Resize);
 
-	if (timeclip == 0)
-	{
-		LUTVB = new VectLut [1];
-		LUTVF = new VectLut [1];
-		Create_LUTV(time256, LUTVB [0], LUTVF [0]);
-	}
-	else
-	{
-		LUTVB = new VectLut [256];
-		LUTVF = new VectLut [256];
-		for (int t256 = 0; t256 < 256; ++t256)
-		{
-			Create_LUTV(t256, LUTVB [t256], LUTVF [t256]);
-		}
-	}
+	_vect_maps_aptr = std::auto_ptr <FlowVectMaps> (new FlowVectMaps (
+		nBlkX, nBlkY, nBlkXP, nBlkYP,
+		nWidthP, nHeightP, nWidthPUV, nHeightPUV, yRatioUV
+	));
 
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 	{
 		DstPlanes =  new YUY2Planes(nWidth, nHeight);
 	}
 
+	_super      = super;
+	finest_view = (nPel == 1) ? SuperFrameCache::View_SUPER : SuperFrameCache::View_FINEST;
+	SuperFrameCache::add_client (_super);
 }
 
 MVFlowInter::~MVFlowInter()
 {
+	SuperFrameCache::remove_client (_super);
+
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2  && !planar)
 	{
 		delete DstPlanes;
@@ -195,40 +152,6 @@ MVFlowInter::~MVFlowInter()
 	delete upsizer;
 	delete upsizerUV;
 
-	delete [] VXFullYB;
-	delete [] VXFullUVB;
-	delete [] VYFullYB;
-	delete [] VYFullUVB;
-	delete [] VXSmallYB;
-	delete [] VYSmallYB;
-	delete [] VXSmallUVB;
-	delete [] VYSmallUVB;
-	delete [] VXFullYF;
-	delete [] VXFullUVF;
-	delete [] VYFullYF;
-	delete [] VYFullUVF;
-	delete [] VXSmallYF;
-	delete [] VYSmallYF;
-	delete [] VXSmallUVF;
-	delete [] VYSmallUVF;
-
-	delete [] VXFullYBB;
-	delete [] VXFullUVBB;
-	delete [] VYFullYBB;
-	delete [] VYFullUVBB;
-	delete [] VXSmallYBB;
-	delete [] VYSmallYBB;
-	delete [] VXSmallUVBB;
-	delete [] VYSmallUVBB;
-	delete [] VXFullYFF;
-	delete [] VXFullUVFF;
-	delete [] VYFullYFF;
-	delete [] VYFullUVFF;
-	delete [] VXSmallYFF;
-	delete [] VYSmallYFF;
-	delete [] VXSmallUVFF;
-	delete [] VYSmallUVFF;
-
 	delete [] MaskSmallB;
 	delete [] MaskFullYB;
 	delete [] MaskFullUVB;
@@ -239,9 +162,6 @@ MVFlowInter::~MVFlowInter()
 	delete [] SADMaskSmallB;
 	delete [] SADMaskSmallF;
 
-	delete [] LUTVB;
-	delete [] LUTVF;
-
 }
 
 //-------------------------------------------------------------------------
@@ -279,11 +199,11 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
 		env->ThrowError("MFlowInter: wrong forward vectors");
 
 //	int sharp = mvClipB.GetSharp();
-	PVideoFrame	src	= finest->GetFrame(n, env);
-	PVideoFrame ref = finest->GetFrame(nref, env);//  ref for  compensation
+	PVideoFrame	src	= SuperFrameCache::get_frame (_super, n, *env, finest_view, &finest);
+	PVideoFrame ref = SuperFrameCache::get_frame (_super, nref, *env, finest_view, &finest);//  ref for  compensation
 	dst = env->NewVideoFrame(vi);
 
-	const Time256ProviderCst	t256_prov_cst (time256, LUTVB [0], LUTVF [0]);
+	const Time256ProviderCst	t256_prov_cst (time256, 0, 0);
 
 	if ( mvClipB.IsUsable()  && mvClipF.IsUsable() )
 	{
@@ -379,36 +299,8 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
 		int nOffsetUV = nRefPitches[1] * nVPaddingUV*nPel + nHPaddingUV*nPel;
 
 
-		// make  vector vx and vy small masks
-		// 1. ATTENTION: vectors are assumed SHORT (|vx|, |vy| < 127) !
-		// 2. they will be zeroed if not
-		// 3. added 128 to all values
-		MakeVectorSmallMasks(mvClipB, nBlkX, nBlkY, VXSmallYB, nBlkXP, VYSmallYB, nBlkXP);
-		MakeVectorSmallMasks(mvClipF, nBlkX, nBlkY, VXSmallYF, nBlkXP, VYSmallYF, nBlkXP);
-		if (nBlkXP > nBlkX) // fill right
-		{
-			for (int j=0; j<nBlkY; j++)
-			{
-				VXSmallYB[j*nBlkXP + nBlkX] = std::min(VXSmallYB[j*nBlkXP + nBlkX-1], uint8_t (128));
-				VYSmallYB[j*nBlkXP + nBlkX] = VYSmallYB[j*nBlkXP + nBlkX-1];
-				VXSmallYF[j*nBlkXP + nBlkX] = std::min(VXSmallYF[j*nBlkXP + nBlkX-1], uint8_t (128));
-				VYSmallYF[j*nBlkXP + nBlkX] = VYSmallYF[j*nBlkXP + nBlkX-1];
-			}
-		}
-		if (nBlkYP > nBlkY) // fill bottom
-		{
-			for (int i=0; i<nBlkXP; i++)
-			{
-				VXSmallYB[nBlkXP*nBlkY +i] = VXSmallYB[nBlkXP*(nBlkY-1) +i];
-				VYSmallYB[nBlkXP*nBlkY +i] = std::min(VYSmallYB[nBlkXP*(nBlkY-1) +i], uint8_t (128));
-				VXSmallYF[nBlkXP*nBlkY +i] = VXSmallYF[nBlkXP*(nBlkY-1) +i];
-				VYSmallYF[nBlkXP*nBlkY +i] = std::min(VYSmallYF[nBlkXP*(nBlkY-1) +i], uint8_t (128));
-			}
-		}
-		VectorSmallMaskYToHalfUV(VXSmallYB, nBlkXP, nBlkYP, VXSmallUVB, 2);
-		VectorSmallMaskYToHalfUV(VYSmallYB, nBlkXP, nBlkYP, VYSmallUVB, yRatioUV);
-		VectorSmallMaskYToHalfUV(VXSmallYF, nBlkXP, nBlkYP, VXSmallUVF, 2);
-		VectorSmallMaskYToHalfUV(VYSmallYF, nBlkXP, nBlkYP, VYSmallUVF, yRatioUV);
+		_vect_maps_aptr->build_small (FlowVectMaps::Dir_B, mvClipB);
+		_vect_maps_aptr->build_small (FlowVectMaps::Dir_F, mvClipF);
 
 		// analyse vectors field to detect occlusion
 		if (timeclip == 0)
@@ -461,27 +353,6 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
 				MaskSmallF[nBlkXP*nBlkY +i] = MaskSmallF[nBlkXP*(nBlkY-1) +i];
 			}
 		}
-		// upsize (bilinear interpolate) vector masks to fullframe size
-
-
-		int dummyplane = PLANAR_Y; // use luma plane resizer code for all planes if we resize from luma small mask
-		upsizer->SimpleResizeDo(VXFullYB, nWidthP, nHeightP, VPitchY, VXSmallYB, nBlkXP, nBlkXP, dummyplane);
-		upsizer->SimpleResizeDo(VYFullYB, nWidthP, nHeightP, VPitchY, VYSmallYB, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(VXFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVB, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(VYFullUVB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVB, nBlkXP, nBlkXP, dummyplane);
-
-		upsizer->SimpleResizeDo(VXFullYF, nWidthP, nHeightP, VPitchY, VXSmallYF, nBlkXP, nBlkXP, dummyplane);
-		upsizer->SimpleResizeDo(VYFullYF, nWidthP, nHeightP, VPitchY, VYSmallYF, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(VXFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVF, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(VYFullUVF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVF, nBlkXP, nBlkXP, dummyplane);
-
-		upsizer->SimpleResizeDo(MaskFullYB, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(MaskFullUVB, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP, dummyplane);
-
-		upsizer->SimpleResizeDo(MaskFullYF, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP, dummyplane);
-		upsizerUV->SimpleResizeDo(MaskFullUVF, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP, dummyplane);
-
-
 		// Get motion info from more frames for occlusion areas
 		PVideoFrame mvFF = mvClipF.GetFrame(n, env);
 		mvClipF.Update(mvFF, env);// forward from prev to cur
@@ -490,112 +361,37 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
 		mvClipB.Update(mvBB, env);// backward from next next to next
 		mvBB = 0;
 
-		if ( mvClipB.IsUsable()  && mvClipF.IsUsable() )
+		_extra_flag = ( mvClipB.IsUsable()  && mvClipF.IsUsable() );
+		if (_extra_flag)
 		{
 			// get vector mask from extra frames
-			MakeVectorSmallMasks(mvClipB, nBlkX, nBlkY, VXSmallYBB, nBlkXP, VYSmallYBB, nBlkXP);
-			MakeVectorSmallMasks(mvClipF, nBlkX, nBlkY, VXSmallYFF, nBlkXP, VYSmallYFF, nBlkXP);
-			if (nBlkXP > nBlkX) // fill right
-			{
-				for (int j=0; j<nBlkY; j++)
-				{
-					VXSmallYBB[j*nBlkXP + nBlkX] = std::min(VXSmallYBB[j*nBlkXP + nBlkX-1], uint8_t (128));
-					VYSmallYBB[j*nBlkXP + nBlkX] = VYSmallYBB[j*nBlkXP + nBlkX-1];
-					VXSmallYFF[j*nBlkXP + nBlkX] = std::min(VXSmallYFF[j*nBlkXP + nBlkX-1], uint8_t (128));
-					VYSmallYFF[j*nBlkXP + nBlkX] = VYSmallYFF[j*nBlkXP + nBlkX-1];
-				}
-			}
-			if (nBlkYP > nBlkY) // fill bottom
-			{
-				for (int i=0; i<nBlkXP; i++)
-				{
-					VXSmallYBB[nBlkXP*nBlkY +i] = VXSmallYBB[nBlkXP*(nBlkY-1) +i];
-					VYSmallYBB[nBlkXP*nBlkY +i] = std::min(VYSmallYBB[nBlkXP*(nBlkY-1) +i], uint8_t (128));
-					VXSmallYFF[nBlkXP*nBlkY +i] = VXSmallYFF[nBlkXP*(nBlkY-1) +i];
-					VYSmallYFF[nBlkXP*nBlkY +i] = std::min(VYSmallYFF[nBlkXP*(nBlkY-1) +i], uint8_t (128));
-				}
-			}
-			VectorSmallMaskYToHalfUV(VXSmallYBB, nBlkXP, nBlkYP, VXSmallUVBB, 2);
-			VectorSmallMaskYToHalfUV(VYSmallYBB, nBlkXP, nBlkYP, VYSmallUVBB, yRatioUV);
-			VectorSmallMaskYToHalfUV(VXSmallYFF, nBlkXP, nBlkYP, VXSmallUVFF, 2);
-			VectorSmallMaskYToHalfUV(VYSmallYFF, nBlkXP, nBlkYP, VYSmallUVFF, yRatioUV);
-
-			// upsize vectors to full frame
-			upsizer->SimpleResizeDo(VXFullYBB, nWidthP, nHeightP, VPitchY, VXSmallYBB, nBlkXP, nBlkXP, dummyplane);
-			upsizer->SimpleResizeDo(VYFullYBB, nWidthP, nHeightP, VPitchY, VYSmallYBB, nBlkXP, nBlkXP, dummyplane);
-			upsizerUV->SimpleResizeDo(VXFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVBB, nBlkXP, nBlkXP, dummyplane);
-			upsizerUV->SimpleResizeDo(VYFullUVBB, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVBB, nBlkXP, nBlkXP, dummyplane);
-
-			upsizer->SimpleResizeDo(VXFullYFF, nWidthP, nHeightP, VPitchY, VXSmallYFF, nBlkXP, nBlkXP, dummyplane);
-			upsizer->SimpleResizeDo(VYFullYFF, nWidthP, nHeightP, VPitchY, VYSmallYFF, nBlkXP, nBlkXP, dummyplane);
-			upsizerUV->SimpleResizeDo(VXFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VXSmallUVFF, nBlkXP, nBlkXP, dummyplane);
-			upsizerUV->SimpleResizeDo(VYFullUVFF, nWidthPUV, nHeightPUV, VPitchUV, VYSmallUVFF, nBlkXP, nBlkXP, dummyplane);
-
-			if (timeclip == 0)
-			{
-				FlowInterExtra(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-					VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-					nWidth, nHeight, nPel, t256_prov_cst,
-					VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-				FlowInterExtra(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel, t256_prov_cst,
-					VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-				FlowInterExtra(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel, t256_prov_cst,
-					VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-			}
-			else
-			{
-				FlowInterExtra(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-					VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-					nWidth, nHeight, nPel,
-					Time256ProviderPlane (pt256 [0], nt256Pitches [0], LUTVB, LUTVF),
-					VXFullYBB, VXFullYFF, VYFullYBB, VYFullYFF);
-				FlowInterExtra(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel,
-					Time256ProviderPlane (pt256 [1], nt256Pitches [1], LUTVB, LUTVF),
-					VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-				FlowInterExtra(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel,
-					Time256ProviderPlane (pt256 [2], nt256Pitches [2], LUTVB, LUTVF),
-					VXFullUVBB, VXFullUVFF, VYFullUVBB, VYFullUVFF);
-			}
+			_vect_maps_aptr->build_small (FlowVectMaps::Dir_BB, mvClipB);
+			_vect_maps_aptr->build_small (FlowVectMaps::Dir_FF, mvClipF);
 		}
-		else // bad extra frames, use old method without extra frames
+		// else: bad extra frames, use old method without extra frames
+
+		for (int p = 0; p < 3; ++p)
 		{
-			if (timeclip == 0)
-			{
-				FlowInter(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-					VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-					nWidth, nHeight, nPel, t256_prov_cst);
-				FlowInter(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel, t256_prov_cst);
-				FlowInter(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel, t256_prov_cst);
-			}
-			else
+			const int      offset = (p == 0) ? nOffsetY : nOffsetUV;
+			_dst_ptr_arr [p]   = pDst [p];
+			_dst_pitch_arr [p] = nDstPitches [p];
+			_ref_ptr_arr [p]   = pRef [p] + offset;
+			_src_ptr_arr [p]   = pSrc [p] + offset;
+			_ref_pitch_arr [p] = nRefPitches [p];
+			if (timeclip != 0)
 			{
-				FlowInter(pDst[0], nDstPitches[0], pRef[0] + nOffsetY, pSrc[0] + nOffsetY, nRefPitches[0],
-					VXFullYB, VXFullYF, VYFullYB, VYFullYF, MaskFullYB, MaskFullYF, VPitchY,
-					nWidth, nHeight, nPel,
-					Time256ProviderPlane (pt256 [0], nt256Pitches [0], LUTVB, LUTVF));
-				FlowInter(pDst[1], nDstPitches[1], pRef[1] + nOffsetUV, pSrc[1] + nOffsetUV, nRefPitches[1],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel,
-					Time256ProviderPlane (pt256 [1], nt256Pitches [1], LUTVB, LUTVF));
-				FlowInter(pDst[2], nDstPitches[2], pRef[2] + nOffsetUV, pSrc[2] + nOffsetUV, nRefPitches[2],
-					VXFullUVB, VXFullUVF, VYFullUVB, VYFullUVF, MaskFullUVB, MaskFullUVF, VPitchUV,
-					nWidthUV, nHeightUV, nPel,
-					Time256ProviderPlane (pt256 [2], nt256Pitches [2], LUTVB, LUTVF));
+				_t256_ptr_arr [p]   = pt256 [p];
+				_t256_pitch_arr [p] = nt256Pitches [p];
 			}
 		}
 
+		// The masks are upsized to the full frame size and the picture is
+		// interpolated slice by slice. Slices are made of chroma rows, so
+		// the luma and chroma rows of a slice always match.
+		Slicer         slicer (_mt_flag);
+		slicer.start (nHeightPUV, *this, &MVFlowInter::process_slice, 4);
+		slicer.wait ();
+
 		if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 && !planar)
 		{
 			YUY2FromPlanes(pDstYUY2, nDstPitchYUY2, nWidth, nHeight,
@@ -711,3 +507,109 @@ PVideoFrame __stdcall MVFlowInter::GetFrame(int n, IScriptEnvironment* env)
 		}
 	}
 }
+
+
+
+// Slices are counted in chroma rows. The last slice includes the remaining
+// luma rows when the luma height is not a multiple of the chroma ratio.
+void MVFlowInter::process_slice (Slicer::TaskData &td)
+{
+	const int      yc_beg = td._y_beg;
+	const int      yc_end = td._y_end;
+	const int      yl_beg = yc_beg * yRatioUV;
+	const int      yl_end = (yc_end == nHeightPUV) ? nHeightP : yc_end * yRatioUV;
+
+	// A row of the interpolated picture only uses the same row of the
+	// full-size masks, so there is no need to wait for the other slices.
+	upsize_rows (yl_beg, yl_end, yc_beg, yc_end);
+
+	interpolate_rows (0, std::min (yl_beg, nHeight  ), std::min (yl_end, nHeight  ));
+	interpolate_rows (1, std::min (yc_beg, nHeightUV), std::min (yc_end, nHeightUV));
+	interpolate_rows (2, std::min (yc_beg, nHeightUV), std::min (yc_end, nHeightUV));
+}
+
+
+
+void MVFlowInter::upsize_rows (int yl_beg, int yl_end, int yc_beg, int yc_end)
+{
+	const int      dummyplane = PLANAR_Y; // use luma plane resizer code for all planes if we resize from luma small mask
+	FlowVectMaps & vm = *_vect_maps_aptr;
+
+	vm.upsize_rows (FlowVectMaps::Dir_B, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+	vm.upsize_rows (FlowVectMaps::Dir_F, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+
+	upsizer->SimpleResizeDo(MaskFullYB, nWidthP, nHeightP, VPitchY, MaskSmallB, nBlkXP, nBlkXP, dummyplane, yl_beg, yl_end);
+	upsizerUV->SimpleResizeDo(MaskFullUVB, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallB, nBlkXP, nBlkXP, dummyplane, yc_beg, yc_end);
+
+	upsizer->SimpleResizeDo(MaskFullYF, nWidthP, nHeightP, VPitchY, MaskSmallF, nBlkXP, nBlkXP, dummyplane, yl_beg, yl_end);
+	upsizerUV->SimpleResizeDo(MaskFullUVF, nWidthPUV, nHeightPUV, VPitchUV, MaskSmallF, nBlkXP, nBlkXP, dummyplane, yc_beg, yc_end);
+
+	if (_extra_flag)
+	{
+		vm.upsize_rows (FlowVectMaps::Dir_BB, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+		vm.upsize_rows (FlowVectMaps::Dir_FF, *upsizer, *upsizerUV, yl_beg, yl_end, yc_beg, yc_end);
+	}
+}
+
+
+
+void MVFlowInter::interpolate_rows (int p, int y_beg, int y_end)
+{
+	if (y_beg >= y_end)
+	{
+		return;
+	}
+
+	if (timeclip == 0)
+	{
+		const Time256ProviderCst	t256_prov_cst (time256, 0, 0);
+		interpolate_rows_t256 (p, y_beg, y_end, t256_prov_cst);
+	}
+	else
+	{
+		Time256ProviderPlane	t256_prov_plane (
+			_t256_ptr_arr [p] + y_beg * _t256_pitch_arr [p], _t256_pitch_arr [p],
+			0, 0
+		);
+		interpolate_rows_t256 (p, y_beg, y_end, t256_prov_plane);
+	}
+}
+
+
+
+template <class T256P>
+void MVFlowInter::interpolate_rows_t256 (int p, int y_beg, int y_end, T256P &t256_provider)
+{
+	const bool     luma_flag = (p == 0);
+	const FlowVectMaps::Res	res = luma_flag ? FlowVectMaps::Res_LUMA : FlowVectMaps::Res_CHROMA;
+	const FlowVectMaps &	vm = *_vect_maps_aptr;
+	const int      vpitch    = vm.get_full_pitch (res);
+	const int      mpitch    = luma_flag ? VPitchY : VPitchUV;
+	const int      m_ofs     = y_beg * mpitch;
+	const int      ref_ofs   = y_beg * _ref_pitch_arr [p] * nPel;
+	BYTE *         pdst      = _dst_ptr_arr [p] + y_beg * _dst_pitch_arr [p];
+	const BYTE *   prefB     = _ref_ptr_arr [p] + ref_ofs;
+	const BYTE *   prefF     = _src_ptr_arr [p] + ref_ofs;
+	const int      width     = luma_flag ? nWidth : nWidthUV;
+	const int      height    = y_end - y_beg;
+
+	const int16_t* vb  = vm.use_full (FlowVectMaps::Dir_B, res, y_beg);
+	const int16_t* vf  = vm.use_full (FlowVectMaps::Dir_F, res, y_beg);
+	const BYTE *   mb  = (luma_flag ? MaskFullYB  : MaskFullUVB ) + m_ofs;
+	const BYTE *   mf  = (luma_flag ? MaskFullYF  : MaskFullUVF ) + m_ofs;
+
+	if (_extra_flag)
+	{
+		FlowInterExtra(pdst, _dst_pitch_arr [p], prefB, prefF, _ref_pitch_arr [p],
+			vb, vf, vpitch, mb, mf, mpitch,
+			width, height, nPel, t256_provider,
+			vm.use_full (FlowVectMaps::Dir_BB, res, y_beg),
+			vm.use_full (FlowVectMaps::Dir_FF, res, y_beg), _avx2_flag);
+	}
+	else
+	{
+		FlowInter(pdst, _dst_pitch_arr [p], prefB, prefF, _ref_pitch_arr [p],
+			vb, vf, vpitch, mb, mf, mpitch,
+			width, height, nPel, t256_provider, _avx2_flag);
+	}
+}
@@ -1,64 +1,37 @@
 #ifndef __MV_FLOWINTER__
 #define __MV_FLOWINTER__
 
+#include "FlowVectMaps.h"
+#include "MTSlicer.h"
 #include "MVClip.h"
 #include "MVFilter.h"
 #include "SimpleResize.h"
+#include "SuperFrameCache.h"
 #include "yuy2planes.h"
 
+#include <memory>
+
 class MVFlowInter
 :	public GenericVideoFilter
 ,	public MVFilter
 {
 private:
 
-	enum { VECT_AMP = 256	};
-
    MVClip mvClipB;
    MVClip mvClipF;
    int time256;
    double ml;
    PClip finest;
+   PClip _super; // Key for the SuperFrameCache
+   SuperFrameCache::View finest_view;
 	PClip	timeclip;
    bool isse;
    bool planar;
    bool blend;
 
-   // fullframe vector mask
-   BYTE *VXFullYB; //backward
-   BYTE *VXFullUVB;
-   BYTE *VYFullYB;
-   BYTE *VYFullUVB;
-   BYTE *VXFullYF;  // forward
-   BYTE *VXFullUVF;
-   BYTE *VYFullYF;
-   BYTE *VYFullUVF;
-   BYTE *VXFullYBB; //backward backward
-   BYTE *VXFullUVBB;
-   BYTE *VYFullYBB;
-   BYTE *VYFullUVBB;
-   BYTE *VXFullYFF; // forward forward
-   BYTE *VXFullUVFF;
-   BYTE *VYFullYFF;
-   BYTE *VYFullUVFF;
-
-   // Small vector mask
-   BYTE *VXSmallYB;
-   BYTE *VXSmallUVB;
-   BYTE *VYSmallYB;
-   BYTE *VYSmallUVB;
-   BYTE *VXSmallYF;
-   BYTE *VXSmallUVF;
-   BYTE *VYSmallYF;
-   BYTE *VYSmallUVF;
-   BYTE *VXSmallYBB;
-   BYTE *VXSmallUVBB;
-   BYTE *VYSmallYBB;
-   BYTE *VYSmallUVBB;
-   BYTE *VXSmallYFF;
-   BYTE *VXSmallUVFF;
-   BYTE *VYSmallYFF;
-   BYTE *VYSmallUVFF;
+   // Vector maps, backward, forward, backward backward and forward forward
+	std::auto_ptr <FlowVectMaps>
+	               _vect_maps_aptr;
 
    BYTE *MaskSmallB;
    BYTE *MaskFullYB;
@@ -83,20 +56,36 @@ private:
 	 int nHPaddingUV;
 	 int nVPaddingUV;
 
-	typedef	short	VectLut [VECT_AMP];
-   VectLut	*LUTVB; // [time256] [v] lookup table for v
-	VectLut	*LUTVF;
-
 
    SimpleResize *upsizer;
    SimpleResize *upsizerUV;
 
 	YUY2Planes * DstPlanes;
 
+	typedef	MTSlicer <MVFlowInter>	Slicer;
+
+	void           process_slice (Slicer::TaskData &td);
+	void           upsize_rows (int yl_beg, int yl_end, int yc_beg, int yc_end);
+	void           interpolate_rows (int p, int y_beg, int y_end);
+	template <class T256P>
+	void           interpolate_rows_t256 (int p, int y_beg, int y_end, T256P &t256_provider);
+
+	bool           _mt_flag;
+	bool           _avx2_flag;
+
+	// Processing variables
+	BYTE *         _dst_ptr_arr [3];
+	int            _dst_pitch_arr [3];
+	const BYTE *   _ref_ptr_arr [3];	// Top-left of the picture, padding skipped
+	const BYTE *   _src_ptr_arr [3];
+	int            _ref_pitch_arr [3];
+	const BYTE *   _t256_ptr_arr [3];	// Only with timeclip
+	int            _t256_pitch_arr [3];
+	bool           _extra_flag;		// Extra vectors are usable
 
 public:
 	MVFlowInter(PClip _child, PClip _finest, PClip _mvbw, PClip _mvfw, int _time256, double _ml,
-                bool _blend, int nSCD1, int nSCD2, bool isse, bool _planar, PClip _timeclip, IScriptEnvironment* env);
+                bool _blend, int nSCD1, int nSCD2, bool isse, bool _planar, PClip _timeclip, bool mt_flag, IScriptEnvironment* env);
 	~MVFlowInter();
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env);
 };
@@ -52,7 +52,6 @@
 
 
 //#define MOTION_DEBUG          // allows to output debug information to the debug output
-//#define MOTION_PROFILE        // allows to make a profiling of the motion estimation
 
 #define N_PER_BLOCK 3
 
@@ -205,13 +205,9 @@ void MVPlane::refine_start()
 {
 	if (! isRefined)
 	{
-		if (nPel == 2)
-		{
-			_sched_refine.start (_plan_refine, *this, &MVPlane::refine_pel2);
-		}
-		else if (nPel == 4)
+		if (nPel > 1)
 		{
-			_sched_refine.start (_plan_refine, *this, &MVPlane::refine_pel4);
+			_sched_refine.start (_plan_refine, *this, &MVPlane::refine_sched);
 		}
 	}
 }
@@ -251,17 +247,19 @@ void MVPlane::RefineExt(const uint8_t *pSrc2x, int nSrc2xPitch, bool isExtPadded
 				pp2[w] = pSrc2x[(w<<1) + nSrc2xPitch    ];
 				pp3[w] = pSrc2x[(w<<1) + nSrc2xPitch + 1];
 			}
+			if (! isExtPadded)
+			{
+				// Pads the row while it is hot
+				for (int i = 1; i < 4; ++i)
+				{
+					Padding::PadRows(pPlane[i], nPitch, nHPadding, nVPadding, nWidth, nHeight, h, h + 1);
+				}
+			}
 			pp1 += nPitch;
 			pp2 += nPitch;
 			pp3 += nPitch;
 			pSrc2x += nSrc2xPitch*2;
 		}
-		if (! isExtPadded)
-		{
-			Padding::PadReferenceFrame(pPlane[1], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[2], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[3], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-		}
 		isPadded = true;
 	}
 	else if (( nPel == 4 ) && ( !isRefined ))
@@ -304,6 +302,14 @@ void MVPlane::RefineExt(const uint8_t *pSrc2x, int nSrc2xPitch, bool isExtPadded
 				pp14[w] = pSrc2x[(w<<2) + nSrc2xPitch*3 + 2];
 				pp15[w] = pSrc2x[(w<<2) + nSrc2xPitch*3 + 3];
 			}
+			if (!isExtPadded)
+			{
+				// Pads the row while it is hot
+				for (int i = 1; i < 16; ++i)
+				{
+					Padding::PadRows(pPlane[i], nPitch, nHPadding, nVPadding, nWidth, nHeight, h, h + 1);
+				}
+			}
 			pp1  += nPitch;
 			pp2  += nPitch;
 			pp3  += nPitch;
@@ -321,24 +327,6 @@ void MVPlane::RefineExt(const uint8_t *pSrc2x, int nSrc2xPitch, bool isExtPadded
 			pp15 += nPitch;
 			pSrc2x += nSrc2xPitch*4;
 		}
-		if (!isExtPadded)
-		{
-			Padding::PadReferenceFrame(pPlane[ 1], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 2], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 3], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 4], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 5], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 6], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 7], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 8], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[ 9], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[10], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[11], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[12], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[13], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[14], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-			Padding::PadReferenceFrame(pPlane[15], nPitch, nHPadding, nVPadding, nWidth, nHeight);
-		}
 		isPadded = true;
 	}
 	isRefined = true;
@@ -366,12 +354,70 @@ void	MVPlane::reduce_wait ()
 		_slicer_reduce.wait ();
 
 		_redp_ptr->isFilled = true;
+		_redp_ptr->isPadded = true;
 		_redp_ptr = 0;
 	}
 }
 
 
 
+// Copies the rows [y_beg ; y_end[ of the source plane and pads them.
+// pSrc points on the first row of the source.
+void	MVPlane::fill_rows (const uint8_t *pSrc, int nSrcPitch, int y_beg, int y_end)
+{
+	assert (pSrc != 0);
+	assert (y_beg >= 0);
+	assert (y_beg < y_end);
+	assert (y_end <= nHeight);
+
+	BitBlt (
+		pPlane[0] + nOffsetPadding + y_beg * nPitch, nPitch,
+		pSrc + y_beg * nSrcPitch, nSrcPitch,
+		nWidth, y_end - y_beg, isse
+	);
+	Padding::PadRows (pPlane[0], nPitch, nHPadding, nVPadding, nWidth, nHeight, y_beg, y_end);
+}
+
+
+
+// Reduces the rows [y_beg ; y_end[ of the reduced plane red and pads them
+void	MVPlane::reduce_rows (MVPlane &red, int y_beg, int y_end)
+{
+	assert (&red != 0);
+	assert (y_beg >= 0);
+	assert (y_beg < y_end);
+	assert (y_end <= red.nHeight);
+
+	_reduce_ptr (
+		red.pPlane[0] + red.nOffsetPadding, pPlane[0] + nOffsetPadding,
+		red.nPitch, nPitch,
+		red.nWidth, red.nHeight, y_beg, y_end,
+		isse
+	);
+	Padding::PadRows (
+		red.pPlane[0], red.nPitch, red.nHPadding, red.nVPadding,
+		red.nWidth, red.nHeight, y_beg, y_end
+	);
+}
+
+
+
+// Computes a single sub-pel plane. task_index is a node of the graph
+// returned by use_refine_plan(), the root (0) doing nothing.
+void	MVPlane::refine_task (int task_index)
+{
+	if (nPel == 2)
+	{
+		refine_pel2 (task_index);
+	}
+	else if (nPel == 4)
+	{
+		refine_pel4 (task_index);
+	}
+}
+
+
+
 void MVPlane::WritePlane(FILE *pFile)
 {
    for ( int i = 0; i < nHeight; i++ )
@@ -382,11 +428,18 @@ void MVPlane::WritePlane(FILE *pFile)
 
 
 
-void	MVPlane::refine_pel2 (SchedulerRefine::TaskData &td)
+void	MVPlane::refine_sched (SchedulerRefine::TaskData &td)
 {
 	assert (&td != 0);
 
-	switch (td._task_index)
+	refine_task (td._task_index);
+}
+
+
+
+void	MVPlane::refine_pel2 (int task_index)
+{
+	switch (task_index)
 	{
 	case	0:  break;	// Nothing on the root node
 	case	1:
@@ -396,6 +449,7 @@ void	MVPlane::refine_pel2 (SchedulerRefine::TaskData &td)
 		case	1: _bicubic_hor_ptr (pPlane[1], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight); break;
 		default: _wiener_hor_ptr  (pPlane[1], pPlane[0], nPitch, nPitch, nExtendedWidth, nExtendedHeight); break;
 		}
+		break;
 	case	2:
 		switch (nSharp)
 		{
@@ -420,11 +474,9 @@ void	MVPlane::refine_pel2 (SchedulerRefine::TaskData &td)
 
 
 
-void	MVPlane::refine_pel4 (SchedulerRefine::TaskData &td)
+void	MVPlane::refine_pel4 (int task_index)
 {
-	assert (&td != 0);
-
-	switch (td._task_index)
+	switch (task_index)
 	{
 	case	0:  break;	// Nothing on the root node
 	case	1:  _average_ptr (pPlane[ 1], pPlane[ 0],          pPlane[ 2], nPitch, nExtendedWidth,   nExtendedHeight); break;
@@ -476,11 +528,5 @@ void	MVPlane::reduce_slice (SlicerReduce::TaskData &td)
 	assert (&td != 0);
 	assert (_redp_ptr != 0);
 
-	MVPlane &		red = *_redp_ptr;
-	_reduce_ptr (
-		red.pPlane[0] + red.nOffsetPadding, pPlane[0] + nOffsetPadding,
-		red.nPitch, nPitch,
-		red.nWidth, red.nHeight, td._y_beg, td._y_end,
-		isse
-	);
+	reduce_rows (*_redp_ptr, td._y_beg, td._y_end);
 }
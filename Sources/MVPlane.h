@@ -54,6 +54,16 @@ public:
 	void reduce_wait ();
    void WritePlane(FILE *pFile);
 
+	// Fine-grained operations, for callers scheduling the fill, reduce and
+	// refine steps of several planes and levels in a single graph (MSuper).
+	// They don't check nor update the plane state.
+	void fill_rows (const uint8_t *pSrc, int nSrcPitch, int y_beg, int y_end);
+	void reduce_rows (MVPlane &red, int y_beg, int y_end);
+	void refine_task (int task_index);
+	inline const MTFlowGraphSimple <16> & use_refine_plan () const { return _plan_refine; }
+	inline void set_filled () { isFilled = isPadded = true; }
+	inline void set_refined () { isRefined = true; }
+
 	template <int NPELL2>
    inline const uint8_t *GetAbsolutePointerPel(int nX, int nY) const
    {
@@ -129,8 +139,9 @@ private:
 		int nWidth, int nHeight, int y_beg, int y_end, bool isse
 	);
 
-	void	refine_pel2 (SchedulerRefine::TaskData &td);
-	void	refine_pel4 (SchedulerRefine::TaskData &td);
+	void	refine_sched (SchedulerRefine::TaskData &td);
+	void	refine_pel2 (int task_index);
+	void	refine_pel4 (int task_index);
 	void	reduce_slice (SlicerReduce::TaskData &td);
 
    uint8_t **pPlane;
@@ -27,7 +27,6 @@
 #include "MVClip.h"
 #include "MVGroupOfFrames.h"
 #include "MVRecalculate.h"
-#include "profile.h"
 #include "SuperParams64Bits.h"
 
 #include	<algorithm>
@@ -43,7 +42,7 @@ MVRecalculate::MVRecalculate (
 	int _blksizex, int _blksizey, int st, int stp, int lambda, bool chroma,
    int _pnew, int _overlapx, int _overlapy, const char* _outfilename,
 	int _dctmode, int _divide, int _sadx264, bool _isse, bool _meander,
-	int trad, bool mt_flag, IScriptEnvironment* env
+	int trad, bool mt_flag, const char *profile_0, IScriptEnvironment* env
 )
 :	GenericVideoFilter (_super)
 ,	_srd_arr ()
@@ -52,6 +51,7 @@ MVRecalculate::MVRecalculate (
 ,	_dct_pool ()
 ,	_nbr_srd ((trad > 0) ? trad * 2 : 1)
 ,	_mt_flag (mt_flag)
+,	_prof_ptr (0)
 {
 	_srd_arr.resize (_nbr_srd);
 	for (int srd_index = 0; srd_index < _nbr_srd; ++srd_index)
@@ -263,6 +263,8 @@ MVRecalculate::MVRecalculate (
 		}
 	}
 
+	_prof_ptr = Profiler::acquire (profile_0);
+
 	_vectorfields_aptr = std::auto_ptr <GroupOfPlanes> (new GroupOfPlanes (
 		analysisData.nBlkSizeX,
 		analysisData.nBlkSizeY,
@@ -276,6 +278,7 @@ MVRecalculate::MVRecalculate (
 		analysisData.yRatioUV,
 		divideExtra,
 		(_dct_factory_ptr.get () != 0) ? &_dct_pool : 0,
+		_prof_ptr,
 		_mt_flag
 	));
 
@@ -292,6 +295,8 @@ MVRecalculate::MVRecalculate (
 		outfile = fopen(outfilename,"wb");
 		if (outfile == NULL)
 		{
+			Profiler::release (_prof_ptr);
+			_prof_ptr = 0;
 			env->ThrowError ("MRecalculate: out file can not be created!");
 		}
 		else
@@ -387,6 +392,9 @@ MVRecalculate::~MVRecalculate()
 	pSrcGOF = 0;
 	delete pRefGOF;
 	pRefGOF = 0;
+
+	Profiler::release (_prof_ptr);
+	_prof_ptr = 0;
 }
 
 
@@ -497,7 +505,6 @@ PVideoFrame __stdcall MVRecalculate::GetFrame(int n, IScriptEnvironment* env)
 			);
 		}
 
-//		PROFILE_CUMULATE ();
 		if (outfile != NULL)
 		{
 			fwrite (
@@ -517,7 +524,6 @@ PVideoFrame __stdcall MVRecalculate::GetFrame(int n, IScriptEnvironment* env)
 
 void	MVRecalculate::load_src_frame (MVGroupOfFrames &gof, ::PVideoFrame &src, const MVAnalysisData &ana_data)
 {
-	PROFILE_START (MOTION_PROFILE_YUY2CONVERT);
 	const unsigned char *	pSrcY;
 	const unsigned char *	pSrcU;
 	const unsigned char *	pSrcV;
@@ -541,7 +547,6 @@ void	MVRecalculate::load_src_frame (MVGroupOfFrames &gof, ::PVideoFrame &src, co
 		nSrcPitchY  = src->GetPitch (PLANAR_Y);
 		nSrcPitchUV = src->GetPitch (PLANAR_U);
 	}
-	PROFILE_STOP (MOTION_PROFILE_YUY2CONVERT);
 
 	gof.Update (
 		nModeYUV,
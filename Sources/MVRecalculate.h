@@ -29,6 +29,7 @@
 #include "DCTFactory.h"
 #include "GroupOfPlanes.h"
 #include "MVAnalysisData.h"
+#include "Profiler.h"
 #include "yuy2planes.h"
 #include	"SharedPtr.h"
 
@@ -111,6 +112,7 @@ protected:
 
 	int            _nbr_srd;
 	bool           _mt_flag;
+	Profiler *     _prof_ptr;        // 0 if profiling is disabled
 
 public :
 
@@ -119,7 +121,7 @@ public :
 		int _blksizex, int _blksizey, int st, int stp, int lambda, bool chroma,
 		int _pnew, int _overlapx, int _overlapy, const char* _outfilename,
 		int _dctmode, int _divide, int _sadx264, bool _isse, bool _meander,
-		int trad, bool mt_flag, IScriptEnvironment* env
+		int trad, bool mt_flag, const char *profile_0, IScriptEnvironment* env
 	);
 	~MVRecalculate();
 
@@ -20,32 +20,34 @@
 // Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA, or visit
 // http://www.gnu.org/copyleft/gpl.html .
 
+#include	"AvstpWrapper.h"
 #include	"debugprintf.h"
 #include "MVFrame.h"
 #include "MVGroupOfFrames.h"
 #include "MVPlane.h"
 #include "MVSuper.h"
-#include	"profile.h"
 #include "SuperParams64Bits.h"
 
+#include	<algorithm>
+
+#include	<cassert>
 #include <cmath>
 
-// move profile init here from MVCore.cpp (it is not quite correct for several mvsuper)
-#ifdef MOTION_PROFILE
-int ProfTimeTable[MOTION_PROFILE_COUNT];
-int ProfResults[MOTION_PROFILE_COUNT * 2];
-__int64 ProfCumulatedResults[MOTION_PROFILE_COUNT * 2];
-#endif
 
 
 MVSuper::MVSuper (
 	PClip _child, int _hPad, int _vPad, int _pel, int _levels, bool _chroma,
 	int _sharp, int _rfilter, PClip _pelclip, bool _isse, bool _planar,
-	bool mt_flag, IScriptEnvironment* env
+	bool mt_flag, const char *profile_0, IScriptEnvironment* env
 )
 :	GenericVideoFilter (_child)
 ,	pelclip (_pelclip)
 ,	_mt_flag (mt_flag)
+,	_prof_ptr (0)
+,	_task_arr ()
+,	_build_graph ()
+,	_src_ptr_arr ()
+,	_src_pitch_arr ()
 {
 	planar = _planar;
 
@@ -143,7 +145,9 @@ MVSuper::MVSuper (
 
 	pSrcGOF->set_interp (nModeYUV, rfilter, sharp);
 
-	PROFILE_INIT();
+	build_graph ();
+
+	_prof_ptr = Profiler::acquire (profile_0);
 }
 
 MVSuper::~MVSuper()
@@ -159,7 +163,8 @@ MVSuper::~MVSuper()
 	}
 	delete pSrcGOF;
 
-	PROFILE_SHOW();
+	Profiler::release (_prof_ptr);
+	_prof_ptr = 0;
 }
 
 PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
@@ -182,7 +187,6 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
 
 	PVideoFrame	dst = env->NewVideoFrame(vi);
 
-	PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
 	{
 		if (!planar)
@@ -254,21 +258,52 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
 		nDstPitchY  = dst->GetPitch(PLANAR_Y);
 		nDstPitchUV  = dst->GetPitch(PLANAR_U);
 	}
-	PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
-
-	PROFILE_START(MOTION_PROFILE_INTERPOLATION);
 
 	pSrcGOF->Update(YUVPLANES, pDstY, nDstPitchY, pDstU, nDstPitchUV, pDstV, nDstPitchUV);
 
-	pSrcGOF->SetPlane(pSrcY, nSrcPitchY, YPLANE);
-	pSrcGOF->SetPlane(pSrcU, nSrcPitchUV, UPLANE);
-	pSrcGOF->SetPlane(pSrcV, nSrcPitchUV, VPLANE);
+	static const MVPlaneSet	mask_arr [3] = { YPLANE, UPLANE, VPLANE };
+
+	// The processed planes are copied to level 0 by the tasks, the other ones
+	// are just copied.
+	_src_ptr_arr [0]   = pSrcY;
+	_src_ptr_arr [1]   = pSrcU;
+	_src_ptr_arr [2]   = pSrcV;
+	_src_pitch_arr [0] = nSrcPitchY;
+	_src_pitch_arr [1] = nSrcPitchUV;
+	_src_pitch_arr [2] = nSrcPitchUV;
+	for (int p = 0; p < 3; ++p)
+	{
+		if ((nModeYUV & mask_arr [p]) == 0)
+		{
+			pSrcGOF->SetPlane (_src_ptr_arr [p], _src_pitch_arr [p], mask_arr [p]);
+		}
+	}
+
+	// Fill, reduce and refine steps of all the planes and levels
+	{
+		Scheduler      sched (_mt_flag);
+		sched.start (_build_graph, *this, &MVSuper::process_task);
+		sched.wait ();
+	}
 
-	pSrcGOF->Reduce(nModeYUV);
-	pSrcGOF->Pad(nModeYUV);
+	for (int p = 0; p < 3; ++p)
+	{
+		if ((nModeYUV & mask_arr [p]) != 0)
+		{
+			for (int level = 0; level < nLevels; ++level)
+			{
+				pSrcGOF->GetFrame (level)->GetPlane (mask_arr [p])->set_filled ();
+			}
+			if (nPel > 1 && ! usePelClip)
+			{
+				pSrcGOF->GetFrame (0)->GetPlane (mask_arr [p])->set_refined ();
+			}
+		}
+	}
 
 	if (usePelClip)
 	{
+		Profiler::Scope	prof_scope (_prof_ptr, Profiler::STG_REFINE);
 		MVFrame *srcFrames = pSrcGOF->GetFrame(0);
 		MVPlane *srcPlaneY = srcFrames->GetPlane(YPLANE);
 		if (nModeYUV & YPLANE) srcPlaneY->RefineExt(pSrcPelY, nSrcPelPitchY, isPelClipPadded);
@@ -277,17 +312,8 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
 		MVPlane *srcPlaneV = srcFrames->GetPlane(VPLANE);
 		if (nModeYUV & VPLANE) srcPlaneV->RefineExt(pSrcPelV, nSrcPelPitchUV, isPelClipPadded);
 	}
-	else
-	{
-		pSrcGOF->Refine(nModeYUV);
-	}
-
-	PROFILE_STOP(MOTION_PROFILE_INTERPOLATION);
-
 
 /*
-	PROFILE_START(MOTION_PROFILE_YUY2CONVERT);
-
 	if ( (pixelType & VideoInfo::CS_YUY2) == VideoInfo::CS_YUY2 )
 	{
 		pDstYUY2 = dst->GetWritePtr();
@@ -295,10 +321,173 @@ PVideoFrame __stdcall MVSuper::GetFrame(int n, IScriptEnvironment* env)
 		YUY2FromPlanes(pDstYUY2, nDstPitchYUY2, nSuperWidth, nSuperHeight,
 			pDstY, nDstPitchY, pDstU, pDstV, nDstPitchUV, isse);
 	}
-	PROFILE_STOP(MOTION_PROFILE_YUY2CONVERT);
 */
 
-	PROFILE_CUMULATE();
-
 	return dst;
 }
+
+
+
+/*
+Builds the dependency graph of a super frame. For each plane:
+- Level 0 is copied from the source by slices, then its sub-pel planes are
+	computed following the plane refine plan.
+- Each upper level is reduced from the previous one by slices. All the
+	slices of a level wait for all the slices of the previous level.
+Each slice pads its own rows, so there is no separate padding pass.
+Planes are independent, so the chroma runs along with the luma, and the
+reduction of the upper levels along with the refinement.
+*/
+void	MVSuper::build_graph ()
+{
+	assert (nLevels <= MAX_LEVELS);
+
+	static const MVPlaneSet	mask_arr [3] = { YPLANE, UPLANE, VPLANE };
+
+	const bool     refine_flag = (nPel > 1 && ! usePelClip);
+	const int      nbr_threads =
+		  (_mt_flag)
+		? AvstpWrapper::use_instance ().get_nbr_threads ()
+		: 1;
+
+	_task_arr.clear ();
+	_build_graph.clear ();
+	for (int p = 0; p < 3; ++p)
+	{
+		if ((nModeYUV & mask_arr [p]) == 0)
+		{
+			continue;
+		}
+
+		TaskInfo       info;
+		info._plane = p;
+		info._index = 0;
+
+		// Slices of all the levels. The first level depends on the root only.
+		int            prev_beg     = 0;
+		int            prev_end     = 1;
+		int            slice_budget = MAX_SLICES_PER_PLANE;
+		for (int level = 0; level < nLevels; ++level)
+		{
+			const int      h =
+				pSrcGOF->GetFrame (level)->GetPlane (mask_arr [p])->GetHeight ();
+			int            nbr_slices = std::min (nbr_threads, int (MAX_SLICES_PER_LEVEL));
+			nbr_slices = std::min (nbr_slices, h / MIN_SLICE_H);
+			nbr_slices = std::min (nbr_slices, slice_budget - (nLevels - 1 - level));
+			nbr_slices = std::max (nbr_slices, 1);
+			slice_budget -= nbr_slices;
+
+			info._type  = (level == 0) ? TaskType_FILL : TaskType_REDUCE;
+			info._level = level;
+			const int      slice_beg = int (_task_arr.size ()) + 1;
+			for (int s = 0; s < nbr_slices; ++s)
+			{
+				info._y_beg =  s      * h / nbr_slices;
+				info._y_end = (s + 1) * h / nbr_slices;
+				_task_arr.push_back (info);
+				const int      slice_index = int (_task_arr.size ());
+				for (int t = prev_beg; t < prev_end; ++t)
+				{
+					_build_graph.add_dep (t, slice_index);
+				}
+			}
+
+			prev_beg = slice_beg;
+			prev_end = slice_beg + nbr_slices;
+
+			// Node k of the refine plan -> task refine_base + k. The root of
+			// the plan stands for all the slices of level 0, which must be
+			// padded before any interpolation.
+			if (level == 0 && refine_flag)
+			{
+				const MTFlowGraphSimple <16> &	plan =
+					pSrcGOF->GetFrame (0)->GetPlane (mask_arr [p])->use_refine_plan ();
+				const int      last_node   = plan.get_last_node ();
+				const int      refine_base = int (_task_arr.size ());
+				info._type  = TaskType_REFINE;
+				info._y_beg = 0;
+				info._y_end = 0;
+				for (int k = 1; k <= last_node; ++k)
+				{
+					info._index = k;
+					_task_arr.push_back (info);
+				}
+				info._index = 0;
+
+				for (int k = 0; k <= last_node; ++k)
+				{
+					for (MTFlowGraphSimple <16>::Iterator it = plan.get_out_node_it (k)
+					;	it.cont ()
+					;	it.next ())
+					{
+						const int      index_to = refine_base + it.get_index ();
+						if (k == 0)
+						{
+							for (int t = prev_beg; t < prev_end; ++t)
+							{
+								_build_graph.add_dep (t, index_to);
+							}
+						}
+						else
+						{
+							_build_graph.add_dep (refine_base + k, index_to);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	assert (int (_task_arr.size ()) < MAX_TASKS);
+}
+
+
+
+void	MVSuper::process_task (Scheduler::TaskData &td)
+{
+	assert (&td != 0);
+
+	// Root task: nothing to do
+	if (td._task_index == 0)
+	{
+		return;
+	}
+
+	static const MVPlaneSet	mask_arr [3] = { YPLANE, UPLANE, VPLANE };
+
+	const TaskInfo &  info  = _task_arr [td._task_index - 1];
+	const MVPlaneSet  mask  = mask_arr [info._plane];
+	MVPlane &         plane = *pSrcGOF->GetFrame (info._level)->GetPlane (mask);
+
+	switch (info._type)
+	{
+	case	TaskType_FILL:
+		{
+			Profiler::Scope	prof_scope (_prof_ptr, Profiler::STG_PAD);
+			plane.fill_rows (
+				_src_ptr_arr [info._plane], _src_pitch_arr [info._plane],
+				info._y_beg, info._y_end
+			);
+		}
+		break;
+
+	case	TaskType_REDUCE:
+		{
+			Profiler::Scope	prof_scope (_prof_ptr, Profiler::STG_REDUCE);
+			MVPlane &         src = *pSrcGOF->GetFrame (info._level - 1)->GetPlane (mask);
+			src.reduce_rows (plane, info._y_beg, info._y_end);
+		}
+		break;
+
+	case	TaskType_REFINE:
+		{
+			Profiler::Scope	prof_scope (_prof_ptr, Profiler::STG_REFINE);
+			plane.refine_task (info._index);
+		}
+		break;
+
+	default:
+		assert (false);
+		break;
+	}
+}
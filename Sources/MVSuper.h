@@ -22,6 +22,9 @@
 #define __MV_SUPER__
 
 #include "commonfunctions.h"
+#include "MTFlowGraphSched.h"
+#include "MTFlowGraphSimple.h"
+#include "Profiler.h"
 #include "yuy2planes.h"
 
 #define	NOGDI
@@ -30,6 +33,8 @@
 #include "Windows.h"
 #include	"avisynth.h"
 
+#include	<vector>
+
 
 
 // vi.num_audio_samples = nHeight + (nHPad<<16) + (nVPad<<24) + ((_int64)(nPel)<<32) + ((_int64)nModeYUV<<40) + ((_int64)nLevels<<48);
@@ -123,13 +128,56 @@ protected:
 	bool           isPelClipPadded;
 
 	bool           _mt_flag;
+	Profiler *     _prof_ptr;        // 0 if profiling is disabled
+
+private:
+
+	enum {         MAX_LEVELS = 16 };
+	enum {         MAX_SLICES_PER_LEVEL = 8 };
+	enum {         MAX_SLICES_PER_PLANE = 40 };  // Fill and reduce slices, all levels
+	enum {         MIN_SLICE_H = 8 };
+	enum {         MAX_TASKS = 1 + (MAX_SLICES_PER_PLANE + 15) * 3 };	// Root + slices + refine
+
+	typedef	MTFlowGraphSimple <MAX_TASKS>	BuildGraph;
+	typedef	MTFlowGraphSched <MVSuper, BuildGraph, MVSuper, MAX_TASKS>	Scheduler;
+
+	enum TaskType
+	{
+		TaskType_FILL = 0,	// Slice of level 0, from the source frame
+		TaskType_REDUCE,		// Slice of an upper level, from the previous one
+		TaskType_REFINE		// Sub-pel plane of level 0
+	};
+
+	class TaskInfo
+	{
+	public:
+		TaskType       _type;
+		int            _plane;
+		int            _level;
+		int            _index;        // Refine: node of the plane refine plan
+		int            _y_beg;        // Fill and reduce: rows of the level plane
+		int            _y_end;
+	};
+	typedef	std::vector <TaskInfo>	TaskArray;
+
+	void           build_graph ();
+	void           process_task (Scheduler::TaskData &td);
+
+	// The whole hierarchy of a super frame, all planes, levels and steps
+	TaskArray      _task_arr;     // Task index - 1 -> task
+	BuildGraph     _build_graph;
+
+	// Source planes of the current frame, for the fill tasks
+	const unsigned char *
+	               _src_ptr_arr [3];
+	int            _src_pitch_arr [3];
 
 public:
 
 	MVSuper (
 		PClip _child, int _hpad, int _vpad, int pel, int _levels, bool _chroma,
 		int _sharp, int _rfilter, PClip _pelclip, bool _isse, bool _planar,
-		bool mt_flag, IScriptEnvironment* env
+		bool mt_flag, const char *profile_0, IScriptEnvironment* env
 	);
 	~MVSuper();
 
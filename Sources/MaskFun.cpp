@@ -498,13 +498,3 @@ unsigned char SADToMask(unsigned int sad, unsigned int sadnorm1024)
 	unsigned int l = sadnorm1024*sad/1024;
 	return (unsigned char)((l > 255) ? 255 : l);
 }
-
-
-void Create_LUTV(int time256, short *LUTVB, short *LUTVF)
-{
-	for (int v=0; v<256; v++)
-	{
-		LUTVB[v] = ((v-128)*(256-time256))/256;
-		LUTVF[v] = ((v-128)*time256)/256;
-	}
-}
@@ -60,25 +60,26 @@ unsigned char SADToMask(unsigned int sad, unsigned int sadnorm1024);
 template <class T256P>
 void Blend(uint8_t * pdst, const uint8_t * psrc, const uint8_t * pref, int height, int width, int dst_pitch, int src_pitch, int ref_pitch, T256P &t256_provider, bool isse);
 
-
-// lookup table size 256
-void Create_LUTV(int time256, short *LUTVB, short *LUTVF);
-
+// Vector maps: interleaved 16-bit (vx, vy) pairs, see FlowVectMaps
+// avx2_flag: the CPU supports AVX2 (FuncDispatch::Tier_AVX2 or above)
 template <class T256P>
 void FlowInter(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-			   uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-			   int VPitch, int width, int height, int nPel, T256P &t256_provider);
+			   const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+			   const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+			   int width, int height, int nPel, T256P &t256_provider, bool avx2_flag);
 
 template <class T256P>
 void FlowInterSimple(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-			   uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-			   int VPitch, int width, int height, int nPel, T256P &t256_provider);
+			   const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+			   const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+			   int width, int height, int nPel, T256P &t256_provider, bool avx2_flag);
 
 template <class T256P>
 void FlowInterExtra(uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-			   uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-			   int VPitch, int width, int height, int nPel, T256P &t256_provider,
-			   uint8_t *VXFullBB, uint8_t *VXFullFF, uint8_t *VYFullBB, uint8_t *VYFullFF);
+			   const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+			   const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+			   int width, int height, int nPel, T256P &t256_provider,
+			   const int16_t *VFullBB, const int16_t *VFullFF, bool avx2_flag);
 
 
 
@@ -18,6 +18,7 @@
 // http://www.gnu.org/copyleft/gpl.html .
 
 #include "CopyCode.h"
+#include "FlowInterAvx2.h"
 #include "MVClip.h"
 
 #include	<algorithm>
@@ -151,76 +152,86 @@ inline int Median3r (int a, int b, int c)
 
 
 
+// The vector maps are made of interleaved 16-bit (vx, vy) pairs, with
+// VPitch in int16_t units. The masks have their own pitch.
+// With avx2_flag, the columns are processed by groups of 8 with the
+// FlowInterAvx2.h kernels, and the C code only completes the last ones.
+
 template <class T256P, int NPELL2>
 static void FlowInter_NPel(
 	uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-	uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-	int VPitch, int width, int height, T256P &t256_provider)
+	const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+	const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+	int width, int height, T256P &t256_provider, bool avx2_flag)
 {
+	int				x0 = 0;
+	if (avx2_flag)
+	{
+		x0 = width & ~7;
+		FlowInter_avx2 <T256P, NPELL2> (
+			pdst, dst_pitch, prefB, prefF, ref_pitch,
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			x0, height, t256_provider
+		);
+	}
+
 	for (int h=0; h<height; h++)
 	{
-		for (int w=0; w<width; w++)
+		for (int w=x0; w<width; w++)
 		{
 			const int		time256 = t256_provider.get_t (w);
 
-//			int vxF = ((VXFullF[w]-128)*time256)/256;
-//			int vyF = ((VYFullF[w]-128)*time256)/256;
-			int vxF = t256_provider.get_vect_f (time256, VXFullF[w]);
-			int vyF = t256_provider.get_vect_f (time256, VYFullF[w]);
+			int vxF = t256_provider.scale_vect_f (time256, VFullF[w*2  ]);
+			int vyF = t256_provider.scale_vect_f (time256, VFullF[w*2+1]);
 			int dstF = prefF[vyF*ref_pitch + vxF + (w<<NPELL2)];
 			int dstF0 = prefF[(w<<NPELL2)]; // zero
-//			int vxB = ((VXFullB[w]-128)*(256-time256))/256;
-//			int vyB = ((VYFullB[w]-128)*(256-time256))/256;
-			int vxB = t256_provider.get_vect_b (time256, VXFullB[w]);
-			int vyB = t256_provider.get_vect_b (time256, VYFullB[w]);
+			int vxB = t256_provider.scale_vect_b (time256, VFullB[w*2  ]);
+			int vyB = t256_provider.scale_vect_b (time256, VFullB[w*2+1]);
 			int dstB = prefB[vyB*ref_pitch + vxB + (w<<NPELL2)];
 			int dstB0 = prefB[(w<<NPELL2)]; // zero
 			pdst[w] = ( ( (dstF*(255-MaskF[w]) + ((MaskF[w]*(dstB*(255-MaskB[w])+MaskB[w]*dstF0)+255)>>8) + 255)>>8 )*(256-time256) +
 			            ( (dstB*(255-MaskB[w]) + ((MaskB[w]*(dstF*(255-MaskF[w])+MaskF[w]*dstB0)+255)>>8) + 255)>>8 )*     time256   )>>8;
-//			pdst[w] = ( ( (dstF*(255-MaskF[w]) + dstB*MaskF[w] + 255)>>8 )*(256-time256) +
-//			            ( (dstB*(255-MaskB[w]) + dstF*MaskB[w] + 255)>>8 )*time256 )>>8;
 		}
 		pdst += dst_pitch;
 		prefB += ref_pitch<<NPELL2;
 		prefF += ref_pitch<<NPELL2;
 		t256_provider.jump_to_next_row ();
-		VXFullB += VPitch;
-		VYFullB += VPitch;
-		VXFullF += VPitch;
-		VYFullF += VPitch;
-		MaskB += VPitch;
-		MaskF += VPitch;
+		VFullB += VPitch;
+		VFullF += VPitch;
+		MaskB += MaskPitch;
+		MaskF += MaskPitch;
 	}
 }
 
 template <class T256P>
 void FlowInter(
 	uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-	uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-	int VPitch, int width, int height, int nPel, T256P &t256_provider)
+	const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+	const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+	int width, int height, int nPel, T256P &t256_provider, bool avx2_flag)
 {
 	if (nPel==1)
 	{
 		FlowInter_NPel <T256P, 0> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider, avx2_flag
 		);
 	}
 	else if (nPel==2)
 	{
 		FlowInter_NPel <T256P, 1> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider, avx2_flag
 		);
 	}
 	else if (nPel==4)
 	{
 		FlowInter_NPel <T256P, 2> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider, avx2_flag
 		);
 	}
 }
@@ -230,36 +241,45 @@ void FlowInter(
 template <class T256P, int NPELL2>
 static void FlowInterExtra_NPel(
 	uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-	uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-	int VPitch, int width, int height, T256P &t256_provider,
-	uint8_t *VXFullBB, uint8_t *VXFullFF, uint8_t *VYFullBB, uint8_t *VYFullFF)
+	const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+	const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+	int width, int height, T256P &t256_provider,
+	const int16_t *VFullBB, const int16_t *VFullFF, bool avx2_flag)
 {
+	int				x0 = 0;
+	if (avx2_flag)
+	{
+		x0 = width & ~7;
+		FlowInterExtra_avx2 <T256P, NPELL2> (
+			pdst, dst_pitch, prefB, prefF, ref_pitch,
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			x0, height, t256_provider,
+			VFullBB, VFullFF
+		);
+	}
+
 	for (int h=0; h<height; h++)
 	{
-		for (int w=0; w<width; w++)
+		for (int w=x0; w<width; w++)
 		{
 			const int		time256 = t256_provider.get_t (w);
 
-			int vxF = t256_provider.get_vect_f (time256, VXFullF[w]);
-			int vyF = t256_provider.get_vect_f (time256, VYFullF[w]);
+			int vxF = t256_provider.scale_vect_f (time256, VFullF[w*2  ]);
+			int vyF = t256_provider.scale_vect_f (time256, VFullF[w*2+1]);
 			int adrF = vyF*ref_pitch + vxF + (w<<NPELL2);
 			int dstF = prefF[adrF];
-//			int dstF0 = prefF[(w<<NPELL2)]; // zero
-			int vxFF = t256_provider.get_vect_f (time256, VXFullFF[w]);
-			int vyFF = t256_provider.get_vect_f (time256, VYFullFF[w]);
+			int vxFF = t256_provider.scale_vect_f (time256, VFullFF[w*2  ]);
+			int vyFF = t256_provider.scale_vect_f (time256, VFullFF[w*2+1]);
 			int adrFF = vyFF*ref_pitch + vxFF + (w<<NPELL2);
 			int dstFF = prefF[adrFF];
-			int vxB = t256_provider.get_vect_b (time256, VXFullB[w]);
-			int vyB = t256_provider.get_vect_b (time256, VYFullB[w]);
+			int vxB = t256_provider.scale_vect_b (time256, VFullB[w*2  ]);
+			int vyB = t256_provider.scale_vect_b (time256, VFullB[w*2+1]);
 			int adrB = vyB*ref_pitch + vxB + (w<<NPELL2);
 			int dstB = prefB[adrB];
-//			int dstB0 = prefB[(w<<NPELL2)]; // zero
-			int vxBB = t256_provider.get_vect_b (time256, VXFullBB[w]);
-			int vyBB = t256_provider.get_vect_b (time256, VYFullBB[w]);
+			int vxBB = t256_provider.scale_vect_b (time256, VFullBB[w*2  ]);
+			int vyBB = t256_provider.scale_vect_b (time256, VFullBB[w*2+1]);
 			int adrBB = vyBB*ref_pitch + vxBB + (w<<NPELL2);
 			int dstBB = prefB[adrBB];
-//			pdst[w] = ( ( (dstF*(255-MaskF[w]) + ((MaskF[w]*(dstB*(255-MaskB[w])+MaskB[w]*dstF0)+255)>>8) + 255)>>8 )*(256-time256) +
-//			            ( (dstB*(255-MaskB[w]) + ((MaskB[w]*(dstF*(255-MaskF[w])+MaskF[w]*dstB0)+255)>>8) + 255)>>8 )*time256 )>>8;
              // use median, firsly get min max of compensations
              int minfb;
              int maxfb;
@@ -278,51 +298,48 @@ static void FlowInterExtra_NPel(
 		prefB += ref_pitch<<NPELL2;
 		prefF += ref_pitch<<NPELL2;
 		t256_provider.jump_to_next_row ();
-		VXFullB += VPitch;
-		VYFullB += VPitch;
-		VXFullF += VPitch;
-		VYFullF += VPitch;
-		MaskB += VPitch;
-		MaskF += VPitch;
-		VXFullBB += VPitch;
-		VYFullBB += VPitch;
-		VXFullFF += VPitch;
-		VYFullFF += VPitch;
+		VFullB += VPitch;
+		VFullF += VPitch;
+		MaskB += MaskPitch;
+		MaskF += MaskPitch;
+		VFullBB += VPitch;
+		VFullFF += VPitch;
 	}
 }
 
 template <class T256P>
 void FlowInterExtra(
 	uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-	uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-	int VPitch, int width, int height, int nPel, T256P &t256_provider,
-	uint8_t *VXFullBB, uint8_t *VXFullFF, uint8_t *VYFullBB, uint8_t *VYFullFF)
+	const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+	const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+	int width, int height, int nPel, T256P &t256_provider,
+	const int16_t *VFullBB, const int16_t *VFullFF, bool avx2_flag)
 {
  	if (nPel==1)
 	{
 		FlowInterExtra_NPel <T256P, 0> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider,
-		   VXFullBB, VXFullFF, VYFullBB, VYFullFF
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider,
+			VFullBB, VFullFF, avx2_flag
 		);
 	}
 	else if (nPel==2)
 	{
 		FlowInterExtra_NPel <T256P, 1> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider,
-		   VXFullBB, VXFullFF, VYFullBB, VYFullFF
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider,
+			VFullBB, VFullFF, avx2_flag
 		);
 	}
 	else if (nPel==4)
 	{
 		FlowInterExtra_NPel <T256P, 2> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider,
-		   VXFullBB, VXFullFF, VYFullBB, VYFullFF
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider,
+			VFullBB, VFullFF, avx2_flag
 		);
 	}
 }
@@ -332,27 +349,33 @@ void FlowInterExtra(
 template <class T256P, int NPELL2>
 static void FlowInterSimple_NPel(
 	uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-	uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-	int VPitch, int width, int height, T256P &t256_provider)
+	const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+	const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+	int width, int height, T256P &t256_provider, bool avx2_flag)
 {
+	int				x0 = 0;
+	if (avx2_flag)
+	{
+		x0 = width & ~7;
+		FlowInterSimple_avx2 <T256P, NPELL2> (
+			pdst, dst_pitch, prefB, prefF, ref_pitch,
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			x0, height, t256_provider
+		);
+	}
+
 	if (t256_provider.is_half ()) // special case double fps - fastest
 	{
 		for (int h=0; h<height; h++)
 		{
-			for (int w=0; w<width; w+=1)
+			for (int w=x0; w<width; w+=1)
 			{
-//				const int		time256 = t256_provider.get_t (w);
-
-				int vxF = (VXFullF[w]-128)>>1;
-				int vyF = (VYFullF[w]-128)>>1;
-//				int vxF = t256_provider.get_vect_f (time256, VXFullF[w]);
-//				int vyF = t256_provider.get_vect_f (time256, VYFullF[w]);
+				int vxF = VFullF[w*2  ]>>1;
+				int vyF = VFullF[w*2+1]>>1;
 				int adrF = vyF*ref_pitch + vxF + (w<<NPELL2);
 				int dstF = prefF[adrF];
-				int vxB = (VXFullB[w]-128)>>1;
-				int vyB = (VYFullB[w]-128)>>1;
-//				int vxB = t256_provider.get_vect_b (time256, VXFullB[w]);
-//				int vyB = t256_provider.get_vect_b (time256, VYFullB[w]);
+				int vxB = VFullB[w*2  ]>>1;
+				int vyB = VFullB[w*2+1]>>1;
 				int adrB = vyB*ref_pitch + vxB + (w<<NPELL2);
 				int dstB = prefB[adrB];
 				pdst[w] = ( ((dstF + dstB)<<8) + (dstB - dstF)*(MaskF[w] - MaskB[w]) )>>9;
@@ -360,13 +383,10 @@ static void FlowInterSimple_NPel(
 			pdst += dst_pitch;
 			prefB += ref_pitch<<NPELL2;
 			prefF += ref_pitch<<NPELL2;
-//			t256_provider.jump_to_next_row ();
-			VXFullB += VPitch;
-			VYFullB += VPitch;
-			VXFullF += VPitch;
-			VYFullF += VPitch;
-			MaskB += VPitch;
-			MaskF += VPitch;
+			VFullB += VPitch;
+			VFullF += VPitch;
+			MaskB += MaskPitch;
+			MaskF += MaskPitch;
 		}
 	}
 
@@ -374,18 +394,16 @@ static void FlowInterSimple_NPel(
 	{
 		for (int h=0; h<height; h++)
 		{
-			for (int w=0; w<width; w+=1)
+			for (int w=x0; w<width; w+=1)
 			{
 				const int		time256 = t256_provider.get_t (w);
 
-//				int vxF = ((VXFullF[w]-128)*time256)/256;
-//				int vyF = ((VYFullF[w]-128)*time256)/256;
-				int vxF = t256_provider.get_vect_f (time256, VXFullF[w]);
-				int vyF = t256_provider.get_vect_f (time256, VYFullF[w]);
+				int vxF = t256_provider.scale_vect_f (time256, VFullF[w*2  ]);
+				int vyF = t256_provider.scale_vect_f (time256, VFullF[w*2+1]);
 				int adrF = vyF*ref_pitch + vxF + (w<<NPELL2);
 				int dstF = prefF[adrF];
-				int vxB = t256_provider.get_vect_b (time256, VXFullB[w]);
-				int vyB = t256_provider.get_vect_b (time256, VYFullB[w]);
+				int vxB = t256_provider.scale_vect_b (time256, VFullB[w*2  ]);
+				int vyB = t256_provider.scale_vect_b (time256, VFullB[w*2+1]);
 				int adrB = vyB*ref_pitch + vxB + (w<<NPELL2);
 				int dstB = prefB[adrB];
 				pdst[w] = ( ( (dstF*(255-MaskF[w]) + dstB*MaskF[w] + 255)>>8 )*(256-time256) +
@@ -395,12 +413,10 @@ static void FlowInterSimple_NPel(
 			prefB += ref_pitch<<NPELL2;
 			prefF += ref_pitch<<NPELL2;
 			t256_provider.jump_to_next_row ();
-			VXFullB += VPitch;
-			VYFullB += VPitch;
-			VXFullF += VPitch;
-			VYFullF += VPitch;
-			MaskB += VPitch;
-			MaskF += VPitch;
+			VFullB += VPitch;
+			VFullF += VPitch;
+			MaskB += MaskPitch;
+			MaskF += MaskPitch;
 		}
 	}
 }
@@ -408,22 +424,34 @@ static void FlowInterSimple_NPel(
 template <class T256P>
 static void FlowInterSimple_Pel1 (
 	uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-	uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-	int VPitch, int width, int height, T256P &t256_provider)
+	const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+	const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+	int width, int height, T256P &t256_provider, bool avx2_flag)
 {
+	int				x0 = 0;
+	if (avx2_flag)
+	{
+		x0 = width & ~7;
+		FlowInterSimple_avx2 <T256P, 0> (
+			pdst, dst_pitch, prefB, prefF, ref_pitch,
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			x0, height, t256_provider
+		);
+	}
+
 	if (t256_provider.is_half ()) // special case double fps - fastest
 	{
 		for (int h=0; h<height; h++)
 		{
-			for (int w=0; w<width; w+=2) // paired for speed
+			for (int w=x0; w<width; w+=2) // paired for speed
 			{
-				int vxF = (VXFullF[w]-128)>>1;
-				int vyF = (VYFullF[w]-128)>>1;
+				int vxF = VFullF[w*2  ]>>1;
+				int vyF = VFullF[w*2+1]>>1;
 				int addrF = vyF*ref_pitch + vxF + w;
 				int dstF = prefF[addrF];
 				int dstF1 = prefF[addrF+1]; // approximation for speed
-				int vxB = (VXFullB[w]-128)>>1;
-				int vyB = (VYFullB[w]-128)>>1;
+				int vxB = VFullB[w*2  ]>>1;
+				int vyB = VFullB[w*2+1]>>1;
 				int addrB = vyB*ref_pitch + vxB + w;
 				int dstB = prefB[addrB];
 				int dstB1 = prefB[addrB+1];
@@ -433,12 +461,10 @@ static void FlowInterSimple_Pel1 (
 			pdst += dst_pitch;
 			prefB += ref_pitch;
 			prefF += ref_pitch;
-			VXFullB += VPitch;
-			VYFullB += VPitch;
-			VXFullF += VPitch;
-			VYFullF += VPitch;
-			MaskB += VPitch;
-			MaskF += VPitch;
+			VFullB += VPitch;
+			VFullF += VPitch;
+			MaskB += MaskPitch;
+			MaskF += MaskPitch;
 		}
 	}
 
@@ -446,17 +472,17 @@ static void FlowInterSimple_Pel1 (
 	{
 		for (int h=0; h<height; h++)
 		{
-			for (int w=0; w<width; w+=2) // paired for speed
+			for (int w=x0; w<width; w+=2) // paired for speed
 			{
 				const int		time256 = t256_provider.get_t (w);
 
-				int vxF = t256_provider.get_vect_f (time256, VXFullF[w]);
-				int vyF = t256_provider.get_vect_f (time256, VYFullF[w]);
+				int vxF = t256_provider.scale_vect_f (time256, VFullF[w*2  ]);
+				int vyF = t256_provider.scale_vect_f (time256, VFullF[w*2+1]);
 				int addrF = vyF*ref_pitch + vxF + w;
 				int dstF = prefF[addrF];
 				int dstF1 = prefF[addrF+1]; // approximation for speed
-				int vxB = t256_provider.get_vect_b (time256, VXFullB[w]);
-				int vyB = t256_provider.get_vect_b (time256, VYFullB[w]);
+				int vxB = t256_provider.scale_vect_b (time256, VFullB[w*2  ]);
+				int vyB = t256_provider.scale_vect_b (time256, VFullB[w*2+1]);
 				int addrB = vyB*ref_pitch + vxB + w;
 				int dstB = prefB[addrB];
 				int dstB1 = prefB[addrB+1];
@@ -469,12 +495,10 @@ static void FlowInterSimple_Pel1 (
 			prefB += ref_pitch;
 			prefF += ref_pitch;
 			t256_provider.jump_to_next_row ();
-			VXFullB += VPitch;
-			VYFullB += VPitch;
-			VXFullF += VPitch;
-			VYFullF += VPitch;
-			MaskB += VPitch;
-			MaskF += VPitch;
+			VFullB += VPitch;
+			VFullF += VPitch;
+			MaskB += MaskPitch;
+			MaskF += MaskPitch;
 		}
 	}
 }
@@ -482,32 +506,32 @@ static void FlowInterSimple_Pel1 (
 template <class T256P>
 void FlowInterSimple(
 	uint8_t * pdst, int dst_pitch, const uint8_t *prefB, const uint8_t *prefF, int ref_pitch,
-	uint8_t *VXFullB, uint8_t *VXFullF, uint8_t *VYFullB, uint8_t *VYFullF, uint8_t *MaskB, uint8_t *MaskF,
-	int VPitch, int width, int height, int nPel, T256P &t256_provider)
+	const int16_t *VFullB, const int16_t *VFullF, int VPitch,
+	const uint8_t *MaskB, const uint8_t *MaskF, int MaskPitch,
+	int width, int height, int nPel, T256P &t256_provider, bool avx2_flag)
 {
 	if (nPel==1)
 	{
 		FlowInterSimple_Pel1 (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-			VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-			VPitch, width, height, t256_provider
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider, avx2_flag
 		);
 	}
 	else if (nPel==2)
 	{
 		FlowInterSimple_NPel <T256P, 1> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider, avx2_flag
 		);
 	}
 	else if (nPel==4)
 	{
 		FlowInterSimple_NPel <T256P, 2> (
 			pdst, dst_pitch, prefB, prefF, ref_pitch,
-		   VXFullB, VXFullF, VYFullB, VYFullF, MaskB, MaskF,
-		   VPitch, width, height, t256_provider
+			VFullB, VFullF, VPitch, MaskB, MaskF, MaskPitch,
+			width, height, t256_provider, avx2_flag
 		);
 	}
 }
-
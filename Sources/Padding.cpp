@@ -19,19 +19,6 @@
 #include "Padding.h"
 
 
-void PadCorner(unsigned char *p, unsigned char v, int hPad, int vPad, int refPitch)
-{
-	for ( int i = 0; i < vPad; i++ )
-	{
-        memset(p, v, hPad); // faster than loop
-//		for ( int j = 0; j < hPad; j++ )
-//		{
-//			p[j] = v;
-//		}
-		p += refPitch;
-	}
-}
-
 Padding::Padding(PClip _child, int hPad, int vPad, bool _planar, IScriptEnvironment* env) :
 GenericVideoFilter(_child)
 {
@@ -160,49 +147,44 @@ PVideoFrame __stdcall Padding::GetFrame(int n, IScriptEnvironment *env)
 }
 
 void Padding::PadReferenceFrame(unsigned char *refFrame, int refPitch, int hPad, int vPad, int width, int height)
+{
+	PadRows(refFrame, refPitch, hPad, vPad, width, height, 0, height);
+}
+
+// Pads the rows [y_beg ; y_end[ of the plane, on the left and right sides.
+// The slice containing the first (last) row also pads the top (bottom),
+// corners included. This way a plane computed by slices can be padded by
+// the same slices, while the data is still in the cache. The top and bottom
+// paddings only read the rows of their own slice.
+void Padding::PadRows(unsigned char *refFrame, int refPitch, int hPad, int vPad, int width, int height, int y_beg, int y_end)
 {
 	unsigned char *pfoff = refFrame + vPad * refPitch + hPad;
 
-	// Up-Left
-	PadCorner(refFrame, pfoff[0], hPad, vPad, refPitch);
-	// Up-Right
-	PadCorner(refFrame + hPad + width, pfoff[width - 1], hPad, vPad, refPitch);
-	// Down-Left
-	PadCorner(refFrame + (vPad + height) * refPitch,
-		pfoff[(height - 1) * refPitch], hPad, vPad, refPitch);
-	// Down-Right
-	PadCorner(refFrame + hPad + width + (vPad + height) * refPitch,
-		pfoff[(height - 1) * refPitch + width - 1], hPad, vPad, refPitch);
-
-	// Top and bottom
-	// LDS: would multiple memcpy be faster? The inner loop is very short
-	// and the offset calculations are not trivial.
-	for ( int i = 0; i < width; i++ )
+	// Left and right
+	for ( int i = y_beg; i < y_end; i++ )
 	{
-		unsigned char	value_t = pfoff[i                          ];
-		unsigned char	value_b = pfoff[i + (height - 1) * refPitch];
-		unsigned char*	p_t = refFrame + hPad + i;
-		unsigned char*	p_b = p_t + (height + vPad) * refPitch;
+		unsigned char*	p_l = refFrame + (vPad + i) * refPitch;
+		unsigned char*	p_r = p_l + width + hPad;
+		memset(p_l, pfoff[i * refPitch            ], hPad);
+		memset(p_r, pfoff[i * refPitch + width - 1], hPad);
+	}
+
+	// Top and bottom, from the padded first and last rows
+	const int		row_len = width + hPad * 2;
+	if (y_beg == 0)
+	{
+		const unsigned char *	p_src = refFrame + vPad * refPitch;
 		for ( int j = 0; j < vPad; j++ )
 		{
-			p_t [0] = value_t;
-			p_b [0] = value_b;
-			p_t += refPitch;
-			p_b += refPitch;
+			memcpy(refFrame + j * refPitch, p_src, row_len);
 		}
 	}
-
-	// Left and right
-	for ( int i = 0; i < height; i++ )
+	if (y_end == height)
 	{
-		unsigned char	value_l = pfoff[i * refPitch            ];
-		unsigned char	value_r = pfoff[i * refPitch + width - 1];
-		unsigned char*	p_l = refFrame + (vPad + i) * refPitch;
-		unsigned char*	p_r = p_l + width + hPad;
-		for ( int j = 0; j < hPad; j++ )
+		const unsigned char *	p_src = refFrame + (vPad + height - 1) * refPitch;
+		for ( int j = 0; j < vPad; j++ )
 		{
-			p_l [j] = value_l;
-			p_r [j] = value_r;
+			memcpy(refFrame + (vPad + height + j) * refPitch, p_src, row_len);
 		}
 	}
 }
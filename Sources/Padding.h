@@ -49,6 +49,7 @@ public:
 	~Padding();
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env);
 	static void PadReferenceFrame(unsigned char *frame, int pitch, int hPad, int vPad, int width, int height);
+	static void PadRows(unsigned char *frame, int pitch, int hPad, int vPad, int width, int height, int y_beg, int y_end);
 
 };
 
@@ -26,21 +26,22 @@
 #include "DCTFactory.h"
 #include "debugprintf.h"
 #include "FakePlaneOfBlocks.h"
+#include "FuncDispatch.h"
 #include "MVClip.h"
 #include "MVFrame.h"
 #include "MVPlane.h"
 #include "PlaneOfBlocks.h"
 #include "Padding.h"
-#include "profile.h"
 
 #include <mmintrin.h>
 
 #include	<algorithm>
+#include	<climits>
 #include	<stdexcept>
 
 
 
-PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int _nFlags, int _nOverlapX, int _nOverlapY, int _yRatioUV, conc::ObjPool <DCTClass> *dct_pool_ptr, bool mt_flag)
+PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int _nFlags, int _nOverlapX, int _nOverlapY, int _yRatioUV, conc::ObjPool <DCTClass> *dct_pool_ptr, Profiler *prof_ptr, bool mt_flag)
 :	nBlkX (_nBlkX)
 ,	nBlkY (_nBlkY)
 ,	nBlkSizeX (_nBlkSizeX)
@@ -56,6 +57,7 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
 ,	yRatioUV (_yRatioUV)
 ,	nLogyRatioUV (ilog2 (_yRatioUV))
 ,  _mt_flag (mt_flag)
+,	_prof_ptr (prof_ptr)
 ,	SAD (0)
 ,	LUMA (0)
 ,	VAR (0)
@@ -63,6 +65,12 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
 ,	BLITCHROMA (0)
 ,	SADCHROMA (0)
 ,	SATD (0)
+,	SADMULTI (0)
+,	SADCHROMAMULTI (0)
+,	SADMAP (0)
+,	SADCHROMAMAP (0)
+,	SADTHR (0)
+,	_sad_thr_flag (false)
 ,	vectors (nBlkCount)
 ,	smallestPlane ((_nFlags & MOTION_SMALLEST_PLANE) != 0)
 //,	mmx ((_nFlags & MOTION_USE_MMX) != 0)
@@ -71,18 +79,25 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
 ,	dctpitch (std::max (_nBlkSizeX, 16))
 ,	_dct_pool_ptr (dct_pool_ptr)
 ,	verybigSAD (_nBlkSizeX * _nBlkSizeY * 256)
-,	freqArray ()
 ,	dctmode (0)
+,	_src_cache_frame_ptr (0)
+,	_src_cache_flag (false)
+,	_src_cache_blk_size (0)
+,	_src_cache_blk ()
+,	_src_cache_dct ()
+,	_src_cache_luma ()
 ,	_workarea_fact (nBlkSizeX, nBlkSizeY, dctpitch, nLogyRatioUV, yRatioUV)
 ,	_workarea_pool ()
-,	_gvect_estim_ptr (0)
-,	_gvect_result_count (0)
+,	_gmv_part_arr ()
+,	_gmv_nbr_parts (0)
+,	_gmv_median ()
+,	_interp_src_ptr (0)
+,	_wavefront_graph ()
+,	_sched_wavefront (mt_flag)
 {
 	_workarea_pool.set_factory (_workarea_fact);
-
-	// half must be more than max vector length, which is (framewidth + Padding) * nPel
-	freqArray [0].resize (8192 * _nPel * 2);
-	freqArray [1].resize (8192 * _nPel * 2);
+	_badcount_arr.resize (nBlkY, 0);
+	_badcount_nbr_chunks = 1;
 
 	bool mmxext = (bool)(nFlags & CPU_MMXEXT);
 	bool cache32 = (bool)(nFlags & CPU_CACHELINE_32);
@@ -105,42 +120,6 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
 
 	// function's pointers initialization
 
-#define SET_FUNCPTR(blksizex, blksizey, blksizex2, blksizey2)	do \
-	{ \
-		SAD = Sad##blksizex##x##blksizey##_iSSE; \
-		VAR = Var##blksizex##x##blksizey##_sse2; \
-		LUMA = Luma##blksizex##x##blksizey##_sse2; \
-		BLITLUMA = Copy##blksizex##x##blksizey##_sse2; \
-		if (yRatioUV==2) \
-		{ \
-			BLITCHROMA = Copy##blksizex2##x##blksizey2##_sse2; \
-			SADCHROMA = Sad##blksizex2##x##blksizey2##_iSSE; \
-		} \
-		else \
-		{ \
-			BLITCHROMA = Copy##blksizex2##x##blksizey##_sse2; \
-			SADCHROMA = Sad##blksizex2##x##blksizey##_iSSE; \
-		} \
-	} while (false)
-
-#define SET_FUNCPTR_C(blksizex, blksizey, blksizex2, blksizey2)	do \
-	{ \
-		SAD = Sad_C<blksizex , blksizey>; \
-		VAR = Var_C<blksizex , blksizey>; \
-		LUMA = Luma_C<blksizex , blksizey>; \
-		BLITLUMA = Copy_C<blksizex , blksizey>; \
-		if (yRatioUV==2) \
-		{ \
-			BLITCHROMA = Copy_C<blksizex2 , blksizey2>; \
-			SADCHROMA = Sad_C<blksizex2 , blksizey2>; \
-		} \
-		else \
-		{ \
-			BLITCHROMA = Copy_C<blksizex2 , blksizey>; \
-			SADCHROMA = Sad_C<blksizex2  , blksizey>; \
-		} \
-	} while (false)
-
 //#define NEWBLIT
 
 #ifdef NEWBLIT
@@ -205,117 +184,26 @@ PlaneOfBlocks::PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSi
 
 	SATD = SadDummy; //for now disable SATD if default functions are used
 
-	if ( isse )
+	const FuncDispatch::Tier	tier = FuncDispatch::select_tier (isse);
+	FuncDispatch::BlockFnc	fnc;
+	if (FuncDispatch::find (fnc, nBlkSizeX, nBlkSizeY, tier))
 	{
-		switch (nBlkSizeX)
-		{
-		case 16:
-			if (nBlkSizeY==16)
-			{
-				SET_FUNCPTR(16,16,8,8);
-			}
-			else if (nBlkSizeY==8)
-			{
-				SET_FUNCPTR(16,8,8,4);
-			}
-			else if (nBlkSizeY==2)
-			{
-				SET_FUNCPTR(16,2,8,1);
-			}
-			else if (nBlkSizeY==1)
-			{
-				SAD = Sad16x1_iSSE;
-				VAR = Var_C<16,1>;
-				LUMA = Luma_C<16,1>;
-				BLITLUMA = Copy_C<16,1>;
-				if (yRatioUV==2)
-				{
-					//error
-				}
-				else	// yRatioUV==1
-				{
-					BLITCHROMA = Copy8x1_sse2;
-					SADCHROMA = Sad8x1_iSSE;
-				}
-			}
-			break;
-		case 4:
-			SET_FUNCPTR(4,4,2,2);
-			if (yRatioUV==2)
-			{
-				//SADCHROMA = Sad2x2_iSSE_T;
-			}
-			else
-			{
-				//SADCHROMA = Sad2x4_iSSE_T;
-			}
-			break;
-		case 32:
-			if (nBlkSizeY==16)
-			{
-				SET_FUNCPTR(32,16,16,8);
-			}
-			else if (nBlkSizeY==32)
-			{
-				SET_FUNCPTR(32,32,16,16);
-			}
-			break;
-		case 8:
-		default:
-			if (nBlkSizeY == 8)
-			{
-				SET_FUNCPTR(8,8,4,4);
-			}
-			else if (nBlkSizeY == 4)
-			{ // 8x4
-				SET_FUNCPTR(8,4,4,2);
-			}
-		}//end switch
-	}//end isse
-
-	else
+		SAD = fnc._sad_ptr;
+		SADMULTI = fnc._sad_multi_ptr;
+		SADMAP = fnc._sad_map_ptr;
+		SADTHR = fnc._sad_thr_ptr;	// 0 if there is no SIMD kernel
+		VAR = fnc._var_ptr;
+		LUMA = fnc._luma_ptr;
+		BLITLUMA = fnc._copy_ptr;
+	}
+	if (FuncDispatch::find (fnc, nBlkSizeX >> 1, nBlkSizeY >> nLogyRatioUV, tier))
 	{
-		switch (nBlkSizeX)
-		{
-		case 16:
-			if (nBlkSizeY==16)
-			{
-				SET_FUNCPTR_C(16, 16, 8, 8);
-			}
-			else if (nBlkSizeY==8)
-			{
-				SET_FUNCPTR_C(16, 8, 8, 4);
-			}
-			else if (nBlkSizeY==2)
-			{
-				SET_FUNCPTR_C(16, 2, 8, 1);
-			}
-			break;
-		case 4:
-			SET_FUNCPTR_C(4, 4, 2, 2);
-			break;
-		case 32:
-			if (nBlkSizeY==16)
-			{
-				SET_FUNCPTR_C(32, 16, 16, 8);
-			}
-			else if (nBlkSizeY==32)
-			{
-				SET_FUNCPTR_C(32, 32, 16, 16);
-			}
-			break;
-		case 8:
-		default:
-			if (nBlkSizeY==8)
-			{
-				SET_FUNCPTR_C(8, 8, 4, 4);
-			}
-			else if (nBlkSizeY==4)
-			{
-				SET_FUNCPTR_C(8, 4, 4, 2);
-			}
-		}
+		SADCHROMA = fnc._sad_ptr;
+		SADCHROMAMULTI = fnc._sad_multi_ptr;
+		SADCHROMAMAP = fnc._sad_map_ptr;
+		BLITCHROMA = fnc._copy_ptr;
 	}
+	_sad_thr_flag = (SADTHR != 0 && nBlkSizeX >= 16 && nBlkSizeY >= 16);
 
 	if (0&&mmxext) //use new functions from x264
 	{
@@ -544,27 +432,10 @@ void PlaneOfBlocks::SearchMVs (
 
 	nFlags |= flags;
 
-	pSrcFrame = _pSrcFrame;
+	set_src_frame (_pSrcFrame);
 	pRefFrame = _pRefFrame;
+	_src_cache_flag = (_src_cache_frame_ptr != 0 && _src_cache_frame_ptr == pSrcFrame);
 
-#if (ALIGN_SOURCEBLOCK > 1)
-	nSrcPitch_plane[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
-	if (chroma)
-	{
-		nSrcPitch_plane[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
-		nSrcPitch_plane[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
-	}
-	nSrcPitch[0] = nBlkSizeX;
-	nSrcPitch[1] = nBlkSizeX/2;
-	nSrcPitch[2] = nBlkSizeX/2;
-#else	// ALIGN_SOURCEBLOCK
-	nSrcPitch[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
-	if (chroma)
-	{
-		nSrcPitch[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
-		nSrcPitch[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
-	}
-#endif	// ALIGN_SOURCEBLOCK
 	nRefPitch[0] = pRefFrame->GetPlane(YPLANE)->GetPitch();
 	if (chroma)
 	{
@@ -593,7 +464,6 @@ void PlaneOfBlocks::SearchMVs (
 
 	penaltyZero   = _pzero;
 	pglobal       = _pglobal;
-	badcount      = 0;
 	tryMany       = _tryMany;
 	planeSAD      = 0;
 	sumLumaChange = 0;
@@ -607,9 +477,38 @@ void PlaneOfBlocks::SearchMVs (
 
 	// -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 
-	Slicer			slicer (_mt_flag);
-	slicer.start (nBlkY, *this, &PlaneOfBlocks::search_mv_slice, 4);
-	slicer.wait ();
+	const int64_t	prof_t_beg = (_prof_ptr != 0) ? Profiler::get_time () : 0;
+	_prof_slices.clear ();
+
+	const int		nbr_chunks = compute_nbr_chunks ();
+	_badcount_nbr_chunks = nbr_chunks;
+	_badcount_arr.assign (nBlkY * nbr_chunks, 0);
+	_wavefront_graph.init (nBlkY, nBlkX, nbr_chunks);
+
+	int				nbr_threads = 1;
+	if (_mt_flag)
+	{
+		nbr_threads = AvstpWrapper::use_instance ().get_nbr_threads ();
+	}
+	if (nbr_threads > 1 && nbr_chunks > 1 && nBlkY > 1)
+	{
+		_sched_wavefront.start (
+			_wavefront_graph, *this, &PlaneOfBlocks::search_mv_wavefront
+		);
+		_sched_wavefront.wait ();
+	}
+	else
+	{
+		// Nothing can run in parallel
+		search_mv_sequential ();
+	}
+
+	if (_prof_ptr != 0)
+	{
+		_prof_ptr->add_run (
+			Profiler::STG_SEARCH, Profiler::get_time () - prof_t_beg, _prof_slices
+		);
+	}
 
 	// -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 
@@ -622,6 +521,52 @@ void PlaneOfBlocks::SearchMVs (
 
 
 
+// Computes the source-only part of the block matching for all the blocks
+// of the plane: aligned copies, DCT and mean luma. The following calls to
+// SearchMVs() on the same frame object use these data instead of
+// recomputing them for each reference frame. The caller must invalidate
+// the cache as soon as the frame content changes.
+void PlaneOfBlocks::PrepareSrcCache(MVFrame *_pSrcFrame)
+{
+	set_src_frame (_pSrcFrame);
+
+	if (_src_cache_luma.empty ())
+	{
+#if (ALIGN_SOURCEBLOCK > 1)
+		const int		blocksize  = nBlkSizeX * nBlkSizeY;
+		const int		chromasize = (blocksize / 2) >> nLogyRatioUV;
+		const int		mask       = ALIGN_SOURCEBLOCK - 1;
+		_src_cache_ofs [0]  = 0;
+		_src_cache_ofs [1]  = (blocksize + mask) & ~mask;
+		_src_cache_ofs [2]  = _src_cache_ofs [1] + ((chromasize + mask) & ~mask);
+		_src_cache_blk_size = _src_cache_ofs [2] + ((chromasize + mask) & ~mask);
+		_src_cache_blk.resize (nBlkCount * _src_cache_blk_size);
+#endif	// ALIGN_SOURCEBLOCK
+#ifdef ALLOW_DCT
+		if (_dct_pool_ptr != 0 && dctmode != 0 && dctmode <= 4)
+		{
+			_src_cache_dct.resize (nBlkCount * nBlkSizeY * dctpitch);
+		}
+#endif	// ALLOW_DCT
+		_src_cache_luma.resize (nBlkCount);
+	}
+
+	Slicer			slicer (_mt_flag);
+	slicer.start (nBlkY, *this, &PlaneOfBlocks::prepare_src_cache_slice, 4);
+	slicer.wait ();
+
+	_src_cache_frame_ptr = _pSrcFrame;
+}
+
+
+
+void PlaneOfBlocks::InvalidateSrcCache()
+{
+	_src_cache_frame_ptr = 0;
+}
+
+
+
 void PlaneOfBlocks::RecalculateMVs (
 	MVClip & mvClip, MVFrame *_pSrcFrame, MVFrame *_pRefFrame,
 	SearchType st, int stp, int lambda, int lsad, int pnew,
@@ -654,27 +599,10 @@ void PlaneOfBlocks::RecalculateMVs (
 
 	nFlags |= flags;
 
-	pSrcFrame = _pSrcFrame;
+	set_src_frame (_pSrcFrame);
 	pRefFrame = _pRefFrame;
+	_src_cache_flag = false;
 
-#if (ALIGN_SOURCEBLOCK > 1)
-	nSrcPitch_plane[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
-	if (chroma)
-	{
-		nSrcPitch_plane[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
-		nSrcPitch_plane[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
-	}
-	nSrcPitch[0] = nBlkSizeX;
-	nSrcPitch[1] = nBlkSizeX/2;
-	nSrcPitch[2] = nBlkSizeX/2;
-#else	// ALIGN_SOURCEBLOCK
-	nSrcPitch[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
-	if (chroma)
-	{
-		nSrcPitch[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
-		nSrcPitch[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
-	}
-#endif	// ALIGN_SOURCEBLOCK
 	nRefPitch[0] = pRefFrame->GetPlane(YPLANE)->GetPitch();
 	if (chroma)
 	{
@@ -709,10 +637,20 @@ void PlaneOfBlocks::RecalculateMVs (
 
 	// -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 
+	const int64_t	prof_t_beg = (_prof_ptr != 0) ? Profiler::get_time () : 0;
+	_prof_slices.clear ();
+
 	Slicer			slicer (_mt_flag);
 	slicer.start (nBlkY, *this, &PlaneOfBlocks::recalculate_mv_slice, 4);
 	slicer.wait ();
 
+	if (_prof_ptr != 0)
+	{
+		_prof_ptr->add_run (
+			Profiler::STG_SEARCH, Profiler::get_time () - prof_t_beg, _prof_slices
+		);
+	}
+
 	// -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 }
 
@@ -720,86 +658,13 @@ void PlaneOfBlocks::RecalculateMVs (
 
 void PlaneOfBlocks::InterpolatePrediction(const PlaneOfBlocks &pob)
 {
-	int normFactor = 3 - nLogPel + pob.nLogPel;
-	int mulFactor = (normFactor < 0) ? -normFactor : 0;
-	normFactor = (normFactor < 0) ? 0 : normFactor;
-	int normov = (nBlkSizeX - nOverlapX)*(nBlkSizeY - nOverlapY);
-	int aoddx= (nBlkSizeX*3 - nOverlapX*2);
-	int aevenx = (nBlkSizeX*3 - nOverlapX*4);
-	int aoddy= (nBlkSizeY*3 - nOverlapY*2);
-	int aeveny = (nBlkSizeY*3 - nOverlapY*4);
-	// note: overlapping is still (v2.5.7) not processed properly
-	for ( int l = 0, index = 0; l < nBlkY; l++ )
-	{
-		for ( int k = 0; k < nBlkX; k++, index++ )
-		{
-			VECTOR v1, v2, v3, v4;
-			int i = k;
-			int j = l;
-			if ( i >= 2 * pob.nBlkX )
-			{
-				i= 2 * pob.nBlkX-1;
-			}
-			if ( j >= 2 * pob.nBlkY )
-			{
-				j= 2 * pob.nBlkY-1;
-			}
-			int offy = -1 + 2 * ( j % 2);
-			int offx = -1 + 2 * ( i % 2);
+	_interp_src_ptr = &pob;
 
-			if (( i == 0 ) || (i >= 2 * pob.nBlkX - 1))
-				{
-				if (( j == 0 ) || ( j >= 2 * pob.nBlkY - 1))
-				{
-					v1 = v2 = v3 = v4 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
-				}
-				else
-				{
-					v1 = v2 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
-					v3 = v4 = pob.vectors[i / 2 + (j / 2 + offy) * pob.nBlkX];
-				}
-			}
-			else if (( j == 0 ) || ( j >= 2 * pob.nBlkY - 1))
-			{
-				v1 = v2 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
-				v3 = v4 = pob.vectors[i / 2 + offx + (j / 2) * pob.nBlkX];
-			}
-			else
-			{
-				v1 = pob.vectors[i / 2 + (j / 2) * pob.nBlkX];
-				v2 = pob.vectors[i / 2 + offx + (j / 2) * pob.nBlkX];
-				v3 = pob.vectors[i / 2 + (j / 2 + offy) * pob.nBlkX];
-				v4 = pob.vectors[i / 2 + offx + (j / 2 + offy) * pob.nBlkX];
-			}
+	Slicer         slicer (_mt_flag);
+	slicer.start (nBlkY, *this, &PlaneOfBlocks::interpolate_prediction_slice, 4);
+	slicer.wait ();
 
-			if (nOverlapX == 0 && nOverlapY == 0)
-			{
-				vectors[index].x = 9 * v1.x + 3 * v2.x + 3 * v3.x + v4.x;
-				vectors[index].y = 9 * v1.y + 3 * v2.y + 3 * v3.y + v4.y;
-				vectors[index].sad = 9 * v1.sad + 3 * v2.sad + 3 * v3.sad + v4.sad + 8;
-			}
-			else if (nOverlapX <= (nBlkSizeX>>1) && nOverlapY <= (nBlkSizeY>>1)) // corrected in v1.4.11
-			{
-				int	ax1 = (offx > 0) ? aoddx : aevenx;
-				int ax2 = (nBlkSizeX - nOverlapX)*4 - ax1;
-				int ay1 = (offy > 0) ? aoddy : aeveny;
-				int ay2 = (nBlkSizeY - nOverlapY)*4 - ay1;
-				int a11 = ax1*ay1, a12 = ax1*ay2, a21 = ax2*ay1, a22 = ax2*ay2;
-				vectors[index].x = (a11*v1.x + a21*v2.x + a12*v3.x + a22*v4.x) /normov;
-				vectors[index].y = (a11*v1.y + a21*v2.y + a12*v3.y + a22*v4.y) /normov;
-				vectors[index].sad = (a11*v1.sad + a21*v2.sad + a12*v3.sad + a22*v4.sad) /normov;
-			}
-			else // large overlap. Weights are not quite correct but let it be
-			{
-				vectors[index].x = (v1.x + v2.x + v3.x + v4.x) <<2;
-				vectors[index].y = (v1.y + v2.y + v3.y + v4.y) <<2;
-				vectors[index].sad = (v1.sad + v2.sad + v3.sad + v4.sad + 2) << 2;
-			}
-			vectors[index].x = (vectors[index].x >> normFactor) << mulFactor;
-			vectors[index].y = (vectors[index].y >> normFactor) << mulFactor;
-			vectors[index].sad = vectors[index].sad >> 4;
-		}	// for k < nBlkX
-	}	// for l < nBlkY
+	_interp_src_ptr = 0;
 }
 
 
@@ -971,12 +836,20 @@ void PlaneOfBlocks::Refine(WorkingArea &workarea)
 
 	if ( searchType & EXHAUSTIVE )
 	{
-//		ExhaustiveSearch(nSearchParam);
 		int mvx = workarea.bestMV.x;
 		int mvy = workarea.bestMV.y;
-		for ( int i = 1; i <= nSearchParam; i++ )// region is same as exhaustive, but ordered by radius (from near to far)
+#ifndef ONLY_CHECK_NONDEFAULT_MV
+		if ( nPel == 1 && dctmode == 0 && SADMAP != 0 && (SADCHROMAMAP != 0 || !chroma) )
 		{
-			ExpandingSearch(workarea, i, 1, mvx, mvy);
+			ExhaustiveSearch(workarea, nSearchParam, mvx, mvy);
+		}
+		else
+#endif
+		{
+			for ( int i = 1; i <= nSearchParam; i++ )// region is same as exhaustive, but ordered by radius (from near to far)
+			{
+				ExpandingSearch(workarea, i, 1, mvx, mvy);
+			}
 		}
 	}
 
@@ -999,22 +872,34 @@ void PlaneOfBlocks::Refine(WorkingArea &workarea)
 	{
 		int mvx = workarea.bestMV.x;
 		int mvy = workarea.bestMV.y;
+		MVCandList cand;
 		for ( int i = 1; i <= nSearchParam; i++ )// region is same as exhaustive, but ordered by radius (from near to far)
 		{
-			CheckMV(workarea, mvx - i, mvy);
-			CheckMV(workarea, mvx + i, mvy);
+			cand.push(mvx - i, mvy);
+			cand.push(mvx + i, mvy);
+			if (cand.is_full ())
+			{
+				FlushMVCand(workarea, cand);
+			}
 		}
+		FlushMVCand(workarea, cand);
 	}
 
 	if ( searchType & VSEARCH )
 	{
 		int mvx = workarea.bestMV.x;
 		int mvy = workarea.bestMV.y;
+		MVCandList cand;
 		for ( int i = 1; i <= nSearchParam; i++ )// region is same as exhaustive, but ordered by radius (from near to far)
 		{
-			CheckMV(workarea, mvx, mvy - i);
-			CheckMV(workarea, mvx, mvy + i);
+			cand.push(mvx, mvy - i);
+			cand.push(mvx, mvy + i);
+			if (cand.is_full ())
+			{
+				FlushMVCand(workarea, cand);
+			}
 		}
+		FlushMVCand(workarea, cand);
 	}
 }
 
@@ -1027,17 +912,30 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea &workarea)
 	int sad;
 	int saduv;
 #ifdef ALLOW_DCT
-	if ( dctmode != 0 ) // DCT method (luma only - currently use normal spatial SAD chroma)
+	if (_src_cache_flag)
 	{
-		// make dct of source block
-		if (dctmode <= 4) //don't do the slow dct conversion if SATD used
+		// source dct and luma already computed by PrepareSrcCache()
+		if (! _src_cache_dct.empty ())
 		{
-			workarea.DCT->DCTBytes2D(workarea.pSrc[0], nSrcPitch[0], &workarea.dctSrc [0], dctpitch);
+			const size_t	dct_size = workarea.dctSrc.size ();
+			memcpy (&workarea.dctSrc [0], &_src_cache_dct [workarea.blkIdx * dct_size], dct_size);
 		}
+		workarea.srcLuma = _src_cache_luma [workarea.blkIdx];
 	}
-	if (dctmode >= 3) // most use it and it should be fast anyway //if (dctmode == 3 || dctmode == 4) // check it
+	else
 	{
-		workarea.srcLuma = LUMA(workarea.pSrc[0], nSrcPitch[0]);
+		if ( dctmode != 0 ) // DCT method (luma only - currently use normal spatial SAD chroma)
+		{
+			// make dct of source block
+			if (dctmode <= 4) //don't do the slow dct conversion if SATD used
+			{
+				workarea.DCT->DCTBytes2D(workarea.pSrc[0], nSrcPitch[0], &workarea.dctSrc [0], dctpitch);
+			}
+		}
+		if (dctmode >= 3) // most use it and it should be fast anyway //if (dctmode == 3 || dctmode == 4) // check it
+		{
+			workarea.srcLuma = LUMA(workarea.pSrc[0], nSrcPitch[0]);
+		}
 	}
 #endif	// ALLOW_DCT
 
@@ -1118,21 +1016,28 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea &workarea)
 	// then all the other predictors
 	int npred = (temporal) ? 5 : 4;
 
-	for ( int i = 0; i < npred; i++ )
+	if (tryMany)
 	{
-		if (tryMany)
+		for ( int i = 0; i < npred; i++ )
 		{
 			workarea.nMinCost = verybigSAD+1;
-		}
-		CheckMV0(workarea, workarea.predictors[i].x, workarea.predictors[i].y);
-		if (tryMany)
-		{
+			CheckMV0(workarea, workarea.predictors[i].x, workarea.predictors[i].y);
 			// refine around predictor
 			Refine(workarea);    // reset bestMV
 			bestMVMany[i+3]   = workarea.bestMV;    // save bestMV
 			nMinCostMany[i+3] = workarea.nMinCost;
+		}	// for i
+	}
+	else
+	{
+		// all the predictors are known, check them in a single batch
+		MVCandList cand;
+		for ( int i = 0; i < npred; i++ )
+		{
+			cand.push(workarea.predictors[i].x, workarea.predictors[i].y);
 		}
-	}	// for i
+		CheckMVMulti(workarea, cand, 0, 0, true);
+	}
 
 	if (tryMany)
 	{
@@ -1157,12 +1062,17 @@ void PlaneOfBlocks::PseudoEPZSearch(WorkingArea &workarea)
 
 	const int		BADCOUNT_LIMIT = 16;
 
+	// Bad blocks refined so far on the plane, see init_badcount()
+	int &				chunk_badcount = _badcount_arr [workarea.badcount_idx];
+	const int		badcount = workarea.badcount_base + chunk_badcount;
+
 	// bad vector, try wide search
 	if (   workarea.blkIdx > 1 + workarea.blky_beg * nBlkX
 	    && foundSAD > (badSAD + badSAD*badcount / BADCOUNT_LIMIT))
 	{
 		// with some soft limit (BADCOUNT_LIMIT) of bad cured vectors (time consumed)
-		++ badcount;
+		++ chunk_badcount;
+		prof_count (workarea, Profiler::CNT_BAD_SAD, 1);
 
 		DebugPrintf (
 			"bad  blk=%d x=%d y=%d sad=%d mean=%d iter=%d",
@@ -1275,10 +1185,13 @@ void PlaneOfBlocks::DiamondSearch(WorkingArea &workarea, int length)
 		// First, we look the directions that were hinted by the previous step
 		// of the algorithm. If we find one, we add it to the set of directions
 		// we'll test next
-		if ( lastDirection & 1 ) CheckMV2(workarea, dx + length, dy, &direction, 1);
-		if ( lastDirection & 2 ) CheckMV2(workarea, dx - length, dy, &direction, 2);
-		if ( lastDirection & 4 ) CheckMV2(workarea, dx, dy + length, &direction, 4);
-		if ( lastDirection & 8 ) CheckMV2(workarea, dx, dy - length, &direction, 8);
+		MVCandList cand;
+		if ( lastDirection & 1 ) cand.push(dx + length, dy, 1);
+		if ( lastDirection & 2 ) cand.push(dx - length, dy, 2);
+		if ( lastDirection & 4 ) cand.push(dx, dy + length, 4);
+		if ( lastDirection & 8 ) cand.push(dx, dy - length, 8);
+		CheckMVMulti(workarea, cand, penaltyNew, &direction, true);
+		cand.clear ();
 
 		// If one of the directions improves the SAD, we make further tests
 		// on the diagonals
@@ -1290,13 +1203,13 @@ void PlaneOfBlocks::DiamondSearch(WorkingArea &workarea, int length)
 
 			if ( lastDirection & 3 )
 			{
-				CheckMV2(workarea, dx, dy + length, &direction, 4);
-				CheckMV2(workarea, dx, dy - length, &direction, 8);
+				cand.push(dx, dy + length, 4);
+				cand.push(dx, dy - length, 8);
 			}
 			else
 			{
-				CheckMV2(workarea, dx + length, dy, &direction, 1);
-				CheckMV2(workarea, dx - length, dy, &direction, 2);
+				cand.push(dx + length, dy, 1);
+				cand.push(dx - length, dy, 2);
 			}
 		}
 
@@ -1307,51 +1220,53 @@ void PlaneOfBlocks::DiamondSearch(WorkingArea &workarea, int length)
 			switch ( lastDirection )
 			{
 			case 1 :
-				CheckMV2(workarea, dx + length, dy + length, &direction, 1 + 4);
-				CheckMV2(workarea, dx + length, dy - length, &direction, 1 + 8);
+				cand.push(dx + length, dy + length, 1 + 4);
+				cand.push(dx + length, dy - length, 1 + 8);
 				break;
 			case 2 :
-				CheckMV2(workarea, dx - length, dy + length, &direction, 2 + 4);
-				CheckMV2(workarea, dx - length, dy - length, &direction, 2 + 8);
+				cand.push(dx - length, dy + length, 2 + 4);
+				cand.push(dx - length, dy - length, 2 + 8);
 				break;
 			case 4 :
-				CheckMV2(workarea, dx + length, dy + length, &direction, 1 + 4);
-				CheckMV2(workarea, dx - length, dy + length, &direction, 2 + 4);
+				cand.push(dx + length, dy + length, 1 + 4);
+				cand.push(dx - length, dy + length, 2 + 4);
 				break;
 			case 8 :
-				CheckMV2(workarea, dx + length, dy - length, &direction, 1 + 8);
-				CheckMV2(workarea, dx - length, dy - length, &direction, 2 + 8);
+				cand.push(dx + length, dy - length, 1 + 8);
+				cand.push(dx - length, dy - length, 2 + 8);
 				break;
 			case 1 + 4 :
-				CheckMV2(workarea, dx + length, dy + length, &direction, 1 + 4);
-				CheckMV2(workarea, dx - length, dy + length, &direction, 2 + 4);
-				CheckMV2(workarea, dx + length, dy - length, &direction, 1 + 8);
+				cand.push(dx + length, dy + length, 1 + 4);
+				cand.push(dx - length, dy + length, 2 + 4);
+				cand.push(dx + length, dy - length, 1 + 8);
 				break;
 			case 2 + 4 :
-				CheckMV2(workarea, dx + length, dy + length, &direction, 1 + 4);
-				CheckMV2(workarea, dx - length, dy + length, &direction, 2 + 4);
-				CheckMV2(workarea, dx - length, dy - length, &direction, 2 + 8);
+				cand.push(dx + length, dy + length, 1 + 4);
+				cand.push(dx - length, dy + length, 2 + 4);
+				cand.push(dx - length, dy - length, 2 + 8);
 				break;
 			case 1 + 8 :
-				CheckMV2(workarea, dx + length, dy + length, &direction, 1 + 4);
-				CheckMV2(workarea, dx - length, dy - length, &direction, 2 + 8);
-				CheckMV2(workarea, dx + length, dy - length, &direction, 1 + 8);
+				cand.push(dx + length, dy + length, 1 + 4);
+				cand.push(dx - length, dy - length, 2 + 8);
+				cand.push(dx + length, dy - length, 1 + 8);
 				break;
 			case 2 + 8 :
-				CheckMV2(workarea, dx - length, dy - length, &direction, 2 + 8);
-				CheckMV2(workarea, dx - length, dy + length, &direction, 2 + 4);
-				CheckMV2(workarea, dx + length, dy - length, &direction, 1 + 8);
+				cand.push(dx - length, dy - length, 2 + 8);
+				cand.push(dx - length, dy + length, 2 + 4);
+				cand.push(dx + length, dy - length, 1 + 8);
 				break;
 			default :
 				// Even the default case may happen, in the first step of the
 				// algorithm for example.
-				CheckMV2(workarea, dx + length, dy + length, &direction, 1 + 4);
-				CheckMV2(workarea, dx - length, dy + length, &direction, 2 + 4);
-				CheckMV2(workarea, dx + length, dy - length, &direction, 1 + 8);
-				CheckMV2(workarea, dx - length, dy - length, &direction, 2 + 8);
+				cand.push(dx + length, dy + length, 1 + 4);
+				cand.push(dx - length, dy + length, 2 + 4);
+				cand.push(dx + length, dy - length, 1 + 8);
+				cand.push(dx - length, dy - length, 2 + 8);
 				break;
 			}
 		}	// if ! direction
+
+		CheckMVMulti(workarea, cand, penaltyNew, &direction, true);
 	}	// while direction > 0
 }
 
@@ -1398,14 +1313,16 @@ void PlaneOfBlocks::NStepSearch(WorkingArea &workarea, int stp)
 		dx = workarea.bestMV.x;
 		dy = workarea.bestMV.y;
 
-		CheckMV(workarea, dx + length, dy + length);
-		CheckMV(workarea, dx + length, dy);
-		CheckMV(workarea, dx + length, dy - length);
-		CheckMV(workarea, dx, dy - length);
-		CheckMV(workarea, dx, dy + length);
-		CheckMV(workarea, dx - length, dy + length);
-		CheckMV(workarea, dx - length, dy);
-		CheckMV(workarea, dx - length, dy - length);
+		MVCandList cand;
+		cand.push(dx + length, dy + length);
+		cand.push(dx + length, dy);
+		cand.push(dx + length, dy - length);
+		cand.push(dx, dy - length);
+		cand.push(dx, dy + length);
+		cand.push(dx - length, dy + length);
+		cand.push(dx - length, dy);
+		cand.push(dx - length, dy - length);
+		FlushMVCand(workarea, cand);
 
 		length--;
 	}
@@ -1471,57 +1388,220 @@ void PlaneOfBlocks::ExpandingSearch(WorkingArea &workarea, int r, int s, int mvx
 	int i, j;
 //	VECTOR mv = workarea.bestMV; // bug: it was pointer assignent, not values, so iterative! - v2.1
 
+	MVCandList cand;
+
 	// sides of square without corners
 	for ( i = -r+s; i < r; i+=s ) // without corners! - v2.1
 	{
-		CheckMV(workarea, mvx + i, mvy - r);
-		CheckMV(workarea, mvx + i, mvy + r);
+		cand.push(mvx + i, mvy - r);
+		cand.push(mvx + i, mvy + r);
+		if (cand.is_full ())
+		{
+			FlushMVCand(workarea, cand);
+		}
 	}
 
 	for ( j = -r+s; j < r; j+=s )
 	{
-		CheckMV(workarea, mvx - r, mvy + j);
-		CheckMV(workarea, mvx + r, mvy + j);
+		cand.push(mvx - r, mvy + j);
+		cand.push(mvx + r, mvy + j);
+		if (cand.is_full ())
+		{
+			FlushMVCand(workarea, cand);
+		}
 	}
+	FlushMVCand(workarea, cand);
 
 	// then corners - they are more far from cenrer
-	CheckMV(workarea, mvx - r, mvy - r);
-	CheckMV(workarea, mvx - r, mvy + r);
-	CheckMV(workarea, mvx + r, mvy - r);
-	CheckMV(workarea, mvx + r, mvy + r);
+	cand.push(mvx - r, mvy - r);
+	cand.push(mvx - r, mvy + r);
+	cand.push(mvx + r, mvy - r);
+	cand.push(mvx + r, mvy + r);
+	FlushMVCand(workarea, cand);
 }
 
 
 
-/* (x-1)%6 */
-static const int mod6m1[8] = {5,0,1,2,3,4,5,0};
-/* radius 2 hexagon. repeated entries are to avoid having to compute mod6 every time. */
-static const int hex2[8][2] = {{-1,-2}, {-2,0}, {-1,2}, {1,2}, {2,0}, {1,-2}, {-1,-2}, {-2,0}};
-
-void PlaneOfBlocks::Hex2Search(WorkingArea &workarea, int i_me_range)
+/* Same result as ExpandingSearch for all the radii from 1 to r, at step 1.
+The SADs of the whole window are computed at once, then the costs, and the
+best vector is picked in the ring order so ties are resolved the same way.
+Requires nPel = 1 and dctmode = 0. */
+void PlaneOfBlocks::ExhaustiveSearch(WorkingArea &workarea, int r, int mvx, int mvy)
 {
-	// adopted from x264
-	int dir = -2;
-	int bmx = workarea.bestMV.x;
-	int bmy = workarea.bestMV.y;
+	// Window clipped to the search boundaries
+	const int x_beg = std::max (mvx - r,     workarea.nDxMin);
+	const int x_end = std::min (mvx + r + 1, workarea.nDxMax);
+	const int y_beg = std::max (mvy - r,     workarea.nDyMin);
+	const int y_end = std::min (mvy + r + 1, workarea.nDyMax);
+	const int nbr_x = x_end - x_beg;
+	const int nbr_y = y_end - y_beg;
+	const int nbr_cand = (2*r + 1) * (2*r + 1) - 1; // center excluded
+	if (nbr_x <= 0 || nbr_y <= 0)
+	{
+		prof_count (workarea, Profiler::CNT_EARLY_EXIT, nbr_cand);
+		return;
+	}
+
+	const bool center_flag = (mvx >= x_beg && mvx < x_end && mvy >= y_beg && mvy < y_end);
+	const int nbr_ok = nbr_x * nbr_y - (center_flag ? 1 : 0);
+	prof_count (workarea, Profiler::CNT_EARLY_EXIT, nbr_cand - nbr_ok);
+	prof_count (workarea, Profiler::CNT_SAD, nbr_ok);
+#ifdef MOTION_DEBUG
+	workarea.iter += nbr_ok;
+#endif
 
-	if (i_me_range > 1)
+	// Chroma window, in chroma pixels
+	const int cx_beg = x_beg >> 1;
+	const int cy_beg = y_beg >> nLogyRatioUV;
+	const int cnbr_x = ((x_end - 1) >> 1) - cx_beg + 1;
+	const int cnbr_y = ((y_end - 1) >> nLogyRatioUV) - cy_beg + 1;
+	const int len = nbr_x * nbr_y;
+	const int clen = (chroma) ? cnbr_x * cnbr_y : 0;
+	if (int (workarea.sad_map.size ()) < len + clen * 2)
 	{
-		/* hexagon */
-//		COST_MV_X3_DIR( -2,0, -1, 2,  1, 2, costs   );
-//		COST_MV_X3_DIR(  2,0,  1,-2, -1,-2, costs+3 );
-//		COPY2_IF_LT( bcost, costs[0], dir, 0 );
-//		COPY2_IF_LT( bcost, costs[1], dir, 1 );
-//		COPY2_IF_LT( bcost, costs[2], dir, 2 );
-//		COPY2_IF_LT( bcost, costs[3], dir, 3 );
+		workarea.sad_map.resize (len + clen * 2);
+	}
+	if (int (workarea.cost_map.size ()) < len)
+	{
+		workarea.cost_map.resize (len);
+	}
+	unsigned int * sad_ptr = &workarea.sad_map [0];
+	int * cost_ptr = &workarea.cost_map [0];
+
+	SADMAP (sad_ptr, nbr_x, workarea.pSrc[0], nSrcPitch[0],
+		GetRefBlock(workarea, x_beg, y_beg), nRefPitch[0], nbr_x, nbr_y);
+
+	if (chroma)
+	{
+		unsigned int * u_ptr = sad_ptr + len;
+		unsigned int * v_ptr = u_ptr + clen;
+		SADCHROMAMAP (u_ptr, cnbr_x, workarea.pSrc[1], nSrcPitch[1],
+			GetRefBlockU(workarea, x_beg, y_beg), nRefPitch[1], cnbr_x, cnbr_y);
+		SADCHROMAMAP (v_ptr, cnbr_x, workarea.pSrc[2], nSrcPitch[2],
+			GetRefBlockV(workarea, x_beg, y_beg), nRefPitch[2], cnbr_x, cnbr_y);
+		for ( int y = 0; y < nbr_y; y++ )
+		{
+			const int cofs = (((y_beg + y) >> nLogyRatioUV) - cy_beg) * cnbr_x - cx_beg;
+			unsigned int * row_ptr = sad_ptr + y * nbr_x;
+			for ( int x = 0; x < nbr_x; x++ )
+			{
+				const int ci = cofs + ((x_beg + x) >> 1);
+				row_ptr[x] += u_ptr[ci] + v_ptr[ci];
+			}
+		}
+	}
+
+	// Costs, same formula as CheckMV
+	const int lambda = workarea.nLambda;
+	const int px = workarea.predictor.x;
+	const int py = workarea.predictor.y;
+	for ( int y = 0; y < nbr_y; y++ )
+	{
+		const unsigned int * sad_row = sad_ptr + y * nbr_x;
+		int * cost_row = cost_ptr + y * nbr_x;
+		const int dy = y_beg + y - py;
+		const int dist_y = dy * dy;
+		for ( int x = 0; x < nbr_x; x++ )
+		{
+			const int dx = x_beg + x - px;
+			const int sad = sad_row[x];
+			cost_row[x] = sad + ((lambda * (dist_y + dx * dx)) >> 8) + ((penaltyNew*sad)>>8);
+		}
+	}
+	if (center_flag)
+	{
+		cost_ptr[(mvy - y_beg) * nbr_x + (mvx - x_beg)] = INT_MAX;
+	}
+
+	int min_cost = workarea.nMinCost;
+	for ( int i = 0; i < len; i++ )
+	{
+		min_cost = std::min (min_cost, cost_ptr[i]);
+	}
+	if (min_cost >= workarea.nMinCost)
+	{
+		return;
+	}
+
+	// The first vector reaching min_cost in the ExpandingSearch order is the
+	// one CheckMV would have kept.
+	const MapWindow win = { cost_ptr, x_beg, x_end, y_beg, y_end, min_cost };
+	int vx = mvx;
+	int vy = mvy;
+	bool found = false;
+	for ( int rr = 1; rr <= r && !found; rr++ )
+	{
+		for ( int i = -rr+1; i < rr && !found; i++ )
+		{
+			found =    MatchMapCost(win, mvx + i, mvy - rr, vx, vy)
+			        || MatchMapCost(win, mvx + i, mvy + rr, vx, vy);
+		}
+		for ( int j = -rr+1; j < rr && !found; j++ )
+		{
+			found =    MatchMapCost(win, mvx - rr, mvy + j, vx, vy)
+			        || MatchMapCost(win, mvx + rr, mvy + j, vx, vy);
+		}
+		found =    found
+		        || MatchMapCost(win, mvx - rr, mvy - rr, vx, vy)
+		        || MatchMapCost(win, mvx - rr, mvy + rr, vx, vy)
+		        || MatchMapCost(win, mvx + rr, mvy - rr, vx, vy)
+		        || MatchMapCost(win, mvx + rr, mvy + rr, vx, vy);
+	}
+	assert (found);
+
+	workarea.bestMV.x = vx;
+	workarea.bestMV.y = vy;
+	workarea.bestMV.sad = sad_ptr[(vy - y_beg) * nbr_x + (vx - x_beg)];
+	workarea.nMinCost = min_cost;
+}
+
+/* if (cx, cy) is in the window and has the searched cost, copies it to (vx, vy) */
+bool PlaneOfBlocks::MatchMapCost(const MapWindow &win, int cx, int cy, int &vx, int &vy)
+{
+	if (   cx >= win.x_beg && cx < win.x_end
+	    && cy >= win.y_beg && cy < win.y_end
+	    && win.cost_ptr[(cy - win.y_beg) * (win.x_end - win.x_beg) + (cx - win.x_beg)] == win.cost)
+	{
+		vx = cx;
+		vy = cy;
+		return true;
+	}
+	return false;
+}
+
+
+
+/* (x-1)%6 */
+static const int mod6m1[8] = {5,0,1,2,3,4,5,0};
+/* radius 2 hexagon. repeated entries are to avoid having to compute mod6 every time. */
+static const int hex2[8][2] = {{-1,-2}, {-2,0}, {-1,2}, {1,2}, {2,0}, {1,-2}, {-1,-2}, {-2,0}};
+
+void PlaneOfBlocks::Hex2Search(WorkingArea &workarea, int i_me_range)
+{
+	// adopted from x264
+	int dir = -2;
+	int bmx = workarea.bestMV.x;
+	int bmy = workarea.bestMV.y;
+
+	if (i_me_range > 1)
+	{
+		/* hexagon */
+//		COST_MV_X3_DIR( -2,0, -1, 2,  1, 2, costs   );
+//		COST_MV_X3_DIR(  2,0,  1,-2, -1,-2, costs+3 );
+//		COPY2_IF_LT( bcost, costs[0], dir, 0 );
+//		COPY2_IF_LT( bcost, costs[1], dir, 1 );
+//		COPY2_IF_LT( bcost, costs[2], dir, 2 );
+//		COPY2_IF_LT( bcost, costs[3], dir, 3 );
 //		COPY2_IF_LT( bcost, costs[4], dir, 4 );
 //		COPY2_IF_LT( bcost, costs[5], dir, 5 );
-		CheckMVdir(workarea, bmx-2, bmy, &dir, 0);
-		CheckMVdir(workarea, bmx-1, bmy+2, &dir, 1);
-		CheckMVdir(workarea, bmx+1, bmy+2, &dir, 2);
-		CheckMVdir(workarea, bmx+2, bmy, &dir, 3);
-		CheckMVdir(workarea, bmx+1, bmy-2, &dir, 4);
-		CheckMVdir(workarea, bmx-1, bmy-2, &dir, 5);
+		MVCandList cand;
+		cand.push(bmx-2, bmy, 0);
+		cand.push(bmx-1, bmy+2, 1);
+		cand.push(bmx+1, bmy+2, 2);
+		cand.push(bmx+2, bmy, 3);
+		cand.push(bmx+1, bmy-2, 4);
+		cand.push(bmx-1, bmy-2, 5);
+		CheckMVMulti(workarea, cand, penaltyNew, &dir, false);
 
 
 		if( dir != -2 )
@@ -1542,9 +1622,11 @@ void PlaneOfBlocks::Hex2Search(WorkingArea &workarea, int i_me_range)
 //				COPY2_IF_LT( bcost, costs[1], dir, odir   );
 //				COPY2_IF_LT( bcost, costs[2], dir, odir+1 );
 
-				CheckMVdir(workarea, bmx + hex2[odir+0][0], bmy + hex2[odir+0][1], &dir, odir-1);
-				CheckMVdir(workarea, bmx + hex2[odir+1][0], bmy + hex2[odir+1][1], &dir, odir);
-				CheckMVdir(workarea, bmx + hex2[odir+2][0], bmy + hex2[odir+2][1], &dir, odir+1);
+				cand.clear ();
+				cand.push(bmx + hex2[odir+0][0], bmy + hex2[odir+0][1], odir-1);
+				cand.push(bmx + hex2[odir+1][0], bmy + hex2[odir+1][1], odir);
+				cand.push(bmx + hex2[odir+2][0], bmy + hex2[odir+2][1], odir+1);
+				CheckMVMulti(workarea, cand, penaltyNew, &dir, false);
 				if( dir == -2 )
 				{
 					break;
@@ -1570,17 +1652,27 @@ void PlaneOfBlocks::Hex2Search(WorkingArea &workarea, int i_me_range)
 void PlaneOfBlocks::CrossSearch(WorkingArea &workarea, int start, int x_max, int y_max, int mvx, int mvy)
 {
 	// part of umh  search
+	MVCandList cand;
 	for ( int i = start; i < x_max; i+=2 )
 	{
-		CheckMV(workarea, mvx - i, mvy);
-		CheckMV(workarea, mvx + i, mvy);
+		cand.push(mvx - i, mvy);
+		cand.push(mvx + i, mvy);
+		if (cand.is_full ())
+		{
+			FlushMVCand(workarea, cand);
+		}
 	}
 
 	for ( int j = start; j < y_max; j+=2 )
 	{
-		CheckMV(workarea, mvx, mvy + j);
-		CheckMV(workarea, mvx, mvy + j);
+		cand.push(mvx, mvy + j);
+		cand.push(mvx, mvy + j);
+		if (cand.is_full ())
+		{
+			FlushMVCand(workarea, cand);
+		}
 	}
+	FlushMVCand(workarea, cand);
 }
 
 
@@ -1605,12 +1697,18 @@ void PlaneOfBlocks::UMHSearch(WorkingArea &workarea, int i_me_range, int omx, in
 			{-2,-3}, { 0,-4}, { 2,-3},
 		};
 
+		MVCandList cand;
 		for( int j = 0; j < 16; j++ )
 		{
 			int mx = omx + hex4[j][0]*i;
 			int my = omy + hex4[j][1]*i;
-			CheckMV( workarea, mx, my );
+			cand.push(mx, my);
+			if (cand.is_full ())
+			{
+				FlushMVCand(workarea, cand);
+			}
 		}
+		FlushMVCand(workarea, cand);
 	}
 	while( ++i <= i_me_range/4 );
 
@@ -1634,124 +1732,91 @@ void PlaneOfBlocks::UMHSearch(WorkingArea &workarea, int i_me_range, int omx, in
 //
 // use very simple but robust method
 // more advanced method (like MVDepan) can be implemented later
-void PlaneOfBlocks::EstimateGlobalMVDoubled(VECTOR *globalMVec, Slicer &slicer)
+void PlaneOfBlocks::EstimateGlobalMVDoubled(VECTOR *globalMVec)
 {
 	assert (globalMVec != 0);
-	assert (&slicer != 0);
 
-	_gvect_result_count = 2;
-	_gvect_estim_ptr    = globalMVec;
+	// half must be more than max vector length, which is (framewidth + Padding) * nPel
+	const int      freqSize = 8192 * nPel * 2;
 
-	slicer.start (2, *this, &PlaneOfBlocks::estimate_global_mv_doubled_slice);
-}
+	int            nbr_parts = 1;
+	if (_mt_flag)
+	{
+		nbr_parts = AvstpWrapper::use_instance ().get_nbr_threads ();
+		nbr_parts = std::min (nbr_parts, int (MAX_GMV_PARTS));
+		nbr_parts = std::min (nbr_parts, nBlkCount / MIN_GMV_PART_BLOCKS);
+		nbr_parts = std::max (nbr_parts, 1);
+	}
+	_gmv_nbr_parts = nbr_parts;
+	if (int (_gmv_part_arr.size ()) < nbr_parts)
+	{
+		_gmv_part_arr.resize (nbr_parts);
+	}
 
+	Slicer         slicer (_mt_flag);
 
+	// Partial histograms
+	slicer.start (nbr_parts, *this, &PlaneOfBlocks::estimate_global_mv_hist_slice);
+	slicer.wait ();
 
-void	PlaneOfBlocks::estimate_global_mv_doubled_slice (Slicer::TaskData &td)
-{
-	bool				both_done_flag = false;
-	for (int y = td._y_beg; y < td._y_end; ++y)
+	// find most frequent x and y. The partial histograms are cleared for the
+	// next call at the same time.
+	for (int c = 0; c < 2; ++c)
 	{
-		std::vector <int> &	freq_arr = freqArray [y];
-
-		const int      freqSize = int (freq_arr.size ());
-		memset(&freq_arr[0], 0, freqSize*sizeof(freq_arr[0])); // reset
-
 		int            indmin = freqSize-1;
 		int            indmax = 0;
-
-		// find most frequent x
-		if (y == 0)
+		for (int p = 0; p < nbr_parts; ++p)
 		{
-			for (int i=0; i<nBlkCount; i++)
-			{
-				int ind = (freqSize>>1)+vectors[i].x;
-				if (ind>=0 && ind<freqSize)
-				{
-					++ freq_arr [ind];
-					if (ind > indmax)
-					{
-						indmax = ind;
-					}
-					if (ind < indmin)
-					{
-						indmin = ind;
-					}
-				}
-			}
-		}
-
-		// find most frequent y
-		else
-		{
-			for (int i=0; i<nBlkCount; i++)
-			{
-				int ind = (freqSize>>1)+vectors[i].y;
-				if (ind>=0 && ind<freqSize)
-				{
-					++ freq_arr [ind];
-					if (ind > indmax)
-					{
-						indmax = ind;
-					}
-					if (ind < indmin)
-					{
-						indmin = ind;
-					}
-				}
-			}	// i < nBlkCount
+			indmin = std::min (indmin, _gmv_part_arr [p].ind_min [c]);
+			indmax = std::max (indmax, _gmv_part_arr [p].ind_max [c]);
 		}
 
-		int count = freq_arr[indmin];
+		int count = -1;
 		int index = indmin;
-		for (int i=indmin+1; i<=indmax; i++)
+		for (int i=indmin; i<=indmax; i++)
 		{
-			if (freq_arr[i] > count)
+			int freq = 0;
+			for (int p = 0; p < nbr_parts; ++p)
 			{
-				count = freq_arr[i];
+				int &          f = _gmv_part_arr [p].freq_arr [c] [i];
+				freq += f;
+				f = 0;
+			}
+			if (freq > count)
+			{
+				count = freq;
 				index = i;
 			}
 		}
 
 		// most frequent value
-		_gvect_estim_ptr->coord [y] = index - (freqSize >> 1);
-
-		conc::AioSub <int>   dec_ftor (1);
-		const int            new_count = 
-			conc::AtomicIntOp::exec_new (_gvect_result_count, dec_ftor);
-		both_done_flag = (new_count <= 0);
+		_gmv_median.coord [c] = index - (freqSize >> 1);
 	}
 
 	// iteration to increase precision
-	if (both_done_flag)
+	slicer.start (nbr_parts, *this, &PlaneOfBlocks::estimate_global_mv_mean_slice);
+	slicer.wait ();
+
+	int meanvx = 0;
+	int meanvy = 0;
+	int num = 0;
+	for (int p = 0; p < nbr_parts; ++p)
 	{
-		int medianx = _gvect_estim_ptr->x;
-		int mediany = _gvect_estim_ptr->y;
-		int meanvx = 0;
-		int meanvy = 0;
-		int num = 0;
-		for ( int i=0; i < nBlkCount; i++ )
-		{
-			if (   abs (vectors[i].x - medianx) < 6
-			    && abs (vectors[i].y - mediany) < 6)
-			{
-				meanvx += vectors[i].x;
-				meanvy += vectors[i].y;
-				num += 1;
-			}
-		}
+		meanvx += _gmv_part_arr [p].sum [0];
+		meanvy += _gmv_part_arr [p].sum [1];
+		num    += _gmv_part_arr [p].num;
+	}
 
-		// output vectors must be doubled for next (finer) scale level
-		if (num >0)
-		{
-			_gvect_estim_ptr->x = 2*meanvx / num;
-			_gvect_estim_ptr->y = 2*meanvy / num;
-		}
-		else
-		{
-			_gvect_estim_ptr->x = 2*medianx;
-			_gvect_estim_ptr->y = 2*mediany;
-		}
+	// output vectors must be doubled for next (finer) scale level
+	if (num >0)
+	{
+		globalMVec->x = 2*meanvx / num;
+		globalMVec->y = 2*meanvy / num;
+	}
+	else
+	{
+		globalMVec->x = 2*_gmv_median.x;
+		globalMVec->y = 2*_gmv_median.y;
 	}
 
 //	char debugbuf[100];
@@ -1892,6 +1957,7 @@ int	PlaneOfBlocks::LumaSAD (WorkingArea &workarea, const unsigned char *pRef0)
 #ifdef MOTION_DEBUG
 	workarea.iter++;
 #endif
+	prof_count (workarea, Profiler::CNT_SAD, 1);
 #ifdef ALLOW_DCT
 	// made simple SAD more prominent (~1% faster) while keeping DCT support (TSchniede)
 	return !dctmode ? SAD(workarea.pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0]) : LumaSADx(workarea, pRef0);
@@ -1901,31 +1967,79 @@ int	PlaneOfBlocks::LumaSAD (WorkingArea &workarea, const unsigned char *pRef0)
 }
 
 
+/* same as LumaSAD, but may stop as soon as the SAD reaches bound, returning
+a value >= bound in this case. */
+int	PlaneOfBlocks::LumaSADThr (WorkingArea &workarea, const unsigned char *pRef0, int bound)
+{
+	if (dctmode != 0 || SADTHR == 0)
+	{
+		return LumaSAD(workarea, pRef0);
+	}
+#ifdef MOTION_DEBUG
+	workarea.iter++;
+#endif
+	prof_count (workarea, Profiler::CNT_SAD, 1);
+	return SADTHR(workarea.pSrc[0], nSrcPitch[0], pRef0, nRefPitch[0], bound);
+}
+
+/* evaluates a valid vector and keeps it if it is better than the best one.
+The cost is sad + MotionDistorsion + ((pnew*sad)>>8). The luma SAD is
+computed first and stops as soon as the cost cannot be lower than nMinCost.
+Chroma is skipped in this case. */
+void	PlaneOfBlocks::CheckMVThr(WorkingArea &workarea, int vx, int vy, int pnew, int *dir, int val, bool move_flag)
+{
+	const int dist = workarea.MotionDistorsion(vx, vy);
+	// cost >= sad + dist only holds for a positive penalty
+	const int bound = (pnew >= 0) ? workarea.nMinCost - dist : INT_MAX;
+	if (bound <= 0)
+	{
+		return;
+	}
+
+	int sad = LumaSADThr(workarea, GetRefBlock(workarea, vx, vy), bound);
+	if (sad >= bound)
+	{
+		return;
+	}
+	if (chroma)
+	{
+		sad += SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
+		     + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]);
+	}
+
+	const int cost = sad + dist + ((pnew*sad)>>8);
+	if ( cost  < workarea.nMinCost )
+	{
+		if (move_flag)
+		{
+			workarea.bestMV.x = vx;
+			workarea.bestMV.y = vy;
+		}
+		workarea.bestMV.sad = sad;
+		workarea.nMinCost = cost;
+		if (dir != 0)
+		{
+			*dir = val;
+		}
+	}
+}
+
 /* check if the vector (vx, vy) is better than the best vector found so far without penalty new - renamed in v.2.11*/
 void	PlaneOfBlocks::CheckMV0(WorkingArea &workarea, int vx, int vy)
 {		//here the chance for default values are high especially for zeroMVfieldShifted (on left/top border)
 	if (
 #ifdef ONLY_CHECK_NONDEFAULT_MV
-	(( vx != 0 ) || ( vy != zeroMVfieldShifted.y )) &&
-		 (( vx != workarea.predictor.x ) || ( vy != workarea.predictor.y )) &&
-		 (( vx != workarea.globalMVPredictor.x ) || ( vy != workarea.globalMVPredictor.y )) &&
+		(( vx != 0 ) || ( vy != zeroMVfieldShifted.y )) &&
+		(( vx != workarea.predictor.x ) || ( vy != workarea.predictor.y )) &&
+		(( vx != workarea.globalMVPredictor.x ) || ( vy != workarea.globalMVPredictor.y )) &&
 #endif
-		 workarea.IsVectorOK(vx, vy) )
-	{
-		int saduv = (chroma) ? SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-         + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]) : 0;
-		int sad = LumaSAD(workarea, GetRefBlock(workarea, vx, vy));
-         sad += saduv;
-		int cost = sad + workarea.MotionDistorsion (vx, vy);
-//		int cost = sad + sad*workarea.MotionDistorsion(vx, vy)/(nBlkSizeX*nBlkSizeY*4);
-//		if (sad>bigSAD) { DebugPrintf("%d %d %d %d %d %d", workarea.blkIdx, vx, vy, workarea.nMinCost, cost, sad);}
-		if ( cost  < workarea.nMinCost )
-		{
-			workarea.bestMV.x = vx;
-			workarea.bestMV.y = vy;
-			workarea.nMinCost = cost;
-			workarea.bestMV.sad = sad;
-		}
+		workarea.IsVectorOK(vx, vy) )
+	{
+		CheckMVThr(workarea, vx, vy, 0, 0, 0, true);
+	}
+	else
+	{
+		prof_count (workarea, Profiler::CNT_EARLY_EXIT, 1);
 	}
 }
 
@@ -1934,28 +2048,17 @@ void	PlaneOfBlocks::CheckMV(WorkingArea &workarea, int vx, int vy)
 {		//here the chance for default values are high especially for zeroMVfieldShifted (on left/top border)
 	if (
 #ifdef ONLY_CHECK_NONDEFAULT_MV
-		 (( vx != 0 ) || ( vy != zeroMVfieldShifted.y )) &&
-		 (( vx != workarea.predictor.x ) || ( vy != workarea.predictor.y )) &&
-		 (( vx != workarea.globalMVPredictor.x ) || ( vy != workarea.globalMVPredictor.y )) &&
+		(( vx != 0 ) || ( vy != zeroMVfieldShifted.y )) &&
+		(( vx != workarea.predictor.x ) || ( vy != workarea.predictor.y )) &&
+		(( vx != workarea.globalMVPredictor.x ) || ( vy != workarea.globalMVPredictor.y )) &&
 #endif
-		 workarea.IsVectorOK(vx, vy) )
-	{
-		int saduv =
-		!(chroma) ? 0:
-		SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-         + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]);
-		int sad = LumaSAD(workarea, GetRefBlock(workarea, vx, vy));
-         sad += saduv;
-		int cost = sad + workarea.MotionDistorsion(vx, vy)+ ((penaltyNew*sad)>>8); //v2
-//		int cost = sad + sad*workarea.MotionDistorsion(vx, vy)/(nBlkSizeX*nBlkSizeY*4);
-//		if (sad>bigSAD) { DebugPrintf("%d %d %d %d %d %d", workarea.blkIdx, vx, vy, workarea.nMinCost, cost, sad);}
-		if ( cost  < workarea.nMinCost )
-		{
-			workarea.bestMV.x = vx;
-			workarea.bestMV.y = vy;
-			workarea.nMinCost = cost;
-			workarea.bestMV.sad = sad;
-		}
+		workarea.IsVectorOK(vx, vy) )
+	{
+		CheckMVThr(workarea, vx, vy, penaltyNew, 0, 0, true); //v2
+	}
+	else
+	{
+		prof_count (workarea, Profiler::CNT_EARLY_EXIT, 1);
 	}
 }
 
@@ -1970,23 +2073,11 @@ void	PlaneOfBlocks::CheckMV2(WorkingArea &workarea, int vx, int vy, int *dir, in
 #endif
 		workarea.IsVectorOK(vx, vy) )
 	{
-		int saduv =
-		!(chroma) ? 0:
-		SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-         + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]);
-		int sad = LumaSAD(workarea, GetRefBlock(workarea, vx, vy));
-		sad += saduv;
-		int cost = sad + workarea.MotionDistorsion(vx, vy) + ((penaltyNew*sad)>>8); // v1.5.8
-//		if (sad > LSAD/4) DebugPrintf("%d %d %d %d %d %d %d", workarea.blkIdx, vx, vy, val, workarea.nMinCost, cost, sad);
-//		int cost = sad + sad*workarea.MotionDistorsion(vx, vy)/(nBlkSizeX*nBlkSizeY*4) + ((penaltyNew*sad)>>8); // v1.5.8
-		if ( cost  < workarea.nMinCost )
-		{
-			workarea.bestMV.x = vx;
-			workarea.bestMV.y = vy;
-			workarea.bestMV.sad = sad;
-			workarea.nMinCost = cost;
-			*dir = val;
-		}
+		CheckMVThr(workarea, vx, vy, penaltyNew, dir, val, true); // v1.5.8
+	}
+	else
+	{
+		prof_count (workarea, Profiler::CNT_EARLY_EXIT, 1);
 	}
 }
 
@@ -2001,22 +2092,133 @@ void	PlaneOfBlocks::CheckMVdir(WorkingArea &workarea, int vx, int vy, int *dir,
 #endif
 		workarea.IsVectorOK(vx, vy) )
 	{
-		int saduv = (chroma) ? SADCHROMA(workarea.pSrc[1], nSrcPitch[1], GetRefBlockU(workarea, vx, vy), nRefPitch[1])
-         + SADCHROMA(workarea.pSrc[2], nSrcPitch[2], GetRefBlockV(workarea, vx, vy), nRefPitch[2]) : 0;
-		int sad = LumaSAD(workarea, GetRefBlock(workarea, vx, vy));
-		sad += saduv;
-		int cost = sad + workarea.MotionDistorsion(vx, vy) + ((penaltyNew*sad)>>8); // v1.5.8
-//		if (sad > LSAD/4) DebugPrintf("%d %d %d %d %d %d %d", workarea.blkIdx, vx, vy, val, workarea.nMinCost, cost, sad);
-//		int cost = sad + sad*workarea.MotionDistorsion(vx, vy)/(nBlkSizeX*nBlkSizeY*4) + ((penaltyNew*sad)>>8); // v1.5.8
+		CheckMVThr(workarea, vx, vy, penaltyNew, dir, val, false); // v1.5.8
+	}
+	else
+	{
+		prof_count (workarea, Profiler::CNT_EARLY_EXIT, 1);
+	}
+}
+
+/* check a list of vectors at once. The result is the same as calling, in the
+list order, CheckMV (pnew = penaltyNew, no dir), CheckMV0 (pnew = 0),
+CheckMV2 (dir, move_flag) or CheckMVdir (dir, ! move_flag). For small
+blocks, the SADs of all the candidates are computed by a single batched call,
+for large blocks they are computed one by one with early termination. */
+void	PlaneOfBlocks::CheckMVMulti(WorkingArea &workarea, MVCandList &cand, int pnew, int *dir, bool move_flag)
+{
+	assert (cand.nbr <= SAD_MULTI_MAX);
+
+	int idx_arr [SAD_MULTI_MAX];
+	const uint8_t * ref_arr [SAD_MULTI_MAX];
+	int nbr_ok = 0;
+	for (int i = 0; i < cand.nbr; i++)
+	{
+		const int vx = cand.vx [i];
+		const int vy = cand.vy [i];
+		if (
+#ifdef ONLY_CHECK_NONDEFAULT_MV
+			(( vx != 0 ) || ( vy != zeroMVfieldShifted.y )) &&
+			(( vx != workarea.predictor.x ) || ( vy != workarea.predictor.y )) &&
+			(( vx != workarea.globalMVPredictor.x ) || ( vy != workarea.globalMVPredictor.y )) &&
+#endif
+			workarea.IsVectorOK(vx, vy) )
+		{
+			idx_arr [nbr_ok] = i;
+			ref_arr [nbr_ok] = GetRefBlock(workarea, vx, vy);
+			++ nbr_ok;
+		}
+	}
+	prof_count (workarea, Profiler::CNT_EARLY_EXIT, cand.nbr - nbr_ok);
+	if (nbr_ok == 0)
+	{
+		return;
+	}
+
+	// Large blocks: early termination saves more than batching
+	if (_sad_thr_flag)
+	{
+		for (int k = 0; k < nbr_ok; k++)
+		{
+			const int i = idx_arr [k];
+			CheckMVThr(workarea, cand.vx [i], cand.vy [i], pnew, dir, cand.val [i], move_flag);
+		}
+		return;
+	}
+
+	unsigned int sad_arr [SAD_MULTI_MAX];
+#ifdef ALLOW_DCT
+	if (dctmode != 0)
+	{
+		for (int k = 0; k < nbr_ok; k++)
+		{
+			sad_arr [k] = LumaSAD(workarea, ref_arr [k]);
+		}
+	}
+	else
+#endif	// ALLOW_DCT
+	{
+#ifdef MOTION_DEBUG
+		workarea.iter += nbr_ok;
+#endif
+		prof_count (workarea, Profiler::CNT_SAD, nbr_ok);
+		SADMULTI (sad_arr, workarea.pSrc[0], nSrcPitch[0], ref_arr, nRefPitch[0], nbr_ok);
+	}
+
+	if (chroma)
+	{
+		unsigned int saduv_arr [SAD_MULTI_MAX];
+		for (int k = 0; k < nbr_ok; k++)
+		{
+			ref_arr [k] = GetRefBlockU(workarea, cand.vx [idx_arr [k]], cand.vy [idx_arr [k]]);
+		}
+		SADCHROMAMULTI (saduv_arr, workarea.pSrc[1], nSrcPitch[1], ref_arr, nRefPitch[1], nbr_ok);
+		for (int k = 0; k < nbr_ok; k++)
+		{
+			sad_arr [k] += saduv_arr [k];
+			ref_arr [k] = GetRefBlockV(workarea, cand.vx [idx_arr [k]], cand.vy [idx_arr [k]]);
+		}
+		SADCHROMAMULTI (saduv_arr, workarea.pSrc[2], nSrcPitch[2], ref_arr, nRefPitch[2], nbr_ok);
+		for (int k = 0; k < nbr_ok; k++)
+		{
+			sad_arr [k] += saduv_arr [k];
+		}
+	}
+
+	for (int k = 0; k < nbr_ok; k++)
+	{
+		const int i = idx_arr [k];
+		const int vx = cand.vx [i];
+		const int vy = cand.vy [i];
+		int sad = sad_arr [k];
+		int cost = sad + workarea.MotionDistorsion(vx, vy) + ((pnew*sad)>>8);
 		if ( cost  < workarea.nMinCost )
 		{
+			if (move_flag)
+			{
+				workarea.bestMV.x = vx;
+				workarea.bestMV.y = vy;
+			}
 			workarea.bestMV.sad = sad;
 			workarea.nMinCost = cost;
-			*dir = val;
+			if (dir != 0)
+			{
+				*dir = cand.val [i];
+			}
 		}
 	}
 }
 
+/* evaluates the pending candidates as CheckMV would, and empties the list */
+void	PlaneOfBlocks::FlushMVCand(WorkingArea &workarea, MVCandList &cand)
+{
+	if (cand.nbr > 0)
+	{
+		CheckMVMulti(workarea, cand, penaltyNew, 0, true);
+		cand.clear ();
+	}
+}
+
 /* clip a vector to the horizontal boundaries */
 int	PlaneOfBlocks::ClipMVx(WorkingArea &workarea, int vx)
 {
@@ -2061,110 +2263,358 @@ int	PlaneOfBlocks::Median(int a, int b, int c)
 		else if ( b < c ) return c;
 		else return b;
 	}
-}
+}
+
+/* computes square distance between two vectors */
+unsigned int	PlaneOfBlocks::SquareDifferenceNorm(const VECTOR& v1, const VECTOR& v2)
+{
+	return (v1.x - v2.x) * (v1.x - v2.x) + (v1.y - v2.y) * (v1.y - v2.y);
+}
+
+/* computes square distance between two vectors */
+unsigned int	PlaneOfBlocks::SquareDifferenceNorm(const VECTOR& v1, const int v2x, const int v2y)
+{
+	return (v1.x - v2x) * (v1.x - v2x) + (v1.y - v2y) * (v1.y - v2y);
+}
+
+/* check if an index is inside the block's min and max indexes */
+bool	PlaneOfBlocks::IsInFrame(int i)
+{
+	return (( i >= 0 ) && ( i < nBlkCount ));
+}
+
+
+
+void	PlaneOfBlocks::set_src_frame (MVFrame *_pSrcFrame)
+{
+	pSrcFrame = _pSrcFrame;
+
+#if (ALIGN_SOURCEBLOCK > 1)
+	nSrcPitch_plane[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
+	if (chroma)
+	{
+		nSrcPitch_plane[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
+		nSrcPitch_plane[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
+	}
+	nSrcPitch[0] = nBlkSizeX;
+	nSrcPitch[1] = nBlkSizeX/2;
+	nSrcPitch[2] = nBlkSizeX/2;
+#else	// ALIGN_SOURCEBLOCK
+	nSrcPitch[0] = pSrcFrame->GetPlane(YPLANE)->GetPitch();
+	if (chroma)
+	{
+		nSrcPitch[1] = pSrcFrame->GetPlane(UPLANE)->GetPitch();
+		nSrcPitch[2] = pSrcFrame->GetPlane(VPLANE)->GetPitch();
+	}
+#endif	// ALIGN_SOURCEBLOCK
+}
+
+
+
+void	PlaneOfBlocks::prepare_src_cache_slice (Slicer::TaskData &td)
+{
+	assert (&td != 0);
+
+	DCTClass *		dct_ptr = 0;
+#ifdef ALLOW_DCT
+	if (! _src_cache_dct.empty ())
+	{
+		dct_ptr = _dct_pool_ptr->take_obj ();
+		assert (dct_ptr != 0);
+	}
+#endif	// ALLOW_DCT
+	const int		dct_size = nBlkSizeY * dctpitch;
+
+	const MVPlane &	plane_y = *(pSrcFrame->GetPlane(YPLANE));
+	const int		step_x   = nBlkSizeX - nOverlapX;
+	const int		step_y   = nBlkSizeY - nOverlapY;
+	const int		step_xuv = step_x / 2;
+	const int		step_yuv = step_y >> nLogyRatioUV;
+
+	for (int blky = td._y_beg; blky < td._y_end; ++blky)
+	{
+		for (int blkx = 0; blkx < nBlkX; ++blkx)
+		{
+			const int		blkIdx = blky * nBlkX + blkx;
+			const uint8_t *	pSrcY  = plane_y.GetAbsolutePelPointer(
+				plane_y.GetHPadding() + blkx * step_x,
+				plane_y.GetVPadding() + blky * step_y
+			);
+
+#if (ALIGN_SOURCEBLOCK > 1)
+			uint8_t *		pBlk = &_src_cache_blk [blkIdx * _src_cache_blk_size];
+			BLITLUMA (pBlk + _src_cache_ofs [0], nSrcPitch[0], pSrcY, nSrcPitch_plane[0]);
+			if (chroma)
+			{
+				for (int p = 1; p < 3; ++p)
+				{
+					const MVPlane &	plane_uv =
+						*(pSrcFrame->GetPlane((p == 1) ? UPLANE : VPLANE));
+					const uint8_t *	pSrcUV = plane_uv.GetAbsolutePelPointer(
+						plane_uv.GetHPadding() + blkx * step_xuv,
+						plane_uv.GetVPadding() + blky * step_yuv
+					);
+					BLITCHROMA (pBlk + _src_cache_ofs [p], nSrcPitch[p], pSrcUV, nSrcPitch_plane[p]);
+				}
+			}
+			pSrcY = pBlk + _src_cache_ofs [0];
+#endif	// ALIGN_SOURCEBLOCK
+
+			if (dct_ptr != 0)
+			{
+				dct_ptr->DCTBytes2D(pSrcY, nSrcPitch[0], &_src_cache_dct [blkIdx * dct_size], dctpitch);
+			}
+			_src_cache_luma [blkIdx] = LUMA(pSrcY, nSrcPitch[0]);
+		}
+	}
+
+#ifdef ALLOW_DCT
+	if (dct_ptr != 0)
+	{
+		_dct_pool_ptr->return_obj (*dct_ptr);
+	}
+#endif	// ALLOW_DCT
+}
+
+
+
+// Returns the number of chunks per row for the search. It only depends on
+// the plane width. Chunks smaller than WAVEFRONT_CHUNK_W blocks are not
+// worth the scheduling cost, and a row runs two chunks behind the previous
+// one, so we need many chunks to keep the threads busy.
+int	PlaneOfBlocks::compute_nbr_chunks () const
+{
+	return (std::max (nBlkX / WAVEFRONT_CHUNK_W, 1));
+}
+
+
+
+// The number of bad blocks refined before a given block is counted over the
+// chunks the current one depends on (directly or not): on the row k steps
+// above, the chunks up to chunk + k, and on the current row, the chunks on
+// the left. The blocks of the upper rows located farther on the right are not
+// counted, because they may not be processed yet in the wavefront. The
+// count depends on the chunking, but not on the processing order.
+void	PlaneOfBlocks::init_badcount (WorkingArea &workarea, int chunk) const
+{
+	assert (&workarea != 0);
+	assert (chunk >= 0);
+	assert (chunk < _badcount_nbr_chunks);
+
+	const int		nbr_chunks = _badcount_nbr_chunks;
+	const int		row        = workarea.blky;
+
+	int				count = 0;
+	for (int row_above = 0; row_above < row; ++row_above)
+	{
+		const int		chunk_end =
+			std::min (chunk + (row - row_above) + 1, nbr_chunks);
+		const int *		cnt_ptr = &_badcount_arr [row_above * nbr_chunks];
+		for (int c = 0; c < chunk_end; ++c)
+		{
+			count += cnt_ptr [c];
+		}
+	}
+	const int *		cnt_ptr = &_badcount_arr [row * nbr_chunks];
+	for (int c = 0; c < chunk; ++c)
+	{
+		count += cnt_ptr [c];
+	}
+
+	workarea.badcount_base = count;
+	workarea.badcount_idx  = row * nbr_chunks + chunk;
+}
+
+
+
+// Processes all the chunks in index order, in the calling thread.
+void	PlaneOfBlocks::search_mv_sequential ()
+{
+	WorkingArea &	workarea = *(_workarea_pool.take_obj ());
+	assert (&workarea != 0);
+	prof_begin_task (workarea);
+
+	workarea.blky_beg = 0;
+	workarea.blky_end = nBlkY;
+
+	workarea.DCT = 0;
+#ifdef ALLOW_DCT
+	if (_dct_pool_ptr != 0)
+	{
+		workarea.DCT = _dct_pool_ptr->take_obj ();
+	}
+#endif	// ALLOW_DCT
+
+	workarea.planeSAD      = 0;
+	workarea.sumLumaChange = 0;
+
+	// Functions using float must not be used here
+
+	const int		last_node = _wavefront_graph.get_last_node ();
+	for (int task_index = 0; task_index <= last_node; ++task_index)
+	{
+		search_mv_chunk (workarea, task_index);
+	}
+
+	planeSAD      += workarea.planeSAD;
+	sumLumaChange += workarea.sumLumaChange;
+
+	if (isse)
+	{
+		_mm_empty ();
+	}
+
+#ifdef ALLOW_DCT
+	if (_dct_pool_ptr != 0)
+	{
+		_dct_pool_ptr->return_obj (*(workarea.DCT));
+		workarea.DCT = 0;
+	}
+#endif
+
+	prof_end_task (workarea);
+	_workarea_pool.return_obj (workarea);
+}
+
+
+
+// Processes a chunk of a row. The whole plane is seen as a single slice, so
+// the predictors and the lambda are the same as in a sequential scan.
+void	PlaneOfBlocks::search_mv_wavefront (SchedWavefront::TaskData &td)
+{
+	assert (&td != 0);
+
+	WorkingArea &	workarea = *(_workarea_pool.take_obj ());
+	assert (&workarea != 0);
+	prof_begin_task (workarea);
+
+	workarea.blky_beg = 0;
+	workarea.blky_end = nBlkY;
+
+	workarea.DCT = 0;
+#ifdef ALLOW_DCT
+	if (_dct_pool_ptr != 0)
+	{
+		workarea.DCT = _dct_pool_ptr->take_obj ();
+	}
+#endif	// ALLOW_DCT
+
+	workarea.planeSAD      = 0;
+	workarea.sumLumaChange = 0;
+
+	// Functions using float must not be used here
+
+	search_mv_chunk (workarea, td._task_index);
+
+	planeSAD      += workarea.planeSAD;
+	sumLumaChange += workarea.sumLumaChange;
+
+	if (isse)
+	{
+		_mm_empty ();
+	}
+
+#ifdef ALLOW_DCT
+	if (_dct_pool_ptr != 0)
+	{
+		_dct_pool_ptr->return_obj (*(workarea.DCT));
+		workarea.DCT = 0;
+	}
+#endif
 
-/* computes square distance between two vectors */
-unsigned int	PlaneOfBlocks::SquareDifferenceNorm(const VECTOR& v1, const VECTOR& v2)
-{
-	return (v1.x - v2.x) * (v1.x - v2.x) + (v1.y - v2.y) * (v1.y - v2.y);
+	prof_end_task (workarea);
+	_workarea_pool.return_obj (workarea);
 }
 
-/* computes square distance between two vectors */
-unsigned int	PlaneOfBlocks::SquareDifferenceNorm(const VECTOR& v1, const int v2x, const int v2y)
-{
-	return (v1.x - v2x) * (v1.x - v2x) + (v1.y - v2y) * (v1.y - v2y);
-}
 
-/* check if an index is inside the block's min and max indexes */
-bool	PlaneOfBlocks::IsInFrame(int i)
+
+void	PlaneOfBlocks::search_mv_chunk (WorkingArea &workarea, int task_index)
 {
-	return (( i >= 0 ) && ( i < nBlkCount ));
+	assert (&workarea != 0);
+	assert (task_index >= 0);
+	assert (task_index <= _wavefront_graph.get_last_node ());
+
+	int				blkx_beg;
+	int				blkx_end;
+	_wavefront_graph.get_col_range (task_index, blkx_beg, blkx_end);
+	workarea.blky = _wavefront_graph.get_row (task_index);
+	init_badcount (
+		workarea,
+		task_index - workarea.blky * _wavefront_graph.get_nbr_chunks ()
+	);
+
+	search_mv_row (workarea, blkx_beg, blkx_end);
 }
 
 
 
-void	PlaneOfBlocks::search_mv_slice (Slicer::TaskData &td)
+// Searches the blocks [blkx_beg ; blkx_end[ of the row workarea.blky, in the
+// scan direction of the row. In meander mode, the scan is reversed inside the
+// range, so the blocks of the odd rows are scanned from right to left chunk
+// by chunk.
+void	PlaneOfBlocks::search_mv_row (WorkingArea &workarea, int blkx_beg, int blkx_end)
 {
-	assert (&td != 0);
-
-	short *			outfilebuf = _outfilebuf;
-
-	WorkingArea &	workarea = *(_workarea_pool.take_obj ());
 	assert (&workarea != 0);
+	assert (blkx_beg >= 0);
+	assert (blkx_beg < blkx_end);
+	assert (blkx_end <= nBlkX);
 
-	workarea.blky_beg = td._y_beg;
-	workarea.blky_end = td._y_end;
-
-	workarea.DCT = 0;
-#ifdef ALLOW_DCT
-	if (_dct_pool_ptr != 0)
-	{
-		workarea.DCT = _dct_pool_ptr->take_obj ();
-	}
-#endif	// ALLOW_DCT
-
-	int *pBlkData = _out + 1 + workarea.blky_beg * nBlkX*N_PER_BLOCK;
+	int *pBlkData = _out + 1 + workarea.blky * nBlkX*N_PER_BLOCK;
+	short *outfilebuf = _outfilebuf;
 	if (outfilebuf != NULL)
 	{
-		outfilebuf += workarea.blky_beg * nBlkX*4;// 4 short word per block
+		outfilebuf += workarea.blky * nBlkX*4;// 4 short word per block
 	}
 
 	workarea.y[0] = pSrcFrame->GetPlane(YPLANE)->GetVPadding();
-	workarea.y[0] += workarea.blky_beg * (nBlkSizeY - nOverlapY);
+	workarea.y[0] += workarea.blky * (nBlkSizeY - nOverlapY);
 
 	if (pSrcFrame->GetMode() & UPLANE)
 	{
 		workarea.y[1] = pSrcFrame->GetPlane(UPLANE)->GetVPadding();
-		workarea.y[1] += workarea.blky_beg * ((nBlkSizeY - nOverlapY) >> nLogyRatioUV);
+		workarea.y[1] += workarea.blky * ((nBlkSizeY - nOverlapY) >> nLogyRatioUV);
 	}
 	if (pSrcFrame->GetMode() & VPLANE)
 	{
 		workarea.y[2] = pSrcFrame->GetPlane(VPLANE)->GetVPadding();
-		workarea.y[2] += workarea.blky_beg * ((nBlkSizeY - nOverlapY) >> nLogyRatioUV);
+		workarea.y[2] += workarea.blky * ((nBlkSizeY - nOverlapY) >> nLogyRatioUV);
 	}
 
-	workarea.planeSAD      = 0;
-	workarea.sumLumaChange = 0;
-
-	// Functions using float must not be used here
+	// meander (alternate) scan blocks (even row left to right, odd row right to left)
+	workarea.blkScanDir = (workarea.blky%2 == 0 || ! _meander_flag) ? 1 : -1;
+	const int		blkxStart = (workarea.blkScanDir == 1) ? blkx_beg : blkx_end-1;
+	const int		nbr_blk   = blkx_end - blkx_beg;
 
-	for (workarea.blky = workarea.blky_beg; workarea.blky < workarea.blky_end; workarea.blky++ )
+	workarea.x[0] = pSrcFrame->GetPlane(YPLANE)->GetHPadding() + (nBlkSizeX-nOverlapX)*blkxStart;
+	if (chroma)
 	{
-		workarea.blkScanDir = (workarea.blky%2 == 0 || ! _meander_flag) ? 1 : -1;
-		// meander (alternate) scan blocks (even row left to right, odd row right to left)
-		int blkxStart = (workarea.blky%2 == 0 || ! _meander_flag) ? 0 : nBlkX-1;
-		if (workarea.blkScanDir==1) // start with leftmost block
-		{
-			workarea.x[0] = pSrcFrame->GetPlane(YPLANE)->GetHPadding();
-			if (chroma)
-			{
-				workarea.x[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding();
-				workarea.x[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding();
-			}
-		}
-		else // start with rightmost block, but it is already set at prev row
-		{
-			workarea.x[0] = pSrcFrame->GetPlane(YPLANE)->GetHPadding() + (nBlkSizeX-nOverlapX)*(nBlkX-1);
-			if (chroma)
-			{
-				workarea.x[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding()+ ((nBlkSizeX-nOverlapX)/2)*(nBlkX-1);
-				workarea.x[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding()+ ((nBlkSizeX-nOverlapX)/2)*(nBlkX-1);
-			}
-		}
+		workarea.x[1] = pSrcFrame->GetPlane(UPLANE)->GetHPadding()+ ((nBlkSizeX-nOverlapX)/2)*blkxStart;
+		workarea.x[2] = pSrcFrame->GetPlane(VPLANE)->GetHPadding()+ ((nBlkSizeX-nOverlapX)/2)*blkxStart;
+	}
 
-		for ( int iblkx = 0; iblkx < nBlkX; iblkx++ )
-		{
-			workarea.blkx = blkxStart + iblkx*workarea.blkScanDir;
-			workarea.blkIdx = workarea.blky*nBlkX + workarea.blkx;
-			workarea.iter=0;
+	for ( int iblkx = 0; iblkx < nbr_blk; iblkx++ )
+	{
+		workarea.blkx = blkxStart + iblkx*workarea.blkScanDir;
+		workarea.blkIdx = workarea.blky*nBlkX + workarea.blkx;
+		workarea.iter=0;
 //			DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-			PROFILE_START(MOTION_PROFILE_ME);
+		prof_count (workarea, Profiler::CNT_BLOCKS, 1);
 
-			// Resets the global predictor (it may have been clipped during the
-			// previous block scan)
-			workarea.globalMVPredictor = _glob_mv_pred_def;
+		// Resets the global predictor (it may have been clipped during the
+		// previous block scan)
+		workarea.globalMVPredictor = _glob_mv_pred_def;
 
 #if (ALIGN_SOURCEBLOCK > 1)
+		if (_src_cache_flag)
+		{
+			// aligned copy already made by PrepareSrcCache()
+			const uint8_t *	pBlk = &_src_cache_blk [workarea.blkIdx * _src_cache_blk_size];
+			workarea.pSrc[0] = pBlk + _src_cache_ofs [0];
+			workarea.pSrc[1] = pBlk + _src_cache_ofs [1];
+			workarea.pSrc[2] = pBlk + _src_cache_ofs [2];
+		}
+		else
+		{
 			//store the pitch
 			workarea.pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
 			//create aligned copy
@@ -2180,109 +2630,83 @@ void	PlaneOfBlocks::search_mv_slice (Slicer::TaskData &td)
 				BLITCHROMA(workarea.pSrc_temp[2],nSrcPitch[2],workarea.pSrc[2],nSrcPitch_plane[2]);
 				workarea.pSrc[2] = workarea.pSrc_temp[2];
 			}
+		}
 #else	// ALIGN_SOURCEBLOCK
-			workarea.pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
-			if (chroma)
-			{
-				workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
-				workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
-			}
+		workarea.pSrc[0] = pSrcFrame->GetPlane(YPLANE)->GetAbsolutePelPointer(workarea.x[0], workarea.y[0]);
+		if (chroma)
+		{
+			workarea.pSrc[1] = pSrcFrame->GetPlane(UPLANE)->GetAbsolutePelPointer(workarea.x[1], workarea.y[1]);
+			workarea.pSrc[2] = pSrcFrame->GetPlane(VPLANE)->GetAbsolutePelPointer(workarea.x[2], workarea.y[2]);
+		}
 #endif	// ALIGN_SOURCEBLOCK
 
-			if ( workarea.blky == workarea.blky_beg )
-			{
-				workarea.nLambda = 0;
-			}
-			else
-			{
-				workarea.nLambda = _lambda_level;
-			}
-
-			penaltyNew = _pnew; // penalty for new vector
-			LSAD = _lsad;    // SAD limit for lambda using
-			// may be they must be scaled by nPel ?
+		if ( workarea.blky == workarea.blky_beg )
+		{
+			workarea.nLambda = 0;
+		}
+		else
+		{
+			workarea.nLambda = _lambda_level;
+		}
 
-			// decreased padding of coarse levels
-			int nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
-			int nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
-			/* computes search boundaries */
-			workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
-			workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight()  - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
-			workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
-			workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
-
-			/* search the mv */
-			workarea.predictor = ClipMV(workarea, vectors[workarea.blkIdx]);
-			if (temporal)
-			{
-				workarea.predictors[4] = ClipMV(workarea, *reinterpret_cast<VECTOR*>(&_vecPrev[workarea.blkIdx*N_PER_BLOCK])); // temporal predictor
-			}
-			else
-			{
-				workarea.predictors[4] = ClipMV(workarea, zeroMV);
-			}
+		penaltyNew = _pnew; // penalty for new vector
+		LSAD = _lsad;    // SAD limit for lambda using
+		// may be they must be scaled by nPel ?
+
+		// decreased padding of coarse levels
+		int nHPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetHPadding() >> nLogScale;
+		int nVPaddingScaled = pSrcFrame->GetPlane(YPLANE)->GetVPadding() >> nLogScale;
+		/* computes search boundaries */
+		workarea.nDxMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedWidth() - workarea.x[0] - nBlkSizeX - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
+		workarea.nDyMax = nPel * (pSrcFrame->GetPlane(YPLANE)->GetExtendedHeight()  - workarea.y[0] - nBlkSizeY - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
+		workarea.nDxMin = -nPel * (workarea.x[0] - pSrcFrame->GetPlane(YPLANE)->GetHPadding() + nHPaddingScaled);
+		workarea.nDyMin = -nPel * (workarea.y[0] - pSrcFrame->GetPlane(YPLANE)->GetVPadding() + nVPaddingScaled);
+
+		/* search the mv */
+		workarea.predictor = ClipMV(workarea, vectors[workarea.blkIdx]);
+		if (temporal)
+		{
+			workarea.predictors[4] = ClipMV(workarea, *reinterpret_cast<VECTOR*>(&_vecPrev[workarea.blkIdx*N_PER_BLOCK])); // temporal predictor
+		}
+		else
+		{
+			workarea.predictors[4] = ClipMV(workarea, zeroMV);
+		}
 
-			PseudoEPZSearch(workarea);
+		PseudoEPZSearch(workarea);
 //			workarea.bestMV = zeroMV; // debug
 
-			if (outfilebuf != NULL) // write vector to outfile
-			{
-				outfilebuf[workarea.blkx*4+0] = workarea.bestMV.x;
-				outfilebuf[workarea.blkx*4+1] = workarea.bestMV.y;
-				outfilebuf[workarea.blkx*4+2] = (workarea.bestMV.sad & 0x0000ffff); // low word
-				outfilebuf[workarea.blkx*4+3] = (workarea.bestMV.sad >> 16);     // high word, usually null
-			}
-
-			/* write the results */
-			pBlkData[workarea.blkx*N_PER_BLOCK+0] = workarea.bestMV.x;
-			pBlkData[workarea.blkx*N_PER_BLOCK+1] = workarea.bestMV.y;
-			pBlkData[workarea.blkx*N_PER_BLOCK+2] = workarea.bestMV.sad;
-
-			PROFILE_STOP(MOTION_PROFILE_ME);
-
-
-			if (smallestPlane)
-			{
-				workarea.sumLumaChange += LUMA(GetRefBlock(workarea, 0,0), nRefPitch[0]) - LUMA(workarea.pSrc[0], nSrcPitch[0]);
-			}
-
-			/* increment indexes & pointers */
-			if ( iblkx < nBlkX-1 )
-			{
-				workarea.x[0] += (nBlkSizeX - nOverlapX)*workarea.blkScanDir;
-				workarea.x[1] += ((nBlkSizeX - nOverlapX)*workarea.blkScanDir /2);
-				workarea.x[2] += ((nBlkSizeX - nOverlapX)*workarea.blkScanDir /2);
-			}
-		}	// for iblkx
-
-		pBlkData += nBlkX*N_PER_BLOCK;
 		if (outfilebuf != NULL) // write vector to outfile
 		{
-			outfilebuf += nBlkX*4;// 4 short word per block
+			outfilebuf[workarea.blkx*4+0] = workarea.bestMV.x;
+			outfilebuf[workarea.blkx*4+1] = workarea.bestMV.y;
+			outfilebuf[workarea.blkx*4+2] = (workarea.bestMV.sad & 0x0000ffff); // low word
+			outfilebuf[workarea.blkx*4+3] = (workarea.bestMV.sad >> 16);     // high word, usually null
 		}
 
-		workarea.y[0] += (nBlkSizeY - nOverlapY);
-		workarea.y[1] += ((nBlkSizeY - nOverlapY) >> nLogyRatioUV );
-		workarea.y[2] += ((nBlkSizeY - nOverlapY) >> nLogyRatioUV );
-	}	// for workarea.blky
-
-	planeSAD      += workarea.planeSAD;
-	sumLumaChange += workarea.sumLumaChange;
+		/* write the results */
+		pBlkData[workarea.blkx*N_PER_BLOCK+0] = workarea.bestMV.x;
+		pBlkData[workarea.blkx*N_PER_BLOCK+1] = workarea.bestMV.y;
+		pBlkData[workarea.blkx*N_PER_BLOCK+2] = workarea.bestMV.sad;
 
-	if (isse)
-	{
-		_mm_empty ();
-	}
 
-#ifdef ALLOW_DCT
-	if (_dct_pool_ptr != 0)
-	{
-		_dct_pool_ptr->return_obj (*(workarea.DCT));
-		workarea.DCT = 0;
-	}
-#endif
+		if (smallestPlane)
+		{
+			const int		srcLuma =
+				  (_src_cache_flag)
+				? _src_cache_luma [workarea.blkIdx]
+				: LUMA(workarea.pSrc[0], nSrcPitch[0]);
+			workarea.sumLumaChange += LUMA(GetRefBlock(workarea, 0,0), nRefPitch[0]) - srcLuma;
+		}
 
-	_workarea_pool.return_obj (workarea);
+		/* increment indexes & pointers */
+		if ( iblkx < nbr_blk-1 )
+		{
+			workarea.x[0] += (nBlkSizeX - nOverlapX)*workarea.blkScanDir;
+			workarea.x[1] += ((nBlkSizeX - nOverlapX)*workarea.blkScanDir /2);
+			workarea.x[2] += ((nBlkSizeX - nOverlapX)*workarea.blkScanDir /2);
+		}
+	}	// for iblkx
 }
 
 
@@ -2295,6 +2719,7 @@ void	PlaneOfBlocks::recalculate_mv_slice (Slicer::TaskData &td)
 
 	WorkingArea &	workarea = *(_workarea_pool.take_obj ());
 	assert (&workarea != 0);
+	prof_begin_task (workarea);
 
 	workarea.blky_beg = td._y_beg;
 	workarea.blky_end = td._y_end;
@@ -2370,7 +2795,7 @@ void	PlaneOfBlocks::recalculate_mv_slice (Slicer::TaskData &td)
 			workarea.blkx = blkxStart + iblkx*workarea.blkScanDir;
 			workarea.blkIdx = workarea.blky*nBlkX + workarea.blkx;
 			//		DebugPrintf("BlkIdx = %d \n", workarea.blkIdx);
-			PROFILE_START(MOTION_PROFILE_ME);
+			prof_count (workarea, Profiler::CNT_BLOCKS, 1);
 
 #if (ALIGN_SOURCEBLOCK > 1)
 			//store the pitch
@@ -2598,9 +3023,6 @@ void	PlaneOfBlocks::recalculate_mv_slice (Slicer::TaskData &td)
 			pBlkData[workarea.blkx*N_PER_BLOCK+1] = workarea.bestMV.y;
 			pBlkData[workarea.blkx*N_PER_BLOCK+2] = workarea.bestMV.sad;
 
-
-			PROFILE_STOP(MOTION_PROFILE_ME);
-
 			if (smallestPlane)
 			{
 				workarea.sumLumaChange += LUMA(GetRefBlock(workarea, 0,0), nRefPitch[0]) - LUMA(workarea.pSrc[0], nSrcPitch[0]);
@@ -2641,19 +3063,259 @@ void	PlaneOfBlocks::recalculate_mv_slice (Slicer::TaskData &td)
 	}
 #endif
 
+	prof_end_task (workarea);
 	_workarea_pool.return_obj (workarea);
 }
 
 
 
+void	PlaneOfBlocks::prof_begin_task (WorkingArea &workarea)
+{
+	workarea.prof_cnt.clear ();
+	workarea.prof_flag = (_prof_ptr != 0);
+	if (workarea.prof_flag)
+	{
+		workarea.prof_t_beg = Profiler::get_time ();
+	}
+}
+
+
+
+// The counters are only collected here, so the tasks don't share anything
+// while searching.
+void	PlaneOfBlocks::prof_end_task (WorkingArea &workarea)
+{
+	if (_prof_ptr != 0)
+	{
+		const int64_t	dur = Profiler::get_time () - workarea.prof_t_beg;
+		workarea.prof_cnt._val_arr [Profiler::CNT_TIME] = dur;
+		_prof_ptr->add_counters (nLogScale, searchType, workarea.prof_cnt);
+		_prof_slices.add (dur);
+	}
+}
+
+
+
+// The counters are updated in the innermost loops, so nothing is written
+// when profiling is disabled.
+void	PlaneOfBlocks::prof_count (WorkingArea &workarea, Profiler::Counter cnt, int64_t val)
+{
+	if (workarea.prof_flag)
+	{
+		workarea.prof_cnt._val_arr [cnt] += val;
+	}
+}
+
+
+
 // -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -
 
 
 
+// Each slice index is a part of the block list
+void	PlaneOfBlocks::estimate_global_mv_hist_slice (Slicer::TaskData &td)
+{
+	const int      freqSize = 8192 * nPel * 2;
+	const int      half = freqSize >> 1;
+
+	for (int p = td._y_beg; p < td._y_end; ++p)
+	{
+		GlobalMVPart & part = _gmv_part_arr [p];
+		for (int c = 0; c < 2; ++c)
+		{
+			if (part.freq_arr [c].empty ())
+			{
+				part.freq_arr [c].resize (freqSize, 0);
+			}
+			part.ind_min [c] = freqSize-1;
+			part.ind_max [c] = 0;
+		}
+		int *          freqx_ptr = &part.freq_arr [0] [0];
+		int *          freqy_ptr = &part.freq_arr [1] [0];
+		int            indminx = freqSize-1;
+		int            indmaxx = 0;
+		int            indminy = freqSize-1;
+		int            indmaxy = 0;
+
+		const int      blk_end = compute_gmv_part_beg (p + 1);
+		for (int i = compute_gmv_part_beg (p); i < blk_end; i++)
+		{
+			const int      indx = half + vectors[i].x;
+			if (indx >= 0 && indx < freqSize)
+			{
+				++ freqx_ptr [indx];
+				indminx = std::min (indminx, indx);
+				indmaxx = std::max (indmaxx, indx);
+			}
+			const int      indy = half + vectors[i].y;
+			if (indy >= 0 && indy < freqSize)
+			{
+				++ freqy_ptr [indy];
+				indminy = std::min (indminy, indy);
+				indmaxy = std::max (indmaxy, indy);
+			}
+		}
+
+		part.ind_min [0] = indminx;
+		part.ind_max [0] = indmaxx;
+		part.ind_min [1] = indminy;
+		part.ind_max [1] = indmaxy;
+	}
+}
+
+
+
+void	PlaneOfBlocks::estimate_global_mv_mean_slice (Slicer::TaskData &td)
+{
+	const int      medianx = _gmv_median.x;
+	const int      mediany = _gmv_median.y;
+
+	for (int p = td._y_beg; p < td._y_end; ++p)
+	{
+		int            meanvx = 0;
+		int            meanvy = 0;
+		int            num = 0;
+		const int      blk_end = compute_gmv_part_beg (p + 1);
+		for (int i = compute_gmv_part_beg (p); i < blk_end; i++)
+		{
+			if (   abs (vectors[i].x - medianx) < 6
+			    && abs (vectors[i].y - mediany) < 6)
+			{
+				meanvx += vectors[i].x;
+				meanvy += vectors[i].y;
+				num += 1;
+			}
+		}
+
+		GlobalMVPart & part = _gmv_part_arr [p];
+		part.sum [0] = meanvx;
+		part.sum [1] = meanvy;
+		part.num     = num;
+	}
+}
+
+
+
+int	PlaneOfBlocks::compute_gmv_part_beg (int part) const
+{
+	assert (part >= 0);
+	assert (part <= _gmv_nbr_parts);
+
+	return (int (int64_t (part) * nBlkCount / _gmv_nbr_parts));
+}
+
+
+
+// Computes the predictors of a range of block rows from the vectors of the
+// upper plane, which has half the resolution. Each vector is a weighted sum
+// of its 4 nearest upper vectors.
+void	PlaneOfBlocks::interpolate_prediction_slice (Slicer::TaskData &td)
+{
+	assert (_interp_src_ptr != 0);
+
+	const PlaneOfBlocks &	pob = *_interp_src_ptr;
+
+	int normFactor = 3 - nLogPel + pob.nLogPel;
+	const int mulFactor = (normFactor < 0) ? -normFactor : 0;
+	normFactor = (normFactor < 0) ? 0 : normFactor;
+	const int normov = (nBlkSizeX - nOverlapX)*(nBlkSizeY - nOverlapY);
+	const int aoddx= (nBlkSizeX*3 - nOverlapX*2);
+	const int aevenx = (nBlkSizeX*3 - nOverlapX*4);
+	const int aoddy= (nBlkSizeY*3 - nOverlapY*2);
+	const int aeveny = (nBlkSizeY*3 - nOverlapY*4);
+
+	// note: overlapping is still (v2.5.7) not processed properly
+	// Weights are 9/3/3/1 without overlap and uniform for large overlaps.
+	// Otherwise they depend on the block position and the sum is divided by
+	// normov.
+	const bool     div_flag = (   (nOverlapX != 0 || nOverlapY != 0)
+	                           && nOverlapX <= (nBlkSizeX>>1) && nOverlapY <= (nBlkSizeY>>1)); // corrected in v1.4.11
+	const bool     flat_flag = (! div_flag && (nOverlapX != 0 || nOverlapY != 0)); // large overlap. Weights are not quite correct but let it be
+	const int      sad_add = (div_flag) ? 0 : 8;
+
+	const int      i_last = 2 * pob.nBlkX - 1;
+	const int      j_last = 2 * pob.nBlkY - 1;
+
+	for (int l = td._y_beg; l < td._y_end; ++l)
+	{
+		const int      j = std::min (l, j_last);
+		const int      offy = -1 + 2 * ( j % 2);
+		const bool     j_border = ( j == 0 || j >= j_last );
+		const VECTOR * row0_ptr = &pob.vectors [(j / 2) * pob.nBlkX];
+		const VECTOR * row1_ptr = (j_border) ? row0_ptr : row0_ptr + offy * pob.nBlkX;
+
+		// Weights of v1, v2, v3, v4 for odd and even columns
+		int            w_arr [2] [4];
+		const int      ay1 = (offy > 0) ? aoddy : aeveny;
+		const int      ay2 = (nBlkSizeY - nOverlapY)*4 - ay1;
+		for (int odd = 0; odd < 2; ++odd)
+		{
+			const int      ax1 = (odd) ? aoddx : aevenx;
+			const int      ax2 = (nBlkSizeX - nOverlapX)*4 - ax1;
+			int *          w_ptr = w_arr [odd];
+			if (div_flag)
+			{
+				w_ptr [0] = ax1*ay1;
+				w_ptr [1] = ax2*ay1;
+				w_ptr [2] = ax1*ay2;
+				w_ptr [3] = ax2*ay2;
+			}
+			else if (flat_flag)
+			{
+				w_ptr [0] = w_ptr [1] = w_ptr [2] = w_ptr [3] = 4;
+			}
+			else
+			{
+				w_ptr [0] = 9;
+				w_ptr [1] = w_ptr [2] = 3;
+				w_ptr [3] = 1;
+			}
+		}
+
+		VECTOR *       dst_ptr = &vectors [l * nBlkX];
+		for (int k = 0; k < nBlkX; ++k)
+		{
+			const int      i = std::min (k, i_last);
+			const int      odd = i % 2;
+			const int      c0 = i / 2;
+			const int      c1 = ( i == 0 || i >= i_last ) ? c0 : c0 - 1 + 2 * odd;
+
+			// On the first and last rows, the horizontal neighbour is weighted
+			// as a vertical one.
+			const VECTOR & v1 = row0_ptr [c0];
+			const VECTOR & v2 = (j_border) ? row0_ptr [c0] : row0_ptr [c1];
+			const VECTOR & v3 = (j_border) ? row0_ptr [c1] : row1_ptr [c0];
+			const VECTOR & v4 = row1_ptr [c1];
+
+			const int *    w_ptr = w_arr [odd];
+			int            x   = w_ptr [0] * v1.x   + w_ptr [1] * v2.x   + w_ptr [2] * v3.x   + w_ptr [3] * v4.x;
+			int            y   = w_ptr [0] * v1.y   + w_ptr [1] * v2.y   + w_ptr [2] * v3.y   + w_ptr [3] * v4.y;
+			int            sad = w_ptr [0] * v1.sad + w_ptr [1] * v2.sad + w_ptr [2] * v3.sad + w_ptr [3] * v4.sad + sad_add;
+			if (div_flag)
+			{
+				x   /= normov;
+				y   /= normov;
+				sad /= normov;
+			}
+
+			dst_ptr [k].x   = (x >> normFactor) << mulFactor;
+			dst_ptr [k].y   = (y >> normFactor) << mulFactor;
+			dst_ptr [k].sad = sad >> 4;
+		}
+	}
+}
+
+
+
 PlaneOfBlocks::WorkingArea::WorkingArea (int nBlkSizeX, int nBlkSizeY, int dctpitch, int nLogyRatioUV, int yRatioUV)
 :	dctSrc (nBlkSizeY*dctpitch)
 ,	dctRef (nBlkSizeY*dctpitch)
+,	sad_map ()
+,	cost_map ()
 ,	DCT (0)
+,	prof_cnt ()
+,	prof_flag (false)
+,	prof_t_beg (0)
 {
 #if (ALIGN_SOURCEBLOCK > 1)
 	int blocksize=nBlkSizeX*nBlkSizeY;
@@ -20,8 +20,11 @@
 
 #include "conc/ObjPool.h"
 #include "CopyCode.h"
+#include "MTFlowGraphSched.h"
+#include "MTFlowGraphWavefront.h"
 #include "MTSlicer.h"
 #include	"MVInterface.h"	// Required for ALIGN_SOURCEBLOCK
+#include "Profiler.h"
 #include "SADFunctions.h"
 #include "SearchType.h"
 #include "Variance.h"
@@ -55,7 +58,7 @@ public :
 
 	typedef	MTSlicer <PlaneOfBlocks>	Slicer;
 
-	PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int _nFlags, int _nOverlapX, int _nOverlapY, int _yRatioUV, conc::ObjPool <DCTClass> *dct_pool_ptr, bool mt_flag);
+	PlaneOfBlocks(int _nBlkX, int _nBlkY, int _nBlkSizeX, int _nBlkSizeY, int _nPel, int _nLevel, int _nFlags, int _nOverlapX, int _nOverlapY, int _yRatioUV, conc::ObjPool <DCTClass> *dct_pool_ptr, Profiler *prof_ptr, bool mt_flag);
 
 	~PlaneOfBlocks();
 
@@ -76,7 +79,7 @@ public :
 	int WriteDefaultToArray(int *array, int divideExtra);
 	int GetArraySize(int divideExtra);
 	void FitReferenceIntoArray(MVFrame *_pRefFrame, int *array);
-	void EstimateGlobalMVDoubled(VECTOR *globalMVec, Slicer &slicer); // Fizick
+	void EstimateGlobalMVDoubled(VECTOR *globalMVec); // Fizick
 	inline int GetnBlkX() { return nBlkX; }
 	inline int GetnBlkY() { return nBlkY; }
 
@@ -85,6 +88,10 @@ public :
 				  int flags, int *out, short * outfilebuf, int fieldShift, int thSAD,
 				  int _divideExtra, int smooth, bool meander);
 
+	/* per-source-frame cache of the block features, shared by several searches */
+	void PrepareSrcCache(MVFrame *_pSrcFrame);
+	void InvalidateSrcCache();
+
 private:
 
 /* fields set at initialization */
@@ -104,6 +111,7 @@ private:
 	const int      yRatioUV;
 	const int      nLogyRatioUV;     // log of yRatioUV (0 for 1 and 1 for 2)
 	const bool     _mt_flag;         // Allows multithreading
+	Profiler *     _prof_ptr;        // 0 if profiling is disabled
 
 	SADFunction *  SAD;              /* function which computes the sad */
    LUMAFunction * LUMA;             /* function which computes the mean luma */
@@ -112,6 +120,17 @@ private:
    COPYFunction * BLITCHROMA;
    SADFunction *  SADCHROMA;
    SADFunction *  SATD;              /* SATD function, (similar to SAD), used as replacement to dct */
+	SADMultiFunction *
+	               SADMULTI;         /* batched SAD, several candidates at once */
+	SADMultiFunction *
+	               SADCHROMAMULTI;
+	SADMapFunction *
+	               SADMAP;           /* SADs of a whole search window at once */
+	SADMapFunction *
+	               SADCHROMAMAP;
+	SADThrFunction *
+	               SADTHR;           /* SAD with early termination */
+	bool           _sad_thr_flag;    // Candidate lists are checked one by one with SADTHR instead of SADMULTI
 
 	std::vector <VECTOR>              /* motion vectors of the blocks */
 	               vectors;           /* before the search, contains the hierachal predictor */
@@ -127,9 +146,6 @@ private:
 	conc::ObjPool <DCTClass> *		// Set to 0 if not used
 	               _dct_pool_ptr;
 
-	conc::Array <std::vector <int>, 2>
-	               freqArray; // temporary array for global motion estimaton [x|y][value]
-
 	int verybigSAD;
 
 /* working fields */
@@ -158,7 +174,8 @@ private:
 //	int nLambdaLen;             // penalty factor (lambda) for vector length
 	int badSAD;                 // SAD threshold for more wide search
 	int badrange;               // wide search radius
-	conc::AtomicInt <int> badcount;      // number of bad blocks refined
+	std::vector <int> _badcount_arr; // number of bad blocks refined, for each chunk of each row: [row * _badcount_nbr_chunks + chunk]
+	int _badcount_nbr_chunks;   // number of chunks per row for the current search
 	bool temporal;              // use temporal predictor
 	bool tryMany;               // try refine around many predictors
 
@@ -179,6 +196,27 @@ private:
 	int _smooth;
 	int _thSAD;
 
+	Profiler::SliceRun
+	               _prof_slices;     // Durations of the tasks of the current search
+
+	// Source block cache. Filled by PrepareSrcCache() when several searches
+	// are done on the same source frame (MAnalyse multi mode), so the source
+	// side of the block matching is computed only once.
+#if (ALIGN_SOURCEBLOCK > 1)
+	typedef	std::vector <uint8_t, AllocAlign <uint8_t, ALIGN_SOURCEBLOCK> >	SrcCacheArray;
+#else	// ALIGN_SOURCEBLOCK
+	typedef	std::vector <uint8_t>	SrcCacheArray;
+#endif	// ALIGN_SOURCEBLOCK
+
+	MVFrame *      _src_cache_frame_ptr;   // Frame the cache has been built from. 0 if invalid
+	bool           _src_cache_flag;        // The current search reads the source blocks from the cache
+	int            _src_cache_blk_size;    // Bytes per block in _src_cache_blk
+	int            _src_cache_ofs [3];     // Offset of each plane within a cached block
+	SrcCacheArray  _src_cache_blk;         // Aligned copies of the source blocks (Y, U, V)
+	SrcCacheArray  _src_cache_dct;         // DCT of the source blocks, nBlkSizeY*dctpitch bytes per block
+	std::vector <int>
+	               _src_cache_luma;        // Mean luma of the source blocks
+
 	// Working area
 	class WorkingArea
 	{
@@ -206,6 +244,9 @@ private:
 		int blky_beg;               // First line of blocks to process from this thread
 		int blky_end;               // Last line of blocks + 1 to process from this thread
 
+		int badcount_base;          // Bad blocks refined before the current chunk
+		int badcount_idx;           // Index of the current chunk in _badcount_arr
+
 		// Current block
 		const uint8_t* pSrc[3];     // the alignment of this array is important for speed for some reason (cacheline?)
 
@@ -223,9 +264,17 @@ private:
 		int iter;                   // MOTION_DEBUG only?
 		int srcLuma;
 
+		Profiler::Counters prof_cnt; // Block matching counters of the current task
+		bool prof_flag;             // Counters are updated only when profiling
+		int64_t prof_t_beg;         // Start time of the current task
+
 		// Data set once
 		TmpDataArray dctSrc;
 		TmpDataArray dctRef;
+		std::vector <unsigned int>
+		       sad_map;             // SADs of the exhaustive search window, luma then U and V
+		std::vector <int>
+		       cost_map;            // Costs of the exhaustive search window
 #if (ALIGN_SOURCEBLOCK > 1)
 		TmpDataArray pSrc_temp_base;// stores base memory pointer to non _base pointer
 		uint8_t* pSrc_temp[3];      //for easy WRITE access to temp block
@@ -238,6 +287,32 @@ private:
 		inline int MotionDistorsion(int vx, int vy) const;
 	};
 
+	// Cost map of the exhaustive search and the cost to look for
+	struct MapWindow
+	{
+		const int *    cost_ptr;
+		int            x_beg;
+		int            x_end;
+		int            y_beg;
+		int            y_end;
+		int            cost;
+	};
+
+	// List of candidate vectors evaluated in a single batch
+	class MVCandList
+	{
+	public:
+		int nbr;
+		int vx [SAD_MULTI_MAX];
+		int vy [SAD_MULTI_MAX];
+		int val [SAD_MULTI_MAX];     // direction code for CheckMV2/CheckMVdir-like updates
+
+		inline         MVCandList () : nbr (0) {}
+		inline void    push (int x, int y, int v = 0) { vx [nbr] = x; vy [nbr] = y; val [nbr] = v; ++ nbr; }
+		inline bool    is_full () const { return (nbr >= SAD_MULTI_MAX); }
+		inline void    clear () { nbr = 0; }
+	};
+
 	class WorkingAreaFactory
 	:	public conc::ObjFactoryInterface <WorkingArea>
 	{
@@ -262,9 +337,44 @@ private:
 	WorkingAreaPool
 						_workarea_pool;
 
-	VECTOR *       _gvect_estim_ptr;	// Points on the global motion vector estimation result. 0 when not used.
-	conc::AtomicInt <int>
-	               _gvect_result_count;
+	// Global motion estimation. The blocks are split into parts processed
+	// concurrently, each one with its own histograms, merged at the end.
+	enum {         MAX_GMV_PARTS = 16 };
+	enum {         MIN_GMV_PART_BLOCKS = 1024 };
+
+	class GlobalMVPart
+	{
+	public:
+		std::vector <int>
+		               freq_arr [2];      // Histograms [x|y][value + half size]. Zeroed between uses
+		int            ind_min [2];       // Used range of the histograms
+		int            ind_max [2];
+		int            sum [2];           // Sum of the vectors close to the most frequent one
+		int            num;
+	};
+
+	std::vector <GlobalMVPart>
+	               _gmv_part_arr;
+	int            _gmv_nbr_parts;
+	VECTOR         _gmv_median;       // Most frequent vector, for the second pass
+
+	const PlaneOfBlocks *
+	               _interp_src_ptr;   // Upper plane, during InterpolatePrediction
+
+	// Wavefront scheduling of the search. Each row is cut into chunks of a
+	// fixed width, and a chunk is processed as soon as its left, top and
+	// top-right neighbours are done. The chunking doesn't depend on the
+	// number of threads and the sequential search uses the same chunks, so
+	// the result is the same in all cases.
+	// The task storage of the scheduler grows with the plane size on the
+	// first search.
+	enum {         WAVEFRONT_CHUNK_W = 8 }; // Blocks
+
+	typedef	MTFlowGraphSched <PlaneOfBlocks, MTFlowGraphWavefront, PlaneOfBlocks, 1>	SchedWavefront;
+
+	MTFlowGraphWavefront
+	               _wavefront_graph;
+	SchedWavefront _sched_wavefront;
 
 /* mv search related functions */
 
@@ -277,8 +387,9 @@ private:
 	/* performs a square search */
 //	void SquareSearch(WorkingArea &workarea);
 
-	/* performs an exhaustive search */
-//	void ExhaustiveSearch(WorkingArea &workarea, int radius); // diameter = 2*radius - 1
+	/* performs an exhaustive search, with the same result as ExpandingSearch for radius 1 to radius */
+	void ExhaustiveSearch(WorkingArea &workarea, int radius, int mvx, int mvy); // diameter = 2*radius + 1
+	inline static bool MatchMapCost(const MapWindow &win, int cx, int cy, int &vx, int &vy);
 
 	/* performs an n-step search */
 	void NStepSearch(WorkingArea &workarea, int stp);
@@ -306,10 +417,14 @@ private:
 //	inline int LengthPenalty(int vx, int vy);
 	int LumaSADx (WorkingArea &workarea, const unsigned char *pRef0);
 	inline int LumaSAD (WorkingArea &workarea, const unsigned char *pRef0);
+	inline int LumaSADThr (WorkingArea &workarea, const unsigned char *pRef0, int bound);
+	inline void CheckMVThr(WorkingArea &workarea, int vx, int vy, int pnew, int *dir, int val, bool move_flag);
 	inline void CheckMV0(WorkingArea &workarea, int vx, int vy);
 	inline void CheckMV(WorkingArea &workarea, int vx, int vy);
 	inline void CheckMV2(WorkingArea &workarea, int vx, int vy, int *dir, int val);
 	inline void CheckMVdir(WorkingArea &workarea, int vx, int vy, int *dir, int val);
+	void CheckMVMulti(WorkingArea &workarea, MVCandList &cand, int pnew, int *dir, bool move_flag);
+	inline void FlushMVCand(WorkingArea &workarea, MVCandList &cand);
 	inline int ClipMVx(WorkingArea &workarea, int vx);
 	inline int ClipMVy(WorkingArea &workarea, int vy);
 	inline VECTOR ClipMV(WorkingArea &workarea, VECTOR v);
@@ -320,10 +435,23 @@ private:
 
 	void Refine(WorkingArea &workarea);
 
-	void	search_mv_slice (Slicer::TaskData &td);
+	void	set_src_frame (MVFrame *_pSrcFrame);
+	void	prepare_src_cache_slice (Slicer::TaskData &td);
+	void	search_mv_sequential ();
+	void	search_mv_wavefront (SchedWavefront::TaskData &td);
+	void	search_mv_chunk (WorkingArea &workarea, int task_index);
+	void	search_mv_row (WorkingArea &workarea, int blkx_beg, int blkx_end);
+	int	compute_nbr_chunks () const;
+	void	init_badcount (WorkingArea &workarea, int chunk) const;
 	void	recalculate_mv_slice (Slicer::TaskData &td);
-
-	void	estimate_global_mv_doubled_slice (Slicer::TaskData &td);
+	void	prof_begin_task (WorkingArea &workarea);
+	void	prof_end_task (WorkingArea &workarea);
+	inline static void	prof_count (WorkingArea &workarea, Profiler::Counter cnt, int64_t val);
+
+	void	estimate_global_mv_hist_slice (Slicer::TaskData &td);
+	void	estimate_global_mv_mean_slice (Slicer::TaskData &td);
+	void	interpolate_prediction_slice (Slicer::TaskData &td);
+	inline int	compute_gmv_part_beg (int part) const;
 
 };
 
@@ -0,0 +1,487 @@
+/*****************************************************************************
+
+        Profiler.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/AioMax.h"
+#include	"conc/CritSec.h"
+#include	"Profiler.h"
+
+#define	NOGDI
+#define	NOMINMAX
+#define	WIN32_LEAN_AND_MEAN
+#include "Windows.h"
+
+#include	<algorithm>
+
+#include	<cassert>
+#include	<cstdio>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Call it before starting the slices, not while they are running.
+void	Profiler::SliceRun::clear ()
+{
+	_busy = 0;
+	_max  = 0;
+	_nbr  = 0;
+}
+
+
+
+// Can be called concurrently by the slices
+void	Profiler::SliceRun::add (int64_t dur)
+{
+	_busy += dur;
+	++ _nbr;
+	conc::AioMax <int64_t>	max_ftor (dur);
+	conc::AtomicIntOp::exec (_max, max_ftor);
+}
+
+
+
+/*
+==============================================================================
+Name: acquire
+Description:
+	Gets the Profiler associated to a profile name, and creates it if it does
+	not exist yet. Each successful call must be balanced with a call to
+	release().
+Input parameters:
+	- name_0: Name of the profile, also used as file name for the JSON
+		report. Empty string or 0 to disable the profiling.
+Returns: The profiler, or 0 if profiling is disabled.
+==============================================================================
+*/
+
+Profiler *	Profiler::acquire (const char *name_0)
+{
+	if (name_0 == 0 || name_0 [0] == '\0')
+	{
+		return (0);
+	}
+
+	conc::CritSec	lock (_registry_mutex);
+
+	const std::string	name (name_0);
+	Registry::iterator	it = _registry.find (name);
+	if (it == _registry.end ())
+	{
+		it = _registry.insert (
+			Registry::value_type (name, new Profiler (name))
+		).first;
+	}
+	++ it->second->_nbr_users;
+
+	return (it->second);
+}
+
+
+
+// When the last user releases the profiler, the report is written and the
+// profiler is destroyed. prof_ptr may be 0.
+void	Profiler::release (Profiler *prof_ptr)
+{
+	if (prof_ptr == 0)
+	{
+		return;
+	}
+
+	conc::CritSec	lock (_registry_mutex);
+
+	assert (prof_ptr->_nbr_users > 0);
+	-- prof_ptr->_nbr_users;
+	if (prof_ptr->_nbr_users == 0)
+	{
+		prof_ptr->write_json ();
+		_registry.erase (prof_ptr->_name);
+		delete prof_ptr;
+	}
+}
+
+
+
+/*
+==============================================================================
+Name: read_value
+Description:
+	Reads the current value of a counter of a profile.
+	Block matching counters: blocks, sad, early_exits, bad_sad, search_time
+	(ms of thread time), sad_per_block and cand_per_block.
+	Stage values, with <stage> among search, refine, reduce, pad, overlap and
+	degrain: <stage>_time (ms of wall time), <stage>_calls,
+	<stage>_imbalance (longest slice / mean slice duration - 1) and
+	<stage>_parallelism (slice time / wall time).
+Input parameters:
+	- name_0: Name of the profile
+	- counter_0: Name of the counter
+	- level: Pyramid level of the block matching counters, -1 for all levels.
+Output parameters:
+	- val: Counter value
+Returns: false if the profile or the counter does not exist.
+==============================================================================
+*/
+
+bool	Profiler::read_value (double &val, const char *name_0, const char *counter_0, int level)
+{
+	assert (name_0 != 0);
+	assert (counter_0 != 0);
+
+	bool				ok_flag = false;
+
+	conc::CritSec	lock (_registry_mutex);
+
+	Registry::const_iterator	it = _registry.find (name_0);
+	if (it != _registry.end () && level < MAX_LEVELS)
+	{
+		ok_flag = it->second->get_value (val, counter_0, level);
+	}
+
+	return (ok_flag);
+}
+
+
+
+// In ticks of the performance counter
+int64_t	Profiler::get_time ()
+{
+	::LARGE_INTEGER	t;
+	::QueryPerformanceCounter (&t);
+
+	return (t.QuadPart);
+}
+
+
+
+void	Profiler::add_counters (int level, SearchType st, const Counters &cnt)
+{
+	assert (level >= 0);
+	assert (&cnt != 0);
+
+	if (level < MAX_LEVELS)
+	{
+		const int		st_index = conv_search_type_to_index (st);
+		for (int k = 0; k < CNT_NBR_ELT; ++k)
+		{
+			if (cnt._val_arr [k] != 0)
+			{
+				_cnt_arr [level] [st_index] [k] += cnt._val_arr [k];
+			}
+		}
+	}
+}
+
+
+
+void	Profiler::add_stage (Stage stage, int64_t dur)
+{
+	assert (stage >= 0);
+	assert (stage < STG_NBR_ELT);
+
+	StageData &		sd = _stage_arr [stage];
+	sd._time      += dur;
+	sd._nbr_calls += 1;
+}
+
+
+
+// Wall time of the run and durations of its slices
+void	Profiler::add_run (Stage stage, int64_t dur, const SliceRun &run)
+{
+	assert (stage >= 0);
+	assert (stage < STG_NBR_ELT);
+	assert (&run != 0);
+
+	add_stage (stage, dur);
+
+	const int		nbr = run._nbr;
+	if (nbr > 0)
+	{
+		StageData &		sd = _stage_arr [stage];
+		sd._slice_busy += run._busy;
+		sd._slice_span += int64_t (run._max) * nbr;
+		sd._nbr_slices += nbr;
+	}
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+Profiler::Registry	Profiler::_registry;
+conc::Mutex	Profiler::_registry_mutex;
+
+const char * const	Profiler::_cnt_name_0_arr [CNT_NBR_ELT] =
+{
+	"blocks", "sad", "early_exits", "bad_sad", "search_time"
+};
+
+const char * const	Profiler::_stage_name_0_arr [STG_NBR_ELT] =
+{
+	"search", "refine", "reduce", "pad", "overlap", "degrain"
+};
+
+const char * const	Profiler::_search_name_0_arr [NBR_SEARCH_TYPES] =
+{
+	"onetime", "nstep", "logarithmic", "exhaustive",
+	"hex2", "umh", "horizontal", "vertical"
+};
+
+
+
+Profiler::Profiler (const std::string &name)
+:	_name (name)
+,	_nbr_users (0)
+{
+	// Nothing
+}
+
+
+
+// level = -1: all levels
+int64_t	Profiler::sum_counter (Counter cnt, int level) const
+{
+	assert (cnt >= 0);
+	assert (cnt < CNT_NBR_ELT);
+	assert (level >= -1);
+	assert (level < MAX_LEVELS);
+
+	const int		lvl_beg = (level < 0) ? 0          : level;
+	const int		lvl_end = (level < 0) ? MAX_LEVELS : level + 1;
+	int64_t			sum     = 0;
+	for (int lvl = lvl_beg; lvl < lvl_end; ++lvl)
+	{
+		for (int st_index = 0; st_index < NBR_SEARCH_TYPES; ++st_index)
+		{
+			sum += _cnt_arr [lvl] [st_index] [cnt];
+		}
+	}
+
+	return (sum);
+}
+
+
+
+bool	Profiler::get_value (double &val, const std::string &counter, int level) const
+{
+	assert (&val != 0);
+	assert (&counter != 0);
+
+	const double	nbr_blk = double (std::max (sum_counter (CNT_BLOCKS, level), int64_t (1)));
+
+	if (counter == "sad_per_block")
+	{
+		val = sum_counter (CNT_SAD, level) / nbr_blk;
+		return (true);
+	}
+	if (counter == "cand_per_block")
+	{
+		val =   (sum_counter (CNT_SAD, level) + sum_counter (CNT_EARLY_EXIT, level))
+		      / nbr_blk;
+		return (true);
+	}
+	for (int cnt = 0; cnt < CNT_NBR_ELT; ++cnt)
+	{
+		if (counter == _cnt_name_0_arr [cnt])
+		{
+			const int64_t	sum = sum_counter (Counter (cnt), level);
+			val = (cnt == CNT_TIME) ? conv_time_to_ms (sum) : double (sum);
+			return (true);
+		}
+	}
+
+	for (int stage = 0; stage < STG_NBR_ELT; ++stage)
+	{
+		const std::string	prefix = std::string (_stage_name_0_arr [stage]) + "_";
+		if (counter.compare (0, prefix.size (), prefix) == 0)
+		{
+			const StageData &	sd     = _stage_arr [stage];
+			const std::string	suffix = counter.substr (prefix.size ());
+			const int64_t		busy   = sd._slice_busy;
+			const int64_t		span   = sd._slice_span;
+			const int64_t		time   = sd._time;
+			if (suffix == "time")
+			{
+				val = conv_time_to_ms (time);
+				return (true);
+			}
+			if (suffix == "calls")
+			{
+				val = double (int64_t (sd._nbr_calls));
+				return (true);
+			}
+			if (suffix == "imbalance")
+			{
+				val = (busy > 0) ? double (span) / double (busy) - 1 : 0;
+				return (true);
+			}
+			if (suffix == "parallelism")
+			{
+				val = (time > 0) ? double (busy) / double (time) : 0;
+				return (true);
+			}
+		}
+	}
+
+	return (false);
+}
+
+
+
+// Returns false if the file cannot be written.
+bool	Profiler::write_json () const
+{
+	FILE *			f_ptr = fopen (_name.c_str (), "w");
+	if (f_ptr == 0)
+	{
+		return (false);
+	}
+
+	fprintf (f_ptr, "{\n\t\"levels\": [");
+	bool				first_flag = true;
+	for (int level = 0; level < MAX_LEVELS; ++level)
+	{
+		if (sum_counter (CNT_BLOCKS, level) == 0)
+		{
+			continue;
+		}
+
+		double			sad_per_blk;
+		double			cand_per_blk;
+		get_value (sad_per_blk, "sad_per_block", level);
+		get_value (cand_per_blk, "cand_per_block", level);
+		fprintf (
+			f_ptr,
+			"%s\n\t\t{\n"
+			"\t\t\t\"level\": %d,\n"
+			"\t\t\t\"sad_per_block\": %.3f,\n"
+			"\t\t\t\"cand_per_block\": %.3f,\n"
+			"\t\t\t\"search_types\": {",
+			(first_flag) ? "" : ",",
+			level,
+			sad_per_blk,
+			cand_per_blk
+		);
+		first_flag = false;
+
+		bool				first_st_flag = true;
+		for (int st_index = 0; st_index < NBR_SEARCH_TYPES; ++st_index)
+		{
+			const conc::AtomicInt <int64_t> *	cnt_arr =
+				_cnt_arr [level] [st_index];
+			if (cnt_arr [CNT_BLOCKS] == 0)
+			{
+				continue;
+			}
+			fprintf (
+				f_ptr,
+				"%s\n\t\t\t\t\"%s\": { \"blocks\": %lld, \"sad\": %lld, "
+				"\"early_exits\": %lld, \"bad_sad\": %lld, "
+				"\"search_time_ms\": %.3f }",
+				(first_st_flag) ? "" : ",",
+				_search_name_0_arr [st_index],
+				static_cast <long long> (cnt_arr [CNT_BLOCKS]),
+				static_cast <long long> (cnt_arr [CNT_SAD]),
+				static_cast <long long> (cnt_arr [CNT_EARLY_EXIT]),
+				static_cast <long long> (cnt_arr [CNT_BAD_SAD]),
+				conv_time_to_ms (cnt_arr [CNT_TIME])
+			);
+			first_st_flag = false;
+		}
+		fprintf (f_ptr, "\n\t\t\t}\n\t\t}");
+	}
+	fprintf (f_ptr, "\n\t],\n\t\"stages\": {");
+
+	first_flag = true;
+	for (int stage = 0; stage < STG_NBR_ELT; ++stage)
+	{
+		const StageData &	sd = _stage_arr [stage];
+		if (sd._nbr_calls == 0)
+		{
+			continue;
+		}
+
+		const std::string	name (_stage_name_0_arr [stage]);
+		double			imbalance;
+		double			parallelism;
+		get_value (imbalance,   name + "_imbalance",   -1);
+		get_value (parallelism, name + "_parallelism", -1);
+		fprintf (
+			f_ptr,
+			"%s\n\t\t\"%s\": { \"time_ms\": %.3f, \"calls\": %lld, "
+			"\"slices\": %lld, \"imbalance\": %.3f, \"parallelism\": %.3f }",
+			(first_flag) ? "" : ",",
+			name.c_str (),
+			conv_time_to_ms (sd._time),
+			static_cast <long long> (sd._nbr_calls),
+			static_cast <long long> (sd._nbr_slices),
+			imbalance,
+			parallelism
+		);
+		first_flag = false;
+	}
+	fprintf (f_ptr, "\n\t}\n}\n");
+
+	const bool		ok_flag = (ferror (f_ptr) == 0);
+	fclose (f_ptr);
+
+	return (ok_flag);
+}
+
+
+
+int	Profiler::conv_search_type_to_index (SearchType st)
+{
+	int				index = 0;
+	while ((1 << index) < int (st) && index < NBR_SEARCH_TYPES - 1)
+	{
+		++ index;
+	}
+
+	return (index);
+}
+
+
+
+double	Profiler::conv_time_to_ms (int64_t t)
+{
+	::LARGE_INTEGER	freq;
+	::QueryPerformanceFrequency (&freq);
+
+	return (double (t) * 1000.0 / double (freq.QuadPart));
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,226 @@
+/*****************************************************************************
+
+        Profiler.h
+        Author: agent, 2026
+
+Run-time instrumentation of the hot paths, enabled per filter instance with
+the profile parameter. Filters given the same profile name share the same
+Profiler, so a whole MSuper/MAnalyse/MDegrainN chain can be reported at once.
+
+Collected data:
+- Block matching, for each pyramid level and search type: number of blocks,
+	SAD evaluations, candidates rejected before any SAD computation (early
+	exits), blocks needing a wide search (badSAD) and thread time.
+- Time spent in the main stages (search, refine, reduce, pad, overlap,
+	degrain), and how the load was balanced between the slices of each run.
+
+The block matching counters are accumulated in thread-owned Counters
+objects without any synchronisation, then added to the Profiler at the end
+of each task. Stage and slice times are added with atomic operations too, so
+nothing here takes a lock on the processing path.
+
+The results can be read at run time with MProfile(), and are written as a
+JSON file named after the profile when the last filter using it is
+destroyed.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (Profiler_HEADER_INCLUDED)
+#define	Profiler_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/AtomicInt.h"
+#include	"conc/Mutex.h"
+#include	"SearchType.h"
+#include	"types.h"
+
+#include	<map>
+#include	<string>
+
+
+
+class Profiler
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			MAX_LEVELS       = 16	};
+	enum {			NBR_SEARCH_TYPES = 8	};	// SearchType values are 1 << index
+
+	enum Counter
+	{
+		CNT_BLOCKS = 0,
+		CNT_SAD,
+		CNT_EARLY_EXIT,
+		CNT_BAD_SAD,
+		CNT_TIME,
+
+		CNT_NBR_ELT
+	};
+
+	enum Stage
+	{
+		STG_SEARCH = 0,
+		STG_REFINE,
+		STG_REDUCE,
+		STG_PAD,
+		STG_OVERLAP,
+		STG_DEGRAIN,
+
+		STG_NBR_ELT
+	};
+
+	// Block matching counters of a single thread
+	class Counters
+	{
+	public:
+		inline			Counters () { clear (); }
+		inline void		clear ();
+		int64_t			_val_arr [CNT_NBR_ELT];
+	};
+
+	// Durations of the slices of a single run, filled by the slices
+	class SliceRun
+	{
+	public:
+		void				clear ();
+		void				add (int64_t dur);
+		conc::AtomicInt <int64_t>
+							_busy;		// Sum of the slice durations
+		conc::AtomicInt <int64_t>
+							_max;			// Longest slice
+		conc::AtomicInt <int>
+							_nbr;
+	};
+
+	// Adds the time spent in the scope to a stage, if profiling is enabled
+	class Scope
+	{
+	public:
+		inline			Scope (Profiler *prof_ptr, Stage stage);
+		inline			~Scope ();
+	private:
+		Profiler *		_prof_ptr;
+		Stage				_stage;
+		int64_t			_t_beg;
+	private:
+							Scope ();
+							Scope (const Scope &other);
+		Scope &			operator = (const Scope &other);
+	};
+
+	static Profiler *
+						acquire (const char *name_0);
+	static void		release (Profiler *prof_ptr);
+	static bool		read_value (double &val, const char *name_0, const char *counter_0, int level);
+
+	static int64_t	get_time ();
+
+	void				add_counters (int level, SearchType st, const Counters &cnt);
+	void				add_stage (Stage stage, int64_t dur);
+	void				add_run (Stage stage, int64_t dur, const SliceRun &run);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class StageData
+	{
+	public:
+		conc::AtomicInt <int64_t>
+							_time;		// Wall time
+		conc::AtomicInt <int64_t>
+							_nbr_calls;
+		conc::AtomicInt <int64_t>
+							_slice_busy;
+		conc::AtomicInt <int64_t>
+							_slice_span;	// Longest slice * number of slices
+		conc::AtomicInt <int64_t>
+							_nbr_slices;
+	};
+
+	typedef	std::map <std::string, Profiler *>	Registry;
+
+	explicit			Profiler (const std::string &name);
+	virtual			~Profiler () {}
+
+	int64_t			sum_counter (Counter cnt, int level) const;
+	bool				get_value (double &val, const std::string &counter, int level) const;
+	bool				write_json () const;
+
+	static int		conv_search_type_to_index (SearchType st);
+	static double	conv_time_to_ms (int64_t t);
+
+	const std::string
+						_name;
+	int				_nbr_users;		// Protected by _registry_mutex
+
+	conc::AtomicInt <int64_t>
+						_cnt_arr [MAX_LEVELS] [NBR_SEARCH_TYPES] [CNT_NBR_ELT];
+	StageData		_stage_arr [STG_NBR_ELT];
+
+	static Registry
+						_registry;
+	static conc::Mutex
+						_registry_mutex;
+
+	static const char * const
+						_cnt_name_0_arr [CNT_NBR_ELT];
+	static const char * const
+						_stage_name_0_arr [STG_NBR_ELT];
+	static const char * const
+						_search_name_0_arr [NBR_SEARCH_TYPES];
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						Profiler ();
+						Profiler (const Profiler &other);
+	Profiler &		operator = (const Profiler &other);
+	bool				operator == (const Profiler &other) const;
+	bool				operator != (const Profiler &other) const;
+
+};	// class Profiler
+
+
+
+#include	"Profiler.hpp"
+
+
+
+#endif	// Profiler_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
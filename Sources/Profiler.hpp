@@ -0,0 +1,74 @@
+/*****************************************************************************
+
+        Profiler.hpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (Profiler_CODEHEADER_INCLUDED)
+#define	Profiler_CODEHEADER_INCLUDED
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+void	Profiler::Counters::clear ()
+{
+	for (int k = 0; k < CNT_NBR_ELT; ++k)
+	{
+		_val_arr [k] = 0;
+	}
+}
+
+
+
+// prof_ptr may be 0, the scope does nothing then.
+Profiler::Scope::Scope (Profiler *prof_ptr, Stage stage)
+:	_prof_ptr (prof_ptr)
+,	_stage (stage)
+,	_t_beg ((prof_ptr != 0) ? get_time () : 0)
+{
+	// Nothing
+}
+
+
+
+Profiler::Scope::~Scope ()
+{
+	if (_prof_ptr != 0)
+	{
+		_prof_ptr->add_stage (_stage, get_time () - _t_beg);
+	}
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+#endif	// Profiler_CODEHEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -30,6 +30,10 @@
 
 #include "types.h"
 
+#include <emmintrin.h>
+
+#include <cassert>
+
 typedef unsigned int (SADFunction)(const uint8_t *pSrc, int nSrcPitch,
 								    const uint8_t *pRef, int nRefPitch);
 
@@ -225,4 +229,265 @@ MK_CFUNC(SadDummy);
 #undef MK_CFUNC
 
 
+
+// Batched SAD: scores up to SAD_MULTI_MAX reference blocks against a single
+// source block, in the manner of x264 sad_x3/sad_x4. Each source row is
+// loaded once per call and reused for all the candidates, instead of being
+// reloaded for every candidate. Results are stored in sad_arr, in the same
+// order as pRef_arr.
+
+enum {	SAD_MULTI_MAX = 8	};
+
+typedef void (SADMultiFunction)(unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch,
+                                const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref);
+
+template<int nBlkWidth, int nBlkHeight>
+void SadMulti_C(unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch,
+                const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref)
+{
+	assert (nbr_ref > 0 && nbr_ref <= SAD_MULTI_MAX);
+
+	for ( int k = 0; k < nbr_ref; k++ )
+	{
+		sad_arr[k] = 0;
+	}
+	for ( int y = 0; y < nBlkHeight; y++ )
+	{
+		for ( int k = 0; k < nbr_ref; k++ )
+		{
+			const uint8_t *pRef = pRef_arr[k] + y * nRefPitch;
+			unsigned int sum = 0;
+			for ( int x = 0; x < nBlkWidth; x++ )
+				sum += SADABS(pSrc[x] - pRef[x]);
+			sad_arr[k] += sum;
+		}
+		pSrc += nSrcPitch;
+	}
+}
+
+// NBR_REF is a template parameter so the accumulators stay in registers.
+template<int nBlkWidth, int nBlkHeight, int NBR_REF>
+void SadMulti_sse2_n(unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch,
+                     const uint8_t * const pRef_arr [], int nRefPitch)
+{
+	__m128i acc[NBR_REF];
+	const uint8_t *pRef[NBR_REF];
+	for (int k = 0; k < NBR_REF; k++)
+	{
+		acc[k] = _mm_setzero_si128();
+		pRef[k] = pRef_arr[k];
+	}
+
+	if (nBlkWidth >= 16)
+	{
+		for (int y = 0; y < nBlkHeight; y++)
+		{
+			for (int x = 0; x < nBlkWidth; x += 16)
+			{
+				const __m128i s = _mm_loadu_si128((const __m128i *)(pSrc + x));
+				for (int k = 0; k < NBR_REF; k++)
+				{
+					const __m128i r = _mm_loadu_si128((const __m128i *)(pRef[k] + x));
+					acc[k] = _mm_add_epi64(acc[k], _mm_sad_epu8(s, r));
+				}
+			}
+			pSrc += nSrcPitch;
+			for (int k = 0; k < NBR_REF; k++)
+				pRef[k] += nRefPitch;
+		}
+	}
+	else if (nBlkWidth == 8)
+	{
+		// Two rows per register
+		int y = 0;
+		for ( ; y + 1 < nBlkHeight; y += 2)
+		{
+			const __m128i s = _mm_unpacklo_epi64(
+				_mm_loadl_epi64((const __m128i *)(pSrc            )),
+				_mm_loadl_epi64((const __m128i *)(pSrc + nSrcPitch)));
+			for (int k = 0; k < NBR_REF; k++)
+			{
+				const __m128i r = _mm_unpacklo_epi64(
+					_mm_loadl_epi64((const __m128i *)(pRef[k]            )),
+					_mm_loadl_epi64((const __m128i *)(pRef[k] + nRefPitch)));
+				acc[k] = _mm_add_epi64(acc[k], _mm_sad_epu8(s, r));
+				pRef[k] += nRefPitch * 2;
+			}
+			pSrc += nSrcPitch * 2;
+		}
+		if (y < nBlkHeight)	// 8x1
+		{
+			const __m128i s = _mm_loadl_epi64((const __m128i *)pSrc);
+			for (int k = 0; k < NBR_REF; k++)
+			{
+				const __m128i r = _mm_loadl_epi64((const __m128i *)pRef[k]);
+				acc[k] = _mm_add_epi64(acc[k], _mm_sad_epu8(s, r));
+			}
+		}
+	}
+	else if (nBlkWidth == 4)
+	{
+		// Two rows per register, upper half is zero on both sides
+		for (int y = 0; y < nBlkHeight; y += 2)
+		{
+			const __m128i s = _mm_unpacklo_epi32(
+				_mm_cvtsi32_si128(*(const int *)(pSrc            )),
+				_mm_cvtsi32_si128(*(const int *)(pSrc + nSrcPitch)));
+			for (int k = 0; k < NBR_REF; k++)
+			{
+				const __m128i r = _mm_unpacklo_epi32(
+					_mm_cvtsi32_si128(*(const int *)(pRef[k]            )),
+					_mm_cvtsi32_si128(*(const int *)(pRef[k] + nRefPitch)));
+				acc[k] = _mm_add_epi64(acc[k], _mm_sad_epu8(s, r));
+				pRef[k] += nRefPitch * 2;
+			}
+			pSrc += nSrcPitch * 2;
+		}
+	}
+	else
+	{
+		SadMulti_C<nBlkWidth, nBlkHeight>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch, NBR_REF);
+		return;
+	}
+
+	for (int k = 0; k < NBR_REF; k++)
+	{
+		sad_arr[k] = _mm_cvtsi128_si32(acc[k]) + _mm_cvtsi128_si32(_mm_srli_si128(acc[k], 8));
+	}
+}
+
+template<int nBlkWidth, int nBlkHeight>
+void SadMulti_sse2(unsigned int sad_arr [], const uint8_t *pSrc, int nSrcPitch,
+                   const uint8_t * const pRef_arr [], int nRefPitch, int nbr_ref)
+{
+	assert (nbr_ref > 0 && nbr_ref <= SAD_MULTI_MAX);
+
+	switch (nbr_ref)
+	{
+	case 1: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 1>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	case 2: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 2>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	case 3: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 3>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	case 4: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 4>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	case 5: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 5>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	case 6: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 6>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	case 7: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 7>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	case 8: SadMulti_sse2_n<nBlkWidth, nBlkHeight, 8>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch); break;
+	default:
+		SadMulti_C<nBlkWidth, nBlkHeight>(sad_arr, pSrc, nSrcPitch, pRef_arr, nRefPitch, nbr_ref);
+		break;
+	}
+}
+
+
+
+// SAD with early termination: the partial SAD is checked against thr every
+// few rows, and the function returns as soon as it reaches thr. Therefore
+// the result is the exact SAD if it is below thr, otherwise any value >= thr.
+// Used to reject the candidates that cannot beat the current best vector.
+
+typedef unsigned int (SADThrFunction)(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef,
+                                      int nRefPitch, unsigned int thr);
+
+// Checked every 4 rows. Only for widths >= 8 and heights multiple of 4,
+// early termination is pointless on smaller blocks.
+template<int nBlkWidth, int nBlkHeight>
+unsigned int SadThr_sse2(const uint8_t *pSrc, int nSrcPitch, const uint8_t *pRef,
+                         int nRefPitch, unsigned int thr)
+{
+	assert (nBlkWidth >= 8 && (nBlkHeight & 3) == 0);
+
+	__m128i acc = _mm_setzero_si128();
+	unsigned int sum = 0;
+	for (int y = 0; y < nBlkHeight; y += 4)
+	{
+		if (nBlkWidth == 8)
+		{
+			for (int k = 0; k < 4; k += 2)
+			{
+				const __m128i s = _mm_unpacklo_epi64(
+					_mm_loadl_epi64((const __m128i *)(pSrc            )),
+					_mm_loadl_epi64((const __m128i *)(pSrc + nSrcPitch)));
+				const __m128i r = _mm_unpacklo_epi64(
+					_mm_loadl_epi64((const __m128i *)(pRef            )),
+					_mm_loadl_epi64((const __m128i *)(pRef + nRefPitch)));
+				acc = _mm_add_epi64(acc, _mm_sad_epu8(s, r));
+				pSrc += nSrcPitch * 2;
+				pRef += nRefPitch * 2;
+			}
+		}
+		else
+		{
+			for (int k = 0; k < 4; k++)
+			{
+				for (int x = 0; x < nBlkWidth; x += 16)
+				{
+					const __m128i s = _mm_loadu_si128((const __m128i *)(pSrc + x));
+					const __m128i r = _mm_loadu_si128((const __m128i *)(pRef + x));
+					acc = _mm_add_epi64(acc, _mm_sad_epu8(s, r));
+				}
+				pSrc += nSrcPitch;
+				pRef += nRefPitch;
+			}
+		}
+		sum = _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+		if (sum >= thr)
+			break;
+	}
+	return sum;
+}
+
+
+
+// SAD map: scores the source block against every reference block of a
+// nbr_x * nbr_y window, in a single call. The window starts at pRef and the
+// blocks are one pixel apart. The SAD of the block at (x, y) is stored in
+// sad_arr [y * sad_stride + x]. Nothing outside the window is read, so it can
+// be clipped to the search boundaries by the caller.
+
+typedef void (SADMapFunction)(unsigned int sad_arr [], int sad_stride, const uint8_t *pSrc, int nSrcPitch,
+                              const uint8_t *pRef, int nRefPitch, int nbr_x, int nbr_y);
+
+template<int nBlkWidth, int nBlkHeight>
+void SadMap_C(unsigned int sad_arr [], int sad_stride, const uint8_t *pSrc, int nSrcPitch,
+              const uint8_t *pRef, int nRefPitch, int nbr_x, int nbr_y)
+{
+	assert (nbr_x > 0 && nbr_x <= sad_stride);
+	assert (nbr_y > 0);
+
+	for ( int y = 0; y < nbr_y; y++ )
+	{
+		for ( int x = 0; x < nbr_x; x++ )
+		{
+			sad_arr[x] = Sad_C<nBlkWidth, nBlkHeight>(pSrc, nSrcPitch, pRef + x, nRefPitch);
+		}
+		sad_arr += sad_stride;
+		pRef += nRefPitch;
+	}
+}
+
+// Consecutive offsets are batched SAD_MULTI_MAX at a time, so each source row
+// is loaded once per batch.
+template<int nBlkWidth, int nBlkHeight>
+void SadMap_sse2(unsigned int sad_arr [], int sad_stride, const uint8_t *pSrc, int nSrcPitch,
+                 const uint8_t *pRef, int nRefPitch, int nbr_x, int nbr_y)
+{
+	assert (nbr_x > 0 && nbr_x <= sad_stride);
+	assert (nbr_y > 0);
+
+	const uint8_t *pRef_arr[SAD_MULTI_MAX];
+	for ( int y = 0; y < nbr_y; y++ )
+	{
+		for ( int x = 0; x < nbr_x; x += SAD_MULTI_MAX )
+		{
+			const int n = (nbr_x - x < SAD_MULTI_MAX) ? nbr_x - x : SAD_MULTI_MAX;
+			for ( int k = 0; k < n; k++ )
+				pRef_arr[k] = pRef + x + k;
+			SadMulti_sse2<nBlkWidth, nBlkHeight>(sad_arr + x, pSrc, nSrcPitch, pRef_arr, nRefPitch, n);
+		}
+		sad_arr += sad_stride;
+		pRef += nRefPitch;
+	}
+}
+
+
 #endif
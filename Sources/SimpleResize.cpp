@@ -42,6 +42,9 @@
 
 #include	"malloc.h"
 
+#include	<new>
+#include	<vector>
+
 #if !defined(_M_X64)
 #define rax	eax
 #define rbx	ebx
@@ -68,7 +71,11 @@
 
 
 SimpleResize::SimpleResize(int _newwidth, int _newheight, int _oldwidth, int _oldheight, long CPUFlags)
+:	_work_fact (_oldwidth)
+,	_work_pool ()
 {
+		_work_pool.set_factory (_work_fact);
+
 		oldwidth = _oldwidth;
 		oldheight = _oldheight;
 		newwidth = _newwidth;
@@ -118,6 +125,110 @@ SimpleResize::~SimpleResize()
 // YV12 Luma
 void SimpleResize::SimpleResizeDo(uint8_t *dstp,  int row_size, int height, int dst_pitch, 
 						  const uint8_t* srcp, int src_row_size, int src_pitch, int Planar_Type) 
+{
+	SimpleResizeDoRows(dstp, row_size, height, dst_pitch, srcp, src_row_size, src_pitch, Planar_Type,
+		0, height, vWorkY);
+}
+
+// Resizes only the destination rows y_beg to y_end - 1 (dstp still points to
+// the first row of the plane). The work line is borrowed from the pool, so
+// several threads can resize different rows of the same planes at the same
+// time.
+void SimpleResize::SimpleResizeDo(uint8_t *dstp,  int row_size, int height, int dst_pitch, 
+						  const uint8_t* srcp, int src_row_size, int src_pitch, int Planar_Type,
+						  int y_beg, int y_end) 
+{
+	WorkLines &		work = take_work_lines ();
+	SimpleResizeDoRows(dstp, row_size, height, dst_pitch, srcp, src_row_size, src_pitch, Planar_Type,
+		y_beg, y_end, &work._row [0]);
+	_work_pool.return_obj (work);
+}
+
+// Resizes a map of interleaved (vx, vy) 16-bit vectors, rows y_beg to
+// y_end - 1. Pitches are in int16_t. The source vectors are divided by
+// 2^shift_x and 2^shift_y before the interpolation, to get chroma vectors
+// from the luma ones. Plain C, but there is no clamping to 8 bits.
+void SimpleResize::SimpleResizeDoVect(int16_t *dstp, int dst_pitch, const int16_t* srcp, int src_pitch,
+						  int y_beg, int y_end, int shift_x, int shift_y)
+{
+	WorkLines &		work_lines = take_work_lines ();
+	std::vector <int> &	work = work_lines._vect;
+
+	dstp += y_beg * dst_pitch;
+	for (int y = y_beg; y < y_end; y++)
+	{
+		const int w2 = vWeights[y];
+		const int w1 = 256 - w2;
+		const int16_t* srcp1 = srcp + vOffsets[y] * src_pitch;
+		const int16_t* srcp2 = (w2 != 0) ? srcp1 + src_pitch : srcp1;
+
+		for (int x = 0; x < oldwidth; x++)
+		{
+			work[x*2  ] = ((srcp1[x*2  ] >> shift_x) * w1 + (srcp2[x*2  ] >> shift_x) * w2 + 128) >> 8;
+			work[x*2+1] = ((srcp1[x*2+1] >> shift_y) * w1 + (srcp2[x*2+1] >> shift_y) * w2 + 128) >> 8;
+		}
+		work[oldwidth*2  ] = work[oldwidth*2-2];
+		work[oldwidth*2+1] = work[oldwidth*2-1];
+
+		// hControl is organised by pairs of pixels: 2 weights, then 2 offsets
+		for (int x = 0; x < newwidth; x++)
+		{
+			const int ctl = (x & ~1) * 3 + (x & 1);
+			const int hw1 = hControl[ctl] & 0xFFFF;
+			const int hw2 = hControl[ctl] >> 16;
+			const int ofs = hControl[ctl + 4] * 2;
+			dstp[x*2  ] = int16_t ((work[ofs  ] * hw1 + work[ofs+2] * hw2 + 128) >> 8);
+			dstp[x*2+1] = int16_t ((work[ofs+1] * hw1 + work[ofs+3] * hw2 + 128) >> 8);
+		}
+
+		dstp += dst_pitch;
+	}
+
+	_work_pool.return_obj (work_lines);
+}
+
+SimpleResize::WorkLines::WorkLines (int oldwidth)
+:	_row ((2 * oldwidth + 128 + sizeof (unsigned int) - 1) / sizeof (unsigned int))
+,	_vect ((oldwidth + 1) * 2)	// One more pair to read the right neighbour of the last pixel
+{
+	// Nothing
+}
+
+SimpleResize::WorkLinesFactory::WorkLinesFactory (int oldwidth)
+:	_oldwidth (oldwidth)
+{
+	// Nothing
+}
+
+SimpleResize::WorkLines *	SimpleResize::WorkLinesFactory::do_create ()
+{
+	WorkLines *		work_ptr = 0;
+	try
+	{
+		work_ptr = new WorkLines (_oldwidth);
+	}
+	catch (...)
+	{
+		work_ptr = 0;
+	}
+
+	return (work_ptr);
+}
+
+SimpleResize::WorkLines &	SimpleResize::take_work_lines ()
+{
+	WorkLines *		work_ptr = _work_pool.take_obj ();
+	if (work_ptr == 0)
+	{
+		throw std::bad_alloc ();
+	}
+
+	return (*work_ptr);
+}
+
+void SimpleResize::SimpleResizeDoRows(uint8_t *dstp,  int row_size, int height, int dst_pitch, 
+						  const uint8_t* srcp, int src_row_size, int src_pitch, int Planar_Type,
+						  int y_beg, int y_end, unsigned int* vWorkYW) 
 {
 // Note: PlanarType is dummy, I (Fizick) do not use croma planes code for resize in MVTools
 
@@ -146,7 +257,6 @@ void SimpleResize::SimpleResizeDo(uint8_t *dstp,  int row_size, int height, int
 
     const unsigned char* srcp1;
     const unsigned char* srcp2;
-	unsigned int* vWorkYW = vWorkY;
 	
 	unsigned int* vOffsetsW = (Planar_Type == PLANAR_Y)
 		? vOffsets
@@ -165,7 +275,8 @@ void SimpleResize::SimpleResizeDo(uint8_t *dstp,  int row_size, int height, int
 	
 	// Just in case things are not aligned right, maybe turn off sse2
 
-	for (int y = 0; y < height; y++)
+	dstp += y_beg * dst_pitch;
+	for (int y = y_beg; y < y_end; y++)
 	{
 
 		vWeight1[0] = vWeight1[1] = vWeight1[2] = vWeight1[3] = 
@@ -20,8 +20,13 @@
 #ifndef __SIMPLERESIZE__
 #define __SIMPLERESIZE__
 
+#include	"AllocAlign.h"
+#include	"conc/ObjFactoryInterface.h"
+#include	"conc/ObjPool.h"
 #include	"types.h"
 
+#include	<vector>
+
 
 
 class SimpleResize 
@@ -42,13 +47,53 @@ class SimpleResize
 	bool SSE2enabled; 
 	bool SSEMMXenabled; 
 
+	// Work lines of the functions processing a range of rows. Several threads
+	// may resize different rows at the same time, so each one borrows its
+	// own lines from the pool. They are allocated once and kept until the
+	// resizer is destroyed.
+	class WorkLines
+	{
+	public:
+		explicit			WorkLines (int oldwidth);
+		std::vector <unsigned int, AllocAlign <unsigned int, 128> >
+							_row;		// SimpleResizeDoRows(), same size as vWorkY
+		std::vector <int>
+							_vect;	// SimpleResizeDoVect(), (vx, vy) pairs + 1
+	};
+
+	class WorkLinesFactory
+	:	public conc::ObjFactoryInterface <WorkLines>
+	{
+	public:
+		explicit			WorkLinesFactory (int oldwidth);
+	protected:
+		// conc::ObjFactoryInterface
+		virtual WorkLines *
+							do_create ();
+	private:
+		int				_oldwidth;
+	};
+
+	WorkLinesFactory	_work_fact;
+	conc::ObjPool <WorkLines>
+						_work_pool;
+
 	void InitTables_YV12(void);
+	void SimpleResizeDoRows(uint8_t *dstp,  int dst_row_size, int dst_height, int dst_pitch, 
+						  const uint8_t* srcp, int src_row_size, int src_pitch, int Plane_Type,
+						  int y_beg, int y_end, unsigned int* vWorkYW);
+	WorkLines &		take_work_lines ();
 
 public:
 	SimpleResize(int _newwidth, int _newheight, int _oldwidth, int _oldheight, long CPUFlags);
 	~SimpleResize();
 	void SimpleResizeDo(uint8_t *dstp,  int dst_row_size, int dst_height, int dst_pitch, 
 						  const uint8_t* srcp, int src_row_size, int src_pitch, int Plane_Type); 
+	void SimpleResizeDo(uint8_t *dstp,  int dst_row_size, int dst_height, int dst_pitch, 
+						  const uint8_t* srcp, int src_row_size, int src_pitch, int Plane_Type,
+						  int y_beg, int y_end); 
+	void SimpleResizeDoVect(int16_t *dstp, int dst_pitch, const int16_t* srcp, int src_pitch,
+						  int y_beg, int y_end, int shift_x, int shift_y);
 };
 
 
@@ -0,0 +1,274 @@
+/*****************************************************************************
+
+        SuperFrameCache.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/CritSec.h"
+#include	"SuperFrameCache.h"
+
+#include	<climits>
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// Each call must be balanced with a call to remove_client(). Call it once
+// the filter construction cannot fail anymore.
+void	SuperFrameCache::add_client (const ::PClip &super)
+{
+	assert (super);
+
+	conc::CritSec	lock (_mutex);
+
+	++ _client_map [super.operator -> ()];
+}
+
+
+
+// When the last client of a clip is removed, all its frames are released.
+void	SuperFrameCache::remove_client (const ::PClip &super)
+{
+	assert (super);
+
+	const ::IClip *	clip_ptr = super.operator -> ();
+	FrameList		released;	// Frames are released after unlocking
+
+	{
+		conc::CritSec	lock (_mutex);
+
+		ClientMap::iterator	it_client = _client_map.find (clip_ptr);
+		assert (it_client != _client_map.end ());
+		assert (it_client->second > 0);
+		-- it_client->second;
+		if (it_client->second == 0)
+		{
+			_client_map.erase (it_client);
+
+			FrameMap::iterator	it = _frame_map.lower_bound (
+				Key (clip_ptr, View (0), INT_MIN)
+			);
+			while (it != _frame_map.end () && it->first._clip_ptr == clip_ptr)
+			{
+				released.push_back (it->second._frame);
+				_mem_used -= it->second._size;
+				_lru_list.erase (it->second._lru_it);
+				_frame_map.erase (it ++);
+			}
+		}
+	}
+}
+
+
+
+/*
+==============================================================================
+Name: get_frame
+Description:
+	Gets a frame from the cache, or from the clip if it is not cached yet.
+Input parameters:
+	- super: the super clip, used as key.
+	- n: frame number.
+	- view: which kind of frame derived from the super clip is requested.
+	- gen_clip_ptr: clip generating the requested view from super, for
+		example a MVFinest instance. 0 to use super directly.
+Input/output parameters:
+	- env: Avisynth environment, used to fetch the missing frames.
+Returns: The frame.
+==============================================================================
+*/
+
+::PVideoFrame	SuperFrameCache::get_frame (const ::PClip &super, int n, ::IScriptEnvironment &env, View view, const ::PClip *gen_clip_ptr)
+{
+	assert (super);
+	assert (view >= 0);
+	assert (view < View_NBR_ELT);
+	assert (view == View_SUPER || gen_clip_ptr != 0);
+
+	const Key		key (super.operator -> (), view, n);
+	bool				cacheable_flag = false;
+
+	{
+		conc::CritSec	lock (_mutex);
+
+		if (_budget > 0 && _client_map.find (key._clip_ptr) != _client_map.end ())
+		{
+			FrameMap::iterator	it = _frame_map.find (key);
+			if (it != _frame_map.end ())
+			{
+				_lru_list.splice (_lru_list.begin (), _lru_list, it->second._lru_it);
+
+				return (it->second._frame);
+			}
+
+			cacheable_flag = true;
+		}
+	}
+
+	// Not locked here, the upstream filters may take a while
+	const ::PClip &	gen_clip = (gen_clip_ptr != 0) ? *gen_clip_ptr : super;
+	::PVideoFrame	frame = gen_clip->GetFrame (n, &env);
+	if (cacheable_flag)
+	{
+		insert (key, frame);
+	}
+
+	return (frame);
+}
+
+
+
+// Returns the previous budget, in MB. 0 disables the cache.
+int	SuperFrameCache::set_budget (int budget_mb)
+{
+	assert (budget_mb >= 0);
+
+	int				prev_mb;
+	FrameList		released;
+
+	{
+		conc::CritSec	lock (_mutex);
+
+		prev_mb = int (_budget >> 20);
+		_budget = int64_t (budget_mb) << 20;
+		evict (released);
+	}
+
+	return (prev_mb);
+}
+
+
+
+int	SuperFrameCache::get_budget ()
+{
+	conc::CritSec	lock (_mutex);
+
+	return (int (_budget >> 20));
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+SuperFrameCache::Key::Key (const ::IClip *clip_ptr, View view, int frame)
+:	_clip_ptr (clip_ptr)
+,	_view (view)
+,	_frame (frame)
+{
+	// Nothing
+}
+
+
+
+// Frames are grouped by clip, so they can be purged at once.
+bool	SuperFrameCache::Key::operator < (const Key &other) const
+{
+	if (_clip_ptr != other._clip_ptr)
+	{
+		return (_clip_ptr < other._clip_ptr);
+	}
+	if (_view != other._view)
+	{
+		return (_view < other._view);
+	}
+
+	return (_frame < other._frame);
+}
+
+
+
+// The frame may have been inserted by another thread in the meantime, or
+// its clip may have lost all its clients.
+void	SuperFrameCache::insert (const Key &key, const ::PVideoFrame &frame)
+{
+	FrameList		released;
+
+	{
+		conc::CritSec	lock (_mutex);
+
+		if (   _client_map.find (key._clip_ptr) != _client_map.end ()
+		    && _frame_map.find (key) == _frame_map.end ())
+		{
+			_lru_list.push_front (key);
+
+			Entry				entry;
+			entry._frame  = frame;
+			entry._size   = compute_size (frame);
+			entry._lru_it = _lru_list.begin ();
+			_frame_map.insert (FrameMap::value_type (key, entry));
+			_mem_used += entry._size;
+
+			evict (released);
+		}
+	}
+}
+
+
+
+// Must be called with _mutex locked. The evicted frames are moved to
+// released, so the caller can destroy them once unlocked.
+void	SuperFrameCache::evict (FrameList &released)
+{
+	while (_mem_used > _budget && ! _lru_list.empty ())
+	{
+		FrameMap::iterator	it = _frame_map.find (_lru_list.back ());
+		assert (it != _frame_map.end ());
+		released.push_back (it->second._frame);
+		_mem_used -= it->second._size;
+		_frame_map.erase (it);
+		_lru_list.pop_back ();
+	}
+}
+
+
+
+int64_t	SuperFrameCache::compute_size (const ::PVideoFrame &frame)
+{
+	// For interleaved formats, the chroma pitch and height are 0.
+	return (
+		  int64_t (frame->GetPitch ())         * frame->GetHeight ()
+		+ int64_t (frame->GetPitch (PLANAR_U)) * frame->GetHeight (PLANAR_U) * 2
+	);
+}
+
+
+
+SuperFrameCache::FrameMap	SuperFrameCache::_frame_map;
+SuperFrameCache::LruList	SuperFrameCache::_lru_list;
+SuperFrameCache::ClientMap	SuperFrameCache::_client_map;
+int64_t	SuperFrameCache::_mem_used = 0;
+int64_t	SuperFrameCache::_budget   = int64_t (DEFAULT_BUDGET_MB) << 20;
+conc::Mutex	SuperFrameCache::_mutex;
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,170 @@
+/*****************************************************************************
+
+        SuperFrameCache.h
+        Author: agent, 2026
+
+Process-wide cache of the frames of the super clips, shared by all the
+filters reading them (MDegrain*, MCompensate, MFlow*, MBlockFps...). When
+several filters work on the same super clip, each super frame is requested
+only once from the upstream filters instead of once per consumer and per
+temporal reference, even if the Avisynth cache is too small to keep them.
+
+A filter registers the super clip it uses with add_client() and releases it
+with remove_client(). Frames of a clip are only cached while the clip has
+clients, so a destroyed clip can never be confused with a new one allocated
+at the same address. Requests for an unregistered clip are passed through.
+
+The frames of the finest plane (MFinest) derived from a super clip are
+cached too, with their own view tag, so MFlow filters sharing a super clip
+compute them once.
+
+The memory budget is global and can be changed with MSuperCache(). When it
+is exceeded, the least recently used frames are released. A null budget
+disables the cache.
+
+Only the frames are shared. The MVGroupOfFrames views stay in the filters
+because they carry per-filter settings and state, and their update is just
+pointer arithmetic.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (SuperFrameCache_HEADER_INCLUDED)
+#define	SuperFrameCache_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/Mutex.h"
+#include	"types.h"
+
+#define	NOGDI
+#define	NOMINMAX
+#define	WIN32_LEAN_AND_MEAN
+#include "Windows.h"
+#include	"avisynth.h"
+
+#include	<list>
+#include	<map>
+#include	<vector>
+
+
+
+class SuperFrameCache
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			DEFAULT_BUDGET_MB	= 128	};
+
+	enum View
+	{
+		View_SUPER = 0,
+		View_FINEST,
+
+		View_NBR_ELT
+	};
+
+	static void		add_client (const ::PClip &super);
+	static void		remove_client (const ::PClip &super);
+	static ::PVideoFrame
+						get_frame (const ::PClip &super, int n, ::IScriptEnvironment &env, View view = View_SUPER, const ::PClip *gen_clip_ptr = 0);
+	static int		set_budget (int budget_mb);
+	static int		get_budget ();
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class Key
+	{
+	public:
+							Key (const ::IClip *clip_ptr, View view, int frame);
+		bool				operator < (const Key &other) const;
+		const ::IClip*	_clip_ptr;
+		View				_view;
+		int				_frame;
+	};
+
+	typedef	std::list <Key>	LruList;	// Most recently used first
+
+	class Entry
+	{
+	public:
+		::PVideoFrame	_frame;
+		int64_t			_size;		// Bytes
+		LruList::iterator
+							_lru_it;
+	};
+
+	typedef	std::map <Key, Entry>	FrameMap;
+	typedef	std::map <const ::IClip *, int>	ClientMap;	// Number of clients
+	typedef	std::vector < ::PVideoFrame>	FrameList;
+
+	static void		insert (const Key &key, const ::PVideoFrame &frame);
+	static void		evict (FrameList &released);
+	static int64_t	compute_size (const ::PVideoFrame &frame);
+
+	// All protected by _mutex
+	static FrameMap
+						_frame_map;
+	static LruList	_lru_list;
+	static ClientMap
+						_client_map;
+	static int64_t	_mem_used;		// Bytes
+	static int64_t	_budget;			// Bytes
+	static conc::Mutex
+						_mutex;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						SuperFrameCache ();
+						SuperFrameCache (const SuperFrameCache &other);
+	virtual			~SuperFrameCache () {}
+	SuperFrameCache &
+						operator = (const SuperFrameCache &other);
+	bool				operator == (const SuperFrameCache &other) const;
+	bool				operator != (const SuperFrameCache &other) const;
+
+};	// class SuperFrameCache
+
+
+
+//#include	"SuperFrameCache.hpp"
+
+
+
+#endif	// SuperFrameCache_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
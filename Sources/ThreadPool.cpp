@@ -0,0 +1,435 @@
+/*****************************************************************************
+
+        ThreadPool.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#if defined (_WIN32)
+	#define	NOGDI
+	#define	NOMINMAX
+	#define	WIN32_LEAN_AND_MEAN
+	#include	"Windows.h"
+#else
+	#include	<pthread.h>
+	#include	<sched.h>
+#endif
+
+#include	"ThreadPool.h"
+
+#include	<algorithm>
+#include	<system_error>
+
+#include	<cassert>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*
+==============================================================================
+Name: ctor
+Description:
+	Creates the pool and starts the worker threads.
+Input parameters:
+	- nbr_threads: Total number of threads processing the tasks, including
+		the thread waiting for the completion. Range [1 ; MAX_NBR_THREADS].
+	- affinity_mask: Set of the logical CPUs the workers are bound to, one
+		bit per CPU. The workers are distributed over these CPUs, starting
+		from the second one. 0 lets the system schedule them freely.
+Throws: std::bad_alloc, or something related to the mutex creation.
+	If a thread cannot be created, the pool continues with fewer threads.
+==============================================================================
+*/
+
+ThreadPool::ThreadPool (int nbr_threads, uint64_t affinity_mask)
+:	_nbr_workers (0)
+,	_affinity_mask (affinity_mask)
+,	_cell_pool ()
+,	_queue_shared ()
+,	_queue_arr ()
+,	_thread_arr ()
+,	_thread_id_arr ()
+,	_nbr_queued (0)
+,	_nbr_sleeping (0)
+,	_nbr_running (0)
+,	_quit_flag (false)
+,	_mutex ()
+,	_cond ()
+{
+	assert (nbr_threads > 0);
+
+	nbr_threads = std::max (std::min (nbr_threads, int (MAX_NBR_THREADS)), 1);
+
+	_cell_pool.expand_to (1024);
+
+	// The workers wait for the lock release before processing anything, so
+	// the thread identifiers are all set before use.
+	std::lock_guard <std::mutex>	lock (_mutex);
+
+	bool				cont_flag = true;
+	for (int thread_index = 0
+	;	thread_index < nbr_threads - 1 && cont_flag
+	;	++ thread_index)
+	{
+		try
+		{
+			_thread_arr [thread_index] =
+				std::thread (&ThreadPool::worker_loop, this, thread_index);
+			_thread_id_arr [thread_index] = _thread_arr [thread_index].get_id ();
+			++ _nbr_running;
+			++ _nbr_workers;
+
+			if (_affinity_mask != 0)
+			{
+				set_affinity (_thread_arr [thread_index], thread_index);
+			}
+		}
+		catch (std::system_error &)
+		{
+			cont_flag = false;
+		}
+	}
+}
+
+
+
+/*
+==============================================================================
+Name: dtor
+Description:
+	Stops the workers. There should be no dispatcher in use at this point.
+	The threads are not joined, because the pool may be destroyed while the
+	module is being unloaded, where waiting for a thread termination would
+	deadlock. We just wait for them to leave their processing loop.
+	Never destroy the pool when the process is terminating: the workers
+	have already been killed and would never leave the loop. See
+	AvstpWrapper::notify_process_exit().
+==============================================================================
+*/
+
+ThreadPool::~ThreadPool ()
+{
+	{
+		std::lock_guard <std::mutex>	lock (_mutex);
+		_quit_flag = true;
+		_cond.notify_all ();
+	}
+
+	while (_nbr_running > 0)
+	{
+		std::this_thread::yield ();
+	}
+
+	for (int thread_index = 0; thread_index < _nbr_workers; ++thread_index)
+	{
+		_thread_arr [thread_index].detach ();
+	}
+}
+
+
+
+// Number of logical CPUs available on the system. Always > 0.
+int	ThreadPool::get_nbr_cpus ()
+{
+	const int		nbr_cpus = int (std::thread::hardware_concurrency ());
+
+	return (std::max (nbr_cpus, 1));
+}
+
+
+
+avstp_TaskDispatcher *	ThreadPool::create_dispatcher ()
+{
+	Dispatcher *	disp_ptr = new Dispatcher;
+	disp_ptr->_nbr_pending    = 0;
+	disp_ptr->_exception_flag = 0;
+
+	return (reinterpret_cast <avstp_TaskDispatcher *> (disp_ptr));
+}
+
+
+
+void	ThreadPool::destroy_dispatcher (avstp_TaskDispatcher *td_ptr)
+{
+	Dispatcher &	disp = conv_dispatcher (td_ptr);
+	assert (disp._nbr_pending == 0);
+
+	delete &disp;
+}
+
+
+
+int	ThreadPool::get_nbr_threads () const
+{
+	return (_nbr_workers + 1);
+}
+
+
+
+int	ThreadPool::enqueue_task (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr)
+{
+	if (td_ptr == 0 || task_ptr == 0)
+	{
+		return (avstp_Err_INVALID_ARG);
+	}
+
+	Dispatcher &	disp = conv_dispatcher (td_ptr);
+
+	TaskCell *		cell_ptr = _cell_pool.take_cell (true);
+	if (cell_ptr == 0)
+	{
+		// Out of memory, executes the task synchronously.
+		task_ptr (td_ptr, user_data_ptr);
+
+		return (avstp_Err_OK);
+	}
+
+	++ disp._nbr_pending;
+
+	TaskEntry &		task = cell_ptr->_val;
+	task._disp_ptr      = &disp;
+	task._task_ptr      = task_ptr;
+	task._user_data_ptr = user_data_ptr;
+
+	// Tasks enqueued from a worker are kept local, hoping they will use the
+	// data still in the cache of this CPU.
+	const int		thread_index = find_thread_index ();
+	TaskQueue &		queue =
+		(thread_index >= 0) ? _queue_arr [thread_index] : _queue_shared;
+	queue.enqueue (*cell_ptr);
+	++ _nbr_queued;
+
+	// A thread checks _nbr_queued after incrementing _nbr_sleeping, so at
+	// least one of them sees the change of the other.
+	if (_nbr_sleeping > 0)
+	{
+		std::lock_guard <std::mutex>	lock (_mutex);
+		_cond.notify_one ();
+	}
+
+	return (avstp_Err_OK);
+}
+
+
+
+// The calling thread processes the queued tasks (from any dispatcher) while
+// waiting.
+int	ThreadPool::wait_completion (avstp_TaskDispatcher *td_ptr)
+{
+	if (td_ptr == 0)
+	{
+		return (avstp_Err_INVALID_ARG);
+	}
+
+	Dispatcher &	disp = conv_dispatcher (td_ptr);
+	const int		thread_index = find_thread_index ();
+
+	while (disp._nbr_pending > 0)
+	{
+		if (! run_one_task (thread_index))
+		{
+			std::unique_lock <std::mutex>	lock (_mutex);
+			++ _nbr_sleeping;
+			while (disp._nbr_pending > 0 && _nbr_queued <= 0)
+			{
+				_cond.wait (lock);
+			}
+			-- _nbr_sleeping;
+		}
+	}
+
+	return ((disp._exception_flag != 0) ? avstp_Err_EXCEPTION : avstp_Err_OK);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+void	ThreadPool::worker_loop (int thread_index)
+{
+	assert (thread_index >= 0);
+
+	// Waits for the end of the construction
+	{
+		std::lock_guard <std::mutex>	lock (_mutex);
+	}
+
+	while (! _quit_flag)
+	{
+		if (! run_one_task (thread_index))
+		{
+			std::unique_lock <std::mutex>	lock (_mutex);
+			++ _nbr_sleeping;
+			while (! _quit_flag && _nbr_queued <= 0)
+			{
+				_cond.wait (lock);
+			}
+			-- _nbr_sleeping;
+		}
+	}
+
+	-- _nbr_running;
+}
+
+
+
+// Returns the index of the calling thread if it is a worker, or -1.
+int	ThreadPool::find_thread_index () const
+{
+	const std::thread::id	cur_id = std::this_thread::get_id ();
+
+	int				thread_index = -1;
+	for (int k = 0; k < _nbr_workers && thread_index < 0; ++k)
+	{
+		if (_thread_id_arr [k] == cur_id)
+		{
+			thread_index = k;
+		}
+	}
+
+	return (thread_index);
+}
+
+
+
+// Looks for a task in the own queue of the thread, then in the shared queue,
+// then steals it from the other workers.
+ThreadPool::TaskCell *	ThreadPool::pop_task (int thread_index)
+{
+	TaskCell *		cell_ptr = 0;
+
+	if (thread_index >= 0)
+	{
+		cell_ptr = _queue_arr [thread_index].dequeue ();
+	}
+
+	if (cell_ptr == 0)
+	{
+		cell_ptr = _queue_shared.dequeue ();
+	}
+
+	const int		start = std::max (thread_index, 0);
+	for (int k = 1; k <= _nbr_workers && cell_ptr == 0; ++k)
+	{
+		const int		victim = (start + k) % _nbr_workers;
+		if (victim != thread_index)
+		{
+			cell_ptr = _queue_arr [victim].dequeue ();
+		}
+	}
+
+	return (cell_ptr);
+}
+
+
+
+// Returns false if there was no task to run.
+bool	ThreadPool::run_one_task (int thread_index)
+{
+	TaskCell *		cell_ptr = pop_task (thread_index);
+	if (cell_ptr == 0)
+	{
+		return (false);
+	}
+
+	-- _nbr_queued;
+	const TaskEntry	task = cell_ptr->_val;
+	_cell_pool.return_cell (*cell_ptr);
+
+	Dispatcher &	disp = *(task._disp_ptr);
+	try
+	{
+		task._task_ptr (
+			reinterpret_cast <avstp_TaskDispatcher *> (&disp),
+			task._user_data_ptr
+		);
+	}
+	catch (...)
+	{
+		disp._exception_flag = 1;
+	}
+
+	// The dispatcher may be destroyed as soon as its counter reaches 0, so
+	// it must not be accessed after this point.
+	const conc::AioSub <int>	dec_ftor (1);
+	const int		nbr_left =
+		conc::AtomicIntOp::exec_new (disp._nbr_pending, dec_ftor);
+	if (nbr_left <= 0)
+	{
+		std::lock_guard <std::mutex>	lock (_mutex);
+		_cond.notify_all ();
+	}
+
+	return (true);
+}
+
+
+
+// Binds the worker to one of the CPUs of the affinity mask. The first CPU
+// is left to the thread waiting for the completion.
+void	ThreadPool::set_affinity (std::thread &thr, int thread_index)
+{
+	assert (_affinity_mask != 0);
+
+	int				cpu_list [64];
+	int				nbr_cpus = 0;
+	for (int cpu = 0; cpu < 64; ++cpu)
+	{
+		if (((_affinity_mask >> cpu) & 1) != 0)
+		{
+			cpu_list [nbr_cpus] = cpu;
+			++ nbr_cpus;
+		}
+	}
+	const int		cpu = cpu_list [(thread_index + 1) % nbr_cpus];
+
+#if defined (_WIN32)
+	::SetThreadAffinityMask (thr.native_handle (), DWORD_PTR (1) << cpu);
+#else
+	::cpu_set_t		cpu_set;
+	CPU_ZERO (&cpu_set);
+	CPU_SET (cpu, &cpu_set);
+	::pthread_setaffinity_np (thr.native_handle (), sizeof (cpu_set), &cpu_set);
+#endif
+}
+
+
+
+ThreadPool::Dispatcher &	ThreadPool::conv_dispatcher (avstp_TaskDispatcher *td_ptr)
+{
+	assert (td_ptr != 0);
+
+	return (*reinterpret_cast <Dispatcher *> (td_ptr));
+}
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -0,0 +1,168 @@
+/*****************************************************************************
+
+        ThreadPool.h
+        Author: agent, 2026
+
+Built-in implementation of the AVSTP task dispatching, used when avstp.dll
+is not available or not wanted.
+
+Each worker thread owns a task queue. Tasks enqueued from a worker go to its
+own queue, other tasks go to a shared queue. An idle worker takes tasks from
+its own queue first, then from the shared queue, then steals them from the
+queues of the other workers.
+
+The thread waiting for the completion of a dispatcher processes the pending
+tasks too, so the pool runs nbr_threads - 1 workers, and nested dispatchers
+(a task waiting for other tasks) cannot deadlock.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (ThreadPool_HEADER_INCLUDED)
+#define	ThreadPool_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"conc/Array.h"
+#include	"conc/AtomicInt.h"
+#include	"conc/CellPool.h"
+#include	"conc/LockFreeCell.h"
+#include	"conc/LockFreeQueue.h"
+#include	"avstp.h"
+#include	"types.h"
+
+#include	<condition_variable>
+#include	<mutex>
+#include	<thread>
+
+
+
+class ThreadPool
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	enum {			MAX_NBR_THREADS = 64	};
+
+						ThreadPool (int nbr_threads, uint64_t affinity_mask);
+	virtual			~ThreadPool ();
+
+	static int		get_nbr_cpus ();
+
+	avstp_TaskDispatcher *
+						create_dispatcher ();
+	void				destroy_dispatcher (avstp_TaskDispatcher *td_ptr);
+	int				get_nbr_threads () const;
+	int				enqueue_task (avstp_TaskDispatcher *td_ptr, avstp_TaskPtr task_ptr, void *user_data_ptr);
+	int				wait_completion (avstp_TaskDispatcher *td_ptr);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	class Dispatcher
+	{
+	public:
+		conc::AtomicInt <int>
+							_nbr_pending;		// Tasks enqueued and not completed yet
+		conc::AtomicInt <int>
+							_exception_flag;
+	};
+
+	class TaskEntry
+	{
+	public:
+		Dispatcher *	_disp_ptr;
+		avstp_TaskPtr	_task_ptr;
+		void *			_user_data_ptr;
+	};
+
+	typedef	conc::CellPool <TaskEntry>	TaskCellPool;
+	typedef	conc::LockFreeCell <TaskEntry>	TaskCell;
+	typedef	conc::LockFreeQueue <TaskEntry>	TaskQueue;
+
+	void				worker_loop (int thread_index);
+	int				find_thread_index () const;
+	TaskCell *		pop_task (int thread_index);
+	bool				run_one_task (int thread_index);
+	void				set_affinity (std::thread &thr, int thread_index);
+
+	static Dispatcher &
+						conv_dispatcher (avstp_TaskDispatcher *td_ptr);
+
+	int				_nbr_workers;		// Threads owned by the pool
+	const uint64_t	_affinity_mask;	// 0 = no affinity
+
+	TaskCellPool	_cell_pool;
+	TaskQueue		_queue_shared;
+	conc::Array <TaskQueue, MAX_NBR_THREADS>
+						_queue_arr;
+	conc::Array <std::thread, MAX_NBR_THREADS>
+						_thread_arr;
+	conc::Array <std::thread::id, MAX_NBR_THREADS>
+						_thread_id_arr;
+
+	conc::AtomicInt <int>
+						_nbr_queued;		// Approximate number of tasks waiting in the queues
+	conc::AtomicInt <int>
+						_nbr_sleeping;		// Threads blocked on _cond
+	conc::AtomicInt <int>
+						_nbr_running;		// Workers still in their loop
+	volatile bool	_quit_flag;
+
+	// Protects the sleeping state, for new tasks and dispatcher completions
+	std::mutex		_mutex;
+	std::condition_variable
+						_cond;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						ThreadPool ();
+						ThreadPool (const ThreadPool &other);
+	ThreadPool &	operator = (const ThreadPool &other);
+	bool				operator == (const ThreadPool &other) const;
+	bool				operator != (const ThreadPool &other) const;
+
+};	// class ThreadPool
+
+
+
+//#include	"ThreadPool.hpp"
+
+
+
+#endif	// ThreadPool_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -35,6 +35,15 @@ public:
 	{
 		return (_lut_f [v]);
 	}
+	// v is a signed vector component, not an index in the LUT
+	inline int		scale_vect_b (int time256, int v) const
+	{
+		return ((v * (256 - time256)) / 256);
+	}
+	inline int		scale_vect_f (int time256, int v) const
+	{
+		return ((v * time256) / 256);
+	}
 	inline void		jump_to_next_row () const
 	{
 		// Nothing
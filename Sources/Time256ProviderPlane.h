@@ -36,6 +36,25 @@ public:
 	{
 		return (_lut_f [time256] [v]);
 	}
+	// v is a signed vector component, not an index in the LUT
+	inline int		scale_vect_b (int time256, int v) const
+	{
+		return ((v * (256 - time256)) / 256);
+	}
+	inline int		scale_vect_f (int time256, int v) const
+	{
+		return ((v * time256) / 256);
+	}
+	// Current row, for the SIMD kernels
+	inline const BYTE *
+						use_row () const
+	{
+		return (_pt256);
+	}
+	inline int		get_pitch () const
+	{
+		return (_t256_pitch);
+	}
 	inline void		jump_to_next_row ()
 	{
 		_pt256 += _t256_pitch;
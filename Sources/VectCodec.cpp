@@ -0,0 +1,525 @@
+/*****************************************************************************
+
+        VectCodec.cpp
+        Author: agent, 2026
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if defined (_MSC_VER)
+	#pragma warning (1 : 4130 4223 4705 4706)
+	#pragma warning (4 : 4355 4786 4800)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"AnaFlags.h"
+#include	"cpu.h"
+#include	"VectCodec.h"
+
+#include	<emmintrin.h>
+#include	<tmmintrin.h>
+
+#include	<algorithm>
+
+#include	<cassert>
+#include	<cstring>
+
+
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+// src_ptr: a full vector frame, as output by MAnalyse.
+// Lengths are in bytes.
+// Returns the length of the encoded data, or -1 if the frame structure is
+// not recognized or if the encoded data doesn't fit in dst_max_len.
+int	VectCodec::encode (uint8_t dst_ptr [], int dst_max_len, const int32_t src_ptr [], int src_len)
+{
+	assert (dst_ptr != 0);
+	assert (dst_max_len > 0);
+	assert (src_ptr != 0);
+	assert (src_len > 0);
+
+	int				header_size = 0;
+	const MVAnalysisData *	mad_ptr = 0;
+	if (! check_header (
+		header_size, mad_ptr, reinterpret_cast <const uint8_t *> (src_ptr), src_len
+	))
+	{
+		return (-1);
+	}
+
+	const int32_t*	gop_ptr  = src_ptr + header_size / sizeof (int32_t);
+	const int		nbr_val  = gop_ptr [0];
+	const int		max_val  = (src_len - header_size) / sizeof (int32_t);
+	if (nbr_val < 2 || nbr_val > max_val)
+	{
+		return (-1);
+	}
+
+	PlaneArray		plane_arr;
+	if (! find_planes (plane_arr, gop_ptr, nbr_val, *mad_ptr))
+	{
+		return (-1);
+	}
+
+	// Quantises the SADs
+	const int		sad_shift = compute_sad_shift (*mad_ptr);
+	const int		sad_round = (1 << sad_shift) >> 1;
+	std::vector <int32_t>	q_arr (gop_ptr, gop_ptr + nbr_val);
+	for (int plane_cnt = 0; plane_cnt < int (plane_arr.size ()); ++plane_cnt)
+	{
+		const PlaneInfo &	plane = plane_arr [plane_cnt];
+		for (int blk = 0; blk < plane._nbr_blk; ++blk)
+		{
+			int32_t &		sad = q_arr [plane._pos + blk * NBR_COMP + 2];
+			sad = (sad <= 0) ? 0 : std::min (
+				(sad >> sad_shift) + ((sad & sad_round) != 0 ? 1 : 0),
+				int32_t (MAX_SAD_Q)
+			);
+		}
+	}
+
+	// Residuals. Structure words are left as is.
+	std::vector <uint32_t>	val_arr (q_arr.begin (), q_arr.end ());
+	for (int plane_cnt = 0; plane_cnt < int (plane_arr.size ()); ++plane_cnt)
+	{
+		const PlaneInfo &	plane = plane_arr [plane_cnt];
+		const int		len      = plane._nbr_blk * NBR_COMP;
+		const int		stride   = plane._width   * NBR_COMP;
+		const int32_t*	q_ptr    = &q_arr [plane._pos];
+		uint32_t *		v_ptr    = &val_arr [plane._pos];
+		for (int pos = 0; pos < len; ++pos)
+		{
+			const int		dist = (pos < stride) ? NBR_COMP : stride;
+			const int32_t	pred = (pos < dist) ? 0 : q_ptr [pos - dist];
+			v_ptr [pos] = zigzag (q_ptr [pos] - pred);
+		}
+	}
+
+	// Packing
+	const int		ctrl_len = (nbr_val + 3) >> 2;
+	const int		data_pos = header_size + STREAM_HDR + ctrl_len;
+	if (data_pos > dst_max_len)
+	{
+		return (-1);
+	}
+
+	memcpy (dst_ptr, src_ptr, header_size);
+	const int32_t	stream_hdr [2] = { nbr_val, sad_shift };
+	memcpy (dst_ptr + header_size, stream_hdr, sizeof (stream_hdr));
+
+	uint8_t *		ctrl_ptr     = dst_ptr + header_size + STREAM_HDR;
+	uint8_t *		data_ptr     = dst_ptr + data_pos;
+	uint8_t *		data_end_ptr = dst_ptr + dst_max_len;
+	memset (ctrl_ptr, 0, ctrl_len);
+	for (int k = 0; k < nbr_val; ++k)
+	{
+		if (data_end_ptr - data_ptr < int (sizeof (uint32_t)))
+		{
+			return (-1);
+		}
+
+		const uint32_t	v    = val_arr [k];
+		const int		code = compute_code (v);
+		const int		len  = (code == 3) ? 4 : code;
+		ctrl_ptr [k >> 2] |= uint8_t (code << ((k & 3) * 2));
+		for (int b = 0; b < len; ++b)
+		{
+			data_ptr [b] = uint8_t (v >> (b * 8));
+		}
+		data_ptr += len;
+	}
+
+	return (int (data_ptr - dst_ptr));
+}
+
+
+
+// dst_ptr: the restored vector frame. The part following the vector data
+// is filled with zeros.
+// Lengths are in bytes.
+// Returns false if the encoded data is corrupted or doesn't fit in dst_len.
+bool	VectCodec::decode (int32_t dst_ptr [], int dst_len, const uint8_t src_ptr [], int src_len)
+{
+	assert (dst_ptr != 0);
+	assert (dst_len > 0);
+	assert (src_ptr != 0);
+	assert (src_len > 0);
+
+	int				header_size = 0;
+	const MVAnalysisData *	mad_ptr = 0;
+	if (   ! check_header (header_size, mad_ptr, src_ptr, src_len)
+	    || header_size + int (STREAM_HDR) > src_len)
+	{
+		return (false);
+	}
+
+	int32_t			stream_hdr [2];
+	memcpy (stream_hdr, src_ptr + header_size, sizeof (stream_hdr));
+	const int		nbr_val   = stream_hdr [0];
+	const int		sad_shift = stream_hdr [1];
+	const int		ctrl_len  = (nbr_val + 3) >> 2;
+	const int		data_pos  = header_size + STREAM_HDR + ctrl_len;
+	if (   nbr_val < 2
+	    || nbr_val > (dst_len - header_size) / int (sizeof (int32_t))
+	    || sad_shift < 0 || sad_shift > 16
+	    || data_pos > src_len)
+	{
+		return (false);
+	}
+
+	memcpy (dst_ptr, src_ptr, header_size);
+	int32_t *		gop_ptr = dst_ptr + header_size / sizeof (int32_t);
+
+	// Unpacking
+	const uint8_t*	ctrl_ptr     = src_ptr + header_size + STREAM_HDR;
+	const uint8_t*	data_ptr     = src_ptr + data_pos;
+	const uint8_t*	data_end_ptr = src_ptr + src_len;
+	uint32_t *		val_ptr      = reinterpret_cast <uint32_t *> (gop_ptr);
+	const bool		ok_flag      =
+		  (_tables._ssse3_flag)
+		? unpack_ssse3 (val_ptr, nbr_val, ctrl_ptr, data_ptr, data_end_ptr)
+		: unpack_cpp (val_ptr, nbr_val, ctrl_ptr, data_ptr, data_end_ptr);
+	if (! ok_flag || gop_ptr [0] != nbr_val)
+	{
+		return (false);
+	}
+
+	PlaneArray		plane_arr;
+	if (! find_planes (plane_arr, gop_ptr, nbr_val, *mad_ptr))
+	{
+		return (false);
+	}
+
+	// Prediction
+	for (int plane_cnt = 0; plane_cnt < int (plane_arr.size ()); ++plane_cnt)
+	{
+		const PlaneInfo &	plane = plane_arr [plane_cnt];
+		const int		len    = plane._nbr_blk * NBR_COMP;
+		const int		stride = plane._width   * NBR_COMP;
+		int32_t *		v_ptr  = gop_ptr + plane._pos;
+
+		// First row, from the left
+		const int		len_row_0 = std::min (stride, len);
+		for (int pos = 0; pos < len_row_0; ++pos)
+		{
+			const int32_t	pred = (pos < NBR_COMP) ? 0 : v_ptr [pos - NBR_COMP];
+			v_ptr [pos] = unzigzag (uint32_t (v_ptr [pos])) + pred;
+		}
+
+		// Next rows, from above. They are processed as a single run.
+		if (_tables._sse2_flag && stride >= 4)
+		{
+			add_pred_sse2 (v_ptr + len_row_0, len - len_row_0, stride);
+		}
+		else
+		{
+			add_pred_cpp (v_ptr + len_row_0, len - len_row_0, stride);
+		}
+
+		if (sad_shift > 0)
+		{
+			for (int pos = 2; pos < len; pos += NBR_COMP)
+			{
+				v_ptr [pos] <<= sad_shift;
+			}
+		}
+	}
+
+	const int		end_pos = header_size + nbr_val * sizeof (int32_t);
+	memset (reinterpret_cast <uint8_t *> (dst_ptr) + end_pos, 0, dst_len - end_pos);
+
+	return (true);
+}
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+
+
+VectCodec::Tables::Tables ()
+:	_sse2_flag (false)
+,	_ssse3_flag (false)
+{
+	for (int ctrl = 0; ctrl < 256; ++ctrl)
+	{
+		int				pos = 0;
+		for (int j = 0; j < 4; ++j)
+		{
+			const int		code = (ctrl >> (j * 2)) & 3;
+			const int		len  = (code == 3) ? 4 : code;
+			for (int b = 0; b < 4; ++b)
+			{
+				_shuf_arr [ctrl] [j * 4 + b] = uint8_t ((b < len) ? pos + b : 0x80);
+			}
+			pos += len;
+		}
+		_len_arr [ctrl] = uint8_t (pos);
+	}
+
+	const unsigned int	cpu_flags = cpu_detect ();
+	_sse2_flag  = ((cpu_flags & CPU_SSE2 ) != 0);
+	_ssse3_flag = ((cpu_flags & CPU_SSSE3) != 0);
+}
+
+
+
+bool	VectCodec::check_header (int &header_size, const MVAnalysisData * &mad_ptr, const uint8_t src_ptr [], int src_len)
+{
+	assert (src_ptr != 0);
+
+	if (src_len < int (sizeof (int32_t)))
+	{
+		return (false);
+	}
+	int32_t			hs;
+	memcpy (&hs, src_ptr, sizeof (hs));
+	if (   hs < int (sizeof (int32_t) + sizeof (MVAnalysisData))
+	    || (hs & (sizeof (int32_t) - 1)) != 0
+	    || hs > src_len)
+	{
+		return (false);
+	}
+
+	const MVAnalysisData *	m_ptr =
+		reinterpret_cast <const MVAnalysisData *> (src_ptr + sizeof (int32_t));
+	if (   m_ptr->GetMagicKey () != MVAnalysisData::MOTION_MAGIC_KEY
+	    || m_ptr->nBlkSizeX <= m_ptr->nOverlapX
+	    || m_ptr->nOverlapX < 0
+	    || m_ptr->nBlkX <= 0
+	    || m_ptr->nLvCount < 1
+	    || m_ptr->nLvCount > 31)
+	{
+		return (false);
+	}
+
+	header_size = hs;
+	mad_ptr     = m_ptr;
+
+	return (true);
+}
+
+
+
+// The planes are stored from the coarsest level to the finest one, and may
+// be followed by the divided sub-blocks of the finest level.
+// The block width is only used for prediction. When it doesn't match the
+// number of blocks, the plane is handled as a single row.
+bool	VectCodec::find_planes (PlaneArray &plane_arr, const int32_t gop_ptr [], int nbr_val, const MVAnalysisData &mad)
+{
+	assert (gop_ptr != 0);
+	assert (nbr_val >= 2);
+
+	plane_arr.clear ();
+
+	const int		step_x  = mad.nBlkSizeX - mad.nOverlapX;
+	const int		width_b = step_x * mad.nBlkX + mad.nOverlapX;
+	const int		nbr_lvl = mad.nLvCount;
+	int				pos     = 2;	// Skips size and validity
+	for (int plane_cnt = 0; plane_cnt <= nbr_lvl && pos < nbr_val; ++plane_cnt)
+	{
+		const int		plane_size = gop_ptr [pos];
+		if (   plane_size < 1
+		    || plane_size > nbr_val - pos
+		    || (plane_size - 1) % NBR_COMP != 0)
+		{
+			return (false);
+		}
+
+		const int		level   = nbr_lvl - 1 - plane_cnt;
+		const int		width   =
+			  (level >= 0)
+			? ((width_b >> level) - mad.nOverlapX) / step_x
+			: mad.nBlkX * 2;
+		PlaneInfo		plane;
+		plane._pos     = pos + 1;
+		plane._nbr_blk = (plane_size - 1) / NBR_COMP;
+		plane._width   =
+			  (width > 0 && plane._nbr_blk % width == 0)
+			? width
+			: std::max (plane._nbr_blk, 1);
+		plane_arr.push_back (plane);
+
+		pos += plane_size;
+	}
+
+	return (pos == nbr_val && int (plane_arr.size ()) >= nbr_lvl);
+}
+
+
+
+// The SAD of a block is at most 255 per pixel, plus the same amount for the
+// chroma planes.
+int	VectCodec::compute_sad_shift (const MVAnalysisData &mad)
+{
+	const int		max_sad = mad.nBlkSizeX * mad.nBlkSizeY * 256 * 2;
+	int				shift   = 0;
+	while ((max_sad >> shift) > MAX_SAD_Q + 1)
+	{
+		++ shift;
+	}
+
+	return (shift);
+}
+
+
+
+uint32_t	VectCodec::zigzag (int32_t x)
+{
+	return ((uint32_t (x) << 1) ^ uint32_t (x >> 31));
+}
+
+
+
+int32_t	VectCodec::unzigzag (uint32_t x)
+{
+	return (int32_t (x >> 1) ^ -int32_t (x & 1));
+}
+
+
+
+int	VectCodec::compute_code (uint32_t x)
+{
+	return (
+		  (x == 0      ) ? 0
+		: (x < 0x100   ) ? 1
+		: (x < 0x10000 ) ? 2
+		:                  3
+	);
+}
+
+
+
+bool	VectCodec::unpack_cpp (uint32_t dst_ptr [], int nbr_val, const uint8_t ctrl_ptr [], const uint8_t * &data_ptr, const uint8_t data_end_ptr [])
+{
+	assert (dst_ptr != 0);
+	assert (ctrl_ptr != 0);
+	assert (data_ptr != 0);
+	assert (data_end_ptr != 0);
+
+	for (int k = 0; k < nbr_val; ++k)
+	{
+		const int		code = (ctrl_ptr [k >> 2] >> ((k & 3) * 2)) & 3;
+		const int		len  = (code == 3) ? 4 : code;
+		if (data_end_ptr - data_ptr < len)
+		{
+			return (false);
+		}
+		uint32_t			v = 0;
+		for (int b = 0; b < len; ++b)
+		{
+			v |= uint32_t (data_ptr [b]) << (b * 8);
+		}
+		dst_ptr [k] = v;
+		data_ptr += len;
+	}
+
+	return (true);
+}
+
+
+
+// 4 values per control byte, with a single shuffle.
+// The last values are unpacked with the C++ code to avoid reading past the
+// end of the data.
+bool	VectCodec::unpack_ssse3 (uint32_t dst_ptr [], int nbr_val, const uint8_t ctrl_ptr [], const uint8_t * &data_ptr, const uint8_t data_end_ptr [])
+{
+	assert (dst_ptr != 0);
+	assert (ctrl_ptr != 0);
+	assert (data_ptr != 0);
+	assert (data_end_ptr != 0);
+
+	int				k = 0;
+	while (k + 4 <= nbr_val && data_end_ptr - data_ptr >= 16)
+	{
+		const int		ctrl = ctrl_ptr [k >> 2];
+		const __m128i	shuf = _mm_loadu_si128 (
+			reinterpret_cast <const __m128i *> (_tables._shuf_arr [ctrl])
+		);
+		const __m128i	data = _mm_loadu_si128 (
+			reinterpret_cast <const __m128i *> (data_ptr)
+		);
+		_mm_storeu_si128 (
+			reinterpret_cast <__m128i *> (dst_ptr + k),
+			_mm_shuffle_epi8 (data, shuf)
+		);
+		data_ptr += _tables._len_arr [ctrl];
+		k += 4;
+	}
+
+	return (unpack_cpp (
+		dst_ptr + k, nbr_val - k, ctrl_ptr + (k >> 2), data_ptr, data_end_ptr
+	));
+}
+
+
+
+void	VectCodec::add_pred_cpp (int32_t dst_ptr [], int len, int stride)
+{
+	assert (dst_ptr != 0);
+	assert (len >= 0);
+	assert (stride > 0);
+
+	for (int pos = 0; pos < len; ++pos)
+	{
+		dst_ptr [pos] = unzigzag (uint32_t (dst_ptr [pos])) + dst_ptr [pos - stride];
+	}
+}
+
+
+
+// The predictor must be at least one vector away.
+void	VectCodec::add_pred_sse2 (int32_t dst_ptr [], int len, int stride)
+{
+	assert (dst_ptr != 0);
+	assert (len >= 0);
+	assert (stride >= 4);
+
+	const __m128i	one  = _mm_set1_epi32 (1);
+	const __m128i	zero = _mm_setzero_si128 ();
+	const int		len4 = len & -4;
+	for (int pos = 0; pos < len4; pos += 4)
+	{
+		const __m128i	res  = _mm_loadu_si128 (
+			reinterpret_cast <const __m128i *> (dst_ptr + pos)
+		);
+		const __m128i	pred = _mm_loadu_si128 (
+			reinterpret_cast <const __m128i *> (dst_ptr + pos - stride)
+		);
+		const __m128i	sign = _mm_sub_epi32 (zero, _mm_and_si128 (res, one));
+		const __m128i	val  = _mm_xor_si128 (_mm_srli_epi32 (res, 1), sign);
+		_mm_storeu_si128 (
+			reinterpret_cast <__m128i *> (dst_ptr + pos),
+			_mm_add_epi32 (val, pred)
+		);
+	}
+
+	add_pred_cpp (dst_ptr + len4, len - len4, stride);
+}
+
+
+
+const VectCodec::Tables	VectCodec::_tables;
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
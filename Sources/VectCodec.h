@@ -0,0 +1,157 @@
+/*****************************************************************************
+
+        VectCodec.h
+        Author: agent, 2026
+
+Compact encoding of a motion vector frame, as produced by MAnalyse.
+
+The frame header (header size and MVAnalysisData) is stored as is. The
+following group-of-planes array is transformed and packed:
+- Each block component is predicted from the same component of the left
+	block on the first row of a plane, and of the block above on the other
+	rows. The residual is zigzag-mapped to an unsigned value.
+- The SADs are quantised to 16 bits, with a shift depending on the block
+	size. Blocks up to 8x8 are stored without loss.
+- The size and validity words are stored unchanged.
+- All the resulting values are packed with a variable byte length scheme:
+	a control byte holds the length codes of 4 consecutive values (0, 1, 2 or
+	4 bytes) and the value bytes are stored in a separate stream. Zero
+	residuals cost only 2 bits.
+
+This byte-length packing is the only packing stage. There is no entropy
+coding; the remaining redundancy is left to the lossless codec used to
+save the clip.
+
+Stream layout (bytes):
+	header_size	Raw header, its first int32 is header_size
+	4				Number of values in the group-of-planes array
+	4				SAD quantisation shift
+	(n + 3) / 4	Control bytes
+	...			Value bytes
+
+The decoder gets the value bytes back with a byte shuffle and adds the rows
+of residuals to the previous rows as plain vectors.
+
+--- Legal stuff ---
+
+This program is free software. It comes without any warranty, to
+the extent permitted by applicable law. You can redistribute it
+and/or modify it under the terms of the Do What The Fuck You Want
+To Public License, Version 2, as published by Sam Hocevar. See
+http://sam.zoy.org/wtfpl/COPYING for more details.
+
+*Tab=3***********************************************************************/
+
+
+
+#if ! defined (VectCodec_HEADER_INCLUDED)
+#define	VectCodec_HEADER_INCLUDED
+
+#if defined (_MSC_VER)
+	#pragma once
+	#pragma warning (4 : 4250)
+#endif
+
+
+
+/*\\\ INCLUDE FILES \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+#include	"def.h"
+#include	"MVAnalysisData.h"
+#include	"types.h"
+
+#include	<vector>
+
+
+
+class VectCodec
+{
+
+/*\\\ PUBLIC \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+public:
+
+	static int		encode (uint8_t dst_ptr [], int dst_max_len, const int32_t src_ptr [], int src_len);
+	static bool		decode (int32_t dst_ptr [], int dst_len, const uint8_t src_ptr [], int src_len);
+
+
+
+/*\\\ PROTECTED \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+protected:
+
+
+
+/*\\\ PRIVATE \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+	CHECK_COMPILE_TIME (SizeOfInt, (sizeof (int) == sizeof (int32_t)));
+
+	enum {			NBR_COMP   = 3	};	// Same as N_PER_BLOCK: x, y, SAD
+	enum {			MAX_SAD_Q  = 0xFFFF	};
+	enum {			STREAM_HDR = 2 * sizeof (int32_t)	};
+
+	class PlaneInfo
+	{
+	public:
+		int				_pos;				// Position of the first block, in int32
+		int				_nbr_blk;
+		int				_width;			// Blocks. Prediction from above starts after _width blocks
+	};
+	typedef	std::vector <PlaneInfo>	PlaneArray;
+
+	class Tables
+	{
+	public:
+							Tables ();
+		uint8_t			_shuf_arr [256] [16];
+		uint8_t			_len_arr [256];
+		bool				_sse2_flag;
+		bool				_ssse3_flag;
+	};
+
+	static bool		check_header (int &header_size, const MVAnalysisData * &mad_ptr, const uint8_t src_ptr [], int src_len);
+	static bool		find_planes (PlaneArray &plane_arr, const int32_t gop_ptr [], int nbr_val, const MVAnalysisData &mad);
+	static int		compute_sad_shift (const MVAnalysisData &mad);
+
+	static inline uint32_t
+						zigzag (int32_t x);
+	static inline int32_t
+						unzigzag (uint32_t x);
+	static inline int	compute_code (uint32_t x);
+
+	static bool		unpack_cpp (uint32_t dst_ptr [], int nbr_val, const uint8_t ctrl_ptr [], const uint8_t * &data_ptr, const uint8_t data_end_ptr []);
+	static bool		unpack_ssse3 (uint32_t dst_ptr [], int nbr_val, const uint8_t ctrl_ptr [], const uint8_t * &data_ptr, const uint8_t data_end_ptr []);
+	static void		add_pred_cpp (int32_t dst_ptr [], int len, int stride);
+	static void		add_pred_sse2 (int32_t dst_ptr [], int len, int stride);
+
+	static const Tables
+						_tables;
+
+
+
+/*\\\ FORBIDDEN MEMBER FUNCTIONS \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
+
+private:
+
+						VectCodec ();
+						VectCodec (const VectCodec &other);
+	virtual			~VectCodec () {}
+	VectCodec &		operator = (const VectCodec &other);
+	bool				operator == (const VectCodec &other) const;
+	bool				operator != (const VectCodec &other) const;
+
+};	// class VectCodec
+
+
+
+//#include	"VectCodec.hpp"
+
+
+
+#endif	// VectCodec_HEADER_INCLUDED
+
+
+
+/*\\\ EOF \\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\\*/
@@ -32,6 +32,7 @@
 
 extern "C" unsigned int __cdecl x264_cpu_cpuid_test( void );
 extern "C" unsigned int __cdecl x264_cpu_cpuid( uint32_t op, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx );
+extern "C" void __cdecl x264_cpu_xgetbv( uint32_t op, uint32_t *eax, uint32_t *edx );
 
 
 uint32_t cpu_detect( void )
@@ -39,6 +40,7 @@ uint32_t cpu_detect( void )
 	uint32_t cpu = 0;
     uint32_t eax, ebx, ecx, edx;
     uint32_t vendor[4] = {0};
+    int max_basic_cap;
     int max_extended_cap;
     int cache;
 
@@ -50,6 +52,7 @@ uint32_t cpu_detect( void )
     x264_cpu_cpuid( 0, &eax, vendor+0, vendor+2, vendor+1 );
     if( eax == 0 )
         return 0;
+    max_basic_cap = eax;
 
     x264_cpu_cpuid( 1, &eax, &ebx, &ecx, &edx );
     if( edx&0x00800000 )
@@ -67,6 +70,21 @@ uint32_t cpu_detect( void )
     if( ecx&0x00080000 )
         cpu |= CPU_SSE4;
 
+    /* AVX requires the OS to save the ymm (and zmm) states on context switches */
+    if( (ecx&0x18000000) == 0x18000000 && max_basic_cap >= 7 ) /* OSXSAVE and AVX */
+    {
+        uint32_t xcr0, xcr0_hi;
+        x264_cpu_xgetbv( 0, &xcr0, &xcr0_hi );
+        if( (xcr0&0x6) == 0x6 )
+        {
+            x264_cpu_cpuid( 7, &eax, &ebx, &ecx, &edx );
+            if( ebx&0x00000020 )
+                cpu |= CPU_AVX2;
+            if( (ebx&0x40010000) == 0x40010000 && (xcr0&0xe0) == 0xe0 ) /* AVX512F and AVX512BW, opmask and zmm */
+                cpu |= CPU_AVX512BW;
+        }
+    }
+
     if( cpu & CPU_SSSE3 )
         cpu |= CPU_SSE2_IS_FAST;
     if( cpu & CPU_SSE4 )